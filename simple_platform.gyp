@@ -5,9 +5,24 @@
 {
   'variables': {
     'chromium_code': 1,  # Use higher warning level.
+
+    # Set to 1 to build Lock with contention profiling (see lock_profiler.h).
+    'enable_lock_profiling%': 0,
+
+    # Set to 1 to build as C++20, which enables coroutine.h and its tests.
+    'enable_cxx20%': 0,
   },
   'target_defaults': {
     'conditions': [
+      ['enable_lock_profiling==1', {
+        'defines': ['ENABLE_LOCK_PROFILING'],
+      }],
+      ['enable_cxx20==1', {
+        'cflags_cc': ['-std=c++20'],
+        'xcode_settings': {
+          'CLANG_CXX_LANGUAGE_STANDARD': 'c++20',
+        },
+      }],
       # Linux shared libraries should always be built -fPIC.
       ['OS=="linux" or OS=="openbsd" or OS=="freebsd" or OS=="solaris"', {
         'cflags': ['-fPIC', '-fvisibility=hidden'],
@@ -30,14 +45,77 @@
         '..',
       ],
       'sources': [
+        'src/arena.cc',
+        'src/arena.h',
+        'src/atomics.h',
         'src/basictypes.h',
+        'src/condition_variable.h',
+        'src/condition_variable_linux.cc',
+        'src/condition_variable_posix.cc',
+        'src/coroutine.h',
+        'src/epoch_reclaimer.cc',
+        'src/epoch_reclaimer.h',
+        'src/executor.h',
+        'src/fiber.cc',
+        'src/fiber.h',
+        'src/fiber_context.cc',
+        'src/fiber_context.h',
+        'src/fiber_context_arm64.S',
+        'src/fiber_context_x86_64.S',
+        'src/free_list_cache.cc',
+        'src/free_list_cache.h',
+        'src/futex_linux.h',
+        'src/future.cc',
+        'src/future.h',
         'src/lock.cc',
         'src/lock.h',
         'src/lock_impl.h',
+        'src/lock_impl_linux.cc',
         'src/lock_impl_posix.cc',
+        'src/lock_profiler.cc',
+        'src/lock_profiler.h',
+        'src/mailbox.h',
+        'src/mcs_lock_impl.cc',
+        'src/mcs_lock_impl.h',
+        'src/mpmc_queue.h',
+        'src/mpsc_queue.h',
+        'src/object_pool.cc',
+        'src/object_pool.h',
+        'src/parallel.h',
         'src/port.h',
+        'src/rw_lock.h',
+        'src/rw_lock_posix.cc',
+        'src/seq_lock.h',
+        'src/shard_util.cc',
+        'src/shard_util.h',
+        'src/sharded_counter.cc',
+        'src/sharded_counter.h',
+        'src/sharded_rw_lock.cc',
+        'src/sharded_rw_lock.h',
+        'src/spin_wait.h',
+        'src/spsc_ring.h',
+        'src/stack_pool.h',
+        'src/stack_pool_posix.cc',
+        'src/sys_info.h',
+        'src/sys_info_posix.cc',
+        'src/task.h',
         'src/thread.h',
+        'src/thread_local.h',
+        'src/thread_local_posix.cc',
+        'src/thread_pool.cc',
+        'src/thread_pool.h',
         'src/thread_posix.cc',
+        'src/ticket_lock_impl.cc',
+        'src/ticket_lock_impl.h',
+        'src/time.h',
+        'src/time_posix.cc',
+        'src/timer_thread.cc',
+        'src/timer_thread.h',
+        'src/timer_wheel.cc',
+        'src/timer_wheel.h',
+        'src/work_stealing_deque.h',
+        'src/work_stealing_scheduler.cc',
+        'src/work_stealing_scheduler.h',
       ],
       'conditions': [
         ['OS=="win"', {
@@ -50,13 +128,34 @@
         ['OS=="linux"', {
 #          'cflags': ['-Wextra', '-pedantic'],
           'cflags': ['-Wextra', ],
+          'sources!': [
+            'src/condition_variable_posix.cc',
+            'src/lock_impl_posix.cc',
+          ],
+        }, {  # OS!="linux"
+          'sources!': [
+            'src/condition_variable_linux.cc',
+            'src/futex_linux.h',
+            'src/lock_impl_linux.cc',
+          ],
         }],
         ['OS=="mac"', {
           'xcode_settings': {
 #            'WARNING_CFLAGS': ['-Wextra', '-pedantic'], 
             'WARNING_CFLAGS': ['-Wextra', ], 
            },
-        }]
+        }],
+        # Fibers switch contexts in assembly, written for these only.
+        ['target_arch!="x64" and target_arch!="arm64"', {
+          'sources!': [
+            'src/fiber.cc',
+            'src/fiber.h',
+            'src/fiber_context.cc',
+            'src/fiber_context.h',
+            'src/fiber_context_arm64.S',
+            'src/fiber_context_x86_64.S',
+          ],
+        }],
       ],
     },
     {
@@ -71,13 +170,92 @@
         'tests/unittest_main.cc',
 
         # Tests.
+        'tests/arena_unittest.cc',
+        'tests/atomics_unittest.cc',
+        'tests/condition_variable_unittest.cc',
+        'tests/coroutine_unittest.cc',
+        'tests/epoch_reclaimer_unittest.cc',
+        'tests/fiber_unittest.cc',
+        'tests/free_list_cache_unittest.cc',
+        'tests/future_unittest.cc',
+        'tests/lock_profiler_unittest.cc',
         'tests/lock_unittest.cc',
+        'tests/mailbox_unittest.cc',
+        'tests/mpmc_queue_unittest.cc',
+        'tests/mpsc_queue_unittest.cc',
+        'tests/object_pool_unittest.cc',
+        'tests/parallel_unittest.cc',
+        'tests/rw_lock_unittest.cc',
+        'tests/seq_lock_unittest.cc',
+        'tests/sharded_counter_unittest.cc',
+        'tests/spsc_ring_unittest.cc',
+        'tests/thread_local_unittest.cc',
+        'tests/thread_pool_unittest.cc',
         'tests/thread_unittest.cc',
+        'tests/time_unittest.cc',
+        'tests/timer_thread_unittest.cc',
+        'tests/timer_wheel_unittest.cc',
+        'tests/work_stealing_deque_unittest.cc',
+        'tests/work_stealing_scheduler_unittest.cc',
+      ],
+      'dependencies': [
+        'simple_platform',
+        'gtest/gtest.gyp:gtest',
+      ],
+      'conditions': [
+        ['target_arch!="x64" and target_arch!="arm64"', {
+          'sources!': [
+            'tests/fiber_unittest.cc',
+          ],
+        }],
+      ],
+    },
+    {
+      'target_name': 'simple_platform_perftests',
+      'type': 'executable',
+      'include_dirs': [
+        '..',
+      ],
+      'sources': [
+        # Test runner.
+        'tests/unittest_main.cc',
+
+        # Helpers.
+        'tests/perftimer.h',
+
+        # Perf tests.
+        'tests/condition_variable_perftest.cc',
+        'tests/coroutine_perftest.cc',
+        'tests/epoch_reclaimer_perftest.cc',
+        'tests/fiber_perftest.cc',
+        'tests/future_perftest.cc',
+        'tests/lock_perftest.cc',
+        'tests/mailbox_perftest.cc',
+        'tests/mpmc_queue_perftest.cc',
+        'tests/object_pool_perftest.cc',
+        'tests/parallel_perftest.cc',
+        'tests/rw_lock_perftest.cc',
+        'tests/seq_lock_perftest.cc',
+        'tests/sharded_counter_perftest.cc',
+        'tests/spsc_ring_perftest.cc',
+        'tests/thread_local_perftest.cc',
+        'tests/thread_perftest.cc',
+        'tests/thread_pool_perftest.cc',
+        'tests/time_perftest.cc',
+        'tests/timer_wheel_perftest.cc',
+        'tests/work_stealing_scheduler_perftest.cc',
       ],
       'dependencies': [
         'simple_platform',
         'gtest/gtest.gyp:gtest',
       ],
+      'conditions': [
+        ['target_arch!="x64" and target_arch!="arm64"', {
+          'sources!': [
+            'tests/fiber_perftest.cc',
+          ],
+        }],
+      ],
     },
   ],
 }
@@ -0,0 +1,86 @@
+// Copyright (c) 2010 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "simple-platform-lib/src/arena.h"
+
+namespace platform {
+
+namespace {
+
+// Room for the block header, keeping the data aligned.
+const size_t kHeaderSize = 16;
+
+}  // namespace
+
+Arena::Arena(size_t block_size)
+    : block_size_((block_size + kAlignment - 1) & ~(kAlignment - 1)),
+      blocks_(NULL),
+      cursor_(NULL),
+      end_(NULL),
+      bytes_allocated_(0) {
+}
+
+Arena::~Arena() {
+  while (blocks_) {
+    Block* next = blocks_->next;
+    operator delete(blocks_);
+    blocks_ = next;
+  }
+}
+
+void* Arena::AllocateSlow(size_t size) {
+  // No room for the block header.
+  if (size > static_cast<size_t>(-1) - kHeaderSize)
+    abort();
+  bytes_allocated_ += size;
+  if (size > block_size_ / 4) {
+    // Behind the current block, so that its free space is not given up.
+    Block* block = NewBlock(size, cursor_ ? blocks_ : NULL);
+    return BlockData(block);
+  }
+  Block* block = NewBlock(block_size_, NULL);
+  cursor_ = BlockData(block) + size;
+  end_ = BlockData(block) + block_size_;
+  return BlockData(block);
+}
+
+void Arena::Reset() {
+  // Keep the most recent full-sized block.
+  Block* kept = NULL;
+  Block* block = blocks_;
+  while (block) {
+    Block* next = block->next;
+    if (!kept && block->size == block_size_) {
+      kept = block;
+      kept->next = NULL;
+    } else {
+      operator delete(block);
+    }
+    block = next;
+  }
+  blocks_ = kept;
+  cursor_ = kept ? BlockData(kept) : NULL;
+  end_ = kept ? BlockData(kept) + block_size_ : NULL;
+  bytes_allocated_ = 0;
+}
+
+Arena::Block* Arena::NewBlock(size_t size, Block* after) {
+  Block* block = static_cast<Block*>(operator new(kHeaderSize + size));
+  block->size = size;
+  if (after) {
+    block->next = after->next;
+    after->next = block;
+  } else {
+    block->next = blocks_;
+    blocks_ = block;
+  }
+  return block;
+}
+
+// static
+char* Arena::BlockData(Block* block) {
+  return reinterpret_cast<char*>(block) + kHeaderSize;
+}
+
+}  // namespace platform
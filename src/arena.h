@@ -0,0 +1,104 @@
+// Copyright (c) 2010 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+// Arena hands out memory by bumping a pointer through large blocks, and
+// frees all of it at once, for data that lives exactly as long as something
+// else (a request, a parse) and then goes together:
+//
+//   Arena arena(64 * 1024);
+//   for (each request) {
+//     Header* header = arena.New<Header>();
+//     char* body = static_cast<char*>(arena.Allocate(body_size));
+//     ...
+//     arena.Reset();  // Everything from this request, in one go.
+//   }
+//
+// Allocating costs a compare and an add, and freeing costs nothing per
+// allocation.  The flip side: nothing is freed before Reset(), and
+// destructors are never run, so an arena suits types that need no
+// destruction (or whose destruction can be skipped).  An arena is not
+// thread-safe.
+
+#ifndef SIMPLEPLATFORMLIB_SRC_ARENA_H_
+#define SIMPLEPLATFORMLIB_SRC_ARENA_H_
+#pragma once
+
+#include <stddef.h>
+#include <stdlib.h>
+
+#include <new>
+
+#include "simple-platform-lib/src/basictypes.h"
+
+namespace platform {
+
+class Arena {
+ public:
+  // Every allocation is aligned to this.
+  static const size_t kAlignment = 16;
+
+  // Memory is taken from the heap in blocks of |block_size| bytes; an
+  // allocation of more than a quarter of that gets a block of its own.
+  explicit Arena(size_t block_size);
+  ~Arena();
+
+  // A |size| of 0 still gets an address of its own.  A |size| too large to
+  // be allocated at all aborts the program.
+  void* Allocate(size_t size) {
+    size_t rounded = (size + kAlignment - 1) & ~(kAlignment - 1);
+    if (rounded == 0) {
+      // Rounding 0, or wrapping around.
+      if (size != 0)
+        abort();
+      rounded = kAlignment;
+    }
+    size = rounded;
+    if (size <= static_cast<size_t>(end_ - cursor_)) {
+      void* memory = cursor_;
+      cursor_ += size;
+      bytes_allocated_ += size;
+      return memory;
+    }
+    return AllocateSlow(size);
+  }
+
+  // A default-constructed T, whose destructor will not be run.
+  template <typename T>
+  T* New() {
+    return new (Allocate(sizeof(T))) T;
+  }
+
+  // Frees everything allocated from the arena, keeping one block for the
+  // next round.
+  void Reset();
+
+  // The bytes handed out since construction or the last Reset(), rounded
+  // up to kAlignment each.
+  size_t bytes_allocated() const { return bytes_allocated_; }
+
+ private:
+  // A block's header; the memory follows it.
+  struct Block {
+    Block* next;
+    size_t size;
+  };
+
+  void* AllocateSlow(size_t size);
+  // Allocates a block of |size| bytes and links it after |after|, or first
+  // if |after| is NULL.
+  Block* NewBlock(size_t size, Block* after);
+  static char* BlockData(Block* block);
+
+  const size_t block_size_;
+  Block* blocks_;
+  char* cursor_;
+  char* end_;
+  size_t bytes_allocated_;
+
+  DISALLOW_COPY_AND_ASSIGN(Arena);
+};
+
+}  // namespace platform
+
+#endif  // SIMPLEPLATFORMLIB_SRC_ARENA_H_
@@ -0,0 +1,203 @@
+// Copyright (c) 2010 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+// Atomic operations with explicit memory ordering, for the lock-free code in
+// this library.  The orderings are those of the C++0x draft (and of the
+// GCC/Clang __atomic builtins the implementation maps onto):
+//
+//   MEMORY_ORDER_RELAXED  atomicity only, no ordering of other accesses
+//   MEMORY_ORDER_ACQUIRE  later accesses stay after the load
+//   MEMORY_ORDER_RELEASE  earlier accesses stay before the store
+//   MEMORY_ORDER_ACQ_REL  both, for read-modify-writes
+//   MEMORY_ORDER_SEQ_CST  acquire/release plus a single total order of all
+//                         SEQ_CST operations; the default
+//
+//   Atomic<int32> count;
+//   count.FetchAdd(1, MEMORY_ORDER_RELAXED);
+//
+//   AtomicFlag done;
+//   done.Set();                // Publishes what the thread wrote before...
+//   if (done.IsSet()) ...      // ...to whoever sees the flag set.
+//
+// Also here: CpuRelax() for spin-wait loops, and kCacheLineSize and
+// CacheAligned<T> for keeping data that different threads write off each
+// other's cache lines.
+//
+// No MSVC implementation yet.
+
+#ifndef SIMPLEPLATFORMLIB_SRC_ATOMICS_H_
+#define SIMPLEPLATFORMLIB_SRC_ATOMICS_H_
+#pragma once
+
+#include <stddef.h>
+
+#include "simple-platform-lib/build/build_config.h"
+#include "simple-platform-lib/src/basictypes.h"
+
+namespace platform {
+
+enum MemoryOrder {
+  MEMORY_ORDER_RELAXED = __ATOMIC_RELAXED,
+  MEMORY_ORDER_ACQUIRE = __ATOMIC_ACQUIRE,
+  MEMORY_ORDER_RELEASE = __ATOMIC_RELEASE,
+  MEMORY_ORDER_ACQ_REL = __ATOMIC_ACQ_REL,
+  MEMORY_ORDER_SEQ_CST = __ATOMIC_SEQ_CST
+};
+
+// An integer or pointer that is read and written atomically.  Has the size
+// and alignment of a T.  FetchAdd() and friends are for integers only.
+template <typename T>
+class Atomic {
+ public:
+  Atomic() : value_() {}
+  explicit Atomic(T value) : value_(value) {}
+
+  T Load(MemoryOrder order = MEMORY_ORDER_SEQ_CST) const {
+    return __atomic_load_n(&value_, order);
+  }
+
+  void Store(T value, MemoryOrder order = MEMORY_ORDER_SEQ_CST) {
+    __atomic_store_n(&value_, value, order);
+  }
+
+  // Returns the previous value.
+  T Exchange(T value, MemoryOrder order = MEMORY_ORDER_SEQ_CST) {
+    return __atomic_exchange_n(&value_, value, order);
+  }
+
+  // If the value is |*expected|, replaces it with |desired| and returns true.
+  // Otherwise stores the value in |*expected| and returns false.  |failure|
+  // is the ordering of the load when the comparison fails; it defaults to
+  // the strongest one allowed for |success|.
+  bool CompareExchange(T* expected, T desired,
+                       MemoryOrder success = MEMORY_ORDER_SEQ_CST) {
+    return CompareExchange(expected, desired, success,
+                           FailureOrder(success));
+  }
+  bool CompareExchange(T* expected, T desired, MemoryOrder success,
+                       MemoryOrder failure) {
+    return __atomic_compare_exchange_n(&value_, expected, desired, false,
+                                       success, failure);
+  }
+
+  // Like CompareExchange(), but may fail spuriously, which is cheaper on
+  // load-linked/store-conditional processors.  For retry loops.
+  bool CompareExchangeWeak(T* expected, T desired,
+                           MemoryOrder success = MEMORY_ORDER_SEQ_CST) {
+    return CompareExchangeWeak(expected, desired, success,
+                               FailureOrder(success));
+  }
+  bool CompareExchangeWeak(T* expected, T desired, MemoryOrder success,
+                           MemoryOrder failure) {
+    return __atomic_compare_exchange_n(&value_, expected, desired, true,
+                                       success, failure);
+  }
+
+  // Each returns the previous value.
+  T FetchAdd(T delta, MemoryOrder order = MEMORY_ORDER_SEQ_CST) {
+    return __atomic_fetch_add(&value_, delta, order);
+  }
+  T FetchSub(T delta, MemoryOrder order = MEMORY_ORDER_SEQ_CST) {
+    return __atomic_fetch_sub(&value_, delta, order);
+  }
+  T FetchAnd(T bits, MemoryOrder order = MEMORY_ORDER_SEQ_CST) {
+    return __atomic_fetch_and(&value_, bits, order);
+  }
+  T FetchOr(T bits, MemoryOrder order = MEMORY_ORDER_SEQ_CST) {
+    return __atomic_fetch_or(&value_, bits, order);
+  }
+
+ private:
+  static MemoryOrder FailureOrder(MemoryOrder success) {
+    switch (success) {
+      case MEMORY_ORDER_RELEASE:
+        return MEMORY_ORDER_RELAXED;
+      case MEMORY_ORDER_ACQ_REL:
+        return MEMORY_ORDER_ACQUIRE;
+      default:
+        return success;
+    }
+  }
+
+  T value_;
+
+  DISALLOW_COPY_AND_ASSIGN(Atomic);
+};
+
+// A boolean flag.  Set() and IsSet() default to release and acquire, which
+// is what one thread telling another that something is done needs.
+class AtomicFlag {
+ public:
+  AtomicFlag() : value_(false) {}
+
+  void Set(MemoryOrder order = MEMORY_ORDER_RELEASE) {
+    __atomic_store_n(&value_, true, order);
+  }
+
+  void Clear(MemoryOrder order = MEMORY_ORDER_RELEASE) {
+    __atomic_store_n(&value_, false, order);
+  }
+
+  bool IsSet(MemoryOrder order = MEMORY_ORDER_ACQUIRE) const {
+    return __atomic_load_n(&value_, order);
+  }
+
+  // Sets the flag and returns whether it was already set.
+  bool TestAndSet(MemoryOrder order = MEMORY_ORDER_SEQ_CST) {
+    return __atomic_exchange_n(&value_, true, order);
+  }
+
+ private:
+  bool value_;
+
+  DISALLOW_COPY_AND_ASSIGN(AtomicFlag);
+};
+
+// Orders the memory accesses around it, as if it were the atomic operation
+// it is named after (an acquire fence orders earlier loads before later
+// accesses, and so on).
+inline void AtomicThreadFence(MemoryOrder order) {
+  __atomic_thread_fence(order);
+}
+
+// Only stops the compiler from reordering accesses across it; for ordering
+// against a signal handler on the same thread.
+inline void AtomicSignalFence(MemoryOrder order) {
+  __atomic_signal_fence(order);
+}
+
+// Tells the processor that the calling thread is in a spin-wait loop.  On x86
+// this is the PAUSE instruction, which avoids the memory-order mis-speculation
+// penalty on loop exit and gives the sibling hyperthread the pipeline.
+inline void CpuRelax() {
+#if defined(ARCH_CPU_X86_FAMILY)
+  __asm__ __volatile__("pause" : : : "memory");
+#elif defined(ARCH_CPU_ARM_FAMILY) || defined(__aarch64__)
+  __asm__ __volatile__("yield" : : : "memory");
+#else
+  __asm__ __volatile__("" : : : "memory");
+#endif
+}
+
+// The unit in which processors keep caches coherent.  Two threads writing
+// different variables on the same line slow each other down as much as if
+// they wrote the same variable ("false sharing").
+const size_t kCacheLineSize = 64;
+
+// A T alone on its cache line(s): aligned to, and padded to a multiple of,
+// kCacheLineSize.  Arrays of them put each element on lines of its own.
+// The alignment only holds where the compiler controls it (globals, the
+// stack, members); memory from operator new or malloc() is only aligned for
+// the largest standard type, so use posix_memalign() for heap arrays.
+template <typename T>
+struct CacheAligned {
+  CacheAligned() : value() {}
+  explicit CacheAligned(const T& initial_value) : value(initial_value) {}
+
+  T value;
+} __attribute__((aligned(kCacheLineSize)));
+
+}  // namespace platform
+
+#endif  // SIMPLEPLATFORMLIB_SRC_ATOMICS_H_
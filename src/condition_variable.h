@@ -0,0 +1,92 @@
+// Copyright (c) 2010 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+// Taken from Chromium: src/base/condition_variable.h
+// Significant changes (other than naming):
+//  - |TimedWait()| takes milliseconds or a |TimeDelta| and reports whether
+//    it timed out; the deadline is computed against the monotonic clock
+//  - Linux implementation on futexes (see condition_variable_linux.cc)
+//  - no Windows implementation yet
+
+// ConditionVariable wraps pthreads condition variable synchronization or, on
+// Linux, a futex.  This functionality is very helpful for having several
+// threads wait for an event, as is common with a thread pool managed by a
+// master.  The meaning of such an event in the (worker) thread pool scenario
+// is that additional tasks are now available for processing.  It is used in
+// Chrome in the DNS prefetching system to notify worker threads that a queue
+// now has items (tasks) which need to be tended to.
+//
+// A condition variable must always be used with a Lock.  A thread must hold
+// the lock before calling Wait(), TimedWait(), and (usually) before Signal()
+// or Broadcast().  Wait() atomically releases the lock while it sleeps and
+// re-acquires it before returning, so the usual pattern is:
+//
+//   AutoLock auto_lock(lock);
+//   while (!condition_is_met)
+//     cv.Wait();
+//
+// Wait() may return spuriously, which is why the condition must be re-checked
+// in a loop.  Signal() wakes at most one waiting thread; Broadcast() wakes
+// them all.
+
+#ifndef SIMPLEPLATFORMLIB_SRC_CONDITION_VARIABLE_H_
+#define SIMPLEPLATFORMLIB_SRC_CONDITION_VARIABLE_H_
+#pragma once
+
+#include "simple-platform-lib/build/build_config.h"
+
+#if defined(OS_POSIX) && !defined(OS_LINUX)
+#include <pthread.h>
+#endif
+
+#include "simple-platform-lib/src/basictypes.h"
+#include "simple-platform-lib/src/lock.h"
+#include "simple-platform-lib/src/time.h"
+
+namespace platform {
+
+class ConditionVariable {
+ public:
+  // Construct a cv for use with ONLY one user lock.
+  explicit ConditionVariable(Lock* user_lock);
+
+  ~ConditionVariable();
+
+  // Wait() releases the caller's critical section atomically as it starts to
+  // sleep, and then reacquires it when it is signaled.
+  void Wait();
+
+  // Like Wait(), but gives up once |max_time_ms| milliseconds have passed on
+  // the monotonic clock.  Returns false if it gave up, and true if it was
+  // woken (which, as with Wait(), may be spurious).
+  bool TimedWait(int max_time_ms);
+  bool TimedWait(const TimeDelta& max_time);
+
+  // Broadcast() revives all waiting threads.
+  void Broadcast();
+  // Signal() revives one waiting thread.
+  void Signal();
+
+ private:
+#if defined(OS_LINUX)
+  // Bumped by every Signal()/Broadcast(); waiters sleep on it.
+  volatile int32 sequence_;
+  // Number of threads in Wait()/TimedWait(), so that signaling an idle
+  // condition variable does not need a system call.
+  volatile int32 waiters_;
+  Lock* user_lock_;
+#elif defined(OS_POSIX)
+  pthread_cond_t condition_;
+  pthread_mutex_t* user_mutex_;
+#if !defined(NDEBUG)
+  Lock* user_lock_;     // Needed to adjust shadow lock state on wait.
+#endif
+#endif
+
+  DISALLOW_COPY_AND_ASSIGN(ConditionVariable);
+};
+
+}  // namespace platform
+
+#endif  // SIMPLEPLATFORMLIB_SRC_CONDITION_VARIABLE_H_
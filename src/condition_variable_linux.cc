@@ -0,0 +1,117 @@
+// Copyright (c) 2010 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+// Futex-based ConditionVariable for Linux, built to cooperate with the futex
+// LockImpl in lock_impl_linux.cc.
+//
+// Waiters sleep on |sequence_|, which every Signal()/Broadcast() increments,
+// so a wakeup that happens between the waiter releasing the user lock and
+// going to sleep is never lost: the futex value check fails instead.
+//
+// Broadcast() wakes a single waiter and requeues the rest directly onto the
+// user lock's futex word.  Waking them all would only have them stampede for
+// the lock and go straight back to sleep on it; instead, each Unlock() of the
+// user lock hands it to the next requeued waiter.
+
+#include "simple-platform-lib/src/condition_variable.h"
+
+#include <errno.h>
+#include <limits.h>
+#include <time.h>
+
+#include "simple-platform-lib/src/futex_linux.h"
+
+namespace platform {
+
+namespace {
+
+void GetDeadline(const TimeDelta& max_time, struct timespec* deadline) {
+  TimeTicks now = TimeTicks::Now();
+  *deadline = (max_time > TimeDelta() ? now + max_time : now).ToTimeSpec();
+}
+
+}  // namespace
+
+ConditionVariable::ConditionVariable(Lock* user_lock)
+    : sequence_(0),
+      waiters_(0),
+      user_lock_(user_lock) {
+}
+
+ConditionVariable::~ConditionVariable() {
+//  DCHECK_EQ(0, waiters_);
+}
+
+void ConditionVariable::Wait() {
+  int32 sequence = sequence_;
+  __sync_fetch_and_add(&waiters_, 1);
+#if !defined(NDEBUG)
+  user_lock_->CheckHeldAndUnmark();
+#endif
+#if defined(ENABLE_LOCK_PROFILING)
+  // The wait ends the hold.
+  user_lock_->profile_.RecordRelease();
+#endif
+  user_lock_->lock_.Unlock();
+
+  internal::FutexWait(&sequence_, sequence);
+
+  __sync_fetch_and_sub(&waiters_, 1);
+  user_lock_->lock_.LockContended();
+#if !defined(NDEBUG)
+  user_lock_->CheckUnheldAndMark();
+#endif
+}
+
+bool ConditionVariable::TimedWait(int max_time_ms) {
+  return TimedWait(TimeDelta::FromMilliseconds(max_time_ms));
+}
+
+bool ConditionVariable::TimedWait(const TimeDelta& max_time) {
+  struct timespec deadline;
+  GetDeadline(max_time, &deadline);
+
+  int32 sequence = sequence_;
+  __sync_fetch_and_add(&waiters_, 1);
+#if !defined(NDEBUG)
+  user_lock_->CheckHeldAndUnmark();
+#endif
+#if defined(ENABLE_LOCK_PROFILING)
+  // The wait ends the hold.
+  user_lock_->profile_.RecordRelease();
+#endif
+  user_lock_->lock_.Unlock();
+
+  int rv = internal::FutexWaitUntil(&sequence_, sequence, &deadline);
+  bool timed_out = rv != 0 && errno == ETIMEDOUT;
+
+  __sync_fetch_and_sub(&waiters_, 1);
+  user_lock_->lock_.LockContended();
+#if !defined(NDEBUG)
+  user_lock_->CheckUnheldAndMark();
+#endif
+  return !timed_out;
+}
+
+void ConditionVariable::Broadcast() {
+  // The increment is a full barrier, so a waiter that we do not count here
+  // must have read the old sequence number and will not go to sleep.
+  int32 sequence = __sync_add_and_fetch(&sequence_, 1);
+  if (waiters_ == 0)
+    return;
+  if (internal::FutexCmpRequeue(&sequence_, sequence, 1, INT_MAX,
+                                user_lock_->lock_.os_lock()) < 0) {
+    // Raced with another Signal()/Broadcast(); fall back to waking everyone.
+    internal::FutexWake(&sequence_, INT_MAX);
+  }
+}
+
+void ConditionVariable::Signal() {
+  __sync_add_and_fetch(&sequence_, 1);
+  if (waiters_ == 0)
+    return;
+  internal::FutexWake(&sequence_, 1);
+}
+
+}  // namespace platform
@@ -0,0 +1,106 @@
+// Copyright (c) 2010 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+// Taken from Chromium: src/base/condition_variable_posix.cc
+// Significant changes (other than naming):
+//  - see condition_variable.h
+
+#include "simple-platform-lib/src/condition_variable.h"
+
+#include <errno.h>
+#include <time.h>
+
+//FIXME
+//#include "base/logging.h"
+
+namespace platform {
+
+ConditionVariable::ConditionVariable(Lock* user_lock)
+    : user_mutex_(user_lock->lock_.os_lock())
+#if !defined(NDEBUG)
+    , user_lock_(user_lock)
+#endif
+{
+#if defined(OS_MACOSX)
+  // Mac OS X has no pthread_condattr_setclock(); TimedWait() uses
+  // pthread_cond_timedwait_relative_np() instead.
+  int rv = pthread_cond_init(&condition_, NULL);
+#else
+  pthread_condattr_t attrs;
+  int rv = pthread_condattr_init(&attrs);
+//  DCHECK_EQ(0, rv);
+  pthread_condattr_setclock(&attrs, CLOCK_MONOTONIC);
+  rv = pthread_cond_init(&condition_, &attrs);
+  pthread_condattr_destroy(&attrs);
+#endif
+//  DCHECK_EQ(0, rv);
+(void)rv;
+}
+
+ConditionVariable::~ConditionVariable() {
+  int rv = pthread_cond_destroy(&condition_);
+//  DCHECK_EQ(0, rv);
+(void)rv;
+}
+
+void ConditionVariable::Wait() {
+#if !defined(NDEBUG)
+  user_lock_->CheckHeldAndUnmark();
+#endif
+#if defined(ENABLE_LOCK_PROFILING)
+  // The wait ends the hold.
+  user_lock_->profile_.RecordRelease();
+#endif
+  int rv = pthread_cond_wait(&condition_, user_mutex_);
+//  DCHECK_EQ(0, rv);
+(void)rv;
+#if !defined(NDEBUG)
+  user_lock_->CheckUnheldAndMark();
+#endif
+}
+
+bool ConditionVariable::TimedWait(int max_time_ms) {
+  return TimedWait(TimeDelta::FromMilliseconds(max_time_ms));
+}
+
+bool ConditionVariable::TimedWait(const TimeDelta& max_time) {
+#if !defined(NDEBUG)
+  user_lock_->CheckHeldAndUnmark();
+#endif
+#if defined(ENABLE_LOCK_PROFILING)
+  // The wait ends the hold.
+  user_lock_->profile_.RecordRelease();
+#endif
+
+#if defined(OS_MACOSX)
+  struct timespec relative_time = max_time.ToTimeSpec();
+  int rv = pthread_cond_timedwait_relative_np(&condition_, user_mutex_,
+                                              &relative_time);
+#else
+  TimeTicks now = TimeTicks::Now();
+  struct timespec absolute_time =
+      (max_time > TimeDelta() ? now + max_time : now).ToTimeSpec();
+  int rv = pthread_cond_timedwait(&condition_, user_mutex_, &absolute_time);
+#endif
+//  DCHECK(rv == 0 || rv == ETIMEDOUT);
+
+#if !defined(NDEBUG)
+  user_lock_->CheckUnheldAndMark();
+#endif
+  return rv != ETIMEDOUT;
+}
+
+void ConditionVariable::Broadcast() {
+  int rv = pthread_cond_broadcast(&condition_);
+//  DCHECK_EQ(0, rv);
+(void)rv;
+}
+
+void ConditionVariable::Signal() {
+  int rv = pthread_cond_signal(&condition_);
+//  DCHECK_EQ(0, rv);
+(void)rv;
+}
+
+}  // namespace platform
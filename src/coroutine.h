@@ -0,0 +1,596 @@
+// Copyright (c) 2010 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+// C++20 coroutines on the platform primitives, for writing asynchronous code
+// such as request handlers as straight-line code:
+//
+//   CoroutineTask<Response> HandleRequest(Request request) {
+//     co_await ScheduleOn(&pool);                  // Continue on |pool|.
+//     co_await state_lock.Acquire();               // Suspends, not blocks.
+//     ...
+//     state_lock.Release();
+//     co_await AsyncSleep(&timers, TimeDelta::FromMilliseconds(10), &pool);
+//     Response response = co_await Lookup(request);  // Another coroutine.
+//     co_return response;
+//   }
+//
+//   Spawn(&pool, Serve(connection));           // Fire and forget, or
+//   Response response = SyncWait(HandleRequest(request));  // block on it.
+//
+// CoroutineTask<T> is lazy: the coroutine starts when it is co_awaited, and
+// resumes its awaiter directly when it finishes (symmetric transfer), so
+// awaiting a coroutine that completes synchronously costs a pair of calls.
+// Clang, and GCC when optimizing (-O2), make the transfer a tail call, so
+// loops awaiting such coroutines do not grow the stack either.  Each task
+// must be awaited, or passed to SyncWait() or Spawn(), at most once, and
+// must not be empty (default-constructed or moved from) when it is.
+//
+// ScheduleOn() continues the coroutine as a Task on an Executor (see
+// executor.h).  AsyncLock is a mutual exclusion lock that suspends the
+// coroutines waiting for it instead of their threads.  AsyncSleep() and
+// AsyncSleepUntil() suspend on a TimerThread (see timer_thread.h).
+//
+// Coroutine frames are allocated from per-thread free lists of recently
+// freed frames, so calling a coroutine does not usually go to malloc.
+//
+// The library does not use exceptions: an exception escaping a coroutine
+// terminates the program.
+//
+// Only available when the compiler supports coroutines (C++20); otherwise
+// this header declares nothing.  Build with enable_cxx20=1 (see
+// simple_platform.gyp) to compile with -std=c++20.
+
+#ifndef SIMPLEPLATFORMLIB_SRC_COROUTINE_H_
+#define SIMPLEPLATFORMLIB_SRC_COROUTINE_H_
+#pragma once
+
+#if defined(__cpp_impl_coroutine)
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+#include <coroutine>
+#include <exception>
+#include <optional>
+#include <type_traits>
+#include <utility>
+
+#include "simple-platform-lib/src/atomics.h"
+#include "simple-platform-lib/src/basictypes.h"
+#include "simple-platform-lib/src/condition_variable.h"
+#include "simple-platform-lib/src/executor.h"
+#include "simple-platform-lib/src/lock.h"
+#include "simple-platform-lib/src/task.h"
+#include "simple-platform-lib/src/time.h"
+#include "simple-platform-lib/src/timer_thread.h"
+#include "simple-platform-lib/src/timer_wheel.h"
+
+namespace platform {
+
+template <typename T> class CoroutineTask;
+
+namespace internal {
+
+// Caches freed coroutine frames per thread, in size classes of 64 bytes up
+// to 1 KB.  A frame freed on another thread than it was allocated on goes
+// to that thread's cache.  Larger frames, and frames beyond the cache's
+// capacity, go to malloc.
+class CoroutineFrameAllocator {
+ public:
+  static void* Allocate(size_t size) {
+    size_t size_class = SizeClass(size);
+    if (size_class < kSizeClasses) {
+      Cache* cache = GetCache();
+      FreeFrame* frame = cache->frames[size_class];
+      if (frame) {
+        cache->frames[size_class] = frame->next;
+        cache->counts[size_class]--;
+        return frame;
+      }
+      size = (size_class + 1) * kSizeClassBytes;
+    }
+    void* frame = malloc(size);
+    if (!frame)
+      abort();
+    return frame;
+  }
+
+  static void Free(void* frame, size_t size) {
+    size_t size_class = SizeClass(size);
+    if (size_class < kSizeClasses) {
+      Cache* cache = GetCache();
+      if (cache->counts[size_class] < kMaxCachedFrames) {
+        FreeFrame* free_frame = static_cast<FreeFrame*>(frame);
+        free_frame->next = cache->frames[size_class];
+        cache->frames[size_class] = free_frame;
+        cache->counts[size_class]++;
+        return;
+      }
+    }
+    free(frame);
+  }
+
+ private:
+  static const size_t kSizeClassBytes = 64;
+  static const size_t kSizeClasses = 16;
+  static const int kMaxCachedFrames = 256;
+
+  struct FreeFrame {
+    FreeFrame* next;
+  };
+
+  struct Cache {
+    Cache() {
+      for (size_t i = 0; i < kSizeClasses; i++) {
+        frames[i] = NULL;
+        counts[i] = 0;
+      }
+    }
+
+    ~Cache() {
+      for (size_t i = 0; i < kSizeClasses; i++) {
+        while (frames[i]) {
+          FreeFrame* frame = frames[i];
+          frames[i] = frame->next;
+          free(frame);
+        }
+      }
+    }
+
+    FreeFrame* frames[kSizeClasses];
+    int counts[kSizeClasses];
+  };
+
+  static size_t SizeClass(size_t size) {
+    return (size - 1) / kSizeClassBytes;
+  }
+
+  static Cache* GetCache() {
+    static thread_local Cache cache;
+    return &cache;
+  }
+};
+
+// Resumes a coroutine as a Task, e.g. on an Executor.
+class ResumeTask : public platform::Task {
+ public:
+  explicit ResumeTask(std::coroutine_handle<> handle) : handle_(handle) {}
+
+  virtual void Run() {
+    handle_.resume();
+  }
+
+ private:
+  std::coroutine_handle<> handle_;
+
+  DISALLOW_COPY_AND_ASSIGN(ResumeTask);
+};
+
+// Resumes the coroutine that awaited the one finishing, if any.
+struct FinalAwaiter {
+  bool await_ready() const noexcept { return false; }
+
+  template <typename Promise>
+  std::coroutine_handle<> await_suspend(
+      std::coroutine_handle<Promise> handle) noexcept {
+    std::coroutine_handle<> continuation = handle.promise().continuation;
+    if (continuation)
+      return continuation;
+    return std::noop_coroutine();
+  }
+
+  void await_resume() const noexcept {}
+};
+
+class CoroutinePromiseBase {
+ public:
+  static void* operator new(size_t size) {
+    return CoroutineFrameAllocator::Allocate(size);
+  }
+
+  static void operator delete(void* frame, size_t size) {
+    CoroutineFrameAllocator::Free(frame, size);
+  }
+
+  std::suspend_always initial_suspend() const noexcept { return {}; }
+  FinalAwaiter final_suspend() const noexcept { return {}; }
+  void unhandled_exception() const { std::terminate(); }
+
+  // The coroutine to resume once this one has finished.
+  std::coroutine_handle<> continuation;
+};
+
+template <typename T>
+class CoroutinePromise : public CoroutinePromiseBase {
+ public:
+  CoroutineTask<T> get_return_object();
+
+  void return_value(T value) {
+    value_.emplace(std::move(value));
+  }
+
+  T TakeValue() {
+    return std::move(*value_);
+  }
+
+ private:
+  std::optional<T> value_;
+};
+
+template <>
+class CoroutinePromise<void> : public CoroutinePromiseBase {
+ public:
+  CoroutineTask<void> get_return_object();
+
+  void return_void() const {}
+  void TakeValue() const {}
+};
+
+}  // namespace internal
+
+// A lazily started coroutine producing a T (or nothing, for void).
+template <typename T>
+class CoroutineTask {
+ public:
+  typedef internal::CoroutinePromise<T> promise_type;
+
+  CoroutineTask() {}
+
+  CoroutineTask(CoroutineTask&& other)
+      : handle_(std::exchange(other.handle_, {})) {}
+
+  CoroutineTask& operator=(CoroutineTask&& other) {
+    if (this != &other) {
+      if (handle_)
+        handle_.destroy();
+      handle_ = std::exchange(other.handle_, {});
+    }
+    return *this;
+  }
+
+  // Destroys the coroutine, which must not be running.
+  ~CoroutineTask() {
+    if (handle_)
+      handle_.destroy();
+  }
+
+  // Awaiting the task starts it, and resumes the awaiter with its result.
+  // An empty task (default-constructed or moved from) has no result, and
+  // awaiting one aborts.
+  bool await_ready() const {
+    if (!handle_)
+      abort();
+    return handle_.done();
+  }
+
+  std::coroutine_handle<> await_suspend(std::coroutine_handle<> awaiter) {
+    handle_.promise().continuation = awaiter;
+    return handle_;
+  }
+
+  T await_resume() {
+    return handle_.promise().TakeValue();
+  }
+
+ private:
+  friend class internal::CoroutinePromise<T>;
+
+  explicit CoroutineTask(std::coroutine_handle<promise_type> handle)
+      : handle_(handle) {}
+
+  std::coroutine_handle<promise_type> handle_;
+
+  DISALLOW_COPY_AND_ASSIGN(CoroutineTask);
+};
+
+namespace internal {
+
+template <typename T>
+CoroutineTask<T> CoroutinePromise<T>::get_return_object() {
+  return CoroutineTask<T>(
+      std::coroutine_handle<CoroutinePromise<T> >::from_promise(*this));
+}
+
+inline CoroutineTask<void> CoroutinePromise<void>::get_return_object() {
+  return CoroutineTask<void>(
+      std::coroutine_handle<CoroutinePromise<void> >::from_promise(*this));
+}
+
+// The coroutine behind SyncWait() and Spawn(): started explicitly, and
+// calls |on_done| from its final suspension point, after which whoever is
+// notified destroys it.
+class RootCoroutine {
+ public:
+  class promise_type;
+
+  class DoneAwaiter {
+   public:
+    bool await_ready() const noexcept { return false; }
+    void await_suspend(std::coroutine_handle<promise_type> handle) noexcept;
+    void await_resume() const noexcept {}
+  };
+
+  class promise_type : public CoroutinePromiseBase {
+   public:
+    promise_type() : on_done(NULL), on_done_arg(NULL) {}
+
+    RootCoroutine get_return_object() {
+      return RootCoroutine(
+          std::coroutine_handle<promise_type>::from_promise(*this));
+    }
+
+    DoneAwaiter final_suspend() const noexcept { return DoneAwaiter(); }
+    void return_void() const {}
+
+    // Called with the coroutine's handle and |on_done_arg|.
+    void (*on_done)(std::coroutine_handle<promise_type>, void*);
+    void* on_done_arg;
+  };
+
+  explicit RootCoroutine(std::coroutine_handle<promise_type> handle)
+      : handle(handle) {}
+
+  std::coroutine_handle<promise_type> handle;
+};
+
+inline void RootCoroutine::DoneAwaiter::await_suspend(
+    std::coroutine_handle<promise_type> handle) noexcept {
+  promise_type& promise = handle.promise();
+  promise.on_done(handle, promise.on_done_arg);
+}
+
+template <typename T, typename Result>
+RootCoroutine AwaitInto(CoroutineTask<T> task, Result* result) {
+  if constexpr (std::is_void<T>::value)
+    co_await task;
+  else
+    result->emplace(co_await task);
+}
+
+// What SyncWait() blocks on.
+class SyncWaitEvent {
+ public:
+  SyncWaitEvent() : done_(false), done_cv_(&lock_) {}
+
+  static void Signal(std::coroutine_handle<RootCoroutine::promise_type>,
+                     void* arg) {
+    SyncWaitEvent* event = static_cast<SyncWaitEvent*>(arg);
+    AutoLock auto_lock(event->lock_);
+    event->done_ = true;
+    event->done_cv_.Signal();
+  }
+
+  void Wait() {
+    AutoLock auto_lock(lock_);
+    while (!done_)
+      done_cv_.Wait();
+  }
+
+ private:
+  Lock lock_;
+  bool done_;
+  ConditionVariable done_cv_;
+
+  DISALLOW_COPY_AND_ASSIGN(SyncWaitEvent);
+};
+
+inline void DestroyCoroutine(
+    std::coroutine_handle<RootCoroutine::promise_type> handle, void*) {
+  handle.destroy();
+}
+
+}  // namespace internal
+
+// Runs |task| on the calling thread until it first suspends, then blocks
+// until it has finished, and returns its result.  Must not be called from a
+// coroutine, nor from a thread that the task needs in order to finish.
+template <typename T>
+T SyncWait(CoroutineTask<T> task) {
+  typedef typename std::conditional<std::is_void<T>::value, int, T>::type
+      Stored;
+  std::optional<Stored> result;
+  internal::SyncWaitEvent event;
+  internal::RootCoroutine root =
+      internal::AwaitInto(std::move(task), &result);
+  root.handle.promise().on_done = internal::SyncWaitEvent::Signal;
+  root.handle.promise().on_done_arg = &event;
+  root.handle.resume();
+  event.Wait();
+  root.handle.destroy();
+  if constexpr (!std::is_void<T>::value)
+    return std::move(*result);
+}
+
+// Starts |task| on |executor|, or on the calling thread if |executor| is
+// NULL, without waiting for it.  The task is destroyed once it finishes.
+inline void Spawn(Executor* executor, CoroutineTask<void> task) {
+  internal::RootCoroutine root =
+      internal::AwaitInto(std::move(task), static_cast<std::optional<int>*>(
+          NULL));
+  root.handle.promise().on_done = internal::DestroyCoroutine;
+  if (executor)
+    executor->Execute(new internal::ResumeTask(root.handle));
+  else
+    root.handle.resume();
+}
+
+// co_await ScheduleOn(executor) continues the coroutine on |executor|.  If
+// the executor deletes the task without running it (e.g. a ThreadPool that
+// has been shut down), the coroutine never resumes.
+class ScheduleOnAwaiter {
+ public:
+  explicit ScheduleOnAwaiter(Executor* executor) : executor_(executor) {}
+
+  bool await_ready() const { return false; }
+
+  void await_suspend(std::coroutine_handle<> handle) const {
+    executor_->Execute(new internal::ResumeTask(handle));
+  }
+
+  void await_resume() const {}
+
+ private:
+  Executor* executor_;
+};
+
+inline ScheduleOnAwaiter ScheduleOn(Executor* executor) {
+  return ScheduleOnAwaiter(executor);
+}
+
+// A lock for coroutines: co_await Acquire() suspends the coroutine until the
+// lock is free, rather than blocking its thread.  Release() resumes the
+// next waiter, in the order they suspended, on the releasing thread; the
+// waiter runs there until it suspends again, and then Release() returns.
+//
+// Acquiring a free lock and releasing a lock with no waiters each take one
+// compare-and-swap.  The state is a word that is either "unlocked",
+// "locked", or the waiters that arrived since the holder last looked,
+// pushed as a stack; the holder moves them into a queue of its own.
+class AsyncLock {
+ public:
+  class AcquireAwaiter {
+   public:
+    explicit AcquireAwaiter(AsyncLock* lock) : lock_(lock), next_(NULL) {}
+
+    bool await_ready() { return lock_->TryAcquire(); }
+
+    // Returns false, not suspending, if the lock was released meanwhile.
+    bool await_suspend(std::coroutine_handle<> handle) {
+      handle_ = handle;
+      return lock_->Enqueue(this);
+    }
+
+    void await_resume() const {}
+
+   private:
+    friend class AsyncLock;
+
+    AsyncLock* lock_;
+    std::coroutine_handle<> handle_;
+    AcquireAwaiter* next_;
+  };
+
+  AsyncLock() : state_(kUnlocked), waiters_(NULL) {}
+
+  // The lock must be free.
+  ~AsyncLock() {
+//    DCHECK(state_.Load(MEMORY_ORDER_RELAXED) == kUnlocked);
+  }
+
+  // co_await Acquire() returns with the lock held.
+  AcquireAwaiter Acquire() { return AcquireAwaiter(this); }
+
+  bool TryAcquire() {
+    intptr_t expected = kUnlocked;
+    return state_.CompareExchange(&expected, kLockedNoWaiters,
+                                  MEMORY_ORDER_ACQUIRE);
+  }
+
+  void Release() {
+    AcquireAwaiter* waiter = waiters_;
+    if (!waiter) {
+      intptr_t expected = kLockedNoWaiters;
+      if (state_.CompareExchange(&expected, kUnlocked, MEMORY_ORDER_RELEASE))
+        return;
+      // Take the waiters that arrived, and put them in arrival order.
+      intptr_t pushed =
+          state_.Exchange(kLockedNoWaiters, MEMORY_ORDER_ACQUIRE);
+      AcquireAwaiter* stack = reinterpret_cast<AcquireAwaiter*>(pushed);
+      while (stack) {
+        AcquireAwaiter* next = stack->next_;
+        stack->next_ = waiter;
+        waiter = stack;
+        stack = next;
+      }
+    }
+    // The lock passes to |waiter| without being unlocked.
+    waiters_ = waiter->next_;
+    waiter->handle_.resume();
+  }
+
+ private:
+  static const intptr_t kUnlocked = 1;
+  static const intptr_t kLockedNoWaiters = 0;
+
+  // Returns false if the lock was acquired instead.
+  bool Enqueue(AcquireAwaiter* waiter) {
+    intptr_t state = state_.Load(MEMORY_ORDER_ACQUIRE);
+    for (;;) {
+      if (state == kUnlocked) {
+        if (state_.CompareExchangeWeak(&state, kLockedNoWaiters,
+                                       MEMORY_ORDER_ACQUIRE)) {
+          return false;
+        }
+        continue;
+      }
+      waiter->next_ = state == kLockedNoWaiters ?
+          NULL : reinterpret_cast<AcquireAwaiter*>(state);
+      if (state_.CompareExchangeWeak(&state,
+                                     reinterpret_cast<intptr_t>(waiter),
+                                     MEMORY_ORDER_RELEASE)) {
+        return true;
+      }
+    }
+  }
+
+  Atomic<intptr_t> state_;
+  // Waiters in arrival order, only touched by the holder.
+  AcquireAwaiter* waiters_;
+
+  DISALLOW_COPY_AND_ASSIGN(AsyncLock);
+};
+
+// co_await AsyncSleepUntil(timer_thread, deadline, executor) suspends the
+// coroutine until |deadline|, then continues it on |executor|, or on the
+// timer thread (which must not be kept busy) if |executor| is NULL.  If the
+// timer thread is stopped first, or |executor| deletes the task without
+// running it, the coroutine never resumes, as with ScheduleOn().
+class SleepAwaiter : public Timer {
+ public:
+  SleepAwaiter(TimerThread* timer_thread, const TimeTicks& deadline,
+               Executor* executor)
+      : timer_thread_(timer_thread), deadline_(deadline),
+        executor_(executor) {}
+
+  bool await_ready() const { return deadline_ <= TimeTicks::Now(); }
+
+  void await_suspend(std::coroutine_handle<> handle) {
+    handle_ = handle;
+    timer_thread_->Schedule(this, deadline_);
+  }
+
+  void await_resume() const {}
+
+  virtual void OnExpired() {
+    if (executor_)
+      executor_->Execute(new internal::ResumeTask(handle_));
+    else
+      handle_.resume();
+  }
+
+ private:
+  TimerThread* timer_thread_;
+  TimeTicks deadline_;
+  Executor* executor_;
+  std::coroutine_handle<> handle_;
+};
+
+inline SleepAwaiter AsyncSleepUntil(TimerThread* timer_thread,
+                                    const TimeTicks& deadline,
+                                    Executor* executor = NULL) {
+  return SleepAwaiter(timer_thread, deadline, executor);
+}
+
+inline SleepAwaiter AsyncSleep(TimerThread* timer_thread,
+                               const TimeDelta& duration,
+                               Executor* executor = NULL) {
+  return SleepAwaiter(timer_thread, TimeTicks::Now() + duration, executor);
+}
+
+}  // namespace platform
+
+#endif  // defined(__cpp_impl_coroutine)
+
+#endif  // SIMPLEPLATFORMLIB_SRC_COROUTINE_H_
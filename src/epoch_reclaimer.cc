@@ -0,0 +1,233 @@
+// Copyright (c) 2010 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "simple-platform-lib/src/epoch_reclaimer.h"
+
+namespace platform {
+namespace internal {
+
+namespace {
+
+// Retired objects are kept by epoch modulo this; an epoch's list is free
+// to reuse once the epoch is two behind.
+const int kEpochLists = 3;
+
+// EpochRecord::state holds the thread's epoch shifted up by one, and
+// this bit while the thread is in a critical section.
+const uint64 kActive = 1;
+
+}  // namespace
+
+struct EpochRecord {
+  struct Retired {
+    void* object;
+    EpochReclaimer::Deleter deleter;
+  };
+
+  EpochRecord() : in_use(1), next(NULL), nesting(0), retired(0) {
+    for (int i = 0; i < kEpochLists; i++)
+      retired_epoch[i] = 0;
+  }
+
+  // Read by the threads that move the epoch on.
+  Atomic<uint64> state;
+  // Whether a thread owns the record.
+  Atomic<int> in_use;
+  EpochRecord* next;
+
+  // The rest is only touched by the owning thread.
+  int nesting;
+  // Retirements since the last Collect().
+  int retired;
+  std::vector<Retired> retired_objects[kEpochLists];
+  uint64 retired_epoch[kEpochLists];
+};
+
+}  // namespace internal
+
+using internal::EpochRecord;
+using internal::kActive;
+using internal::kEpochLists;
+
+EpochReclaimer::ThreadEntry::~ThreadEntry() {
+  if (record)
+    owner->ReleaseRecord(record);
+}
+
+// The epoch starts past kEpochLists, so that the lists of a new record,
+// marked epoch 0, read as old enough to reuse.
+EpochReclaimer::EpochReclaimer()
+    : epoch_(kEpochLists),
+      records_(NULL),
+      pending_(0),
+      orphans_lock_("EpochReclaimer::orphans_lock_") {
+}
+
+EpochReclaimer::~EpochReclaimer() {
+  ThreadEntry* entry = entries_.GetIfExists();
+  if (entry && entry->record) {
+    ReleaseRecord(entry->record);
+    entry->record = NULL;
+  }
+  for (size_t i = 0; i < orphans_.size(); i++)
+    orphans_[i].deleter(orphans_[i].object);
+  EpochRecord* record = records_.Load(MEMORY_ORDER_ACQUIRE);
+  while (record) {
+    EpochRecord* next = record->next;
+    delete record;
+    record = next;
+  }
+}
+
+// static
+EpochReclaimer* EpochReclaimer::GetDefault() {
+  static EpochReclaimer* reclaimer = new EpochReclaimer;
+  return reclaimer;
+}
+
+void EpochReclaimer::Enter() {
+  EpochRecord* record = GetRecord();
+  if (record->nesting++ > 0)
+    return;
+  // The exchange keeps the loads of the critical section after the
+  // announcement, where TryAdvance() will see it.
+  uint64 epoch = epoch_.Load(MEMORY_ORDER_SEQ_CST);
+  record->state.Exchange((epoch << 1) | kActive, MEMORY_ORDER_SEQ_CST);
+}
+
+void EpochReclaimer::Exit() {
+  EpochRecord* record = GetRecord();
+//  DCHECK_GT(record->nesting, 0);
+  if (--record->nesting > 0)
+    return;
+  record->state.Store(record->state.Load(MEMORY_ORDER_RELAXED) & ~kActive,
+                      MEMORY_ORDER_RELEASE);
+}
+
+void EpochReclaimer::Retire(void* object, Deleter deleter) {
+  EpochRecord* record = GetRecord();
+  // Read after |object| was unlinked: a reader that can still reach it
+  // entered in this epoch or before.
+  uint64 epoch = epoch_.Load(MEMORY_ORDER_SEQ_CST);
+  int list = static_cast<int>(epoch % kEpochLists);
+  if (record->retired_epoch[list] != epoch) {
+    // What is there is from epoch - kEpochLists or before.
+    FreeRetired(record, list);
+    record->retired_epoch[list] = epoch;
+  }
+  EpochRecord::Retired retired = { object, deleter };
+  record->retired_objects[list].push_back(retired);
+  pending_.FetchAdd(1, MEMORY_ORDER_RELAXED);
+
+  if (++record->retired >= kRetireBatch)
+    Collect();
+}
+
+void EpochReclaimer::Collect() {
+  EpochRecord* record = GetRecord();
+  record->retired = 0;
+  // Safe in a critical section too: the epoch cannot get more than one
+  // past this thread's, so what is freed was unlinked before it entered.
+  TryAdvance();
+  uint64 epoch = epoch_.Load(MEMORY_ORDER_ACQUIRE);
+  for (int i = 0; i < kEpochLists; i++) {
+    if (record->retired_epoch[i] + 2 <= epoch)
+      FreeRetired(record, i);
+  }
+  FreeOrphans(epoch);
+}
+
+EpochRecord* EpochReclaimer::GetRecord() {
+  ThreadEntry* entry = entries_.Get();
+  if (!entry->record) {
+    entry->owner = this;
+    entry->record = AcquireRecord();
+  }
+  return entry->record;
+}
+
+EpochRecord* EpochReclaimer::AcquireRecord() {
+  for (EpochRecord* record = records_.Load(MEMORY_ORDER_ACQUIRE); record;
+       record = record->next) {
+    int free = 0;
+    if (record->in_use.Load(MEMORY_ORDER_RELAXED) == 0 &&
+        record->in_use.CompareExchange(&free, 1, MEMORY_ORDER_ACQUIRE)) {
+      return record;
+    }
+  }
+
+  EpochRecord* record = new EpochRecord;
+  EpochRecord* head = records_.Load(MEMORY_ORDER_RELAXED);
+  do {
+    record->next = head;
+  } while (!records_.CompareExchangeWeak(&head, record, MEMORY_ORDER_RELEASE,
+                                         MEMORY_ORDER_RELAXED));
+  return record;
+}
+
+void EpochReclaimer::ReleaseRecord(EpochRecord* record) {
+//  DCHECK_EQ(0, record->nesting);
+  {
+    AutoLock auto_lock(orphans_lock_);
+    for (int i = 0; i < kEpochLists; i++) {
+      std::vector<EpochRecord::Retired>& retired = record->retired_objects[i];
+      for (size_t j = 0; j < retired.size(); j++) {
+        Orphan orphan = { record->retired_epoch[i], retired[j].object,
+                          retired[j].deleter };
+        orphans_.push_back(orphan);
+      }
+      retired.clear();
+      record->retired_epoch[i] = 0;
+    }
+  }
+  record->retired = 0;
+  record->state.Store(0, MEMORY_ORDER_RELAXED);
+  record->in_use.Store(0, MEMORY_ORDER_RELEASE);
+}
+
+void EpochReclaimer::TryAdvance() {
+  uint64 epoch = epoch_.Load(MEMORY_ORDER_SEQ_CST);
+  for (EpochRecord* record = records_.Load(MEMORY_ORDER_ACQUIRE); record;
+       record = record->next) {
+    uint64 state = record->state.Load(MEMORY_ORDER_SEQ_CST);
+    if ((state & kActive) && (state >> 1) != epoch)
+      return;
+  }
+  // Losing the race means another thread moved it on.
+  epoch_.CompareExchange(&epoch, epoch + 1, MEMORY_ORDER_SEQ_CST);
+}
+
+void EpochReclaimer::FreeRetired(EpochRecord* record, int list) {
+  std::vector<EpochRecord::Retired>& retired = record->retired_objects[list];
+  if (retired.empty())
+    return;
+  for (size_t i = 0; i < retired.size(); i++)
+    retired[i].deleter(retired[i].object);
+  pending_.FetchSub(static_cast<int64>(retired.size()),
+                    MEMORY_ORDER_RELAXED);
+  retired.clear();
+}
+
+void EpochReclaimer::FreeOrphans(uint64 epoch) {
+  std::vector<Orphan> safe;
+  {
+    AutoLock auto_lock(orphans_lock_);
+    if (orphans_.empty())
+      return;
+    size_t kept = 0;
+    for (size_t i = 0; i < orphans_.size(); i++) {
+      if (orphans_[i].epoch + 2 <= epoch)
+        safe.push_back(orphans_[i]);
+      else
+        orphans_[kept++] = orphans_[i];
+    }
+    orphans_.resize(kept);
+  }
+  // Outside the lock, which deleters have no business holding up.
+  for (size_t i = 0; i < safe.size(); i++)
+    safe[i].deleter(safe[i].object);
+  pending_.FetchSub(static_cast<int64>(safe.size()), MEMORY_ORDER_RELAXED);
+}
+
+}  // namespace platform
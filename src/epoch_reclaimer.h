@@ -0,0 +1,168 @@
+// Copyright (c) 2010 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+// EpochReclaimer frees the nodes of lock-free data structures once no
+// thread can still be reading them, by epoch-based reclamation (Fraser,
+// "Practical lock-freedom", 2004):
+//
+//   EpochReclaimer* reclaimer = EpochReclaimer::GetDefault();
+//
+//   {  // Reader.
+//     AutoEpoch auto_epoch(reclaimer);
+//     Node* node = head_.Load(MEMORY_ORDER_ACQUIRE);
+//     ...  // |node| stays valid until |auto_epoch| goes.
+//   }
+//
+//   // Writer, having unlinked |old_node| so that no new reader finds it.
+//   reclaimer->Retire(old_node);  // Deleted later.
+//
+// A global epoch counts up.  A thread in a critical section (between
+// Enter() and Exit(), which AutoEpoch pairs) announces the epoch it saw on
+// entering, and the epoch only moves on once every thread in a critical
+// section has seen the current one.  An object retired in epoch e was
+// unlinked before any reader that entered after e; by the time the epoch
+// reaches e + 2, every reader from e or before has left, and the object
+// can go.
+//
+// Retired objects wait in per-thread lists, one per epoch, and every
+// kRetireBatch retirements a thread tries to move the epoch on and frees
+// what has become safe; so the cost of a retirement is a push_back, and
+// that of a critical section an atomic exchange on entering and a store on
+// leaving.  A thread that stays in a critical section holds every retired
+// object back, so critical sections should be short, and must not block.
+//
+// Threads, including those made by Thread::Create(), join a reclaimer the
+// first time they use it, and leave it when they exit (see thread_local.h);
+// objects a thread retired and that are not safe to free yet are then left
+// for the other threads' Collect()s.
+
+#ifndef SIMPLEPLATFORMLIB_SRC_EPOCH_RECLAIMER_H_
+#define SIMPLEPLATFORMLIB_SRC_EPOCH_RECLAIMER_H_
+#pragma once
+
+#include <vector>
+
+#include "simple-platform-lib/src/atomics.h"
+#include "simple-platform-lib/src/basictypes.h"
+#include "simple-platform-lib/src/lock.h"
+#include "simple-platform-lib/src/thread_local.h"
+
+namespace platform {
+
+namespace internal {
+struct EpochRecord;
+}  // namespace internal
+
+class EpochReclaimer {
+ public:
+  typedef void (*Deleter)(void* object);
+
+  // Retire() calls Collect() once per this many retirements on a thread.
+  static const int kRetireBatch = 64;
+
+  EpochReclaimer();
+
+  // Frees every object still retired.  No thread may be in a critical
+  // section, and every other thread that used the reclaimer must have
+  // exited.
+  ~EpochReclaimer();
+
+  // A process-wide reclaimer, never destroyed.
+  static EpochReclaimer* GetDefault();
+
+  // Starts and ends a critical section.  They nest.  Prefer AutoEpoch.
+  void Enter();
+  void Exit();
+
+  // Calls |deleter|(|object|) once no critical section that may have seen
+  // |object| remains.  |object| must be unreachable for new readers
+  // already.  May be called in a critical section or not, but not from a
+  // deleter.
+  void Retire(void* object, Deleter deleter);
+
+  template <typename T>
+  void Retire(T* object) {
+    Retire(object, &DeleteObject<T>);
+  }
+
+  // Moves the epoch on if every thread in a critical section has caught
+  // up, then frees the calling thread's retired objects, and those left by
+  // exited threads, that have become safe.  May be called in a critical
+  // section or not.
+  void Collect();
+
+  // The number of objects retired and not freed yet.
+  int64 pending() const { return pending_.Load(MEMORY_ORDER_RELAXED); }
+
+ private:
+  // The calling thread's membership.
+  struct ThreadEntry {
+    ThreadEntry() : owner(NULL), record(NULL) {}
+    // Leaves |owner|.
+    ~ThreadEntry();
+
+    EpochReclaimer* owner;
+    internal::EpochRecord* record;
+  };
+
+  // An object retired by a thread that has since exited.
+  struct Orphan {
+    uint64 epoch;
+    void* object;
+    Deleter deleter;
+  };
+
+  template <typename T>
+  static void DeleteObject(void* object) {
+    delete static_cast<T*>(object);
+  }
+
+  // The calling thread's record, joining if need be.
+  internal::EpochRecord* GetRecord();
+  // Takes a record left by an exited thread, or adds a new one.
+  internal::EpochRecord* AcquireRecord();
+  // Hands |record|'s retired objects over as orphans, and frees it for
+  // another thread.
+  void ReleaseRecord(internal::EpochRecord* record);
+
+  // Moves the epoch on if it can.
+  void TryAdvance();
+  // Frees |record|'s retired objects from its |bucket|'th list.
+  void FreeRetired(internal::EpochRecord* record, int bucket);
+  // Frees the orphans retired before |epoch| - 1.
+  void FreeOrphans(uint64 epoch);
+
+  Atomic<uint64> epoch_;
+  // Every thread record there has been, newest first; records are reused,
+  // never unlinked.
+  Atomic<internal::EpochRecord*> records_;
+  Atomic<int64> pending_;
+
+  Lock orphans_lock_;
+  std::vector<Orphan> orphans_;  // Protected by |orphans_lock_|.
+
+  ThreadLocal<ThreadEntry> entries_;
+
+  DISALLOW_COPY_AND_ASSIGN(EpochReclaimer);
+};
+
+class AutoEpoch {
+ public:
+  explicit AutoEpoch(EpochReclaimer* reclaimer) : reclaimer_(reclaimer) {
+    reclaimer_->Enter();
+  }
+
+  ~AutoEpoch() {
+    reclaimer_->Exit();
+  }
+
+ private:
+  EpochReclaimer* reclaimer_;
+
+  DISALLOW_COPY_AND_ASSIGN(AutoEpoch);
+};
+
+}  // namespace platform
+
+#endif  // SIMPLEPLATFORMLIB_SRC_EPOCH_RECLAIMER_H_
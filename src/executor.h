@@ -0,0 +1,44 @@
+// Copyright (c) 2010 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+// An Executor runs Tasks somewhere: ThreadPool and WorkStealingScheduler are
+// Executors, so code that only needs its work run (such as Future::Then(),
+// see future.h) can take either.
+
+#ifndef SIMPLEPLATFORMLIB_SRC_EXECUTOR_H_
+#define SIMPLEPLATFORMLIB_SRC_EXECUTOR_H_
+#pragma once
+
+#include "simple-platform-lib/src/basictypes.h"
+#include "simple-platform-lib/src/task.h"
+
+namespace platform {
+
+class Executor {
+ public:
+  virtual ~Executor() {}
+
+  // Runs |task|, now or later, on whatever thread the executor uses, and
+  // takes ownership of it.  An executor that can no longer run tasks (e.g.
+  // a ThreadPool that has been shut down) deletes |task| without running it.
+  virtual void Execute(Task* task) = 0;
+};
+
+// Runs each task right away, on the calling thread.
+class InlineExecutor : public Executor {
+ public:
+  InlineExecutor() {}
+
+  virtual void Execute(Task* task) {
+    task->Run();
+    delete task;
+  }
+
+ private:
+  DISALLOW_COPY_AND_ASSIGN(InlineExecutor);
+};
+
+}  // namespace platform
+
+#endif  // SIMPLEPLATFORMLIB_SRC_EXECUTOR_H_
@@ -0,0 +1,343 @@
+// Copyright (c) 2010 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "simple-platform-lib/src/fiber.h"
+
+#include "simple-platform-lib/src/fiber_context.h"
+#include "simple-platform-lib/src/sys_info.h"
+#include "simple-platform-lib/src/timer_wheel.h"
+
+namespace platform {
+
+namespace {
+
+// The Worker running on the current thread, if any.  A void* because Worker
+// is private to FiberScheduler.
+__thread void* g_current_worker = NULL;
+
+// Freed stacks kept for new fibers.
+const size_t kMaxCachedStacks = 1024;
+
+}  // namespace
+
+namespace internal {
+
+// A fiber: its context and stack, and the links its waits need.  It is the
+// timer that wakes it from Fiber::SleepUntil().
+struct FiberRecord : public Timer {
+  FiberRecord(FiberScheduler* scheduler, Task* task)
+      : scheduler(scheduler),
+        task(task),
+        context(NULL),
+        next_waiter(NULL) {}
+
+  virtual void OnExpired() {
+    scheduler->MakeRunnable(this);
+  }
+
+  FiberScheduler* scheduler;
+  Task* task;
+  Stack stack;
+  // The fiber's stack pointer while it is switched away.
+  void* context;
+  // The next fiber waiting for the same FiberLock.
+  FiberRecord* next_waiter;
+  TimeTicks wakeup_time;
+};
+
+}  // namespace internal
+
+using internal::FiberRecord;
+
+class FiberScheduler::Worker : public Thread::Delegate {
+ public:
+  explicit Worker(FiberScheduler* scheduler)
+      : context(NULL),
+        current(NULL),
+        after_switch(REQUEUE),
+        unlock(NULL),
+        scheduler_(scheduler) {}
+
+  virtual void ThreadMain() {
+    g_current_worker = this;
+    scheduler_->Run(this);
+    g_current_worker = NULL;
+  }
+
+  // The worker's own stack pointer while a fiber runs.
+  void* context;
+  // The fiber running on the worker, or NULL.
+  FiberRecord* current;
+  // Set by the fiber just before it switches back to the worker.
+  AfterSwitch after_switch;
+  Lock* unlock;
+
+ private:
+  FiberScheduler* scheduler_;
+
+  DISALLOW_COPY_AND_ASSIGN(Worker);
+};
+
+FiberScheduler::FiberScheduler(int num_threads, size_t stack_size)
+    : num_threads_(num_threads > 0 ? num_threads :
+                                     SysInfo::NumberOfProcessors()),
+      stack_pool_(stack_size > 0 ? stack_size : kDefaultStackSize,
+                  kMaxCachedStacks),
+      timer_thread_(TimeDelta::FromMilliseconds(1)),
+      lock_("FiberScheduler::lock_"),
+      work_available_(&lock_),
+      idle_(&lock_),
+      live_fibers_(0),
+      stopping_(false),
+      shut_down_(false) {
+}
+
+FiberScheduler::~FiberScheduler() {
+  if (!shut_down_)
+    Shutdown();
+}
+
+bool FiberScheduler::Start() {
+  bool ok = timer_thread_.Start();
+  for (int i = 0; i < num_threads_; i++) {
+    Worker* worker = new Worker(this);
+    ThreadHandle handle;
+    if (!Thread::Create(0, worker, &handle)) {
+      delete worker;
+      ok = false;
+      continue;
+    }
+    workers_.push_back(worker);
+    handles_.push_back(handle);
+  }
+  return ok;
+}
+
+bool FiberScheduler::Spawn(Task* task) {
+  FiberRecord* fiber = new FiberRecord(this, task);
+  if (!stack_pool_.Allocate(&fiber->stack)) {
+    delete fiber;
+    delete task;
+    return false;
+  }
+  fiber->context = MakeFiberContext(fiber->stack.base, fiber->stack.size,
+                                    &FiberScheduler::FiberMain, fiber);
+
+  AutoLock auto_lock(lock_);
+  live_fibers_++;
+  run_queue_.push_back(fiber);
+  work_available_.Signal();
+  return true;
+}
+
+void FiberScheduler::WaitForIdle() {
+  AutoLock auto_lock(lock_);
+  while (live_fibers_ > 0)
+    idle_.Wait();
+}
+
+void FiberScheduler::Shutdown() {
+//  DCHECK(!shut_down_);
+  // With no workers (never started, or none could be created), nothing
+  // would run the fibers still queued, and waiting for them would never
+  // return; they are dropped instead.  None of them has run, so none is
+  // parked or sleeping.
+  std::deque<FiberRecord*> dropped;
+  if (handles_.empty()) {
+    AutoLock auto_lock(lock_);
+    dropped.swap(run_queue_);
+    live_fibers_ -= static_cast<int>(dropped.size());
+  }
+  for (size_t i = 0; i < dropped.size(); i++) {
+    FiberRecord* fiber = dropped[i];
+    delete fiber->task;
+    stack_pool_.Free(fiber->stack);
+    delete fiber;
+  }
+
+  WaitForIdle();
+  {
+    AutoLock auto_lock(lock_);
+    stopping_ = true;
+    work_available_.Broadcast();
+  }
+  for (size_t i = 0; i < handles_.size(); i++) {
+    Thread::Join(handles_[i]);
+    delete workers_[i];
+  }
+  workers_.clear();
+  handles_.clear();
+  timer_thread_.Stop();
+  shut_down_ = true;
+}
+
+// Not inlined: a fiber may resume on another thread, so the thread-local
+// must be read afresh on every call rather than from an address the
+// compiler computed before a switch.
+// static
+__attribute__((noinline)) FiberRecord* FiberScheduler::CurrentFiber() {
+  Worker* worker = static_cast<Worker*>(g_current_worker);
+  return worker ? worker->current : NULL;
+}
+
+// static
+void FiberScheduler::SwitchToWorker(AfterSwitch action, Lock* unlock) {
+  Worker* worker = static_cast<Worker*>(g_current_worker);
+  FiberRecord* fiber = worker->current;
+  worker->after_switch = action;
+  worker->unlock = unlock;
+  SwitchFiberContext(&fiber->context, worker->context);
+  // |worker| may not be this thread's worker any more.
+}
+
+void FiberScheduler::MakeRunnable(FiberRecord* fiber) {
+  AutoLock auto_lock(lock_);
+  run_queue_.push_back(fiber);
+  work_available_.Signal();
+}
+
+// static
+void FiberScheduler::FiberMain(void* arg) {
+  FiberRecord* fiber = static_cast<FiberRecord*>(arg);
+  fiber->task->Run();
+  delete fiber->task;
+  fiber->task = NULL;
+  SwitchToWorker(EXIT, NULL);
+}
+
+void FiberScheduler::Run(Worker* worker) {
+  for (;;) {
+    FiberRecord* fiber;
+    {
+      AutoLock auto_lock(lock_);
+      while (run_queue_.empty() && !stopping_)
+        work_available_.Wait();
+      if (run_queue_.empty())
+        return;
+      fiber = run_queue_.front();
+      run_queue_.pop_front();
+    }
+
+    worker->current = fiber;
+    SwitchFiberContext(&worker->context, fiber->context);
+    worker->current = NULL;
+
+    switch (worker->after_switch) {
+      case REQUEUE:
+        MakeRunnable(fiber);
+        break;
+      case PARK:
+        worker->unlock->Release();
+        break;
+      case SLEEP:
+        timer_thread_.Schedule(fiber, fiber->wakeup_time);
+        break;
+      case EXIT: {
+        stack_pool_.Free(fiber->stack);
+        delete fiber;
+        AutoLock auto_lock(lock_);
+        if (--live_fibers_ == 0)
+          idle_.Broadcast();
+        break;
+      }
+    }
+  }
+}
+
+namespace Fiber {
+
+bool IsInFiber() {
+  return FiberScheduler::CurrentFiber() != NULL;
+}
+
+void Yield() {
+  if (!FiberScheduler::CurrentFiber()) {
+    Thread::Yield();
+    return;
+  }
+  FiberScheduler::SwitchToWorker(FiberScheduler::REQUEUE, NULL);
+}
+
+void SleepUntil(const TimeTicks& deadline) {
+  FiberRecord* fiber = FiberScheduler::CurrentFiber();
+  if (!fiber) {
+    Thread::SleepUntil(deadline);
+    return;
+  }
+  if (deadline <= TimeTicks::Now())
+    return;
+  fiber->wakeup_time = deadline;
+  FiberScheduler::SwitchToWorker(FiberScheduler::SLEEP, NULL);
+}
+
+void Sleep(const TimeDelta& duration) {
+  SleepUntil(TimeTicks::Now() + duration);
+}
+
+}  // namespace Fiber
+
+FiberLock::FiberLock()
+    : lock_("FiberLock::lock_"),
+      held_(false),
+      first_waiter_(NULL),
+      last_waiter_(NULL) {
+}
+
+FiberLock::~FiberLock() {
+//  DCHECK(!held_);
+}
+
+void FiberLock::Acquire() {
+  lock_.Acquire();
+  if (!held_) {
+    held_ = true;
+    lock_.Release();
+    return;
+  }
+
+  FiberRecord* fiber = FiberScheduler::CurrentFiber();
+  if (!fiber) {
+    lock_.Release();
+    while (!Try())
+      Thread::Yield();
+    return;
+  }
+
+  fiber->next_waiter = NULL;
+  if (last_waiter_)
+    last_waiter_->next_waiter = fiber;
+  else
+    first_waiter_ = fiber;
+  last_waiter_ = fiber;
+  // The worker releases |lock_| once the fiber has switched away, and
+  // Release() hands the lock over with |held_| still set.
+  FiberScheduler::SwitchToWorker(FiberScheduler::PARK, &lock_);
+}
+
+void FiberLock::Release() {
+  FiberRecord* waiter;
+  {
+    AutoLock auto_lock(lock_);
+//    DCHECK(held_);
+    waiter = first_waiter_;
+    if (!waiter) {
+      held_ = false;
+      return;
+    }
+    first_waiter_ = waiter->next_waiter;
+    if (!first_waiter_)
+      last_waiter_ = NULL;
+  }
+  waiter->scheduler->MakeRunnable(waiter);
+}
+
+bool FiberLock::Try() {
+  AutoLock auto_lock(lock_);
+  if (held_)
+    return false;
+  held_ = true;
+  return true;
+}
+
+}  // namespace platform
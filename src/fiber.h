@@ -0,0 +1,211 @@
+// Copyright (c) 2010 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+// Fibers are threads scheduled in user mode: FiberScheduler runs any number
+// of them (M) on a fixed set of worker threads (N), switching between them
+// with fiber_context.h.  A fiber that waits for a FiberLock, sleeps or
+// yields gives its worker to the next runnable fiber instead of blocking the
+// thread, so tens of thousands of mostly-blocked sessions cost a small stack
+// each (see stack_pool.h) rather than a thread each.
+//
+//   FiberScheduler scheduler(0, 0);  // A worker per processor, 64 KB stacks.
+//   scheduler.Start();
+//   scheduler.Spawn(new SessionTask(connection));
+//   ...
+//
+//   void SessionTask::Run() {     // On a fiber.
+//     ...
+//     Fiber::Sleep(TimeDelta::FromMilliseconds(10));  // Yields the worker.
+//     AutoFiberLock auto_lock(sessions_lock_);
+//     ...
+//   }
+//
+//   scheduler.Shutdown();  // Once every fiber has finished.
+//
+// The runnable fibers wait in a single queue, first in first out, and a
+// fiber may resume on a different worker from the one it left.  Fibers are
+// not preemptive: a fiber that computes, or blocks in the kernel (including
+// on a plain Lock), holds up its worker, so fibers should wait with
+// FiberLock, Fiber::Sleep() and Fiber::Yield().  Thread-local storage
+// belongs to the worker, and so may change under a fiber across any of
+// those calls.
+
+#ifndef SIMPLEPLATFORMLIB_SRC_FIBER_H_
+#define SIMPLEPLATFORMLIB_SRC_FIBER_H_
+#pragma once
+
+#include <stddef.h>
+
+#include <deque>
+#include <vector>
+
+#include "simple-platform-lib/src/basictypes.h"
+#include "simple-platform-lib/src/condition_variable.h"
+#include "simple-platform-lib/src/lock.h"
+#include "simple-platform-lib/src/stack_pool.h"
+#include "simple-platform-lib/src/task.h"
+#include "simple-platform-lib/src/thread.h"
+#include "simple-platform-lib/src/time.h"
+#include "simple-platform-lib/src/timer_thread.h"
+
+namespace platform {
+
+namespace internal {
+struct FiberRecord;
+}  // namespace internal
+
+namespace Fiber {
+
+// Whether the calling code runs on a fiber.
+bool IsInFiber();
+
+// Lets the other runnable fibers run before the current one continues.  On
+// a thread that is not a fiber, yields the thread.
+void Yield();
+
+// Suspends the current fiber until TimeTicks::Now() reaches |deadline|,
+// giving up its worker meanwhile.  On a thread that is not a fiber, sleeps
+// the thread.
+void SleepUntil(const TimeTicks& deadline);
+void Sleep(const TimeDelta& duration);
+
+}  // namespace Fiber
+
+class FiberScheduler {
+ public:
+  // The stack size used when 0 is given.
+  static const size_t kDefaultStackSize = 64 * 1024;
+
+  // |num_threads| of 0 means one worker per processor.  Fibers get stacks of
+  // |stack_size| bytes, rounded up to pages; 0 means kDefaultStackSize.
+  FiberScheduler(int num_threads, size_t stack_size);
+
+  // Shuts down, if Shutdown() has not been called.
+  ~FiberScheduler();
+
+  // Starts the workers.  Returns false if any of them could not be created,
+  // in which case the scheduler runs on those that could (if any).
+  bool Start();
+
+  // Runs |task| on a new fiber, then deletes it.  May be called from any
+  // thread, including fibers, before or after Start().  Returns false, and
+  // deletes |task|, if no stack could be allocated.
+  bool Spawn(Task* task);
+
+  // Blocks until every fiber has finished, which never happens if the
+  // scheduler has no workers.  Must not be called from a fiber.
+  void WaitForIdle();
+
+  // Waits for every fiber to finish, then joins the workers.  If the
+  // scheduler has no workers (Start() was never called, or none could be
+  // created), the fibers spawned so far never run: their tasks are deleted
+  // without being run.  Must be called at most once, and not from a fiber.
+  void Shutdown();
+
+  int num_threads() const { return num_threads_; }
+
+ private:
+  friend class FiberLock;
+  friend struct internal::FiberRecord;
+  friend bool Fiber::IsInFiber();
+  friend void Fiber::Yield();
+  friend void Fiber::SleepUntil(const TimeTicks& deadline);
+  class Worker;
+
+  // What a fiber asks its worker to do once it has switched away.
+  enum AfterSwitch {
+    // Queue the fiber again.
+    REQUEUE,
+    // Nothing: someone holds on to the fiber and makes it runnable later.
+    // |unlock| is released, so that they cannot do so before the fiber has
+    // switched away.
+    PARK,
+    // Make the fiber runnable at its wakeup time.
+    SLEEP,
+    // Free the fiber.
+    EXIT,
+  };
+
+  // The fiber running on the current thread, or NULL.
+  static internal::FiberRecord* CurrentFiber();
+
+  // Switches from the current fiber to its worker, which then does |action|.
+  // Returns when the fiber is resumed, possibly on another worker.
+  static void SwitchToWorker(AfterSwitch action, Lock* unlock);
+
+  // Queues |fiber| to run.
+  void MakeRunnable(internal::FiberRecord* fiber);
+
+  static void FiberMain(void* arg);
+
+  // The body of each worker thread.
+  void Run(Worker* worker);
+
+  int num_threads_;
+  std::vector<Worker*> workers_;
+  std::vector<ThreadHandle> handles_;
+
+  StackPool stack_pool_;
+  // Wakes sleeping fibers.
+  TimerThread timer_thread_;
+
+  Lock lock_;
+  // Signaled when a fiber is queued, and broadcast on shutdown.
+  ConditionVariable work_available_;
+  // Broadcast when the last fiber finishes.
+  ConditionVariable idle_;
+
+  // The following are protected by |lock_|.
+  std::deque<internal::FiberRecord*> run_queue_;
+  int live_fibers_;
+  bool stopping_;
+  bool shut_down_;
+
+  DISALLOW_COPY_AND_ASSIGN(FiberScheduler);
+};
+
+// A lock for fibers: a fiber that has to wait for it gives up its worker
+// until the lock is handed to it, in the order the fibers started waiting.
+// Threads other than fibers may use it too, and wait by yielding the
+// thread.
+class FiberLock {
+ public:
+  FiberLock();
+  ~FiberLock();
+
+  void Acquire();
+  void Release();
+
+  // If the lock is free, takes it and returns true.
+  bool Try();
+
+ private:
+  Lock lock_;
+  // The following are protected by |lock_|.
+  bool held_;
+  internal::FiberRecord* first_waiter_;
+  internal::FiberRecord* last_waiter_;
+
+  DISALLOW_COPY_AND_ASSIGN(FiberLock);
+};
+
+class AutoFiberLock {
+ public:
+  explicit AutoFiberLock(FiberLock& lock) : lock_(lock) {
+    lock_.Acquire();
+  }
+
+  ~AutoFiberLock() {
+    lock_.Release();
+  }
+
+ private:
+  FiberLock& lock_;
+
+  DISALLOW_COPY_AND_ASSIGN(AutoFiberLock);
+};
+
+}  // namespace platform
+
+#endif  // SIMPLEPLATFORMLIB_SRC_FIBER_H_
@@ -0,0 +1,60 @@
+// Copyright (c) 2010 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "simple-platform-lib/src/fiber_context.h"
+
+#include <stdint.h>
+#include <string.h>
+
+#include "simple-platform-lib/src/basictypes.h"
+
+namespace platform {
+
+// The layouts below mirror what PlatformSwitchFiberContext() pops, lowest
+// address first, so that the first switch to the context "returns" into
+// PlatformFiberTrampoline() with the entry point and its argument in
+// callee-saved registers.
+
+#if defined(__x86_64__)
+
+void* MakeFiberContext(void* stack_base, size_t stack_size,
+                       FiberEntryPoint entry, void* arg) {
+  uintptr_t top = (reinterpret_cast<uintptr_t>(stack_base) + stack_size) &
+                  ~static_cast<uintptr_t>(15);
+  // The return address goes just below a 16-byte boundary, so that the
+  // trampoline's call leaves the stack aligned as the ABI requires.
+  uint64* sp = reinterpret_cast<uint64*>(top - 16);
+  *--sp = reinterpret_cast<uintptr_t>(&PlatformFiberTrampoline);
+  *--sp = 0;  // %rbp
+  *--sp = 0;  // %rbx
+  *--sp = reinterpret_cast<uintptr_t>(arg);    // %r12
+  *--sp = reinterpret_cast<uintptr_t>(entry);  // %r13
+  *--sp = 0;  // %r14
+  *--sp = 0;  // %r15
+  // MXCSR and the x87 control word, at their power-on defaults.
+  *--sp = GG_ULONGLONG(0x1f80) | (GG_ULONGLONG(0x037f) << 32);
+  return sp;
+}
+
+#elif defined(__aarch64__)
+
+void* MakeFiberContext(void* stack_base, size_t stack_size,
+                       FiberEntryPoint entry, void* arg) {
+  uintptr_t top = (reinterpret_cast<uintptr_t>(stack_base) + stack_size) &
+                  ~static_cast<uintptr_t>(15);
+  // x19-x28, x29 (frame pointer), x30 (link register), then d8-d15.
+  const size_t kFrameWords = 20;
+  uint64* sp = reinterpret_cast<uint64*>(top) - kFrameWords;
+  memset(sp, 0, kFrameWords * sizeof(*sp));
+  sp[0] = reinterpret_cast<uintptr_t>(arg);    // x19
+  sp[1] = reinterpret_cast<uintptr_t>(entry);  // x20
+  sp[11] = reinterpret_cast<uintptr_t>(&PlatformFiberTrampoline);  // x30
+  return sp;
+}
+
+#else
+#error "Fibers are only implemented for x86-64 and AArch64."
+#endif
+
+}  // namespace platform
@@ -0,0 +1,61 @@
+// Copyright (c) 2010 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+// User-mode context switching, the bottom layer of fibers (see fiber.h).
+//
+// A context is a stack pointer: switching away pushes the callee-saved
+// registers onto the current stack and stores the stack pointer; switching
+// to a context loads its stack pointer and pops them.  So a switch costs
+// about as much as a function call that saves every callee-saved register,
+// and no system call; signal masks and other per-thread state are not
+// switched.
+//
+//   void* main_context;
+//   void* fiber_context = MakeFiberContext(stack.base, stack.size,
+//                                          &FiberMain, arg);
+//   SwitchFiberContext(&main_context, fiber_context);  // Runs FiberMain(arg)
+//   ...                                                // until it switches
+//                                                      // back to
+//                                                      // main_context.
+//
+// The switch routines are written in assembly, for x86-64 (System V ABI)
+// and AArch64, in fiber_context_x86_64.S and fiber_context_arm64.S; on
+// other architectures simple_platform.gyp leaves fibers out of the build.
+
+#ifndef SIMPLEPLATFORMLIB_SRC_FIBER_CONTEXT_H_
+#define SIMPLEPLATFORMLIB_SRC_FIBER_CONTEXT_H_
+#pragma once
+
+#include <stddef.h>
+
+extern "C" {
+
+// Saves the current context and stores its stack pointer in |*from|, then
+// resumes the context whose stack pointer is |to|.  Returns when something
+// switches back to |*from|.
+void PlatformSwitchFiberContext(void** from, void* to);
+
+// Where a context made by MakeFiberContext() starts; calls its entry point.
+void PlatformFiberTrampoline();
+
+}  // extern "C"
+
+namespace platform {
+
+typedef void (*FiberEntryPoint)(void* arg);
+
+// Lays out a context at the top of the stack [|stack_base|, |stack_base| +
+// |stack_size|) that, once switched to, calls |entry|(|arg|).  |entry| must
+// never return; it ends by switching to another context for good.  Returns
+// the context's stack pointer.
+void* MakeFiberContext(void* stack_base, size_t stack_size,
+                       FiberEntryPoint entry, void* arg);
+
+inline void SwitchFiberContext(void** from, void* to) {
+  PlatformSwitchFiberContext(from, to);
+}
+
+}  // namespace platform
+
+#endif  // SIMPLEPLATFORMLIB_SRC_FIBER_CONTEXT_H_
@@ -0,0 +1,94 @@
+// Copyright (c) 2010 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "simple-platform-lib/src/free_list_cache.h"
+
+#include <new>
+
+namespace platform {
+
+FreeListCache::ThreadCache::~ThreadCache() {
+  if (owner)
+    owner->Drain(this, 0);
+}
+
+FreeListCache::FreeListCache(size_t block_size, size_t max_per_thread)
+    : block_size_(block_size < sizeof(Block) ? sizeof(Block) : block_size),
+      max_per_thread_(max_per_thread),
+      lock_("FreeListCache::lock_"),
+      shared_(NULL) {
+}
+
+FreeListCache::~FreeListCache() {
+  ThreadCache* cache = thread_caches_.GetIfExists();
+  if (cache)
+    Drain(cache, 0);
+  while (shared_) {
+    Block* block = shared_;
+    shared_ = block->next;
+    operator delete(block);
+  }
+}
+
+void* FreeListCache::Allocate() {
+  ThreadCache* cache = thread_caches_.Get();
+  if (!cache->head) {
+    cache->owner = this;
+    Refill(cache);
+    if (!cache->head)
+      return operator new(block_size_);
+  }
+  Block* block = cache->head;
+  cache->head = block->next;
+  cache->count--;
+  return block;
+}
+
+void FreeListCache::Free(void* block) {
+  ThreadCache* cache = thread_caches_.Get();
+  cache->owner = this;
+  Block* freed = static_cast<Block*>(block);
+  freed->next = cache->head;
+  cache->head = freed;
+  if (++cache->count > max_per_thread_)
+    Drain(cache, max_per_thread_ / 2);
+}
+
+void FreeListCache::Drain(ThreadCache* cache, size_t keep) {
+  if (cache->count <= keep)
+    return;
+  // Unlink the blocks past the first |keep|, outside the lock.
+  Block* first = cache->head;
+  Block* before = NULL;
+  for (size_t i = 0; i < keep; i++) {
+    before = first;
+    first = first->next;
+  }
+  Block* last = first;
+  while (last->next)
+    last = last->next;
+  if (before)
+    before->next = NULL;
+  else
+    cache->head = NULL;
+  cache->count = keep;
+
+  AutoLock auto_lock(lock_);
+  last->next = shared_;
+  shared_ = first;
+}
+
+void FreeListCache::Refill(ThreadCache* cache) {
+  size_t wanted = max_per_thread_ / 2 > 0 ? max_per_thread_ / 2 : 1;
+  AutoLock auto_lock(lock_);
+  while (shared_ && cache->count < wanted) {
+    Block* block = shared_;
+    shared_ = block->next;
+    block->next = cache->head;
+    cache->head = block;
+    cache->count++;
+  }
+}
+
+}  // namespace platform
@@ -0,0 +1,87 @@
+// Copyright (c) 2010 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+// FreeListCache recycles blocks of one size through a free list per thread
+// (see thread_local.h), so that threads allocating and freeing at a high
+// rate stay off the heap's locks, and off each other's cache lines:
+//
+//   FreeListCache cache(sizeof(Message), 256);
+//   Message* message = new (cache.Allocate()) Message;
+//   ...
+//   message->~Message();
+//   cache.Free(message);  // On any thread.
+//
+// A thread frees onto its own list.  Once the list holds more than
+// |max_per_thread| blocks, half of them move, in one go, to a list shared by
+// all threads under a Lock; a thread whose list runs dry takes a batch from
+// the shared list before falling back on operator new.  The lists of an
+// exiting thread go to the shared list.  Blocks only go back to the heap
+// when the cache is destroyed.
+
+#ifndef SIMPLEPLATFORMLIB_SRC_FREE_LIST_CACHE_H_
+#define SIMPLEPLATFORMLIB_SRC_FREE_LIST_CACHE_H_
+#pragma once
+
+#include <stddef.h>
+
+#include "simple-platform-lib/src/basictypes.h"
+#include "simple-platform-lib/src/lock.h"
+#include "simple-platform-lib/src/thread_local.h"
+
+namespace platform {
+
+class FreeListCache {
+ public:
+  // Blocks are |block_size| bytes, at least a pointer's worth, aligned as
+  // operator new aligns them.
+  FreeListCache(size_t block_size, size_t max_per_thread);
+
+  // Frees the blocks cached by the shared list and by the calling thread.
+  // Every other thread that used the cache must have exited, and every
+  // block must have been freed.
+  ~FreeListCache();
+
+  void* Allocate();
+
+  // |block| must come from this cache; it may come from another thread.
+  void Free(void* block);
+
+  size_t block_size() const { return block_size_; }
+
+ private:
+  struct Block {
+    Block* next;
+  };
+
+  // A thread's free list.
+  struct ThreadCache {
+    ThreadCache() : owner(NULL), head(NULL), count(0) {}
+    // Gives the blocks to |owner|'s shared list.
+    ~ThreadCache();
+
+    FreeListCache* owner;
+    Block* head;
+    size_t count;
+  };
+
+  // Moves blocks from |cache| to the shared list until |cache| holds |keep|.
+  void Drain(ThreadCache* cache, size_t keep);
+  // Moves up to |max_per_thread_| / 2 blocks, and at least one, from the
+  // shared list to |cache|.
+  void Refill(ThreadCache* cache);
+
+  const size_t block_size_;
+  const size_t max_per_thread_;
+
+  Lock lock_;
+  Block* shared_;  // Protected by |lock_|.
+
+  ThreadLocal<ThreadCache> thread_caches_;
+
+  DISALLOW_COPY_AND_ASSIGN(FreeListCache);
+};
+
+}  // namespace platform
+
+#endif  // SIMPLEPLATFORMLIB_SRC_FREE_LIST_CACHE_H_
@@ -0,0 +1,59 @@
+// Copyright (c) 2010 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+// Thin wrappers around the Linux futex(2) system call.  These are internal to
+// the library; use Lock (and friends) instead.
+
+#ifndef SIMPLEPLATFORMLIB_SRC_FUTEX_LINUX_H_
+#define SIMPLEPLATFORMLIB_SRC_FUTEX_LINUX_H_
+#pragma once
+
+#include <linux/futex.h>
+#include <stddef.h>
+#include <sys/syscall.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "simple-platform-lib/src/basictypes.h"
+
+namespace platform {
+namespace internal {
+
+// Blocks the calling thread as long as |*word| == |value|.  Returns 0 when
+// woken (possibly spuriously), or -1 with errno set (EAGAIN if |*word| did not
+// hold |value|, EINTR on a signal).
+inline int FutexWait(volatile int32* word, int32 value) {
+  return syscall(SYS_futex, word, FUTEX_WAIT_PRIVATE, value, NULL, NULL, 0);
+}
+
+// Like FutexWait(), but gives up at the absolute CLOCK_MONOTONIC time
+// |deadline|, failing with ETIMEDOUT.
+inline int FutexWaitUntil(volatile int32* word, int32 value,
+                          const struct timespec* deadline) {
+  return syscall(SYS_futex, word, FUTEX_WAIT_BITSET_PRIVATE, value, deadline,
+                 NULL, FUTEX_BITSET_MATCH_ANY);
+}
+
+// Wakes at most |count| threads blocked in FutexWait() on |word|.  Returns the
+// number of threads woken.
+inline int FutexWake(volatile int32* word, int32 count) {
+  return syscall(SYS_futex, word, FUTEX_WAKE_PRIVATE, count, NULL, NULL, 0);
+}
+
+// If |*word| == |value|, wakes at most |wake_count| threads blocked on |word|
+// and moves up to |requeue_count| of the remaining ones to wait on |target|
+// instead, without waking them.  Fails with EAGAIN if |*word| != |value|.
+inline int FutexCmpRequeue(volatile int32* word, int32 value,
+                           int32 wake_count, int32 requeue_count,
+                           volatile int32* target) {
+  // The requeue count is passed in the timeout argument.
+  return syscall(SYS_futex, word, FUTEX_CMP_REQUEUE_PRIVATE, wake_count,
+                 reinterpret_cast<void*>(static_cast<intptr_t>(requeue_count)),
+                 target, value);
+}
+
+}  // namespace internal
+}  // namespace platform
+
+#endif  // SIMPLEPLATFORMLIB_SRC_FUTEX_LINUX_H_
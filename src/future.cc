@@ -0,0 +1,95 @@
+// Copyright (c) 2010 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "simple-platform-lib/src/future.h"
+
+#include "simple-platform-lib/src/condition_variable.h"
+#include "simple-platform-lib/src/lock.h"
+
+namespace platform {
+
+namespace internal {
+
+namespace {
+
+// Wakes a thread blocked in FutureStateBase::Wait().
+class WaitCallback : public FutureCallback {
+ public:
+  WaitCallback() : ready_(false), ready_cv_(&lock_) {}
+
+  virtual void OnReady() {
+    AutoLock auto_lock(lock_);
+    ready_ = true;
+    ready_cv_.Signal();
+  }
+
+  void Wait() {
+    AutoLock auto_lock(lock_);
+    while (!ready_)
+      ready_cv_.Wait();
+  }
+
+ private:
+  Lock lock_;
+  bool ready_;
+  ConditionVariable ready_cv_;
+
+  DISALLOW_COPY_AND_ASSIGN(WaitCallback);
+};
+
+}  // namespace
+
+FutureStateBase::FutureStateBase() : refs_(1), callbacks_(NULL) {
+}
+
+FutureStateBase::~FutureStateBase() {
+}
+
+void FutureStateBase::AddCallback(FutureCallback* callback) {
+  FutureCallback* head = callbacks_.Load(MEMORY_ORDER_ACQUIRE);
+  for (;;) {
+    if (head == ReadyMark()) {
+      callback->OnReady();
+      return;
+    }
+    callback->next_ = head;
+    if (callbacks_.CompareExchangeWeak(&head, callback,
+                                       MEMORY_ORDER_ACQ_REL)) {
+      return;
+    }
+  }
+}
+
+void FutureStateBase::Wait() {
+  if (IsReady())
+    return;
+  WaitCallback waiter;
+  AddCallback(&waiter);
+  waiter.Wait();
+}
+
+void FutureStateBase::MarkReady() {
+  FutureCallback* callback =
+      callbacks_.Exchange(ReadyMark(), MEMORY_ORDER_ACQ_REL);
+//  DCHECK(callback != ReadyMark());
+
+  // Reverse the stack, to run the callbacks in the order they were added.
+  FutureCallback* ordered = NULL;
+  while (callback) {
+    FutureCallback* next = callback->next_;
+    callback->next_ = ordered;
+    ordered = callback;
+    callback = next;
+  }
+  while (ordered) {
+    // OnReady() may delete the callback.
+    FutureCallback* next = ordered->next_;
+    ordered->OnReady();
+    ordered = next;
+  }
+}
+
+}  // namespace internal
+
+}  // namespace platform
@@ -0,0 +1,456 @@
+// Copyright (c) 2010 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+// Future<T> is a value that will be available later; Promise<T> is how the
+// producer makes it available.  Rather than blocking a thread until the
+// value is there, consumers can chain continuations onto a future with
+// Then(), which run once the value is set, either inline on the thread that
+// sets it or on an Executor (see executor.h):
+//
+//   struct Parse {
+//     typedef Request result_type;
+//     Request operator()(const std::string& data) const { ... }
+//   };
+//
+//   Promise<std::string> read;
+//   Future<Request> request = read.GetFuture().Then(&pool, Parse());
+//   ...
+//   read.SetValue(data);  // Parse() gets posted to |pool|.
+//   ...
+//   Handle(request.Get());  // Blocks until the value is there.
+//
+// Continuations are functors with a |result_type| typedef, called with a
+// const T&; each returns a Future<result_type>.  WhenAll() and WhenAny()
+// combine several futures into one.
+//
+// Setting a value and adding continuations never take a lock: the shared
+// state holds either a stack of continuations, pushed with a compare-and-
+// swap, or a "ready" mark that SetValue() exchanges in, and so whichever of
+// SetValue() and Then() comes second runs the continuation.  Only Get() and
+// Wait() on a future that is not ready block, on a lock and condition
+// variable of their own.
+//
+// There are no errors: a promise that is destroyed without a value, or a
+// continuation whose executor deletes it without running it (e.g. a
+// ThreadPool that has been shut down), leaves its future unready forever.
+// Values must be default-constructible and assignable, and are copied into
+// the shared state.  Futures and promises are cheap to copy, and copies
+// share the state; it is freed along with the last of them.
+//
+// Inline continuations run recursively when they set the value of a future
+// that has inline continuations itself, so chains of many thousands of them
+// should use an executor.
+
+#ifndef SIMPLEPLATFORMLIB_SRC_FUTURE_H_
+#define SIMPLEPLATFORMLIB_SRC_FUTURE_H_
+#pragma once
+
+#include <stddef.h>
+
+#include <utility>
+#include <vector>
+
+#include "simple-platform-lib/src/atomics.h"
+#include "simple-platform-lib/src/basictypes.h"
+#include "simple-platform-lib/src/executor.h"
+#include "simple-platform-lib/src/task.h"
+
+namespace platform {
+
+template <typename T> class Future;
+template <typename T> class Promise;
+
+namespace internal {
+
+// Something to do once a future is ready.
+class FutureCallback {
+ public:
+  FutureCallback() : next_(NULL) {}
+  virtual ~FutureCallback() {}
+
+  // Called once, by whichever thread made the future ready, or added the
+  // callback to a future that already was.  May delete the callback.
+  virtual void OnReady() = 0;
+
+ private:
+  friend class FutureStateBase;
+
+  FutureCallback* next_;
+
+  DISALLOW_COPY_AND_ASSIGN(FutureCallback);
+};
+
+// The reference count and the callback state machine, shared by every
+// FutureState<T>.
+class FutureStateBase {
+ public:
+  // Starts with one reference, owned by the creator.
+  FutureStateBase();
+
+  void AddRef() { refs_.FetchAdd(1, MEMORY_ORDER_RELAXED); }
+  void Release() {
+    if (refs_.FetchSub(1, MEMORY_ORDER_ACQ_REL) == 1)
+      delete this;
+  }
+
+  bool IsReady() const {
+    return callbacks_.Load(MEMORY_ORDER_ACQUIRE) == ReadyMark();
+  }
+
+  // Calls |callback|->OnReady() once the state is ready; right away if it
+  // already is.
+  void AddCallback(FutureCallback* callback);
+
+  // Blocks until the state is ready.
+  void Wait();
+
+ protected:
+  virtual ~FutureStateBase();
+
+  // Marks the state ready, publishing the value, and runs the callbacks in
+  // the order they were added.  Must be called once.
+  void MarkReady();
+
+ private:
+  static FutureCallback* ReadyMark() {
+    return reinterpret_cast<FutureCallback*>(1);
+  }
+
+  Atomic<int32> refs_;
+  // The callbacks, most recently added first, or ReadyMark().
+  Atomic<FutureCallback*> callbacks_;
+
+  DISALLOW_COPY_AND_ASSIGN(FutureStateBase);
+};
+
+template <typename T>
+class FutureState : public FutureStateBase {
+ public:
+  FutureState() : value_() {}
+
+  void SetValue(const T& value) {
+    value_ = value;
+    MarkReady();
+  }
+
+  // Only once ready.
+  const T& value() const { return value_; }
+
+ private:
+  virtual ~FutureState() {}
+
+  T value_;
+
+  DISALLOW_COPY_AND_ASSIGN(FutureState);
+};
+
+// Lets the combinators below get at the state of futures.
+struct FutureAccess {
+  template <typename T>
+  static FutureState<T>* GetState(const Future<T>& future) {
+    return future.state_;
+  }
+
+  // Takes over the caller's reference to |state|.
+  template <typename T>
+  static Future<T> Adopt(FutureState<T>* state) {
+    return Future<T>(state);
+  }
+};
+
+// A Then() continuation.  Runs inline, or as a Task on |executor|.
+template <typename T, typename Functor>
+class ThenCallback : public FutureCallback, public Task {
+ public:
+  typedef typename Functor::result_type R;
+
+  // Takes over a reference to each of |source| and |result|.
+  ThenCallback(FutureState<T>* source, Executor* executor,
+               const Functor& functor, FutureState<R>* result)
+      : source_(source), executor_(executor), functor_(functor),
+        result_(result) {}
+
+  virtual ~ThenCallback() {
+    source_->Release();
+    result_->Release();
+  }
+
+  virtual void OnReady() {
+    if (executor_) {
+      executor_->Execute(this);
+    } else {
+      Run();
+      delete this;
+    }
+  }
+
+  virtual void Run() {
+    result_->SetValue(functor_(source_->value()));
+  }
+
+ private:
+  FutureState<T>* source_;
+  Executor* executor_;
+  Functor functor_;
+  FutureState<R>* result_;
+
+  DISALLOW_COPY_AND_ASSIGN(ThenCallback);
+};
+
+// The state of a WhenAll(), freed by the last input to become ready.
+template <typename T>
+class WhenAllState {
+ public:
+  explicit WhenAllState(size_t count)
+      : remaining_(static_cast<int32>(count)), values_(count) {}
+
+  Future<std::vector<T> > GetFuture() const { return promise_.GetFuture(); }
+
+  void SetValue(size_t index, const T& value) {
+    values_[index] = value;
+    // The last input sees every other input's value.
+    if (remaining_.FetchSub(1, MEMORY_ORDER_ACQ_REL) == 1) {
+      promise_.SetValue(values_);
+      delete this;
+    }
+  }
+
+ private:
+  Atomic<int32> remaining_;
+  std::vector<T> values_;
+  Promise<std::vector<T> > promise_;
+
+  DISALLOW_COPY_AND_ASSIGN(WhenAllState);
+};
+
+template <typename T>
+class WhenAllCallback : public FutureCallback {
+ public:
+  // Takes over a reference to |source|.
+  WhenAllCallback(WhenAllState<T>* all, size_t index, FutureState<T>* source)
+      : all_(all), index_(index), source_(source) {}
+
+  virtual ~WhenAllCallback() {
+    source_->Release();
+  }
+
+  virtual void OnReady() {
+    all_->SetValue(index_, source_->value());
+    delete this;
+  }
+
+ private:
+  WhenAllState<T>* all_;
+  size_t index_;
+  FutureState<T>* source_;
+
+  DISALLOW_COPY_AND_ASSIGN(WhenAllCallback);
+};
+
+// The state of a WhenAny(), freed by the last input to become ready.
+template <typename T>
+class WhenAnyState {
+ public:
+  explicit WhenAnyState(size_t count)
+      : remaining_(static_cast<int32>(count)) {}
+
+  Future<std::pair<size_t, T> > GetFuture() const {
+    return promise_.GetFuture();
+  }
+
+  void SetValue(size_t index, const T& value) {
+    if (!done_.TestAndSet(MEMORY_ORDER_ACQ_REL))
+      promise_.SetValue(std::make_pair(index, value));
+    if (remaining_.FetchSub(1, MEMORY_ORDER_ACQ_REL) == 1)
+      delete this;
+  }
+
+ private:
+  AtomicFlag done_;
+  Atomic<int32> remaining_;
+  Promise<std::pair<size_t, T> > promise_;
+
+  DISALLOW_COPY_AND_ASSIGN(WhenAnyState);
+};
+
+template <typename T>
+class WhenAnyCallback : public FutureCallback {
+ public:
+  // Takes over a reference to |source|.
+  WhenAnyCallback(WhenAnyState<T>* any, size_t index, FutureState<T>* source)
+      : any_(any), index_(index), source_(source) {}
+
+  virtual ~WhenAnyCallback() {
+    source_->Release();
+  }
+
+  virtual void OnReady() {
+    any_->SetValue(index_, source_->value());
+    delete this;
+  }
+
+ private:
+  WhenAnyState<T>* any_;
+  size_t index_;
+  FutureState<T>* source_;
+
+  DISALLOW_COPY_AND_ASSIGN(WhenAnyCallback);
+};
+
+}  // namespace internal
+
+template <typename T>
+class Future {
+ public:
+  // A future with no state, for assigning to later.
+  Future() : state_(NULL) {}
+
+  Future(const Future& other) : state_(other.state_) {
+    if (state_)
+      state_->AddRef();
+  }
+
+  Future& operator=(const Future& other) {
+    if (other.state_)
+      other.state_->AddRef();
+    if (state_)
+      state_->Release();
+    state_ = other.state_;
+    return *this;
+  }
+
+  ~Future() {
+    if (state_)
+      state_->Release();
+  }
+
+  // Whether the future has a state, i.e. did not come from Future().
+  bool is_valid() const { return state_ != NULL; }
+
+  bool IsReady() const { return state_->IsReady(); }
+
+  // Blocks until the value is set.
+  void Wait() const { state_->Wait(); }
+
+  // Blocks until the value is set, and returns it.
+  const T& Get() const {
+    if (!state_->IsReady())
+      state_->Wait();
+    return state_->value();
+  }
+
+  // Returns a future for |functor|(value), called on the thread that sets
+  // the value, or on this one if it is already set.
+  template <typename Functor>
+  Future<typename Functor::result_type> Then(const Functor& functor) const {
+    return Then(NULL, functor);
+  }
+
+  // Returns a future for |functor|(value), run on |executor| once the value
+  // is set.  |executor| must outlive the future's value being set.  NULL
+  // means inline, as above.
+  template <typename Functor>
+  Future<typename Functor::result_type> Then(Executor* executor,
+                                             const Functor& functor) const {
+    typedef typename Functor::result_type R;
+    internal::FutureState<R>* result = new internal::FutureState<R>;
+    result->AddRef();
+    state_->AddRef();
+    state_->AddCallback(new internal::ThenCallback<T, Functor>(
+        state_, executor, functor, result));
+    return internal::FutureAccess::Adopt(result);
+  }
+
+ private:
+  friend class Promise<T>;
+  friend struct internal::FutureAccess;
+
+  // Takes over the caller's reference to |state|.
+  explicit Future(internal::FutureState<T>* state) : state_(state) {}
+
+  internal::FutureState<T>* state_;
+};
+
+template <typename T>
+class Promise {
+ public:
+  Promise() : state_(new internal::FutureState<T>) {}
+
+  Promise(const Promise& other) : state_(other.state_) {
+    state_->AddRef();
+  }
+
+  Promise& operator=(const Promise& other) {
+    other.state_->AddRef();
+    state_->Release();
+    state_ = other.state_;
+    return *this;
+  }
+
+  ~Promise() {
+    state_->Release();
+  }
+
+  Future<T> GetFuture() const {
+    state_->AddRef();
+    return Future<T>(state_);
+  }
+
+  // Sets the value and runs the inline continuations.  Must be called once,
+  // for all copies of the promise.
+  void SetValue(const T& value) {
+    state_->SetValue(value);
+  }
+
+ private:
+  internal::FutureState<T>* state_;
+};
+
+// Returns a future that is already ready with |value|.
+template <typename T>
+Future<T> MakeReadyFuture(const T& value) {
+  Promise<T> promise;
+  promise.SetValue(value);
+  return promise.GetFuture();
+}
+
+// Returns a future for the values of all of |futures|, in the same order,
+// ready once they all are.
+template <typename T>
+Future<std::vector<T> > WhenAll(const std::vector<Future<T> >& futures) {
+  if (futures.empty())
+    return MakeReadyFuture(std::vector<T>());
+  internal::WhenAllState<T>* all = new internal::WhenAllState<T>(
+      futures.size());
+  // Get the result first: the last input to be ready frees |all|.
+  Future<std::vector<T> > result = all->GetFuture();
+  for (size_t i = 0; i < futures.size(); i++) {
+    internal::FutureState<T>* state =
+        internal::FutureAccess::GetState(futures[i]);
+    state->AddRef();
+    state->AddCallback(new internal::WhenAllCallback<T>(all, i, state));
+  }
+  return result;
+}
+
+// Returns a future for the index and value of the first of |futures| to be
+// ready, which must not be empty.
+template <typename T>
+Future<std::pair<size_t, T> > WhenAny(const std::vector<Future<T> >& futures) {
+//  DCHECK(!futures.empty());
+  internal::WhenAnyState<T>* any = new internal::WhenAnyState<T>(
+      futures.size());
+  Future<std::pair<size_t, T> > result = any->GetFuture();
+  for (size_t i = 0; i < futures.size(); i++) {
+    internal::FutureState<T>* state =
+        internal::FutureAccess::GetState(futures[i]);
+    state->AddRef();
+    state->AddCallback(new internal::WhenAnyCallback<T>(any, i, state));
+  }
+  return result;
+}
+
+}  // namespace platform
+
+#endif  // SIMPLEPLATFORMLIB_SRC_FUTURE_H_
@@ -16,29 +16,56 @@
 
 namespace platform {
 
-Lock::Lock() : lock_() {
+template <class LockImplType>
+BasicLock<LockImplType>::BasicLock()
+    : lock_()
+#if defined(ENABLE_LOCK_PROFILING)
+    , profile_(NULL)
+#endif
+{
   owned_by_thread_ = false;
   owning_thread_id_ = static_cast<ThreadId>(0);
 }
 
-void Lock::AssertAcquired() const {
+template <class LockImplType>
+BasicLock<LockImplType>::BasicLock(const char* name)
+    : lock_()
+#if defined(ENABLE_LOCK_PROFILING)
+    , profile_(name)
+#endif
+{
+#if !defined(ENABLE_LOCK_PROFILING)
+  (void)name;  // Only the profiler uses the name.
+#endif
+  owned_by_thread_ = false;
+  owning_thread_id_ = static_cast<ThreadId>(0);
+}
+
+template <class LockImplType>
+void BasicLock<LockImplType>::AssertAcquired() const {
 //  DCHECK(owned_by_thread_);
 //  DCHECK_EQ(owning_thread_id_, Thread::CurrentId());
 }
 
-void Lock::CheckHeldAndUnmark() {
+template <class LockImplType>
+void BasicLock<LockImplType>::CheckHeldAndUnmark() {
 //  DCHECK(owned_by_thread_);
 //  DCHECK_EQ(owning_thread_id_, Thread::CurrentId());
   owned_by_thread_ = false;
   owning_thread_id_ = static_cast<ThreadId>(0);
 }
 
-void Lock::CheckUnheldAndMark() {
+template <class LockImplType>
+void BasicLock<LockImplType>::CheckUnheldAndMark() {
 //  DCHECK(!owned_by_thread_);
   owned_by_thread_ = true;
   owning_thread_id_ = Thread::CurrentId();
 }
 
+template class BasicLock<LockImpl>;
+template class BasicLock<TicketLockImpl>;
+template class BasicLock<McsLockImpl>;
+
 }  // namespace platform
 
 #endif  // NDEBUG
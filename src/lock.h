@@ -3,51 +3,97 @@
 // found in the LICENSE file.
 
 // Taken from Chromium: src/base/lock.h
+// Significant changes (other than naming):
+//  - |Lock|, |AutoLock| and |AutoUnlock| are instantiations of the templates
+//    |BasicLock|, |BasicAutoLock| and |BasicAutoUnlock|, parameterized on the
+//    underlying lock implementation
 
 #ifndef SIMPLEPLATFORMLIB_SRC_LOCK_H_
 #define SIMPLEPLATFORMLIB_SRC_LOCK_H_
 #pragma once
 
 #include "simple-platform-lib/src/lock_impl.h"
+#if defined(ENABLE_LOCK_PROFILING)
+#include "simple-platform-lib/src/lock_profiler.h"
+#endif
+#include "simple-platform-lib/src/mcs_lock_impl.h"
+#include "simple-platform-lib/src/ticket_lock_impl.h"
 
 namespace platform {
 
 // A convenient wrapper for an OS specific critical section.  The only real
 // intelligence in this class is in debug mode for the support for the
 // AssertAcquired() method.
-
-class Lock {
+//
+// The underlying implementation is a policy parameter.  |LockImplType| must
+// provide Try(), Lock() and Unlock() with the semantics of LockImpl's.  The
+// instantiations are:
+//
+//   Lock        - LockImpl, the OS lock (a futex on Linux).  Waiters sleep,
+//                 so this is the right choice unless profiling says otherwise.
+//   TicketLock  - TicketLockImpl, a FIFO spin lock.
+//   McsLock     - McsLockImpl, a FIFO queue spin lock whose waiters each spin
+//                 on their own cache line.
+//
+// The FIFO locks trade throughput for fairness and a bounded wait, which can
+// help tail latency on heavily contended locks with short critical sections.
+// Since their waiters never sleep, they must not be used when contending
+// threads outnumber processors.
+//
+// A lock may be given a name identifying its site, which is what the
+// contention profiler reports it under (see lock_profiler.h).  Without
+// ENABLE_LOCK_PROFILING the name is ignored.
+//
+// New policies must be explicitly instantiated in lock.cc.
+template <class LockImplType>
+class BasicLock {
  public:
 #if defined(NDEBUG)             // Optimized wrapper implementation
-  Lock() : lock_() {}
-  ~Lock() {}
-  void Acquire() { lock_.Lock(); }
-  void Release() { lock_.Unlock(); }
+  BasicLock()
+      : lock_()
+#if defined(ENABLE_LOCK_PROFILING)
+      , profile_(NULL)
+#endif
+  {}
+  explicit BasicLock(const char* name)
+      : lock_()
+#if defined(ENABLE_LOCK_PROFILING)
+      , profile_(name)
+#endif
+  {
+#if !defined(ENABLE_LOCK_PROFILING)
+    (void)name;  // Only the profiler uses the name.
+#endif
+  }
+  ~BasicLock() {}
+  void Acquire() { LockInternal(); }
+  void Release() { UnlockInternal(); }
 
   // If the lock is not held, take it and return true. If the lock is already
   // held by another thread, immediately return false.
-  bool Try() { return lock_.Try(); }
+  bool Try() { return TryInternal(); }
 
   // Null implementation if not debug.
   void AssertAcquired() const {}
 #else
-  Lock();
-  ~Lock() {}
+  BasicLock();
+  explicit BasicLock(const char* name);
+  ~BasicLock() {}
 
   // NOTE: Although windows critical sections support recursive locks, we do not
   // allow this, and we will commonly fire a DCHECK() if a thread attempts to
   // acquire the lock a second time (while already holding it).
   void Acquire() {
-    lock_.Lock();
+    LockInternal();
     CheckUnheldAndMark();
   }
   void Release() {
     CheckHeldAndUnmark();
-    lock_.Unlock();
+    UnlockInternal();
   }
 
   bool Try() {
-    bool rv = lock_.Try();
+    bool rv = TryInternal();
     if (rv) {
       CheckUnheldAndMark();
     }
@@ -66,6 +112,35 @@ class Lock {
 #endif
 
  private:
+#if defined(ENABLE_LOCK_PROFILING)
+  // A Try() first, so that uncontended acquisitions are not timed.
+  void LockInternal() {
+    if (!LockProfiler::IsEnabled()) {
+      lock_.Lock();
+    } else if (lock_.Try()) {
+      profile_.RecordAcquire(false, 0);
+    } else {
+      int64 start_ns = LockProfiler::NowNs();
+      lock_.Lock();
+      profile_.RecordAcquire(true, LockProfiler::NowNs() - start_ns);
+    }
+  }
+  void UnlockInternal() {
+    profile_.RecordRelease();
+    lock_.Unlock();
+  }
+  bool TryInternal() {
+    bool rv = lock_.Try();
+    if (rv && LockProfiler::IsEnabled())
+      profile_.RecordAcquire(false, 0);
+    return rv;
+  }
+#else
+  void LockInternal() { lock_.Lock(); }
+  void UnlockInternal() { lock_.Unlock(); }
+  bool TryInternal() { return lock_.Try(); }
+#endif  // ENABLE_LOCK_PROFILING
+
 #if !defined(NDEBUG)
   // Members and routines taking care of locks assertions.
   // Note that this checks for recursive locks and allows them
@@ -84,47 +159,65 @@ class Lock {
   ThreadId owning_thread_id_;
 #endif  // NDEBUG
 
-  LockImpl lock_;  // Platform specific underlying lock implementation.
+  LockImplType lock_;  // Platform specific underlying lock implementation.
+
+#if defined(ENABLE_LOCK_PROFILING)
+  // Protected by lock_, like the debugging members.
+  LockProfile profile_;
+#endif
 
-  DISALLOW_COPY_AND_ASSIGN(Lock);
+  DISALLOW_COPY_AND_ASSIGN(BasicLock);
 };
 
-// A helper class that acquires the given Lock while the AutoLock is in scope.
-class AutoLock {
+typedef BasicLock<LockImpl> Lock;
+typedef BasicLock<TicketLockImpl> TicketLock;
+typedef BasicLock<McsLockImpl> McsLock;
+
+// A helper class that acquires the given lock while the AutoLock is in scope.
+template <class LockType>
+class BasicAutoLock {
  public:
-  explicit AutoLock(Lock& lock) : lock_(lock) {
+  explicit BasicAutoLock(LockType& lock) : lock_(lock) {
     lock_.Acquire();
   }
 
-  ~AutoLock() {
+  ~BasicAutoLock() {
     lock_.AssertAcquired();
     lock_.Release();
   }
 
  private:
-  Lock& lock_;
-  DISALLOW_COPY_AND_ASSIGN(AutoLock);
+  LockType& lock_;
+  DISALLOW_COPY_AND_ASSIGN(BasicAutoLock);
 };
 
 // AutoUnlock is a helper that will Release() the |lock| argument in the
 // constructor, and re-Acquire() it in the destructor.
-class AutoUnlock {
+template <class LockType>
+class BasicAutoUnlock {
  public:
-  explicit AutoUnlock(Lock& lock) : lock_(lock) {
+  explicit BasicAutoUnlock(LockType& lock) : lock_(lock) {
     // We require our caller to have the lock.
     lock_.AssertAcquired();
     lock_.Release();
   }
 
-  ~AutoUnlock() {
+  ~BasicAutoUnlock() {
     lock_.Acquire();
   }
 
  private:
-  Lock& lock_;
-  DISALLOW_COPY_AND_ASSIGN(AutoUnlock);
+  LockType& lock_;
+  DISALLOW_COPY_AND_ASSIGN(BasicAutoUnlock);
 };
 
+typedef BasicAutoLock<Lock> AutoLock;
+typedef BasicAutoUnlock<Lock> AutoUnlock;
+typedef BasicAutoLock<TicketLock> AutoTicketLock;
+typedef BasicAutoUnlock<TicketLock> AutoTicketUnlock;
+typedef BasicAutoLock<McsLock> AutoMcsLock;
+typedef BasicAutoUnlock<McsLock> AutoMcsUnlock;
+
 }  // namespace platform
 
 #endif  // SIMPLEPLATFORMLIB_SRC_LOCK_H_
@@ -28,6 +28,10 @@ class LockImpl {
  public:
 #if defined(OS_WIN)
   typedef CRITICAL_SECTION OSLockType;
+#elif defined(OS_LINUX)
+  // On Linux the lock is a bare futex word: 0 when unlocked, 1 when locked
+  // and 2 when locked with (possibly) blocked waiters.
+  typedef volatile int32 OSLockType;
 #elif defined(OS_POSIX)
   typedef pthread_mutex_t OSLockType;
 #endif
@@ -53,7 +57,26 @@ class LockImpl {
   OSLockType* os_lock() { return &os_lock_; }
 #endif
 
+#if defined(OS_LINUX)
+  // Lock() spins up to this many times (with a CPU pause between attempts)
+  // while the holder is running its critical section, before parking the
+  // caller in the kernel.  Spinning stops early once other waiters are
+  // already parked.  Zero disables spinning.  Affects all locks in the
+  // process; the default depends on the number of processors.
+  static void SetSpinCount(int spin_count);
+  static int spin_count();
+#endif
+
  private:
+#if defined(OS_LINUX)
+  // ConditionVariable requeues its waiters directly onto our futex word, so
+  // they must re-acquire through LockContended(), which leaves the word in the
+  // "waiters" state so that Unlock() keeps waking them one at a time.
+  friend class ConditionVariable;
+
+  void LockContended();
+#endif
+
   OSLockType os_lock_;
 
   DISALLOW_COPY_AND_ASSIGN(LockImpl);
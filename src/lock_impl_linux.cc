@@ -0,0 +1,108 @@
+// Copyright (c) 2010 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+// Futex-based LockImpl for Linux.  This is the three-state mutex from Ulrich
+// Drepper's "Futexes Are Tricky", with a bounded spin phase in front of the
+// kernel wait: an uncontended Lock()/Unlock() pair is two atomic instructions
+// and no system calls, and the object is a single 32-bit word.
+
+#include "simple-platform-lib/src/lock_impl.h"
+
+#include "simple-platform-lib/src/futex_linux.h"
+#include "simple-platform-lib/src/spin_wait.h"
+#include "simple-platform-lib/src/sys_info.h"
+
+namespace platform {
+
+namespace {
+
+// Lock word states.
+const int32 kUnlocked = 0;
+const int32 kLocked = 1;
+const int32 kLockedWithWaiters = 2;
+
+// Spin count used when SetSpinCount() has not been called.  Spinning only pays
+// off when the holder can run concurrently on another processor.
+const int kDefaultSpinCount = 100;
+
+// -1 means "not yet initialized"; see GetSpinCount().  Read and written
+// without synchronization: it is a tuning knob, and any value is valid.
+int g_spin_count = -1;
+
+int GetSpinCount() {
+  int spin_count = g_spin_count;
+  if (spin_count < 0) {
+    spin_count = SysInfo::NumberOfProcessors() > 1 ? kDefaultSpinCount : 0;
+    g_spin_count = spin_count;
+  }
+  return spin_count;
+}
+
+}  // namespace
+
+LockImpl::LockImpl() : os_lock_(kUnlocked) {
+}
+
+LockImpl::~LockImpl() {
+//  DCHECK_EQ(os_lock_, kUnlocked);
+}
+
+// static
+void LockImpl::SetSpinCount(int spin_count) {
+  g_spin_count = spin_count < 0 ? 0 : spin_count;
+}
+
+// static
+int LockImpl::spin_count() {
+  return GetSpinCount();
+}
+
+bool LockImpl::Try() {
+  return __sync_bool_compare_and_swap(&os_lock_, kUnlocked, kLocked);
+}
+
+void LockImpl::Lock() {
+  int32 c = __sync_val_compare_and_swap(&os_lock_, kUnlocked, kLocked);
+  if (c == kUnlocked)
+    return;
+
+  // Spin while the lock is held but nobody is parked on it: the holder is most
+  // likely on another processor running a short critical section.  Each time
+  // we observe a release we retry the acquire, so the spin only gives up when
+  // the holder has not made progress for the whole budget.
+  for (int spins = GetSpinCount(); spins > 0 && c == kLocked; --spins) {
+    CpuRelax();
+    c = os_lock_;
+    if (c == kUnlocked) {
+      c = __sync_val_compare_and_swap(&os_lock_, kUnlocked, kLocked);
+      if (c == kUnlocked)
+        return;
+    }
+  }
+
+  // Park.  Marking the word as contended makes the holder's Unlock() issue a
+  // FUTEX_WAKE.  If the exchange returns kUnlocked we own the lock (in the
+  // contended state, which costs at most one spurious wake).
+  if (c != kLockedWithWaiters)
+    c = __sync_lock_test_and_set(&os_lock_, kLockedWithWaiters);
+  while (c != kUnlocked) {
+    internal::FutexWait(&os_lock_, kLockedWithWaiters);
+    c = __sync_lock_test_and_set(&os_lock_, kLockedWithWaiters);
+  }
+}
+
+void LockImpl::LockContended() {
+  while (__sync_lock_test_and_set(&os_lock_, kLockedWithWaiters) != kUnlocked)
+    internal::FutexWait(&os_lock_, kLockedWithWaiters);
+}
+
+void LockImpl::Unlock() {
+  if (__sync_fetch_and_sub(&os_lock_, 1) != kLocked) {
+    // There may be waiters parked in the kernel; release and wake one.
+    __sync_lock_release(&os_lock_);
+    internal::FutexWake(&os_lock_, 1);
+  }
+}
+
+}  // namespace platform
@@ -0,0 +1,276 @@
+// Copyright (c) 2010 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "simple-platform-lib/src/lock_profiler.h"
+
+#include <stdio.h>
+
+#if defined(OS_WIN)
+#include <windows.h>
+#endif
+
+#include <algorithm>
+#include <map>
+
+#include "simple-platform-lib/build/build_config.h"
+#include "simple-platform-lib/src/lock_impl.h"
+#include "simple-platform-lib/src/time.h"
+
+namespace platform {
+
+namespace internal {
+volatile bool g_lock_profiling_enabled = false;
+}  // namespace internal
+
+LockProfileStats::LockProfileStats()
+    : acquisitions(0),
+      contended(0),
+      total_wait_ns(0),
+      max_hold_ns(0) {
+}
+
+namespace {
+
+void Accumulate(const LockProfileStats& stats, LockProfileStats* total) {
+  total->acquisitions += stats.acquisitions;
+  total->contended += stats.contended;
+  total->total_wait_ns += stats.total_wait_ns;
+  total->max_hold_ns = std::max(total->max_hold_ns, stats.max_hold_ns);
+}
+
+bool MoreContended(const LockProfileStats& a, const LockProfileStats& b) {
+  if (a.total_wait_ns != b.total_wait_ns)
+    return a.total_wait_ns > b.total_wait_ns;
+  return a.contended > b.contended;
+}
+
+void AppendJsonString(const std::string& value, std::string* out) {
+  out->push_back('"');
+  for (size_t i = 0; i < value.size(); i++) {
+    char c = value[i];
+    if (c == '"' || c == '\\') {
+      out->push_back('\\');
+      out->push_back(c);
+    } else if (static_cast<unsigned char>(c) < 0x20) {
+      char escaped[8];
+      snprintf(escaped, sizeof(escaped), "\\u%04x", c);
+      out->append(escaped);
+    } else {
+      out->push_back(c);
+    }
+  }
+  out->push_back('"');
+}
+
+}  // namespace
+
+// The list of live LockProfiles, and the totals of destroyed ones by name.
+class LockProfileRegistry {
+ public:
+  static LockProfileRegistry* GetInstance() {
+    // Leaked, so that locks destroyed during shutdown can still unregister.
+    static LockProfileRegistry* instance = new LockProfileRegistry;
+    return instance;
+  }
+
+  void Register(LockProfile* profile) {
+    lock_.Lock();
+    profile->previous_ = NULL;
+    profile->next_ = head_;
+    if (head_)
+      head_->previous_ = profile;
+    head_ = profile;
+    lock_.Unlock();
+  }
+
+  void Unregister(LockProfile* profile) {
+    lock_.Lock();
+    if (profile->previous_)
+      profile->previous_->next_ = profile->next_;
+    else
+      head_ = profile->next_;
+    if (profile->next_)
+      profile->next_->previous_ = profile->previous_;
+    if (profile->acquisitions_ > 0) {
+      LockProfileStats stats;
+      GetStats(*profile, &stats);
+      Accumulate(stats, &retired_[stats.name]);
+    }
+    lock_.Unlock();
+  }
+
+  void GetAll(std::vector<LockProfileStats>* all) {
+    std::map<std::string, LockProfileStats> by_name;
+    lock_.Lock();
+    by_name = retired_;
+    for (LockProfile* profile = head_; profile; profile = profile->next_) {
+      if (profile->acquisitions_ == 0)
+        continue;
+      LockProfileStats stats;
+      GetStats(*profile, &stats);
+      Accumulate(stats, &by_name[stats.name]);
+    }
+    lock_.Unlock();
+
+    all->clear();
+    for (std::map<std::string, LockProfileStats>::iterator it =
+             by_name.begin(); it != by_name.end(); ++it) {
+      it->second.name = it->first;
+      all->push_back(it->second);
+    }
+  }
+
+  void Reset() {
+    lock_.Lock();
+    retired_.clear();
+    for (LockProfile* profile = head_; profile; profile = profile->next_) {
+      profile->acquisitions_ = 0;
+      profile->contended_ = 0;
+      profile->total_wait_ns_ = 0;
+      profile->max_hold_ns_ = 0;
+    }
+    lock_.Unlock();
+  }
+
+ private:
+  LockProfileRegistry() : head_(NULL) {}
+
+  static void GetStats(const LockProfile& profile, LockProfileStats* stats) {
+    if (profile.name_) {
+      stats->name = profile.name_;
+    } else {
+      char name[32];
+      snprintf(name, sizeof(name), "(unnamed lock %p)", &profile);
+      stats->name = name;
+    }
+    stats->acquisitions = profile.acquisitions_;
+    stats->contended = profile.contended_;
+    stats->total_wait_ns = profile.total_wait_ns_;
+    stats->max_hold_ns = profile.max_hold_ns_;
+  }
+
+  // A LockImpl rather than a Lock, which could itself be profiled.
+  LockImpl lock_;
+  LockProfile* head_;
+  std::map<std::string, LockProfileStats> retired_;
+
+  DISALLOW_COPY_AND_ASSIGN(LockProfileRegistry);
+};
+
+LockProfile::LockProfile(const char* name)
+    : name_(name),
+      acquisitions_(0),
+      contended_(0),
+      total_wait_ns_(0),
+      max_hold_ns_(0),
+      hold_start_ns_(0),
+      previous_(NULL),
+      next_(NULL) {
+  LockProfileRegistry::GetInstance()->Register(this);
+}
+
+LockProfile::~LockProfile() {
+  // Destroyed unnamed locks all end up in the same entry.
+  if (!name_)
+    name_ = "(unnamed locks)";
+  LockProfileRegistry::GetInstance()->Unregister(this);
+}
+
+void LockProfile::RecordAcquire(bool contended, int64 wait_ns) {
+  acquisitions_++;
+  if (contended) {
+    contended_++;
+    total_wait_ns_ += wait_ns;
+  }
+  if (contended || acquisitions_ % kHoldSampleInterval == 0)
+    hold_start_ns_ = LockProfiler::NowNs();
+}
+
+void LockProfile::RecordHoldTime() {
+  int64 hold_ns = LockProfiler::NowNs() - hold_start_ns_;
+  if (hold_ns > max_hold_ns_)
+    max_hold_ns_ = hold_ns;
+  hold_start_ns_ = 0;
+}
+
+namespace LockProfiler {
+
+void SetEnabled(bool enabled) {
+  internal::g_lock_profiling_enabled = enabled;
+}
+
+int64 NowNs() {
+#if defined(OS_WIN)
+  static LARGE_INTEGER frequency = {0};
+  if (frequency.QuadPart == 0)
+    QueryPerformanceFrequency(&frequency);
+  LARGE_INTEGER now;
+  QueryPerformanceCounter(&now);
+  return static_cast<int64>(
+      now.QuadPart * (1000.0 * 1000 * 1000 / frequency.QuadPart));
+#else
+  // Called twice per acquisition while profiling, so use the cheap clock.
+  return TimeTicks::FastNow().ToInternalValue();
+#endif
+}
+
+void GetTopContended(size_t max_count, std::vector<LockProfileStats>* stats) {
+  LockProfileRegistry::GetInstance()->GetAll(stats);
+  std::sort(stats->begin(), stats->end(), MoreContended);
+  if (stats->size() > max_count)
+    stats->resize(max_count);
+}
+
+std::string DumpText(size_t max_count) {
+  std::vector<LockProfileStats> stats;
+  GetTopContended(max_count, &stats);
+
+  std::string out;
+  char line[256];
+  snprintf(line, sizeof(line), "%14s %14s %14s %14s  %s\n", "acquisitions",
+           "contended", "wait_ms", "max_hold_us", "lock");
+  out.append(line);
+  for (size_t i = 0; i < stats.size(); i++) {
+    snprintf(line, sizeof(line), "%14lld %14lld %14.3f %14.3f  ",
+             static_cast<long long>(stats[i].acquisitions),
+             static_cast<long long>(stats[i].contended),
+             stats[i].total_wait_ns / 1e6, stats[i].max_hold_ns / 1e3);
+    out.append(line);
+    out.append(stats[i].name);
+    out.push_back('\n');
+  }
+  return out;
+}
+
+std::string DumpJson(size_t max_count) {
+  std::vector<LockProfileStats> stats;
+  GetTopContended(max_count, &stats);
+
+  std::string out("[");
+  char fields[256];
+  for (size_t i = 0; i < stats.size(); i++) {
+    if (i > 0)
+      out.push_back(',');
+    out.append("{\"name\":");
+    AppendJsonString(stats[i].name, &out);
+    snprintf(fields, sizeof(fields),
+             ",\"acquisitions\":%lld,\"contended\":%lld,"
+             "\"total_wait_ns\":%lld,\"max_hold_ns\":%lld}",
+             static_cast<long long>(stats[i].acquisitions),
+             static_cast<long long>(stats[i].contended),
+             static_cast<long long>(stats[i].total_wait_ns),
+             static_cast<long long>(stats[i].max_hold_ns));
+    out.append(fields);
+  }
+  out.push_back(']');
+  return out;
+}
+
+void Reset() {
+  LockProfileRegistry::GetInstance()->Reset();
+}
+
+}  // namespace LockProfiler
+
+}  // namespace platform
@@ -0,0 +1,130 @@
+// Copyright (c) 2010 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+// Contention profiling for Lock.
+//
+// When built with ENABLE_LOCK_PROFILING defined (gyp: enable_lock_profiling=1),
+// every BasicLock carries a LockProfile, which records for that lock:
+//
+//  - the number of acquisitions,
+//  - the number of contended acquisitions, i.e. ones where the fast path Try()
+//    failed and the caller had to wait,
+//  - the total time spent waiting in contended acquisitions, and
+//  - the longest time the lock was held.  To keep uncontended acquisitions
+//    cheap, hold times are only measured for contended acquisitions and for
+//    one in every kHoldSampleInterval uncontended ones.
+//
+// Recording also has to be switched on at runtime with
+// LockProfiler::SetEnabled(true); until then the only cost is a flag check
+// per acquisition.  Without ENABLE_LOCK_PROFILING there is no cost at all.
+//
+// Locks are reported by site, i.e. by the name passed to their constructor:
+//
+//   Lock lock_("FooCache::lock_");
+//
+// Statistics for all locks with the same name are added up, including locks
+// that have since been destroyed.  Unnamed locks are reported individually
+// while alive, by address.  Waiting on a ConditionVariable ends a hold; the
+// reacquisition when the wait returns is not counted.
+//
+//   LockProfiler::SetEnabled(true);
+//   ...
+//   printf("%s", LockProfiler::DumpText(10).c_str());
+
+#ifndef SIMPLEPLATFORMLIB_SRC_LOCK_PROFILER_H_
+#define SIMPLEPLATFORMLIB_SRC_LOCK_PROFILER_H_
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "simple-platform-lib/src/basictypes.h"
+
+namespace platform {
+
+struct LockProfileStats {
+  LockProfileStats();
+
+  std::string name;
+  int64 acquisitions;
+  int64 contended;
+  int64 total_wait_ns;
+  int64 max_hold_ns;
+};
+
+// The per-lock recorder.  All Record*() calls are made by the lock's holder,
+// so the counters are protected by the profiled lock itself.
+class LockProfile {
+ public:
+  static const int kHoldSampleInterval = 16;
+
+  // |name| identifies the lock site, and must outlive the LockProfile (a
+  // string literal, typically).  It may be NULL.
+  explicit LockProfile(const char* name);
+  ~LockProfile();
+
+  // Called just after the lock has been acquired.  |wait_ns| is the time spent
+  // waiting for it, if |contended|.
+  void RecordAcquire(bool contended, int64 wait_ns);
+
+  // Called just before the lock is released.
+  void RecordRelease() {
+    if (hold_start_ns_ != 0)
+      RecordHoldTime();
+  }
+
+ private:
+  friend class LockProfileRegistry;
+
+  void RecordHoldTime();
+
+  const char* name_;
+  int64 acquisitions_;
+  int64 contended_;
+  int64 total_wait_ns_;
+  int64 max_hold_ns_;
+  // Start of the current hold, if it is being timed; 0 otherwise.
+  int64 hold_start_ns_;
+
+  // Registry links; protected by the registry's lock.
+  LockProfile* previous_;
+  LockProfile* next_;
+
+  DISALLOW_COPY_AND_ASSIGN(LockProfile);
+};
+
+namespace internal {
+extern volatile bool g_lock_profiling_enabled;
+}  // namespace internal
+
+namespace LockProfiler {
+
+// Starts or stops recording in all profiled locks.
+void SetEnabled(bool enabled);
+
+inline bool IsEnabled() {
+  return internal::g_lock_profiling_enabled;
+}
+
+// Returns the current time, in nanoseconds, on the clock used for profiling.
+int64 NowNs();
+
+// Stores the |max_count| lock sites with the most total wait time into
+// |stats|, most contended first.  Statistics of live locks are read without
+// synchronizing with their holders, so they are approximate.
+void GetTopContended(size_t max_count, std::vector<LockProfileStats>* stats);
+
+// GetTopContended(), formatted as a text table or as a JSON array of objects.
+std::string DumpText(size_t max_count);
+std::string DumpJson(size_t max_count);
+
+// Clears the statistics of every lock, live or destroyed.  The statistics of
+// locks that are being acquired or released concurrently may not be cleared.
+void Reset();
+
+}  // namespace LockProfiler
+
+}  // namespace platform
+
+#endif  // SIMPLEPLATFORMLIB_SRC_LOCK_PROFILER_H_
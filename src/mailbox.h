@@ -0,0 +1,118 @@
+// Copyright (c) 2010 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+// Mailbox<T> is the inbox of an actor: any thread may Post() messages to it,
+// and the one thread that runs the actor Receive()s them in order, sleeping
+// while there are none.  Messages derive from MpscQueueNode and are linked
+// in place (see mpsc_queue.h), so posting allocates nothing.
+//
+//   struct Message : public MpscQueueNode {
+//     ...
+//   };
+//
+//   Mailbox<Message> mailbox;
+//
+//   // Any thread:              // The actor's thread:
+//   mailbox.Post(message);      for (;;) {
+//                                 Message* message = mailbox.Receive();
+//                                 ...
+//                               }
+//
+// Post() only wakes the receiver when the mailbox goes from empty to
+// non-empty, as the receiver sees it, i.e. when it has received every
+// message posted before and may be asleep.  Posting to a busy mailbox costs
+// an atomic exchange and an atomic add, and never takes a lock.
+//
+// The mailbox does not own its messages.
+
+#ifndef SIMPLEPLATFORMLIB_SRC_MAILBOX_H_
+#define SIMPLEPLATFORMLIB_SRC_MAILBOX_H_
+#pragma once
+
+#include <stddef.h>
+
+#include "simple-platform-lib/src/atomics.h"
+#include "simple-platform-lib/src/basictypes.h"
+#include "simple-platform-lib/src/condition_variable.h"
+#include "simple-platform-lib/src/lock.h"
+#include "simple-platform-lib/src/mpsc_queue.h"
+#include "simple-platform-lib/src/thread.h"
+
+namespace platform {
+
+template <typename T>
+class Mailbox {
+ public:
+  Mailbox()
+      : size_(0),
+        received_(0),
+        lock_("Mailbox::lock_"),
+        message_posted_(&lock_) {}
+
+  // Any thread.  Queues |message|, which must stay alive until received.
+  void Post(T* message) {
+    queue_.Push(message);
+    if (size_.FetchAdd(1, MEMORY_ORDER_ACQ_REL) == 0) {
+      AutoLock auto_lock(lock_);
+      message_posted_.Signal();
+    }
+  }
+
+  // Receiver only.  Returns the oldest message, waiting for one if needed.
+  T* Receive() {
+    for (;;) {
+      T* message = TryReceive();
+      if (message)
+        return message;
+      AutoLock auto_lock(lock_);
+      while (size_.Load(MEMORY_ORDER_ACQUIRE) <= 0)
+        message_posted_.Wait();
+    }
+  }
+
+  // Receiver only.  Returns the oldest message, or NULL if there is none.
+  T* TryReceive() {
+    T* message = queue_.Pop();
+    if (message) {
+      received_++;
+      return message;
+    }
+    // Account for the messages received since last time.  If that leaves
+    // |size_| at zero, the mailbox is empty, and the next Post() will wake
+    // us.  Otherwise a Post() is halfway done; wait for it to link its
+    // message.
+    int32 size =
+        size_.FetchSub(received_, MEMORY_ORDER_ACQ_REL) - received_;
+    received_ = 0;
+    while (size > 0) {
+      message = queue_.Pop();
+      if (message) {
+        received_++;
+        return message;
+      }
+      Thread::Yield();
+    }
+    return NULL;
+  }
+
+ private:
+  MpscQueue<T> queue_;
+  // Messages posted minus messages the receiver has accounted for; the
+  // receiver only accounts for received messages once the queue looks
+  // empty, so that Post() sees zero only when the receiver may sleep.  Goes
+  // briefly negative when a message is received before its Post() counted
+  // it.
+  Atomic<int32> size_;
+  // Receiver only.  Messages received but not yet taken off |size_|.
+  int32 received_;
+
+  Lock lock_;
+  ConditionVariable message_posted_;
+
+  DISALLOW_COPY_AND_ASSIGN(Mailbox);
+};
+
+}  // namespace platform
+
+#endif  // SIMPLEPLATFORMLIB_SRC_MAILBOX_H_
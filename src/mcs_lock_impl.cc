@@ -0,0 +1,92 @@
+// Copyright (c) 2010 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+// See "Shared-Memory Synchronization" (Scott, 2013), section 4.3.1, for the
+// K42 variant of the MCS lock implemented here.
+
+#include "simple-platform-lib/src/mcs_lock_impl.h"
+
+#include <stddef.h>
+
+#include "simple-platform-lib/src/spin_wait.h"
+
+namespace platform {
+
+McsLockImpl::McsLockImpl() {
+}
+
+McsLockImpl::~McsLockImpl() {
+//  DCHECK(!queue_.tail.Load());
+}
+
+bool McsLockImpl::Try() {
+  Node* expected = NULL;
+  return queue_.tail.CompareExchange(&expected, &queue_, MEMORY_ORDER_ACQUIRE,
+                                     MEMORY_ORDER_RELAXED);
+}
+
+void McsLockImpl::Lock() {
+  // Marks a waiter's node until the lock is handed to it.
+  Node* const kWaiting = reinterpret_cast<Node*>(1);
+
+  for (;;) {
+    Node* prev = queue_.tail.Load(MEMORY_ORDER_RELAXED);
+    if (prev == NULL) {
+      // The lock looks free; the lock's own node represents the holder.
+      if (queue_.tail.CompareExchange(&prev, &queue_, MEMORY_ORDER_ACQUIRE,
+                                      MEMORY_ORDER_RELAXED))
+        return;
+      continue;
+    }
+
+    Node node;
+    node.tail.Store(kWaiting, MEMORY_ORDER_RELAXED);
+    if (!queue_.tail.CompareExchange(&prev, &node, MEMORY_ORDER_ACQ_REL,
+                                     MEMORY_ORDER_RELAXED))
+      continue;
+
+    // Link in behind our predecessor (possibly the holder, i.e. |queue_|),
+    // and wait for it to hand us the lock.
+    prev->next.Store(&node, MEMORY_ORDER_RELEASE);
+    SpinWait spin_wait;
+    while (node.tail.Load(MEMORY_ORDER_ACQUIRE) == kWaiting)
+      spin_wait.Once();
+
+    // We hold the lock, but |node| is about to go out of scope: move the queue
+    // head into the lock's own node, and if we are also the tail, point the
+    // tail back at the lock's node.
+    Node* next = node.next.Load(MEMORY_ORDER_ACQUIRE);
+    if (next == NULL) {
+      queue_.next.Store(NULL, MEMORY_ORDER_RELAXED);
+      Node* expected = &node;
+      if (queue_.tail.CompareExchange(&expected, &queue_, MEMORY_ORDER_ACQ_REL,
+                                      MEMORY_ORDER_RELAXED))
+        return;
+      // Somebody enqueued behind us in the meantime; wait for the link.
+      spin_wait.Reset();
+      while ((next = node.next.Load(MEMORY_ORDER_ACQUIRE)) == NULL)
+        spin_wait.Once();
+    }
+    queue_.next.Store(next, MEMORY_ORDER_RELAXED);
+    return;
+  }
+}
+
+void McsLockImpl::Unlock() {
+  Node* next = queue_.next.Load(MEMORY_ORDER_ACQUIRE);
+  if (next == NULL) {
+    Node* expected = &queue_;
+    if (queue_.tail.CompareExchange(&expected, NULL, MEMORY_ORDER_RELEASE,
+                                    MEMORY_ORDER_RELAXED))
+      return;
+    // A waiter is enqueueing; wait until it has linked itself in.
+    SpinWait spin_wait;
+    while ((next = queue_.next.Load(MEMORY_ORDER_ACQUIRE)) == NULL)
+      spin_wait.Once();
+  }
+  // Hand over the lock.
+  next->tail.Store(NULL, MEMORY_ORDER_RELEASE);
+}
+
+}  // namespace platform
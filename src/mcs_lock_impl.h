@@ -0,0 +1,55 @@
+// Copyright (c) 2010 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef SIMPLEPLATFORMLIB_SRC_MCS_LOCK_IMPL_H_
+#define SIMPLEPLATFORMLIB_SRC_MCS_LOCK_IMPL_H_
+#pragma once
+
+#include "simple-platform-lib/src/atomics.h"
+#include "simple-platform-lib/src/basictypes.h"
+
+namespace platform {
+
+// An MCS queue lock (Mellor-Crummey and Scott).  Waiters form a linked queue
+// and each spins on a flag in its own queue node, so a release touches only
+// the cache line of the next waiter instead of every waiter's, and the lock is
+// granted in FIFO order.  As with TicketLockImpl, waiters spin rather than
+// sleep.  Use it through Lock's policy parameter: McsLock, see lock.h.
+//
+// This is the "K42" variant, in which the lock itself stands in for the
+// holder's queue node.  Queue nodes live on the waiters' stacks only while
+// they wait, so Lock() and Unlock() need no per-acquisition node from the
+// caller and the interface matches LockImpl.
+class McsLockImpl {
+ public:
+  McsLockImpl();
+  ~McsLockImpl();
+
+  // If the lock is not held, take it and return true.  If the lock is already
+  // held by something else, immediately return false.
+  bool Try();
+
+  // Take the lock, waiting behind every earlier caller.
+  void Lock();
+
+  // Release the lock.  This must only be called by the lock's holder.
+  void Unlock();
+
+ private:
+  struct Node {
+    // In a waiter's node: kWaiting until the lock is handed to it.  In the
+    // lock's own node: the last node in the queue, or NULL if unlocked.
+    Atomic<Node*> tail;
+    // The next node in the queue, or NULL.
+    Atomic<Node*> next;
+  };
+
+  Node queue_;
+
+  DISALLOW_COPY_AND_ASSIGN(McsLockImpl);
+};
+
+}  // namespace platform
+
+#endif  // SIMPLEPLATFORMLIB_SRC_MCS_LOCK_IMPL_H_
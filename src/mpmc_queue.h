@@ -0,0 +1,288 @@
+// Copyright (c) 2010 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+// MpmcQueue<T> is a bounded lock-free queue that any number of threads may
+// push to and pop from: Dmitry Vyukov's array queue, in which every slot
+// carries a sequence number saying whose turn it is.
+//
+// A producer claims the slot at |enqueue_pos_| with a compare-and-swap once
+// the slot's sequence number says it is free, writes the item, then bumps the
+// sequence number to hand the slot to the consumer that will claim the same
+// position at |dequeue_pos_|; which in turn hands it to the producer one lap
+// later.  So producers only contend with producers and consumers with
+// consumers, each on a single compare-and-swap, and nothing is allocated.
+//
+// TryPush() and TryPop() never wait.  BlockingMpmcQueue<T> adds Push() and
+// Pop(), which park the calling thread on a condition variable while the
+// queue is full or empty, and Close() to release them on shutdown:
+//
+//   BlockingMpmcQueue<Task*> queue(1024);
+//
+//   // Producers:                     // Consumers:
+//   queue.Push(task);                  Task* task;
+//   ...                                while (queue.Pop(&task))
+//   queue.Close();                       Run(task);
+//
+// T must be default constructible and assignable, and is copied in and out.
+
+#ifndef SIMPLEPLATFORMLIB_SRC_MPMC_QUEUE_H_
+#define SIMPLEPLATFORMLIB_SRC_MPMC_QUEUE_H_
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "simple-platform-lib/src/atomics.h"
+#include "simple-platform-lib/src/basictypes.h"
+#include "simple-platform-lib/src/condition_variable.h"
+#include "simple-platform-lib/src/lock.h"
+#include "simple-platform-lib/src/spin_wait.h"
+
+namespace platform {
+
+template <typename T>
+class MpmcQueue {
+ public:
+  // |capacity| is rounded up to a power of two, and to at least 2.
+  explicit MpmcQueue(size_t capacity)
+      : mask_(RoundUpToPowerOfTwo(capacity) - 1),
+        cells_(new Cell[mask_ + 1]),
+        enqueue_pos_(0),
+        dequeue_pos_(0) {
+    for (size_t i = 0; i <= mask_; i++)
+      cells_[i].sequence.Store(i, MEMORY_ORDER_RELAXED);
+  }
+
+  ~MpmcQueue() { delete[] cells_; }
+
+  // Returns false if the queue is full.
+  bool TryPush(const T& item) {
+    Cell* cell;
+    size_t pos = enqueue_pos_.Load(MEMORY_ORDER_RELAXED);
+    for (;;) {
+      cell = &cells_[pos & mask_];
+      size_t sequence = cell->sequence.Load(MEMORY_ORDER_ACQUIRE);
+      intptr_t diff = static_cast<intptr_t>(sequence - pos);
+      if (diff == 0) {
+        // The slot is free; claim it.  On failure |pos| is reloaded.
+        if (enqueue_pos_.CompareExchangeWeak(&pos, pos + 1,
+                                             MEMORY_ORDER_RELAXED))
+          break;
+      } else if (diff < 0) {
+        // The slot still holds the item from one lap ago.
+        return false;
+      } else {
+        // Another producer claimed the slot; catch up.
+        pos = enqueue_pos_.Load(MEMORY_ORDER_RELAXED);
+      }
+    }
+    cell->item = item;
+    cell->sequence.Store(pos + 1, MEMORY_ORDER_RELEASE);
+    return true;
+  }
+
+  // Returns false if the queue is empty.
+  bool TryPop(T* item) {
+    Cell* cell;
+    size_t pos = dequeue_pos_.Load(MEMORY_ORDER_RELAXED);
+    for (;;) {
+      cell = &cells_[pos & mask_];
+      size_t sequence = cell->sequence.Load(MEMORY_ORDER_ACQUIRE);
+      intptr_t diff = static_cast<intptr_t>(sequence - (pos + 1));
+      if (diff == 0) {
+        if (dequeue_pos_.CompareExchangeWeak(&pos, pos + 1,
+                                             MEMORY_ORDER_RELAXED))
+          break;
+      } else if (diff < 0) {
+        // No producer has filled the slot yet.
+        return false;
+      } else {
+        pos = dequeue_pos_.Load(MEMORY_ORDER_RELAXED);
+      }
+    }
+    *item = cell->item;
+    // Free the slot for the producer one lap ahead.
+    cell->sequence.Store(pos + mask_ + 1, MEMORY_ORDER_RELEASE);
+    return true;
+  }
+
+  // Only a hint while other threads push or pop.
+  size_t Size() const {
+    size_t dequeue_pos = dequeue_pos_.Load(MEMORY_ORDER_RELAXED);
+    size_t enqueue_pos = enqueue_pos_.Load(MEMORY_ORDER_RELAXED);
+    intptr_t size = static_cast<intptr_t>(enqueue_pos - dequeue_pos);
+    return size < 0 ? 0 : static_cast<size_t>(size);
+  }
+
+  size_t capacity() const { return mask_ + 1; }
+
+ private:
+  struct Cell {
+    Atomic<size_t> sequence;
+    T item;
+  };
+
+  static size_t RoundUpToPowerOfTwo(size_t n) {
+    size_t power = 2;
+    while (power < n)
+      power *= 2;
+    return power;
+  }
+
+  char padding0_[kCacheLineSize];
+  const size_t mask_;
+  Cell* const cells_;
+  char padding1_[kCacheLineSize - sizeof(size_t) - sizeof(Cell*)];
+  Atomic<size_t> enqueue_pos_;
+  char padding2_[kCacheLineSize - sizeof(Atomic<size_t>)];
+  Atomic<size_t> dequeue_pos_;
+  char padding3_[kCacheLineSize - sizeof(Atomic<size_t>)];
+
+  DISALLOW_COPY_AND_ASSIGN(MpmcQueue);
+};
+
+template <typename T>
+class BlockingMpmcQueue {
+ public:
+  // |capacity| is rounded up to a power of two, and to at least 2.
+  explicit BlockingMpmcQueue(size_t capacity)
+      : queue_(capacity),
+        lock_("BlockingMpmcQueue::lock_"),
+        not_empty_(&lock_),
+        not_full_(&lock_),
+        waiting_consumers_(0),
+        waiting_producers_(0) {}
+
+  // No thread may be blocked in Push() or Pop().
+  ~BlockingMpmcQueue() {}
+
+  // Waits for room, then pushes |item|.  Returns false, without pushing, if
+  // the queue is closed.
+  bool Push(const T& item) {
+    SpinWait spin_wait;
+    for (int yields = 0; yields < kYieldsBeforeParking;) {
+      if (IsClosed())
+        return false;
+      if (queue_.TryPush(item)) {
+        WakeWaiter(&waiting_consumers_, &not_empty_);
+        return true;
+      }
+      if (spin_wait.yielding())
+        yields++;
+      spin_wait.Once();
+    }
+
+    {
+      AutoLock auto_lock(lock_);
+      waiting_producers_.FetchAdd(1, MEMORY_ORDER_SEQ_CST);
+      bool pushed = false;
+      while (!IsClosed() && !(pushed = queue_.TryPush(item)))
+        not_full_.Wait();
+      waiting_producers_.FetchSub(1, MEMORY_ORDER_RELAXED);
+      if (!pushed)
+        return false;
+    }
+    WakeWaiter(&waiting_consumers_, &not_empty_);
+    return true;
+  }
+
+  // Waits for an item, then pops it into |item|.  Returns false once the
+  // queue is closed and empty.
+  bool Pop(T* item) {
+    SpinWait spin_wait;
+    for (int yields = 0; yields < kYieldsBeforeParking;) {
+      if (queue_.TryPop(item)) {
+        WakeWaiter(&waiting_producers_, &not_full_);
+        return true;
+      }
+      if (IsClosed())
+        break;
+      if (spin_wait.yielding())
+        yields++;
+      spin_wait.Once();
+    }
+
+    {
+      AutoLock auto_lock(lock_);
+      waiting_consumers_.FetchAdd(1, MEMORY_ORDER_SEQ_CST);
+      bool popped;
+      while (!(popped = queue_.TryPop(item)) && !IsClosed())
+        not_empty_.Wait();
+      waiting_consumers_.FetchSub(1, MEMORY_ORDER_RELAXED);
+      if (!popped)
+        return false;
+    }
+    WakeWaiter(&waiting_producers_, &not_full_);
+    return true;
+  }
+
+  // As Push() and Pop(), but return false rather than wait.
+  bool TryPush(const T& item) {
+    if (IsClosed() || !queue_.TryPush(item))
+      return false;
+    WakeWaiter(&waiting_consumers_, &not_empty_);
+    return true;
+  }
+
+  bool TryPop(T* item) {
+    if (!queue_.TryPop(item))
+      return false;
+    WakeWaiter(&waiting_producers_, &not_full_);
+    return true;
+  }
+
+  // Makes every Push() fail from now on, and Pop() fail once the queue is
+  // empty, waking the threads blocked in either.  Usually called once the
+  // producers are done: a Push() racing with Close() may still succeed, after
+  // the consumers have given up.
+  void Close() {
+    AutoLock auto_lock(lock_);
+    closed_.Set(MEMORY_ORDER_RELAXED);
+    not_empty_.Broadcast();
+    not_full_.Broadcast();
+  }
+
+  bool IsClosed() const { return closed_.IsSet(MEMORY_ORDER_RELAXED); }
+
+  // Only a hint while other threads push or pop.
+  size_t Size() const { return queue_.Size(); }
+
+  size_t capacity() const { return queue_.capacity(); }
+
+ private:
+  // Push() and Pop() spin, then yield this many times, before they park.
+  // Parking and waking cost system calls on both sides, so it only pays off
+  // for waits longer than a few timeslices.
+  static const int kYieldsBeforeParking = 16;
+
+  // Called after pushing (popping), to wake a consumer (producer) parked in
+  // Pop() (Push()).  A thread about to park bumps |*waiting| and then tries
+  // the queue once more, all under |lock_|; here the queue was updated before
+  // |*waiting| is read.  The full barriers on both sides make sure that one
+  // of them sees the other, and signaling under |lock_| means the wakeup
+  // cannot slip in between the parking thread's last try and its Wait().
+  void WakeWaiter(Atomic<int32>* waiting, ConditionVariable* cv) {
+    AtomicThreadFence(MEMORY_ORDER_SEQ_CST);
+    if (waiting->Load(MEMORY_ORDER_RELAXED) == 0)
+      return;
+    AutoLock auto_lock(lock_);
+    cv->Signal();
+  }
+
+  MpmcQueue<T> queue_;
+
+  Lock lock_;
+  ConditionVariable not_empty_;
+  ConditionVariable not_full_;
+  // Threads parked, or about to park, in Pop() and Push().
+  Atomic<int32> waiting_consumers_;
+  Atomic<int32> waiting_producers_;
+  AtomicFlag closed_;  // Written under |lock_|.
+
+  DISALLOW_COPY_AND_ASSIGN(BlockingMpmcQueue);
+};
+
+}  // namespace platform
+
+#endif  // SIMPLEPLATFORMLIB_SRC_MPMC_QUEUE_H_
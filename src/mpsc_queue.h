@@ -0,0 +1,118 @@
+// Copyright (c) 2010 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+// MpscQueue<T> is Dmitry Vyukov's intrusive node-based queue: any number of
+// threads may push, and a single thread pops.  It is unbounded, and the
+// items are linked through an MpscQueueNode that T derives from, so pushing
+// allocates nothing and is a single atomic exchange, however many producers
+// there are.  Popping only needs an atomic exchange when it has caught up
+// with the producers.
+//
+//   struct Message : public MpscQueueNode {
+//     ...
+//   };
+//
+//   MpscQueue<Message> queue;
+//   queue.Push(message);          // On any thread.
+//   Message* next = queue.Pop();  // On the consumer thread.
+//
+// A producer exchanges itself in as the new head, then links the old head to
+// its node.  Between the two steps the queue is cut in two, and Pop() can
+// not get past the break: it returns NULL, even though items pushed later
+// may already be in.  They become visible as soon as the producer finishes
+// its Push(), which is a few instructions unless it gets preempted.
+//
+// The queue does not own its items.  An item may only be in one queue at a
+// time, and must stay alive until it is popped.
+
+#ifndef SIMPLEPLATFORMLIB_SRC_MPSC_QUEUE_H_
+#define SIMPLEPLATFORMLIB_SRC_MPSC_QUEUE_H_
+#pragma once
+
+#include <stddef.h>
+
+#include "simple-platform-lib/src/atomics.h"
+#include "simple-platform-lib/src/basictypes.h"
+
+namespace platform {
+
+struct MpscQueueNode {
+  MpscQueueNode() : next(NULL) {}
+  // A copy is not in any queue.
+  MpscQueueNode(const MpscQueueNode&) : next(NULL) {}
+  MpscQueueNode& operator=(const MpscQueueNode&) { return *this; }
+
+  Atomic<MpscQueueNode*> next;
+};
+
+template <typename T>
+class MpscQueue {
+ public:
+  MpscQueue() : head_(&stub_), tail_(&stub_) {}
+
+  // Any thread.
+  void Push(T* item) {
+    PushNode(item);
+  }
+
+  // Consumer only.  Returns the oldest item, or NULL if the queue is empty or
+  // a Push() is halfway done (see above).
+  T* Pop() {
+    MpscQueueNode* tail = tail_;
+    MpscQueueNode* next = tail->next.Load(MEMORY_ORDER_ACQUIRE);
+    if (tail == &stub_) {
+      // The stub marks where the consumer last caught up; skip it.
+      if (!next)
+        return NULL;
+      tail_ = next;
+      tail = next;
+      next = tail->next.Load(MEMORY_ORDER_ACQUIRE);
+    }
+    if (next) {
+      tail_ = next;
+      return static_cast<T*>(tail);
+    }
+
+    // |tail| is the last linked node.  Unless a Push() is under way, it is
+    // also the head; then push the stub behind it so that it can be taken.
+    if (tail != head_.Load(MEMORY_ORDER_ACQUIRE))
+      return NULL;
+    PushNode(&stub_);
+    next = tail->next.Load(MEMORY_ORDER_ACQUIRE);
+    if (next) {
+      tail_ = next;
+      return static_cast<T*>(tail);
+    }
+    return NULL;
+  }
+
+  // Consumer only.  Like Pop(), may report a queue with a Push() halfway done
+  // as empty.
+  bool Empty() const {
+    MpscQueueNode* tail = tail_;
+    if (tail == &stub_)
+      tail = tail->next.Load(MEMORY_ORDER_ACQUIRE);
+    return tail == NULL;
+  }
+
+ private:
+  void PushNode(MpscQueueNode* node) {
+    node->next.Store(NULL, MEMORY_ORDER_RELAXED);
+    MpscQueueNode* previous = head_.Exchange(node, MEMORY_ORDER_ACQ_REL);
+    previous->next.Store(node, MEMORY_ORDER_RELEASE);
+  }
+
+  // The most recently pushed node.  Written by every producer.
+  Atomic<MpscQueueNode*> head_;
+  char padding_[kCacheLineSize - sizeof(Atomic<MpscQueueNode*>)];
+  // The next node to pop.  Consumer only.
+  MpscQueueNode* tail_;
+  MpscQueueNode stub_;
+
+  DISALLOW_COPY_AND_ASSIGN(MpscQueue);
+};
+
+}  // namespace platform
+
+#endif  // SIMPLEPLATFORMLIB_SRC_MPSC_QUEUE_H_
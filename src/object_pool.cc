@@ -0,0 +1,166 @@
+// Copyright (c) 2010 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "simple-platform-lib/src/object_pool.h"
+
+#include <new>
+
+namespace platform {
+namespace internal {
+
+namespace {
+
+// Slabs are at least this big, and hold at least a magazine's worth.
+const size_t kMinSlabSize = 64 * 1024;
+
+size_t RoundUp(size_t size, size_t alignment) {
+  return (size + alignment - 1) & ~(alignment - 1);
+}
+
+}  // namespace
+
+void MagazineDepot::Push(ObjectPoolMagazine* magazine) {
+  ObjectPoolMagazine* head = head_.Load(MEMORY_ORDER_RELAXED);
+  do {
+    magazine->next = head;
+  } while (!head_.CompareExchangeWeak(&head, magazine, MEMORY_ORDER_RELEASE,
+                                      MEMORY_ORDER_RELAXED));
+}
+
+ObjectPoolMagazine* MagazineDepot::Pop() {
+  if (!head_.Load(MEMORY_ORDER_RELAXED))
+    return NULL;
+  AutoLock auto_lock(pop_lock_);
+  // Pushes may still move |head_| on, but only this thread takes magazines
+  // off, so |magazine| stays in the stack, and its next link unchanged,
+  // until the compare-and-swap below.
+  ObjectPoolMagazine* magazine = head_.Load(MEMORY_ORDER_ACQUIRE);
+  while (magazine) {
+    if (head_.CompareExchangeWeak(&magazine, magazine->next,
+                                  MEMORY_ORDER_ACQUIRE,
+                                  MEMORY_ORDER_ACQUIRE)) {
+      magazine->next = NULL;
+      break;
+    }
+  }
+  return magazine;
+}
+
+ObjectPoolMagazine* MagazineDepot::PopAll() {
+  AutoLock auto_lock(pop_lock_);
+  return head_.Exchange(NULL, MEMORY_ORDER_ACQUIRE);
+}
+
+ObjectPoolBase::ThreadMagazines::~ThreadMagazines() {
+  if (owner)
+    owner->Drain(this);
+}
+
+ObjectPoolBase::ObjectPoolBase(size_t object_size, size_t alignment)
+    : object_size_(RoundUp(object_size > 0 ? object_size : 1,
+                           alignment > sizeof(void*) ? alignment :
+                                                       sizeof(void*))),
+      objects_per_slab_(object_size_ * kMagazineSize > kMinSlabSize ?
+                            kMagazineSize : kMinSlabSize / object_size_),
+      slab_lock_("ObjectPoolBase::slab_lock_"),
+      slab_cursor_(NULL),
+      slab_end_(NULL),
+      capacity_(0) {
+}
+
+ObjectPoolBase::~ObjectPoolBase() {
+  ThreadMagazines* magazines = magazines_.GetIfExists();
+  if (magazines)
+    Drain(magazines);
+  for (int i = 0; i < 2; i++) {
+    ObjectPoolMagazine* magazine = i == 0 ? full_.PopAll() : empty_.PopAll();
+    while (magazine) {
+      ObjectPoolMagazine* next = magazine->next;
+      delete magazine;
+      magazine = next;
+    }
+  }
+  for (size_t i = 0; i < slabs_.size(); i++)
+    operator delete(slabs_[i]);
+}
+
+void* ObjectPoolBase::AllocateSlow(ThreadMagazines* magazines) {
+  if (!magazines->loaded)
+    LoadMagazines(magazines);
+
+  if (!IsEmpty(magazines->previous)) {
+    ObjectPoolMagazine* loaded = magazines->loaded;
+    magazines->loaded = magazines->previous;
+    magazines->previous = loaded;
+  } else {
+    ObjectPoolMagazine* full = full_.Pop();
+    if (full) {
+      empty_.Push(magazines->previous);
+      magazines->previous = magazines->loaded;
+      magazines->loaded = full;
+    } else {
+      FillFromSlab(magazines->loaded);
+    }
+  }
+  return Pop(magazines->loaded);
+}
+
+void ObjectPoolBase::FreeSlow(ThreadMagazines* magazines, void* object) {
+  if (!magazines->loaded) {
+    LoadMagazines(magazines);
+  } else if (IsEmpty(magazines->previous)) {
+    ObjectPoolMagazine* loaded = magazines->loaded;
+    magazines->loaded = magazines->previous;
+    magazines->previous = loaded;
+  } else {
+    full_.Push(magazines->previous);
+    magazines->previous = magazines->loaded;
+    magazines->loaded = GetEmptyMagazine();
+  }
+  Push(magazines->loaded, object);
+}
+
+void ObjectPoolBase::LoadMagazines(ThreadMagazines* magazines) {
+  magazines->owner = this;
+  magazines->loaded = GetEmptyMagazine();
+  magazines->previous = GetEmptyMagazine();
+}
+
+ObjectPoolMagazine* ObjectPoolBase::GetEmptyMagazine() {
+  ObjectPoolMagazine* magazine = empty_.Pop();
+  return magazine ? magazine : new ObjectPoolMagazine;
+}
+
+void ObjectPoolBase::FillFromSlab(ObjectPoolMagazine* magazine) {
+  AutoLock auto_lock(slab_lock_);
+  while (!IsFull(magazine)) {
+    if (slab_cursor_ == slab_end_) {
+      size_t slab_size = objects_per_slab_ * object_size_;
+      slab_cursor_ = static_cast<char*>(operator new(slab_size));
+      slab_end_ = slab_cursor_ + slab_size;
+      slabs_.push_back(slab_cursor_);
+    }
+    Push(magazine, slab_cursor_);
+    slab_cursor_ += object_size_;
+    capacity_.Store(capacity_.Load(MEMORY_ORDER_RELAXED) + 1,
+                    MEMORY_ORDER_RELAXED);
+  }
+}
+
+void ObjectPoolBase::Drain(ThreadMagazines* magazines) {
+  ObjectPoolMagazine* loaded[2] = { magazines->loaded, magazines->previous };
+  for (int i = 0; i < 2; i++) {
+    if (!loaded[i])
+      continue;
+    if (IsEmpty(loaded[i]))
+      empty_.Push(loaded[i]);
+    else
+      full_.Push(loaded[i]);
+  }
+  magazines->loaded = NULL;
+  magazines->previous = NULL;
+}
+
+}  // namespace internal
+}  // namespace platform
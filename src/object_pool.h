@@ -0,0 +1,231 @@
+// Copyright (c) 2010 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+// ObjectPool<T> allocates objects of one type from slabs, and recycles them
+// through magazines, after Bonwick and Adams' allocator ("Magazines and
+// Vmem", USENIX 2001):
+//
+//   ObjectPool<Message> pool;
+//   Message* message = pool.New();
+//   ...
+//   pool.Delete(message);  // On any thread.
+//
+// A magazine is a stack of up to kMagazineSize free objects.  Each thread
+// keeps two (see thread_local.h), and allocates from and frees to them
+// without synchronization.  When both are empty, the thread swaps an empty
+// one for a full one from the pool's depot; when both are full, it swaps a
+// full one for an empty one.  So a thread that frees objects another
+// thread allocated (a consumer freeing what a producer made) hands them
+// back a magazine at a time.  The depot is two stacks, of full magazines
+// and of empty ones, pushed without a lock; popping one, and carving new
+// objects off a slab, each take a Lock.
+//
+// Objects go back to the depot, never to the slabs: a pool's memory is its
+// peak use, and is only freed when the pool is destroyed, at which point
+// every object must have been deleted, and every other thread that used the
+// pool must have exited.
+
+#ifndef SIMPLEPLATFORMLIB_SRC_OBJECT_POOL_H_
+#define SIMPLEPLATFORMLIB_SRC_OBJECT_POOL_H_
+#pragma once
+
+#include <stddef.h>
+
+#include <new>
+#include <vector>
+
+#include "simple-platform-lib/src/atomics.h"
+#include "simple-platform-lib/src/basictypes.h"
+#include "simple-platform-lib/src/lock.h"
+#include "simple-platform-lib/src/thread_local.h"
+
+namespace platform {
+
+namespace internal {
+
+struct ObjectPoolMagazine;
+
+// A stack of magazines that threads push without a lock.  Popping unlinks
+// the top magazine with a compare-and-swap, under |pop_lock_|: with one
+// popper at a time, no magazine can be popped and pushed again while the
+// popper looks at it (the ABA problem), and magazines are only deleted with
+// the depot.
+class MagazineDepot {
+ public:
+  MagazineDepot() : pop_lock_("MagazineDepot::pop_lock_"), head_(NULL) {}
+
+  void Push(ObjectPoolMagazine* magazine);
+
+  // Returns NULL if the stack is empty.
+  ObjectPoolMagazine* Pop();
+
+  // Returns the whole stack, linked through ObjectPoolMagazine::next.
+  ObjectPoolMagazine* PopAll();
+
+ private:
+  Lock pop_lock_;
+  Atomic<ObjectPoolMagazine*> head_;
+
+  DISALLOW_COPY_AND_ASSIGN(MagazineDepot);
+};
+
+// The untyped part of ObjectPool<T>.
+class ObjectPoolBase {
+ public:
+  static const int kMagazineSize = 64;
+
+  // Objects are |object_size| bytes, rounded up to a multiple of
+  // |alignment|, which must be a power of two no larger than what operator
+  // new guarantees.
+  ObjectPoolBase(size_t object_size, size_t alignment);
+  ~ObjectPoolBase();
+
+  void* Allocate() {
+    ThreadMagazines* magazines = magazines_.Get();
+    ObjectPoolMagazine* loaded = magazines->loaded;
+    if (loaded && !IsEmpty(loaded))
+      return Pop(loaded);
+    return AllocateSlow(magazines);
+  }
+
+  void Free(void* object) {
+    ThreadMagazines* magazines = magazines_.Get();
+    ObjectPoolMagazine* loaded = magazines->loaded;
+    if (loaded && !IsFull(loaded)) {
+      Push(loaded, object);
+      return;
+    }
+    FreeSlow(magazines, object);
+  }
+
+  size_t object_size() const { return object_size_; }
+
+  size_t capacity() const { return capacity_.Load(MEMORY_ORDER_RELAXED); }
+
+ private:
+  // A thread's magazines.
+  struct ThreadMagazines {
+    ThreadMagazines() : owner(NULL), loaded(NULL), previous(NULL) {}
+    // Gives the magazines to |owner|'s depot.
+    ~ThreadMagazines();
+
+    ObjectPoolBase* owner;
+    ObjectPoolMagazine* loaded;
+    ObjectPoolMagazine* previous;
+  };
+
+  static bool IsEmpty(const ObjectPoolMagazine* magazine);
+  static bool IsFull(const ObjectPoolMagazine* magazine);
+  static void* Pop(ObjectPoolMagazine* magazine);
+  static void Push(ObjectPoolMagazine* magazine, void* object);
+
+  void* AllocateSlow(ThreadMagazines* magazines);
+  void FreeSlow(ThreadMagazines* magazines, void* object);
+
+  // Gives |magazines| two empty magazines, the first time.
+  void LoadMagazines(ThreadMagazines* magazines);
+  // Returns an empty magazine from the depot, or a new one.
+  ObjectPoolMagazine* GetEmptyMagazine();
+  // Fills |magazine| with objects carved off the slabs.
+  void FillFromSlab(ObjectPoolMagazine* magazine);
+  // Gives |magazines|' magazines to the depot.
+  void Drain(ThreadMagazines* magazines);
+
+  const size_t object_size_;
+  const size_t objects_per_slab_;
+
+  // Magazines with objects in them: full ones, and those that exiting
+  // threads left part-full.
+  MagazineDepot full_;
+  MagazineDepot empty_;
+
+  Lock slab_lock_;
+  // The following are protected by |slab_lock_|.
+  std::vector<void*> slabs_;
+  char* slab_cursor_;
+  char* slab_end_;
+  // The objects carved off the slabs; only written under |slab_lock_|.
+  Atomic<size_t> capacity_;
+
+  ThreadLocal<ThreadMagazines> magazines_;
+
+  DISALLOW_COPY_AND_ASSIGN(ObjectPoolBase);
+};
+
+// The magazine is defined here, so that the fast paths above inline.
+struct ObjectPoolMagazine {
+  ObjectPoolMagazine() : next(NULL), count(0) {}
+
+  // The next magazine in a depot.
+  ObjectPoolMagazine* next;
+  int count;
+  void* objects[ObjectPoolBase::kMagazineSize];
+};
+
+inline bool ObjectPoolBase::IsEmpty(const ObjectPoolMagazine* magazine) {
+  return magazine->count == 0;
+}
+
+inline bool ObjectPoolBase::IsFull(const ObjectPoolMagazine* magazine) {
+  return magazine->count == kMagazineSize;
+}
+
+inline void* ObjectPoolBase::Pop(ObjectPoolMagazine* magazine) {
+  return magazine->objects[--magazine->count];
+}
+
+inline void ObjectPoolBase::Push(ObjectPoolMagazine* magazine,
+                                 void* object) {
+  magazine->objects[magazine->count++] = object;
+}
+
+}  // namespace internal
+
+template <typename T>
+class ObjectPool {
+ public:
+  ObjectPool() : base_(sizeof(T), __alignof__(T)) {}
+
+  T* New() {
+    return new (base_.Allocate()) T;
+  }
+
+  template <typename A1>
+  T* New(const A1& a1) {
+    return new (base_.Allocate()) T(a1);
+  }
+
+  template <typename A1, typename A2>
+  T* New(const A1& a1, const A2& a2) {
+    return new (base_.Allocate()) T(a1, a2);
+  }
+
+  // Destroys |object|, which must come from this pool, and recycles its
+  // memory.  May be called on any thread.
+  void Delete(T* object) {
+    if (!object)
+      return;
+    object->~T();
+    base_.Free(object);
+  }
+
+  // Raw memory for a T, for constructors that New() does not cover; give it
+  // back with Free() (after destroying the T, if one was constructed).
+  void* Allocate() { return base_.Allocate(); }
+  void Free(void* memory) { base_.Free(memory); }
+
+  // The objects the pool has carved off its slabs so far.  Freed objects are
+  // reused before new ones are carved, so this stays within the peak number
+  // of live objects plus a few magazines per thread.
+  size_t capacity() const { return base_.capacity(); }
+
+ private:
+  internal::ObjectPoolBase base_;
+
+  DISALLOW_COPY_AND_ASSIGN(ObjectPool);
+};
+
+}  // namespace platform
+
+#endif  // SIMPLEPLATFORMLIB_SRC_OBJECT_POOL_H_
@@ -0,0 +1,201 @@
+// Copyright (c) 2010 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+// Data-parallel loops on a WorkStealingScheduler, by default the shared
+// WorkStealingScheduler::GetDefault().
+//
+//   class ScaleBody {
+//    public:
+//     void operator()(int64 begin, int64 end) const {
+//       for (int64 i = begin; i < end; i++)
+//         values_[i] *= factor_;
+//     }
+//     ...
+//   };
+//
+//   ParallelFor(0, count, 1024, ScaleBody(values, 2.0));
+//
+// The body is called on disjoint subranges of [begin, end) which together
+// cover it, possibly concurrently, and must be callable as const.  Ranges of
+// at most |grain| elements are never split.
+//
+// The range is split adaptively (lazy binary splitting, Tzannes et al., PPoPP
+// 2010): a task works through its range |grain| elements at a time, and only
+// splits off the second half of what is left when its worker's deque is
+// empty, i.e. when an idle worker would have nothing to steal.  So skewed
+// ranges get balanced, while a loop that every worker is already busy with
+// runs in big sequential chunks, and |grain| can be small without paying for
+// a task per grain.
+//
+// Ranges of at most |grain| elements, and all ranges on a scheduler with a
+// single worker, are run inline on the calling thread.
+
+#ifndef SIMPLEPLATFORMLIB_SRC_PARALLEL_H_
+#define SIMPLEPLATFORMLIB_SRC_PARALLEL_H_
+#pragma once
+
+#include <deque>
+
+#include "simple-platform-lib/src/basictypes.h"
+#include "simple-platform-lib/src/task.h"
+#include "simple-platform-lib/src/work_stealing_scheduler.h"
+
+namespace platform {
+
+namespace internal {
+
+template <class Body>
+class ParallelForTask : public Task {
+ public:
+  ParallelForTask(WorkStealingScheduler* scheduler, int64 begin, int64 end,
+                  int64 grain, const Body& body)
+      : scheduler_(scheduler), begin_(begin), end_(end), grain_(grain),
+        body_(body) {}
+
+  virtual void Run() {
+    TaskGroup group(scheduler_);
+    int64 begin = begin_;
+    int64 end = end_;
+    while (end - begin > grain_) {
+      if (scheduler_->CurrentQueueEmpty()) {
+        int64 middle = begin + (end - begin) / 2;
+        group.Spawn(new ParallelForTask(scheduler_, middle, end, grain_,
+                                        body_));
+        end = middle;
+      } else {
+        body_(begin, begin + grain_);
+        begin += grain_;
+      }
+    }
+    body_(begin, end);
+    group.Join();
+  }
+
+ private:
+  WorkStealingScheduler* scheduler_;
+  int64 begin_;
+  int64 end_;
+  int64 grain_;
+  const Body& body_;
+
+  DISALLOW_COPY_AND_ASSIGN(ParallelForTask);
+};
+
+template <class T, class Body, class Combine>
+class ParallelReduceTask : public Task {
+ public:
+  ParallelReduceTask(WorkStealingScheduler* scheduler, int64 begin, int64 end,
+                     int64 grain, const T& identity, const Body& body,
+                     const Combine& combine, T* result)
+      : scheduler_(scheduler), begin_(begin), end_(end), grain_(grain),
+        identity_(identity), body_(body), combine_(combine),
+        result_(result) {}
+
+  virtual void Run() {
+    TaskGroup group(scheduler_);
+    // The results of the split-off parts, each to the left of the previous
+    // one; a deque, so that the children's result pointers stay valid.
+    std::deque<T> split_results;
+    T result = identity_;
+    int64 begin = begin_;
+    int64 end = end_;
+    while (end - begin > grain_) {
+      if (scheduler_->CurrentQueueEmpty()) {
+        int64 middle = begin + (end - begin) / 2;
+        split_results.push_front(identity_);
+        group.Spawn(new ParallelReduceTask(scheduler_, middle, end, grain_,
+                                           identity_, body_, combine_,
+                                           &split_results.front()));
+        end = middle;
+      } else {
+        result = combine_(result, body_(begin, begin + grain_));
+        begin += grain_;
+      }
+    }
+    result = combine_(result, body_(begin, end));
+    group.Join();
+
+    // Combine in range order, in case |combine_| is not commutative.
+    for (size_t i = 0; i < split_results.size(); i++)
+      result = combine_(result, split_results[i]);
+    *result_ = result;
+  }
+
+ private:
+  WorkStealingScheduler* scheduler_;
+  int64 begin_;
+  int64 end_;
+  int64 grain_;
+  const T& identity_;
+  const Body& body_;
+  const Combine& combine_;
+  T* result_;
+
+  DISALLOW_COPY_AND_ASSIGN(ParallelReduceTask);
+};
+
+inline bool ShouldRunInline(WorkStealingScheduler* scheduler, int64 begin,
+                            int64 end, int64 grain) {
+  return end - begin <= grain || scheduler->num_threads() <= 1;
+}
+
+}  // namespace internal
+
+// Calls |body|(sub_begin, sub_end) on subranges covering [begin, end), on
+// |scheduler|.  |grain| is the smallest range worth a task of its own; values
+// below 1 are taken as 1.
+template <class Body>
+void ParallelFor(WorkStealingScheduler* scheduler, int64 begin, int64 end,
+                 int64 grain, const Body& body) {
+  if (begin >= end)
+    return;
+  if (grain < 1)
+    grain = 1;
+  if (internal::ShouldRunInline(scheduler, begin, end, grain)) {
+    body(begin, end);
+    return;
+  }
+  TaskGroup group(scheduler);
+  group.Spawn(new internal::ParallelForTask<Body>(scheduler, begin, end,
+                                                  grain, body));
+  group.Join();
+}
+
+template <class Body>
+void ParallelFor(int64 begin, int64 end, int64 grain, const Body& body) {
+  ParallelFor(WorkStealingScheduler::GetDefault(), begin, end, grain, body);
+}
+
+// Returns |combine| applied over |body|(sub_begin, sub_end) for subranges
+// covering [begin, end), in range order; |identity| if the range is empty.
+// |body| returns a T, and |combine| must be associative with |identity| as
+// its identity element, but need not be commutative.
+template <class T, class Body, class Combine>
+T ParallelReduce(WorkStealingScheduler* scheduler, int64 begin, int64 end,
+                 int64 grain, const T& identity, const Body& body,
+                 const Combine& combine) {
+  if (begin >= end)
+    return identity;
+  if (grain < 1)
+    grain = 1;
+  if (internal::ShouldRunInline(scheduler, begin, end, grain))
+    return combine(identity, body(begin, end));
+  T result = identity;
+  TaskGroup group(scheduler);
+  group.Spawn(new internal::ParallelReduceTask<T, Body, Combine>(
+      scheduler, begin, end, grain, identity, body, combine, &result));
+  group.Join();
+  return result;
+}
+
+template <class T, class Body, class Combine>
+T ParallelReduce(int64 begin, int64 end, int64 grain, const T& identity,
+                 const Body& body, const Combine& combine) {
+  return ParallelReduce(WorkStealingScheduler::GetDefault(), begin, end, grain,
+                        identity, body, combine);
+}
+
+}  // namespace platform
+
+#endif  // SIMPLEPLATFORMLIB_SRC_PARALLEL_H_
@@ -0,0 +1,105 @@
+// Copyright (c) 2010 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+// Reader/writer lock: any number of readers, or a single writer.  Use it for
+// data that is read far more often than it is written; for anything else a
+// plain Lock is cheaper.  See sharded_rw_lock.h for a variant whose read side
+// scales across processors.
+
+#ifndef SIMPLEPLATFORMLIB_SRC_RW_LOCK_H_
+#define SIMPLEPLATFORMLIB_SRC_RW_LOCK_H_
+#pragma once
+
+#include "simple-platform-lib/build/build_config.h"
+
+#if defined(OS_POSIX)
+#include <pthread.h>
+#endif
+
+#include "simple-platform-lib/src/basictypes.h"
+
+namespace platform {
+
+class RWLock {
+ public:
+  // Which side wins when readers hold the lock and a writer is waiting.
+  // PREFER_READERS lets new readers in, which maximizes read throughput but
+  // can starve writers; PREFER_WRITERS holds new readers back until the
+  // waiting writer has been served.  Where the platform does not support the
+  // choice (everywhere but glibc), the platform default is used.
+  enum Preference {
+    PREFER_READERS,
+    PREFER_WRITERS
+  };
+
+  RWLock();
+  explicit RWLock(Preference preference);
+  ~RWLock();
+
+  // Take the lock shared, blocking while a writer holds it.  Read locks are
+  // not recursive: a thread must not acquire one it already holds, since a
+  // writer may have queued up in between.
+  void ReadAcquire();
+  void ReadRelease();
+  // If the lock can be taken shared without blocking, take it and return true.
+  bool ReadTry();
+
+  // Take the lock exclusively, blocking while anybody else holds it.
+  void WriteAcquire();
+  void WriteRelease();
+  // If nobody holds the lock, take it exclusively and return true.
+  bool WriteTry();
+
+ private:
+  void Init(Preference preference);
+
+#if defined(OS_POSIX)
+  pthread_rwlock_t native_lock_;
+#endif
+
+  DISALLOW_COPY_AND_ASSIGN(RWLock);
+};
+
+// Helpers that hold a reader/writer lock in shared (read) or exclusive (write)
+// mode while in scope, in the style of AutoLock.  They work with any type that
+// has the ReadAcquire()/ReadRelease() and WriteAcquire()/WriteRelease()
+// methods above.
+template <class RWLockType>
+class BasicAutoReadLock {
+ public:
+  explicit BasicAutoReadLock(RWLockType& lock) : lock_(lock) {
+    lock_.ReadAcquire();
+  }
+
+  ~BasicAutoReadLock() {
+    lock_.ReadRelease();
+  }
+
+ private:
+  RWLockType& lock_;
+  DISALLOW_COPY_AND_ASSIGN(BasicAutoReadLock);
+};
+
+template <class RWLockType>
+class BasicAutoWriteLock {
+ public:
+  explicit BasicAutoWriteLock(RWLockType& lock) : lock_(lock) {
+    lock_.WriteAcquire();
+  }
+
+  ~BasicAutoWriteLock() {
+    lock_.WriteRelease();
+  }
+
+ private:
+  RWLockType& lock_;
+  DISALLOW_COPY_AND_ASSIGN(BasicAutoWriteLock);
+};
+
+typedef BasicAutoReadLock<RWLock> AutoReadLock;
+typedef BasicAutoWriteLock<RWLock> AutoWriteLock;
+
+}  // namespace platform
+
+#endif  // SIMPLEPLATFORMLIB_SRC_RW_LOCK_H_
@@ -0,0 +1,86 @@
+// Copyright (c) 2010 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "simple-platform-lib/src/rw_lock.h"
+
+#include <errno.h>
+
+//FIXME
+//#include "base/logging.h"
+
+namespace platform {
+
+RWLock::RWLock() {
+  Init(PREFER_READERS);
+}
+
+RWLock::RWLock(Preference preference) {
+  Init(preference);
+}
+
+RWLock::~RWLock() {
+  int rv = pthread_rwlock_destroy(&native_lock_);
+//  DCHECK_EQ(rv, 0);
+(void)rv;
+}
+
+void RWLock::Init(Preference preference) {
+  pthread_rwlockattr_t attrs;
+  int rv = pthread_rwlockattr_init(&attrs);
+//  DCHECK_EQ(rv, 0);
+#if defined(__GLIBC__)
+  // glibc defaults to preferring readers.  The writer preference is only
+  // available in the non-recursive flavor, which matches our contract anyway.
+  if (preference == PREFER_WRITERS) {
+    rv = pthread_rwlockattr_setkind_np(
+        &attrs, PTHREAD_RWLOCK_PREFER_WRITER_NONRECURSIVE_NP);
+//    DCHECK_EQ(rv, 0);
+  }
+#else
+  (void)preference;
+#endif
+  rv = pthread_rwlock_init(&native_lock_, &attrs);
+//  DCHECK_EQ(rv, 0);
+  rv = pthread_rwlockattr_destroy(&attrs);
+//  DCHECK_EQ(rv, 0);
+(void)rv;
+}
+
+void RWLock::ReadAcquire() {
+  int rv = pthread_rwlock_rdlock(&native_lock_);
+//  DCHECK_EQ(rv, 0);
+(void)rv;
+}
+
+void RWLock::ReadRelease() {
+  int rv = pthread_rwlock_unlock(&native_lock_);
+//  DCHECK_EQ(rv, 0);
+(void)rv;
+}
+
+bool RWLock::ReadTry() {
+  int rv = pthread_rwlock_tryrdlock(&native_lock_);
+//  DCHECK(rv == 0 || rv == EBUSY);
+  return rv == 0;
+}
+
+void RWLock::WriteAcquire() {
+  int rv = pthread_rwlock_wrlock(&native_lock_);
+//  DCHECK_EQ(rv, 0);
+(void)rv;
+}
+
+void RWLock::WriteRelease() {
+  int rv = pthread_rwlock_unlock(&native_lock_);
+//  DCHECK_EQ(rv, 0);
+(void)rv;
+}
+
+bool RWLock::WriteTry() {
+  int rv = pthread_rwlock_trywrlock(&native_lock_);
+//  DCHECK(rv == 0 || rv == EBUSY);
+  return rv == 0;
+}
+
+}  // namespace platform
@@ -0,0 +1,93 @@
+// Copyright (c) 2010 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+// SeqLock<T> protects a small, trivially copyable value that is read far more
+// often than it is written (clock offsets, routing epochs, counters).
+//
+// Readers never write shared memory: Read() copies the value between two reads
+// of a sequence counter, and retries if a writer was active in between.  Many
+// readers on many processors therefore scale perfectly, but a steady stream of
+// writes can make readers retry indefinitely, and every read copies the whole
+// value, so keep T small.  Writers are serialized by an embedded LockImpl.
+//
+//   struct ClockOffset { int64 offset_ns; int64 drift_ppb; };
+//   SeqLock<ClockOffset> offset;
+//
+//   ClockOffset snapshot = offset.Read();   // Any thread, any time.
+//   offset.Write(new_offset);               // Blocks only other writers.
+
+#ifndef SIMPLEPLATFORMLIB_SRC_SEQ_LOCK_H_
+#define SIMPLEPLATFORMLIB_SRC_SEQ_LOCK_H_
+#pragma once
+
+#include <string.h>
+
+#if __cplusplus >= 201103L
+#include <type_traits>
+#endif
+
+#include "simple-platform-lib/src/atomics.h"
+#include "simple-platform-lib/src/basictypes.h"
+#include "simple-platform-lib/src/lock_impl.h"
+#include "simple-platform-lib/src/spin_wait.h"
+
+namespace platform {
+
+template <typename T>
+class SeqLock {
+ public:
+  SeqLock() : sequence_(0), value_() {}
+  explicit SeqLock(const T& value) : sequence_(0), value_(value) {}
+
+  // Returns a consistent snapshot of the value.
+  T Read() const {
+    T result;
+    for (;;) {
+      uint32 begin = sequence_.Load(MEMORY_ORDER_ACQUIRE);
+      if ((begin & 1) == 0) {
+        memcpy(&result, &value_, sizeof(T));
+        // Keep the copy above from being reordered after the re-check below.
+        AtomicThreadFence(MEMORY_ORDER_ACQUIRE);
+        if (sequence_.Load(MEMORY_ORDER_RELAXED) == begin)
+          return result;
+      }
+      // A write is in progress, or completed while we were copying.
+      CpuRelax();
+    }
+  }
+
+  // Replaces the value.  Concurrent writers are serialized.
+  void Write(const T& value) {
+    writer_lock_.Lock();
+    uint32 sequence = sequence_.Load(MEMORY_ORDER_RELAXED);
+    // An odd sequence number tells readers a write is in progress.  The fence
+    // keeps the stores to |value_| from being reordered before it.
+    sequence_.Store(sequence + 1, MEMORY_ORDER_RELAXED);
+    AtomicThreadFence(MEMORY_ORDER_RELEASE);
+    memcpy(&value_, &value, sizeof(T));
+    sequence_.Store(sequence + 2, MEMORY_ORDER_RELEASE);
+    writer_lock_.Unlock();
+  }
+
+ private:
+  // Read() copies the value with memcpy() while a writer may be changing it,
+  // which is only sound for types without copy constructors or destructors.
+#if __cplusplus >= 201103L
+  COMPILE_ASSERT(std::is_trivially_copyable<T>::value,
+                 seq_lock_requires_a_trivially_copyable_type);
+#else
+  COMPILE_ASSERT(__has_trivial_copy(T) && __has_trivial_destructor(T),
+                 seq_lock_requires_a_trivially_copyable_type);
+#endif
+
+  Atomic<uint32> sequence_;
+  T value_;
+  LockImpl writer_lock_;
+
+  DISALLOW_COPY_AND_ASSIGN(SeqLock);
+};
+
+}  // namespace platform
+
+#endif  // SIMPLEPLATFORMLIB_SRC_SEQ_LOCK_H_
@@ -0,0 +1,62 @@
+// Copyright (c) 2010 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "simple-platform-lib/src/shard_util.h"
+
+#include <stdlib.h>
+
+#if defined(OS_LINUX)
+#include <sched.h>
+#endif
+
+#include "simple-platform-lib/src/atomics.h"
+#include "simple-platform-lib/src/sys_info.h"
+
+namespace platform {
+namespace internal {
+
+namespace {
+
+const int kMaxShards = 256;
+
+// Where sched_getcpu() is not available, each thread sticks to a shard
+// handed out round-robin.  -1 if not chosen yet.
+__thread int g_thread_shard = -1;
+
+Atomic<int> g_next_shard;
+
+}  // namespace
+
+int ShardCount() {
+  int shard_count = 1;
+  while (shard_count < SysInfo::NumberOfProcessors() &&
+         shard_count < kMaxShards)
+    shard_count *= 2;
+  return shard_count;
+}
+
+int CurrentShard() {
+#if defined(OS_LINUX)
+  int cpu = sched_getcpu();
+  if (cpu >= 0)
+    return cpu;
+#endif
+  int shard = g_thread_shard;
+  if (shard < 0) {
+    shard = g_next_shard.FetchAdd(1, MEMORY_ORDER_RELAXED);
+    g_thread_shard = shard;
+  }
+  return shard;
+}
+
+void* AllocateShards(size_t size) {
+  void* shards = NULL;
+  int rv = posix_memalign(&shards, kCacheLineSize, size);
+//  CHECK_EQ(rv, 0);
+(void)rv;
+  return shards;
+}
+
+}  // namespace internal
+}  // namespace platform
@@ -0,0 +1,35 @@
+// Copyright (c) 2010 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+// Helpers for the classes that spread a hot value over per-processor,
+// cache-line-sized shards (ShardedRWLock, ShardedCounter and
+// ShardedHistogram), so that they size and pick their shards the same way.
+
+#ifndef SIMPLEPLATFORMLIB_SRC_SHARD_UTIL_H_
+#define SIMPLEPLATFORMLIB_SRC_SHARD_UTIL_H_
+#pragma once
+
+#include <stddef.h>
+
+#include "simple-platform-lib/build/build_config.h"
+
+namespace platform {
+namespace internal {
+
+// The number of shards to use: the number of processors rounded up to a
+// power of two, and at most 256, to bound the cost of scanning them all.
+int ShardCount();
+
+// A shard for the current thread, to be masked down to the shard count: the
+// processor it is running on, where sched_getcpu() is available, and
+// otherwise an index handed out round-robin that the thread keeps.
+int CurrentShard();
+
+// Allocates |size| bytes starting on a cache line, to be freed with free().
+void* AllocateShards(size_t size);
+
+}  // namespace internal
+}  // namespace platform
+
+#endif  // SIMPLEPLATFORMLIB_SRC_SHARD_UTIL_H_
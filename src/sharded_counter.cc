@@ -0,0 +1,102 @@
+// Copyright (c) 2010 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "simple-platform-lib/src/sharded_counter.h"
+
+#include <stdlib.h>
+
+#include <algorithm>
+
+#include "simple-platform-lib/src/shard_util.h"
+
+namespace platform {
+
+struct ShardedCounter::Shard {
+  Atomic<int64> value;
+  char padding[kCacheLineSize - sizeof(Atomic<int64>)];
+};
+
+ShardedCounter::ShardedCounter()
+    : shards_(NULL),
+      shard_mask_(internal::ShardCount() - 1) {
+  shards_ = static_cast<Shard*>(
+      internal::AllocateShards((shard_mask_ + 1) * sizeof(Shard)));
+  for (int i = 0; i <= shard_mask_; i++)
+    shards_[i].value.Store(0, MEMORY_ORDER_RELAXED);
+}
+
+ShardedCounter::~ShardedCounter() {
+  free(shards_);
+}
+
+void ShardedCounter::Add(int64 delta) {
+  shards_[internal::CurrentShard() & shard_mask_].value.FetchAdd(
+      delta, MEMORY_ORDER_RELAXED);
+}
+
+int64 ShardedCounter::Value() const {
+  int64 value = 0;
+  for (int i = 0; i <= shard_mask_; i++)
+    value += shards_[i].value.Load(MEMORY_ORDER_RELAXED);
+  return value;
+}
+
+ShardedHistogram::ShardedHistogram(const std::vector<int64>& bucket_limits)
+    : bucket_limits_(bucket_limits),
+      shards_(NULL),
+      shard_size_(0),
+      shard_mask_(internal::ShardCount() - 1) {
+  const size_t kPerLine = kCacheLineSize / sizeof(Atomic<int64>);
+  // The buckets and the sum.
+  shard_size_ = (bucket_count() + 1 + kPerLine - 1) / kPerLine * kPerLine;
+  size_t total = (shard_mask_ + 1) * shard_size_;
+  shards_ = static_cast<Atomic<int64>*>(
+      internal::AllocateShards(total * sizeof(Atomic<int64>)));
+  for (size_t i = 0; i < total; i++)
+    shards_[i].Store(0, MEMORY_ORDER_RELAXED);
+}
+
+ShardedHistogram::~ShardedHistogram() {
+  free(shards_);
+}
+
+Atomic<int64>* ShardedHistogram::Shard(int shard) const {
+  return shards_ + shard * shard_size_;
+}
+
+void ShardedHistogram::Add(int64 sample) {
+  size_t bucket = std::upper_bound(bucket_limits_.begin(),
+                                   bucket_limits_.end(), sample) -
+                  bucket_limits_.begin();
+  Atomic<int64>* shard = Shard(internal::CurrentShard() & shard_mask_);
+  shard[bucket].FetchAdd(1, MEMORY_ORDER_RELAXED);
+  shard[bucket_count()].FetchAdd(sample, MEMORY_ORDER_RELAXED);
+}
+
+void ShardedHistogram::GetCounts(std::vector<int64>* counts) const {
+  counts->assign(bucket_count(), 0);
+  for (int i = 0; i <= shard_mask_; i++) {
+    Atomic<int64>* shard = Shard(i);
+    for (size_t bucket = 0; bucket < bucket_count(); bucket++)
+      (*counts)[bucket] += shard[bucket].Load(MEMORY_ORDER_RELAXED);
+  }
+}
+
+int64 ShardedHistogram::TotalCount() const {
+  std::vector<int64> counts;
+  GetCounts(&counts);
+  int64 total = 0;
+  for (size_t bucket = 0; bucket < counts.size(); bucket++)
+    total += counts[bucket];
+  return total;
+}
+
+int64 ShardedHistogram::Sum() const {
+  int64 sum = 0;
+  for (int i = 0; i <= shard_mask_; i++)
+    sum += Shard(i)[bucket_count()].Load(MEMORY_ORDER_RELAXED);
+  return sum;
+}
+
+}  // namespace platform
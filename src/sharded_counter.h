@@ -0,0 +1,92 @@
+// Copyright (c) 2010 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+// ShardedCounter and ShardedHistogram are statistics that many threads update
+// all the time and that are read rarely, such as request counts and latency
+// distributions.
+//
+// A counter behind a Lock, or even a single atomic, puts every update from
+// every processor on the same cache line, which then becomes the hottest line
+// in the process.  Here each processor updates a cache-line-sized shard of
+// its own, picked with sched_getcpu() on Linux (which recent C libraries
+// answer from the rseq area the kernel keeps up to date, without a system
+// call), so updates from different processors do not touch the same line.
+// Reads add up all the shards.
+//
+//   ShardedCounter requests;
+//   requests.Increment();               // On any thread, as often as needed.
+//   int64 total = requests.Value();     // Occasionally.
+//
+// A thread can be migrated between picking its shard and updating it, so
+// the updates are still atomic read-modify-writes; they are just nearly
+// always to a line already in the processor's cache.  The price is memory: a
+// cache line per processor per counter, and the histogram's buckets per
+// processor.  Reads are not snapshots: updates made while the shards are
+// being added up may or may not be counted.
+
+#ifndef SIMPLEPLATFORMLIB_SRC_SHARDED_COUNTER_H_
+#define SIMPLEPLATFORMLIB_SRC_SHARDED_COUNTER_H_
+#pragma once
+
+#include <vector>
+
+#include "simple-platform-lib/src/atomics.h"
+#include "simple-platform-lib/src/basictypes.h"
+
+namespace platform {
+
+class ShardedCounter {
+ public:
+  ShardedCounter();
+  ~ShardedCounter();
+
+  void Increment() { Add(1); }
+  void Add(int64 delta);
+
+  // The sum of everything added so far.
+  int64 Value() const;
+
+ private:
+  struct Shard;
+
+  Shard* shards_;
+  int shard_mask_;  // Number of shards, minus one; a power of two minus one.
+
+  DISALLOW_COPY_AND_ASSIGN(ShardedCounter);
+};
+
+// Counts samples into buckets bounded by |bucket_limits|, which must be in
+// increasing order: bucket 0 holds the samples below bucket_limits[0], bucket
+// i those in [bucket_limits[i - 1], bucket_limits[i]), and the last bucket,
+// number bucket_limits.size(), those at or above the last limit.
+class ShardedHistogram {
+ public:
+  explicit ShardedHistogram(const std::vector<int64>& bucket_limits);
+  ~ShardedHistogram();
+
+  void Add(int64 sample);
+
+  // Stores the number of samples in each bucket into |counts|.
+  void GetCounts(std::vector<int64>* counts) const;
+  // The number of samples and their sum.
+  int64 TotalCount() const;
+  int64 Sum() const;
+
+  size_t bucket_count() const { return bucket_limits_.size() + 1; }
+
+ private:
+  // Each shard is |shard_size_| Atomic<int64>s: one per bucket, then the sum.
+  Atomic<int64>* Shard(int shard) const;
+
+  const std::vector<int64> bucket_limits_;
+  Atomic<int64>* shards_;
+  size_t shard_size_;  // Padded to a whole number of cache lines.
+  int shard_mask_;
+
+  DISALLOW_COPY_AND_ASSIGN(ShardedHistogram);
+};
+
+}  // namespace platform
+
+#endif  // SIMPLEPLATFORMLIB_SRC_SHARDED_COUNTER_H_
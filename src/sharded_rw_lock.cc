@@ -0,0 +1,115 @@
+// Copyright (c) 2010 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "simple-platform-lib/src/sharded_rw_lock.h"
+
+#include <stdlib.h>
+
+#include "simple-platform-lib/src/shard_util.h"
+#include "simple-platform-lib/src/spin_wait.h"
+
+namespace platform {
+
+namespace {
+
+// The shard index of the current thread, or -1 if not chosen yet.  A thread
+// keeps its shard for its lifetime so that a read lock is always released in
+// the shard it was taken in, even if the thread migrates in between.
+__thread int g_current_shard = -1;
+
+}  // namespace
+
+struct ShardedRWLock::Shard {
+  Atomic<int32> readers;
+  char padding[kCacheLineSize - sizeof(Atomic<int32>)];
+};
+
+ShardedRWLock::ShardedRWLock()
+    : shards_(NULL),
+      shard_mask_(internal::ShardCount() - 1) {
+  shards_ = static_cast<Shard*>(
+      internal::AllocateShards((shard_mask_ + 1) * sizeof(Shard)));
+  for (int i = 0; i <= shard_mask_; i++)
+    shards_[i].readers.Store(0, MEMORY_ORDER_RELAXED);
+}
+
+ShardedRWLock::~ShardedRWLock() {
+  free(shards_);
+}
+
+Atomic<int32>* ShardedRWLock::CurrentReaders() {
+  int shard = g_current_shard;
+  if (shard < 0) {
+    // Starting out on the processor we are running on spreads threads over
+    // the shards the way the scheduler spreads them over processors.
+    shard = internal::CurrentShard();
+    g_current_shard = shard;
+  }
+  return &shards_[shard & shard_mask_].readers;
+}
+
+bool ShardedRWLock::NoReaders() const {
+  for (int i = 0; i <= shard_mask_; i++) {
+    if (shards_[i].readers.Load(MEMORY_ORDER_ACQUIRE) != 0)
+      return false;
+  }
+  return true;
+}
+
+void ShardedRWLock::ReadAcquire() {
+  Atomic<int32>* readers = CurrentReaders();
+  // The increment is a full barrier, and so is the writer's store to
+  // |writer_active_|: either the writer sees our count, or we see its flag.
+  readers->FetchAdd(1);
+  if (!writer_active_.IsSet(MEMORY_ORDER_SEQ_CST))
+    return;
+
+  // A writer holds the lock or is waiting for readers to drain.  Back out and
+  // wait behind it; no writer can become active while we hold |writer_lock_|.
+  readers->FetchSub(1);
+  writer_lock_.Lock();
+  readers->FetchAdd(1);
+  writer_lock_.Unlock();
+}
+
+void ShardedRWLock::ReadRelease() {
+  CurrentReaders()->FetchSub(1, MEMORY_ORDER_RELEASE);
+}
+
+bool ShardedRWLock::ReadTry() {
+  Atomic<int32>* readers = CurrentReaders();
+  readers->FetchAdd(1);
+  if (!writer_active_.IsSet(MEMORY_ORDER_SEQ_CST))
+    return true;
+  readers->FetchSub(1);
+  return false;
+}
+
+void ShardedRWLock::WriteAcquire() {
+  writer_lock_.Lock();
+  writer_active_.Set(MEMORY_ORDER_RELAXED);
+  AtomicThreadFence(MEMORY_ORDER_SEQ_CST);
+  SpinWait spin_wait;
+  while (!NoReaders())
+    spin_wait.Once();
+}
+
+void ShardedRWLock::WriteRelease() {
+  writer_active_.Clear();
+  writer_lock_.Unlock();
+}
+
+bool ShardedRWLock::WriteTry() {
+  if (!writer_lock_.Try())
+    return false;
+  writer_active_.Set(MEMORY_ORDER_RELAXED);
+  AtomicThreadFence(MEMORY_ORDER_SEQ_CST);
+  if (NoReaders())
+    return true;
+  writer_active_.Clear();
+  writer_lock_.Unlock();
+  return false;
+}
+
+}  // namespace platform
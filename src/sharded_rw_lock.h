@@ -0,0 +1,67 @@
+// Copyright (c) 2010 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+// ShardedRWLock is a reader/writer lock for data that is read constantly from
+// many processors and written rarely.
+//
+// With an ordinary reader/writer lock every ReadAcquire() writes the shared
+// reader count, so the cache line holding it bounces between all the reading
+// processors and read throughput stops scaling.  Here each thread counts its
+// reads in one of several cache-line-sized shards (one per processor), so
+// readers on different processors never touch the same line.  The price is
+// paid by writers, which must scan every shard, and in memory: the lock takes
+// a cache line per processor.
+//
+// Writers are preferred: once a writer is waiting, new readers queue up behind
+// it.  As with RWLock, read locks are not recursive.
+
+#ifndef SIMPLEPLATFORMLIB_SRC_SHARDED_RW_LOCK_H_
+#define SIMPLEPLATFORMLIB_SRC_SHARDED_RW_LOCK_H_
+#pragma once
+
+#include "simple-platform-lib/src/atomics.h"
+#include "simple-platform-lib/src/basictypes.h"
+#include "simple-platform-lib/src/lock_impl.h"
+#include "simple-platform-lib/src/rw_lock.h"
+
+namespace platform {
+
+class ShardedRWLock {
+ public:
+  ShardedRWLock();
+  ~ShardedRWLock();
+
+  void ReadAcquire();
+  void ReadRelease();
+  bool ReadTry();
+
+  void WriteAcquire();
+  void WriteRelease();
+  bool WriteTry();
+
+ private:
+  struct Shard;
+
+  Atomic<int32>* CurrentReaders();
+  // Returns true if no reader holds the lock.  Only meaningful while
+  // |writer_active_| is set.
+  bool NoReaders() const;
+
+  Shard* shards_;
+  int shard_mask_;  // Number of shards, minus one; a power of two minus one.
+
+  // Set while a writer holds, or is waiting for, the lock.
+  AtomicFlag writer_active_;
+  // Serializes writers, and is where readers wait while a writer is active.
+  LockImpl writer_lock_;
+
+  DISALLOW_COPY_AND_ASSIGN(ShardedRWLock);
+};
+
+typedef BasicAutoReadLock<ShardedRWLock> AutoShardedReadLock;
+typedef BasicAutoWriteLock<ShardedRWLock> AutoShardedWriteLock;
+
+}  // namespace platform
+
+#endif  // SIMPLEPLATFORMLIB_SRC_SHARDED_RW_LOCK_H_
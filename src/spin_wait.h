@@ -0,0 +1,60 @@
+// Copyright (c) 2010 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+// Helpers for busy-wait loops in the lock implementations.
+
+#ifndef SIMPLEPLATFORMLIB_SRC_SPIN_WAIT_H_
+#define SIMPLEPLATFORMLIB_SRC_SPIN_WAIT_H_
+#pragma once
+
+#include "simple-platform-lib/src/atomics.h"
+#include "simple-platform-lib/src/basictypes.h"
+#include "simple-platform-lib/src/sys_info.h"
+#include "simple-platform-lib/src/thread.h"
+
+namespace platform {
+
+// Backoff for busy-wait loops: spins with CpuRelax() for a while, then starts
+// yielding the processor.  Spinning alone can livelock when there are more
+// runnable threads than processors, e.g. a waiter burning the timeslice that
+// the preempted lock holder needs to finish its critical section.
+//
+//   SpinWait spin_wait;
+//   while (!condition)
+//     spin_wait.Once();
+//
+// On a uniprocessor spinning can never help, so SpinWait yields right away.
+class SpinWait {
+ public:
+  SpinWait() : spins_(0) {}
+
+  void Once() {
+    if (spins_ < SpinsBeforeYield()) {
+      spins_++;
+      CpuRelax();
+    } else {
+      Thread::Yield();
+    }
+  }
+
+  // True once Once() has started yielding rather than spinning.
+  bool yielding() const { return spins_ >= SpinsBeforeYield(); }
+
+  void Reset() { spins_ = 0; }
+
+ private:
+  static int SpinsBeforeYield() {
+    static const int spins_before_yield =
+        SysInfo::NumberOfProcessors() > 1 ? 1000 : 0;
+    return spins_before_yield;
+  }
+
+  int spins_;
+
+  DISALLOW_COPY_AND_ASSIGN(SpinWait);
+};
+
+}  // namespace platform
+
+#endif  // SIMPLEPLATFORMLIB_SRC_SPIN_WAIT_H_
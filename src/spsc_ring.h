@@ -0,0 +1,242 @@
+// Copyright (c) 2010 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+// SpscRing<T, N> is a bounded lock-free queue of up to N items of type T, for
+// handing items from exactly one producer thread to exactly one consumer
+// thread.  N must be a power of two; T must be default constructible and
+// assignable, and is copied in and out.  The items are stored inline, so a
+// big ring should not live on the stack.
+//
+//   SpscRing<Message*, 1024> ring;
+//
+//   // On the producer thread:
+//   ring.Push(message);
+//
+//   // On the consumer thread:
+//   Message* message;
+//   ring.Pop(&message);
+//
+// The producer only writes |tail_| and the consumer only writes |head_|, so
+// neither side needs an atomic read-modify-write, and the two indices live on
+// cache lines of their own.  Each side also keeps a private copy of the other
+// side's index, and only re-reads the real one when the copy says the ring
+// is full (or empty), so that in the steady state the two threads do not
+// bounce each other's cache lines on every item.  The batch calls go further
+// and publish a whole batch with a single store.
+//
+// Push() and Pop() wait while the ring is full or empty.  By default they
+// spin (see SpinWait), which gives the lowest latency but burns a processor.
+// A ring constructed with WAIT_BLOCK parks the waiting side on a condition
+// variable after a short spin instead; that costs every push and pop a full
+// memory barrier, to check whether the other side is parked.
+
+#ifndef SIMPLEPLATFORMLIB_SRC_SPSC_RING_H_
+#define SIMPLEPLATFORMLIB_SRC_SPSC_RING_H_
+#pragma once
+
+#include <stddef.h>
+
+#include "simple-platform-lib/src/atomics.h"
+#include "simple-platform-lib/src/basictypes.h"
+#include "simple-platform-lib/src/condition_variable.h"
+#include "simple-platform-lib/src/lock.h"
+#include "simple-platform-lib/src/spin_wait.h"
+
+namespace platform {
+
+template <typename T, size_t N>
+class SpscRing {
+ public:
+  enum WaitMode {
+    WAIT_SPIN,
+    WAIT_BLOCK
+  };
+
+  SpscRing()
+      : head_(0), cached_tail_(0), tail_(0), cached_head_(0),
+        wait_mode_(WAIT_SPIN), lock_("SpscRing::lock_"), not_empty_(&lock_),
+        not_full_(&lock_) {}
+
+  explicit SpscRing(WaitMode wait_mode)
+      : head_(0), cached_tail_(0), tail_(0), cached_head_(0),
+        wait_mode_(wait_mode), lock_("SpscRing::lock_"), not_empty_(&lock_),
+        not_full_(&lock_) {}
+
+  // Producer only.  Returns false if the ring is full.
+  bool TryPush(const T& item) {
+    size_t tail = tail_.Load(MEMORY_ORDER_RELAXED);
+    if (tail - cached_head_ == N) {
+      cached_head_ = head_.Load(MEMORY_ORDER_ACQUIRE);
+      if (tail - cached_head_ == N)
+        return false;
+    }
+    items_[tail & kMask] = item;
+    tail_.Store(tail + 1, MEMORY_ORDER_RELEASE);
+    if (wait_mode_ == WAIT_BLOCK)
+      WakeWaiter(&consumer_waiting_, &not_empty_);
+    return true;
+  }
+
+  // Producer only.  Pushes as many of the |count| items at |items| as fit, in
+  // order, and returns how many that was.
+  size_t TryPushBatch(const T* items, size_t count) {
+    size_t tail = tail_.Load(MEMORY_ORDER_RELAXED);
+    if (N - (tail - cached_head_) < count)
+      cached_head_ = head_.Load(MEMORY_ORDER_ACQUIRE);
+    size_t free = N - (tail - cached_head_);
+    if (count > free)
+      count = free;
+    if (count == 0)
+      return 0;
+    for (size_t i = 0; i < count; i++)
+      items_[(tail + i) & kMask] = items[i];
+    tail_.Store(tail + count, MEMORY_ORDER_RELEASE);
+    if (wait_mode_ == WAIT_BLOCK)
+      WakeWaiter(&consumer_waiting_, &not_empty_);
+    return count;
+  }
+
+  // Producer only.  Waits for room, then pushes |item|.
+  void Push(const T& item) {
+    while (!TryPush(item))
+      WaitForRoom();
+  }
+
+  // Consumer only.  Returns false if the ring is empty.
+  bool TryPop(T* item) {
+    size_t head = head_.Load(MEMORY_ORDER_RELAXED);
+    if (head == cached_tail_) {
+      cached_tail_ = tail_.Load(MEMORY_ORDER_ACQUIRE);
+      if (head == cached_tail_)
+        return false;
+    }
+    *item = items_[head & kMask];
+    head_.Store(head + 1, MEMORY_ORDER_RELEASE);
+    if (wait_mode_ == WAIT_BLOCK)
+      WakeWaiter(&producer_waiting_, &not_full_);
+    return true;
+  }
+
+  // Consumer only.  Pops up to |max_count| items into |items|, oldest first,
+  // and returns how many it popped.
+  size_t TryPopBatch(T* items, size_t max_count) {
+    size_t head = head_.Load(MEMORY_ORDER_RELAXED);
+    if (cached_tail_ - head < max_count)
+      cached_tail_ = tail_.Load(MEMORY_ORDER_ACQUIRE);
+    size_t count = cached_tail_ - head;
+    if (count > max_count)
+      count = max_count;
+    if (count == 0)
+      return 0;
+    for (size_t i = 0; i < count; i++)
+      items[i] = items_[(head + i) & kMask];
+    head_.Store(head + count, MEMORY_ORDER_RELEASE);
+    if (wait_mode_ == WAIT_BLOCK)
+      WakeWaiter(&producer_waiting_, &not_full_);
+    return count;
+  }
+
+  // Consumer only.  Waits for an item, then pops it into |item|.
+  void Pop(T* item) {
+    while (!TryPop(item))
+      WaitForItem();
+  }
+
+  // Any thread.  Only a hint while the other side is active.
+  bool Empty() const { return Size() == 0; }
+  size_t Size() const {
+    size_t head = head_.Load(MEMORY_ORDER_ACQUIRE);
+    size_t tail = tail_.Load(MEMORY_ORDER_ACQUIRE);
+    return tail - head;
+  }
+
+  static size_t capacity() { return N; }
+
+ private:
+  static const size_t kMask = N - 1;
+  COMPILE_ASSERT(N > 0 && (N & (N - 1)) == 0, n_must_be_a_power_of_two);
+
+  bool Full() const {
+    return tail_.Load(MEMORY_ORDER_RELAXED) -
+        head_.Load(MEMORY_ORDER_ACQUIRE) == N;
+  }
+  bool EmptyForConsumer() const {
+    return tail_.Load(MEMORY_ORDER_ACQUIRE) ==
+        head_.Load(MEMORY_ORDER_RELAXED);
+  }
+
+  void WaitForRoom() {
+    SpinWait spin_wait;
+    while (Full()) {
+      if (wait_mode_ == WAIT_BLOCK && spin_wait.yielding()) {
+        Park(&producer_waiting_, &not_full_, &SpscRing::Full);
+        return;
+      }
+      spin_wait.Once();
+    }
+  }
+
+  void WaitForItem() {
+    SpinWait spin_wait;
+    while (EmptyForConsumer()) {
+      if (wait_mode_ == WAIT_BLOCK && spin_wait.yielding()) {
+        Park(&consumer_waiting_, &not_empty_, &SpscRing::EmptyForConsumer);
+        return;
+      }
+      spin_wait.Once();
+    }
+  }
+
+  // Sleeps on |cv| while |must_wait| holds.  The waiter publishes |*waiting|
+  // and then re-checks the ring; the other side publishes its index and then
+  // checks |*waiting|.  The full barriers on both sides make sure that at
+  // least one of them sees the other's store, and the waiter checks under
+  // |lock_|, which the other side takes to signal, so the wakeup cannot slip
+  // in between the check and the Wait().
+  void Park(AtomicFlag* waiting, ConditionVariable* cv,
+            bool (SpscRing::*must_wait)() const) {
+    AutoLock auto_lock(lock_);
+    waiting->Set(MEMORY_ORDER_RELAXED);
+    AtomicThreadFence(MEMORY_ORDER_SEQ_CST);
+    while ((this->*must_wait)())
+      cv->Wait();
+    waiting->Clear(MEMORY_ORDER_RELAXED);
+  }
+
+  void WakeWaiter(AtomicFlag* waiting, ConditionVariable* cv) {
+    AtomicThreadFence(MEMORY_ORDER_SEQ_CST);
+    if (!waiting->IsSet(MEMORY_ORDER_RELAXED))
+      return;
+    AutoLock auto_lock(lock_);
+    cv->Signal();
+  }
+
+  // Consumer side.
+  Atomic<size_t> head_;
+  size_t cached_tail_;
+  char consumer_padding_[kCacheLineSize - sizeof(Atomic<size_t>) -
+                         sizeof(size_t)];
+
+  // Producer side.
+  Atomic<size_t> tail_;
+  size_t cached_head_;
+  char producer_padding_[kCacheLineSize - sizeof(Atomic<size_t>) -
+                         sizeof(size_t)];
+
+  T items_[N];
+
+  // Parking, for WAIT_BLOCK.
+  const WaitMode wait_mode_;
+  Lock lock_;
+  ConditionVariable not_empty_;
+  ConditionVariable not_full_;
+  AtomicFlag consumer_waiting_;
+  AtomicFlag producer_waiting_;
+
+  DISALLOW_COPY_AND_ASSIGN(SpscRing);
+};
+
+}  // namespace platform
+
+#endif  // SIMPLEPLATFORMLIB_SRC_SPSC_RING_H_
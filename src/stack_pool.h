@@ -0,0 +1,95 @@
+// Copyright (c) 2010 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+// StackPool hands out stacks for fibers (see fiber.h) and threads (see
+// ThreadOptions::stack_pool in thread.h), each mapped with a guard page below
+// it, so that overflowing a stack faults instead of
+// silently overwriting whatever is mapped next.  Memory is only committed
+// as the stack is touched, so a stack costs as much resident memory as its
+// deepest use, rounded up to pages.
+//
+// Mapping and unmapping are system calls that change the address space
+// (and, on unmapping, shoot down the TLB on every processor), so freed
+// stacks are cached, up to a limit, and handed out again.  A pool can also
+// map stacks ahead of a burst of threads, with Reserve(), and fault their
+// top pages in, so that neither the mapping nor the first page faults fall
+// on the threads' start-up:
+//
+//   StackPool pool(256 * 1024, 64);  // Up to 64 idle 256 KB stacks.
+//   pool.set_prefault_size(16 * 1024);
+//   pool.Reserve(64);
+//   ThreadOptions options;
+//   options.stack_pool = &pool;
+//   Thread::Create(options, &delegate, &handle);  // Takes a cached stack...
+//   Thread::Join(handle);                          // ...and gives it back.
+
+#ifndef SIMPLEPLATFORMLIB_SRC_STACK_POOL_H_
+#define SIMPLEPLATFORMLIB_SRC_STACK_POOL_H_
+#pragma once
+
+#include <stddef.h>
+
+#include <vector>
+
+#include "simple-platform-lib/src/basictypes.h"
+#include "simple-platform-lib/src/lock.h"
+
+namespace platform {
+
+// A stack grows down from |base| + |size|; the page below |base| is the
+// guard page.
+struct Stack {
+  Stack() : base(NULL), size(0) {}
+
+  void* base;
+  size_t size;
+};
+
+class StackPool {
+ public:
+  // Stacks are |stack_size| bytes, rounded up to whole pages.  Up to
+  // |max_cached| freed stacks are kept for reuse.
+  StackPool(size_t stack_size, size_t max_cached);
+
+  // Unmaps the cached stacks.  Every stack must have been freed.
+  ~StackPool();
+
+  // Returns false if the stack could not be mapped.
+  bool Allocate(Stack* stack);
+
+  // |stack| must come from this pool.
+  void Free(const Stack& stack);
+
+  // Maps stacks until |count| are cached, or as many as the pool keeps.
+  // Returns false if a stack could not be mapped.
+  bool Reserve(size_t count);
+
+  // Makes the top |size| bytes of each newly mapped stack resident, where a
+  // new thread or fiber starts using it; 0, the default, leaves every page
+  // to be faulted in on first use.  Must be called before the pool is
+  // shared.
+  void set_prefault_size(size_t size) { prefault_size_ = size; }
+
+  size_t stack_size() const { return stack_size_; }
+
+  static size_t PageSize();
+
+ private:
+  // Maps a new stack.
+  bool Map(Stack* stack);
+  static void Unmap(const Stack& stack);
+
+  const size_t stack_size_;
+  const size_t max_cached_;
+  size_t prefault_size_;
+
+  Lock lock_;
+  std::vector<Stack> cached_;  // Protected by |lock_|.
+
+  DISALLOW_COPY_AND_ASSIGN(StackPool);
+};
+
+}  // namespace platform
+
+#endif  // SIMPLEPLATFORMLIB_SRC_STACK_POOL_H_
@@ -0,0 +1,121 @@
+// Copyright (c) 2010 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "simple-platform-lib/src/stack_pool.h"
+
+#include <sys/mman.h>
+#include <unistd.h>
+
+#if !defined(MAP_ANONYMOUS)
+#define MAP_ANONYMOUS MAP_ANON
+#endif
+
+namespace platform {
+
+namespace {
+
+#if defined(MAP_STACK)
+const int kStackFlags = MAP_PRIVATE | MAP_ANONYMOUS | MAP_STACK;
+#else
+const int kStackFlags = MAP_PRIVATE | MAP_ANONYMOUS;
+#endif
+
+size_t RoundUpToPages(size_t size) {
+  size_t page_size = StackPool::PageSize();
+  if (size == 0)
+    return page_size;
+  return (size + page_size - 1) / page_size * page_size;
+}
+
+}  // namespace
+
+StackPool::StackPool(size_t stack_size, size_t max_cached)
+    : stack_size_(RoundUpToPages(stack_size)),
+      max_cached_(max_cached),
+      prefault_size_(0),
+      lock_("StackPool::lock_") {
+}
+
+StackPool::~StackPool() {
+  for (size_t i = 0; i < cached_.size(); i++)
+    Unmap(cached_[i]);
+}
+
+bool StackPool::Allocate(Stack* stack) {
+  {
+    AutoLock auto_lock(lock_);
+    if (!cached_.empty()) {
+      *stack = cached_.back();
+      cached_.pop_back();
+      return true;
+    }
+  }
+  return Map(stack);
+}
+
+void StackPool::Free(const Stack& stack) {
+  {
+    AutoLock auto_lock(lock_);
+    if (cached_.size() < max_cached_) {
+      cached_.push_back(stack);
+      return;
+    }
+  }
+  Unmap(stack);
+}
+
+bool StackPool::Reserve(size_t count) {
+  if (count > max_cached_)
+    count = max_cached_;
+  for (;;) {
+    {
+      AutoLock auto_lock(lock_);
+      if (cached_.size() >= count)
+        return true;
+    }
+    Stack stack;
+    if (!Map(&stack))
+      return false;
+    Free(stack);
+  }
+}
+
+bool StackPool::Map(Stack* stack) {
+  size_t page_size = PageSize();
+  void* mapping = mmap(NULL, page_size + stack_size_, PROT_READ | PROT_WRITE,
+                       kStackFlags, -1, 0);
+  if (mapping == MAP_FAILED)
+    return false;
+  if (mprotect(mapping, page_size, PROT_NONE) != 0) {
+    munmap(mapping, page_size + stack_size_);
+    return false;
+  }
+  stack->base = static_cast<char*>(mapping) + page_size;
+  stack->size = stack_size_;
+
+  // Writing a byte per page faults the pages in, top down, as the stack
+  // would.
+  size_t prefault_size = prefault_size_ < stack_size_ ? prefault_size_ :
+                                                        stack_size_;
+  volatile char* top = static_cast<char*>(stack->base) + stack_size_;
+  for (size_t offset = 0; offset < prefault_size; offset += page_size)
+    *(top - offset - 1) = 0;
+  return true;
+}
+
+// static
+size_t StackPool::PageSize() {
+  return static_cast<size_t>(sysconf(_SC_PAGESIZE));
+}
+
+// static
+void StackPool::Unmap(const Stack& stack) {
+  size_t page_size = PageSize();
+  int rv = munmap(static_cast<char*>(stack.base) - page_size,
+                  page_size + stack.size);
+//  DCHECK_EQ(rv, 0);
+(void)rv;
+}
+
+}  // namespace platform
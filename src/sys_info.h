@@ -0,0 +1,36 @@
+// Copyright (c) 2010 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+// Taken from Chromium: src/base/sys_info.h
+// Significant changes (other than naming):
+//  - class |SysInfo| (with only static methods) -> namespace |SysInfo|
+//  - everything but |NumberOfProcessors()| removed
+//  - NUMA topology queries added
+
+#ifndef SIMPLEPLATFORMLIB_SRC_SYS_INFO_H_
+#define SIMPLEPLATFORMLIB_SRC_SYS_INFO_H_
+#pragma once
+
+#include <vector>
+
+#include "simple-platform-lib/src/basictypes.h"
+
+namespace platform {
+namespace SysInfo {
+
+// Return the number of logical processors/cores on the current machine.
+int NumberOfProcessors();
+
+// Return the number of NUMA nodes, numbered from 0.  Machines (and operating
+// systems) without NUMA have a single node holding every processor.
+int NumberOfNumaNodes();
+
+// Stores the processors of NUMA node |node| into |cpus|, in increasing order.
+// Returns false if there is no such node.
+bool GetNumaNodeCpus(int node, std::vector<int>* cpus);
+
+}  // namespace SysInfo
+}  // namespace platform
+
+#endif  // SIMPLEPLATFORMLIB_SRC_SYS_INFO_H_
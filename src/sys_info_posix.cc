@@ -0,0 +1,111 @@
+// Copyright (c) 2010 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+// Taken from Chromium: src/base/sys_info_posix.cc
+
+#include "simple-platform-lib/src/sys_info.h"
+
+#include <stdio.h>
+#include <unistd.h>
+
+//FIXME
+//#include "base/logging.h"
+
+namespace platform {
+namespace SysInfo {
+
+int NumberOfProcessors() {
+  // It seems that sysconf returns the number of "logical" processors on both
+  // mac and linux.  So we get the number of "online logical" processors.
+  long res = sysconf(_SC_NPROCESSORS_ONLN);
+  if (res == -1) {
+//    NOTREACHED();
+    return 1;
+  }
+
+  return static_cast<int>(res);
+}
+
+#if defined(OS_LINUX)
+
+namespace {
+
+// Parses a sysfs cpulist such as "0-3,8-11\n".
+bool ParseCpuList(FILE* file, std::vector<int>* cpus) {
+  int first, last;
+  char separator;
+  for (;;) {
+    if (fscanf(file, "%d", &first) != 1)
+      return false;
+    last = first;
+    if (fscanf(file, "%c", &separator) != 1)
+      return true;
+    if (separator == '-') {
+      if (fscanf(file, "%d", &last) != 1)
+        return false;
+      if (fscanf(file, "%c", &separator) != 1)
+        separator = '\n';
+    }
+    for (int cpu = first; cpu <= last; cpu++)
+      cpus->push_back(cpu);
+    if (separator != ',')
+      return true;
+  }
+}
+
+}  // namespace
+
+int NumberOfNumaNodes() {
+  int nodes = 0;
+  for (;;) {
+    char path[64];
+    snprintf(path, sizeof(path), "/sys/devices/system/node/node%d", nodes);
+    if (access(path, F_OK) != 0)
+      break;
+    nodes++;
+  }
+  return nodes > 0 ? nodes : 1;
+}
+
+bool GetNumaNodeCpus(int node, std::vector<int>* cpus) {
+  cpus->clear();
+  if (node < 0)
+    return false;
+  char path[64];
+  snprintf(path, sizeof(path), "/sys/devices/system/node/node%d/cpulist",
+           node);
+  FILE* file = fopen(path, "r");
+  if (!file) {
+    // Kernels without NUMA support have no node directories.
+    if (node != 0 || access("/sys/devices/system/node", F_OK) == 0)
+      return false;
+    for (int cpu = 0; cpu < NumberOfProcessors(); cpu++)
+      cpus->push_back(cpu);
+    return true;
+  }
+  // A node without processors (memory only) has an empty list.
+  bool success = ParseCpuList(file, cpus) || cpus->empty();
+  fclose(file);
+  return success;
+}
+
+#else  // !OS_LINUX
+
+int NumberOfNumaNodes() {
+  return 1;
+}
+
+bool GetNumaNodeCpus(int node, std::vector<int>* cpus) {
+  cpus->clear();
+  if (node != 0)
+    return false;
+  for (int cpu = 0; cpu < NumberOfProcessors(); cpu++)
+    cpus->push_back(cpu);
+  return true;
+}
+
+#endif  // OS_LINUX
+
+}  // namespace SysInfo
+}  // namespace platform
@@ -0,0 +1,23 @@
+// Copyright (c) 2010 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+// A Task is a unit of work to be run on some other thread, e.g. by a
+// ThreadPool.  Whoever a Task is handed to takes ownership of it, and deletes
+// it once it has run (or once it is known that it never will).
+
+#ifndef SIMPLEPLATFORMLIB_SRC_TASK_H_
+#define SIMPLEPLATFORMLIB_SRC_TASK_H_
+#pragma once
+
+namespace platform {
+
+class Task {
+ public:
+  virtual ~Task() {}
+  virtual void Run() = 0;
+};
+
+}  // namespace platform
+
+#endif  // SIMPLEPLATFORMLIB_SRC_TASK_H_
@@ -10,6 +10,9 @@
 //  - |SetName()| removed
 //  - (Mac) |InitThreading()| removed, so if Cocoa is going to be used, it must
 //    be warmed up (see Chromium: src/base/platform_thread_mac.mm)
+//  - |ThreadOptions|, |Create()| with options and |SetCurrentAffinity()| added
+//  - |Sleep()| taking a |TimeDelta|, and |SleepUntil()|, added
+//  - (POSIX) stacks from a |StackPool| (|ThreadOptions::stack_pool|) added
 
 // This class provides a low-level platform-specific abstraction to the OS's
 // threading interface, on top of which application-level abstractions can be
@@ -19,7 +22,10 @@
 #define SIMPLEPLATFORMLIB_SRC_PLATFORM_THREAD_H_
 #pragma once
 
+#include <vector>
+
 #include "simple-platform-lib/src/basictypes.h"
+#include "simple-platform-lib/src/time.h"
 
 // ThreadHandle should not be assumed to be a numeric type, since the standard
 // intends to allow pthread_t to be a structure.  This means you should not
@@ -52,9 +58,64 @@ typedef pid_t ThreadId;
 #endif
 
 namespace platform {
+
+class StackPool;
+
+// Placement and scheduling of a new thread; see Thread::Create().
+struct ThreadOptions {
+  enum SchedulingPolicy {
+    // The system's default time-sharing policy.
+    SCHEDULING_DEFAULT,
+    // Real-time policies, with |priority|.  These usually need privileges.
+    SCHEDULING_FIFO,
+    SCHEDULING_ROUND_ROBIN,
+    // Linux only: for CPU-bound background work, and for work that should
+    // only run when nothing else wants the processor.
+    SCHEDULING_BATCH,
+    SCHEDULING_IDLE,
+  };
+
+  ThreadOptions()
+      : stack_size(0),
+        numa_node(-1),
+        scheduling_policy(SCHEDULING_DEFAULT),
+        priority(0),
+        name(NULL),
+        stack_pool(NULL) {}
+
+  // 0 for the default stack size.  Ignored if |stack_pool| is set.
+  size_t stack_size;
+
+  // The processors the thread may run on; empty for any.  Linux only.
+  std::vector<int> cpus;
+
+  // The NUMA node (see SysInfo::NumberOfNumaNodes()) whose processors the
+  // thread runs on (restricted further by |cpus|, if set) and whose memory
+  // it allocates from; -1 for no binding.  Linux only.
+  int numa_node;
+
+  SchedulingPolicy scheduling_policy;
+  // The real-time priority for SCHEDULING_FIFO and SCHEDULING_ROUND_ROBIN;
+  // ignored for the other policies.
+  int priority;
+
+  // A name for debuggers and tools such as top; NULL for none.  Linux
+  // truncates it to 15 characters.  Copied, so it need not outlive Create().
+  const char* name;
+
+  // Where to take the thread's stack from, instead of having the system map
+  // a fresh one (and unmap it on Join()); see stack_pool.h.  Join() gives
+  // the stack back, so the pool must outlive the thread's handle, and its
+  // stacks must be at least PTHREAD_STACK_MIN bytes, the thread's
+  // thread-local storage included.  NULL for the system's stacks.  POSIX
+  // only.
+  StackPool* stack_pool;
+};
+
 namespace Thread {
 
-// Gets the current thread id, which may be useful for logging purposes.
+// Gets the current thread id, which may be useful for logging purposes.  On
+// Linux the id is cached in thread-local storage after the first call.
 ThreadId CurrentId();
 
 // Yield the current thread so another thread can be scheduled.
@@ -63,6 +124,14 @@ void Yield();
 // Sleeps for the specified duration (units are milliseconds).
 void Sleep(int duration_ms);
 
+// Sleeps for |duration|, to the resolution of the system's timers (usually
+// tens of microseconds).
+void Sleep(const TimeDelta& duration);
+
+// Sleeps until TimeTicks::Now() reaches |deadline|.  Unlike sleeping for the
+// time left, this does not drift when called in a loop.
+void SleepUntil(const TimeTicks& deadline);
+
 // Implement this interface to run code on a background thread.  Your
 // ThreadMain method will be called on the newly created thread.
 class Delegate {
@@ -81,6 +150,16 @@ class Delegate {
 // Delegate object outlives the thread.
 bool Create(size_t stack_size, Delegate* delegate, ThreadHandle* thread_handle);
 
+// Like Create(), with the placement and scheduling of the new thread given by
+// |options|.  Fails, without creating a thread, if an option is not supported
+// on this system, is invalid (e.g. no such processor), or is not allowed
+// (e.g. a real-time policy without the privilege).  Options the new thread
+// has to apply itself (a NUMA memory policy, SCHEDULING_BATCH/IDLE) are
+// applied before Create() returns, and if they fail the thread exits without
+// running |delegate|.
+bool Create(const ThreadOptions& options, Delegate* delegate,
+            ThreadHandle* thread_handle);
+
 // CreateNonJoinable() does the same thing as Create() except the thread cannot
 // be Join()'d.  Therefore, it also does not output a ThreadHandle.
 bool CreateNonJoinable(size_t stack_size, Delegate* delegate);
@@ -90,6 +169,10 @@ bool CreateNonJoinable(size_t stack_size, Delegate* delegate);
 // |thread_handle|.
 void Join(ThreadHandle thread_handle);
 
+// Restricts the calling thread to the processors |cpus|.  Returns false if
+// that fails, or is not supported on this system (only Linux is).
+bool SetCurrentAffinity(const std::vector<int>& cpus);
+
 }  // namespace Thread
 }  // namespace platform
 
@@ -0,0 +1,156 @@
+// Copyright (c) 2010 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+// Thread-local storage, for objects that are created at run time (unlike a
+// __thread variable, which has to be a global of POD type):
+//
+//   ThreadLocalPointer<T> holds a T* per thread, NULL until set, and owns
+//   nothing.
+//
+//   ThreadLocal<T> owns a T per thread: default-constructed on the thread's
+//   first Get(), and deleted when the thread exits.
+//
+//   // A buffer per thread, instead of one behind a Lock.
+//   ThreadLocal<std::string>* g_scratch = new ThreadLocal<std::string>;
+//
+//   std::string* scratch = g_scratch->Get();
+//
+// The first kStaticSlots thread-locals created in the process keep their
+// values in an array of static thread-local storage, so Get() is an indexed
+// load off the thread pointer, inlined.  Later ones fall back on a pthread
+// key each, and pthread_getspecific().  Static slots are never reused, so
+// that a new thread-local cannot see a value left by an old one; thread-locals
+// are best kept for long-lived objects, not created per request.  Creating
+// one once the process is out of pthread keys (PTHREAD_KEYS_MAX) aborts.
+//
+// Either way, the objects of a ThreadLocal are deleted as a thread exits;
+// that includes threads made by Thread::Create(), and other pthreads, but
+// not the main thread, which exits the process instead.
+//
+// Like pthread keys, a thread-local must outlive the threads that use it
+// (the one destroying it aside): destroying a ThreadLocal deletes only the
+// destroying thread's object.
+
+#ifndef SIMPLEPLATFORMLIB_SRC_THREAD_LOCAL_H_
+#define SIMPLEPLATFORMLIB_SRC_THREAD_LOCAL_H_
+#pragma once
+
+#include <pthread.h>
+
+#include "simple-platform-lib/src/basictypes.h"
+
+namespace platform {
+
+namespace internal {
+
+// Called with a thread's non-NULL value when the thread exits.
+typedef void (*ThreadLocalDestructor)(void* value);
+
+// Either an index into the static slots, or a pthread key.
+struct ThreadLocalSlot {
+  int index;  // -1 if |key| is used instead.
+  pthread_key_t key;
+};
+
+class ThreadLocalPlatform {
+ public:
+  static const int kStaticSlots = 64;
+
+  // |destructor| may be NULL.
+  static void AllocateSlot(ThreadLocalSlot* slot,
+                           ThreadLocalDestructor destructor);
+  // Does not run the destructor on values still in the slot.
+  static void FreeSlot(ThreadLocalSlot* slot);
+
+  static void* GetValueFromSlot(const ThreadLocalSlot& slot) {
+    if (slot.index >= 0)
+      return static_slots_[slot.index];
+    return pthread_getspecific(slot.key);
+  }
+
+  static void SetValueInSlot(const ThreadLocalSlot& slot, void* value);
+
+ private:
+  // Creates the pthread key whose destructor is OnThreadExit().
+  static void CreateExitKey();
+  // Runs the destructors of the static slots as a thread exits.
+  static void OnThreadExit(void* unused);
+
+  static __thread void* static_slots_[kStaticSlots];
+  // Whether OnThreadExit() will run when the thread exits.
+  static __thread bool exit_registered_;
+};
+
+}  // namespace internal
+
+template <typename T>
+class ThreadLocalPointer {
+ public:
+  ThreadLocalPointer() {
+    internal::ThreadLocalPlatform::AllocateSlot(&slot_, NULL);
+  }
+
+  ~ThreadLocalPointer() {
+    internal::ThreadLocalPlatform::FreeSlot(&slot_);
+  }
+
+  T* Get() {
+    return static_cast<T*>(
+        internal::ThreadLocalPlatform::GetValueFromSlot(slot_));
+  }
+
+  void Set(T* ptr) {
+    internal::ThreadLocalPlatform::SetValueInSlot(
+        slot_, const_cast<void*>(static_cast<const void*>(ptr)));
+  }
+
+ private:
+  internal::ThreadLocalSlot slot_;
+
+  DISALLOW_COPY_AND_ASSIGN(ThreadLocalPointer);
+};
+
+template <typename T>
+class ThreadLocal {
+ public:
+  ThreadLocal() {
+    internal::ThreadLocalPlatform::AllocateSlot(&slot_, &DeleteValue);
+  }
+
+  ~ThreadLocal() {
+    delete GetIfExists();
+    internal::ThreadLocalPlatform::FreeSlot(&slot_);
+  }
+
+  // The calling thread's object, created if need be.
+  T* Get() {
+    T* value = GetIfExists();
+    return value ? value : Create();
+  }
+
+  // The calling thread's object, or NULL if it has none yet.
+  T* GetIfExists() {
+    return static_cast<T*>(
+        internal::ThreadLocalPlatform::GetValueFromSlot(slot_));
+  }
+
+ private:
+  static void DeleteValue(void* value) {
+    delete static_cast<T*>(value);
+  }
+
+  T* Create() {
+    T* value = new T;
+    internal::ThreadLocalPlatform::SetValueInSlot(slot_, value);
+    return value;
+  }
+
+  internal::ThreadLocalSlot slot_;
+
+  DISALLOW_COPY_AND_ASSIGN(ThreadLocal);
+};
+
+}  // namespace platform
+
+#endif  // SIMPLEPLATFORMLIB_SRC_THREAD_LOCAL_H_
@@ -0,0 +1,129 @@
+// Copyright (c) 2010 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "simple-platform-lib/src/thread_local.h"
+
+#include <limits.h>
+#include <stdlib.h>
+
+#include "simple-platform-lib/src/atomics.h"
+
+namespace platform {
+namespace internal {
+
+namespace {
+
+// Plain PODs updated with the __atomic builtins rather than Atomic<T>s, which
+// would need a static initializer: thread-locals may be created during other
+// files' static initialization, before it runs.
+
+// Static slots handed out so far; may run past kStaticSlots.
+int g_next_static_slot = 0;
+
+// The destructor of each static slot, NULL once the slot is freed.
+ThreadLocalDestructor g_static_destructors[ThreadLocalPlatform::kStaticSlots];
+
+// A key whose destructor runs the static slots' destructors.
+pthread_key_t g_exit_key;
+pthread_once_t g_exit_key_once = PTHREAD_ONCE_INIT;
+
+#if defined(PTHREAD_DESTRUCTOR_ITERATIONS)
+const int kDestructorPasses = PTHREAD_DESTRUCTOR_ITERATIONS;
+#else
+const int kDestructorPasses = 4;
+#endif
+
+}  // namespace
+
+__thread void* ThreadLocalPlatform::static_slots_[kStaticSlots];
+__thread bool ThreadLocalPlatform::exit_registered_ = false;
+
+// static
+void ThreadLocalPlatform::AllocateSlot(ThreadLocalSlot* slot,
+                                       ThreadLocalDestructor destructor) {
+  int index =
+      __atomic_load_n(&g_next_static_slot, MEMORY_ORDER_RELAXED) <
+          kStaticSlots ?
+      __atomic_fetch_add(&g_next_static_slot, 1, MEMORY_ORDER_RELAXED) :
+      kStaticSlots;
+  if (index < kStaticSlots) {
+    __atomic_store_n(&g_static_destructors[index], destructor,
+                     MEMORY_ORDER_RELEASE);
+    slot->index = index;
+    return;
+  }
+
+  slot->index = -1;
+  // Out of pthread keys (PTHREAD_KEYS_MAX); there is no slot to hand out.
+  if (pthread_key_create(&slot->key, destructor) != 0)
+    abort();
+}
+
+// static
+void ThreadLocalPlatform::FreeSlot(ThreadLocalSlot* slot) {
+  if (slot->index >= 0) {
+    static_slots_[slot->index] = NULL;
+    __atomic_store_n(&g_static_destructors[slot->index],
+                     static_cast<ThreadLocalDestructor>(NULL),
+                     MEMORY_ORDER_RELEASE);
+    return;
+  }
+  int rv = pthread_key_delete(slot->key);
+//  DCHECK_EQ(rv, 0);
+(void)rv;
+}
+
+// static
+void ThreadLocalPlatform::CreateExitKey() {
+  int rv = pthread_key_create(&g_exit_key,
+                              &ThreadLocalPlatform::OnThreadExit);
+//  CHECK_EQ(rv, 0);
+(void)rv;
+}
+
+// static
+void ThreadLocalPlatform::SetValueInSlot(const ThreadLocalSlot& slot,
+                                         void* value) {
+  if (slot.index < 0) {
+    pthread_setspecific(slot.key, value);
+    return;
+  }
+  static_slots_[slot.index] = value;
+  if (value && !exit_registered_) {
+    // Any non-NULL value makes the key's destructor run.
+    pthread_once(&g_exit_key_once, CreateExitKey);
+    pthread_setspecific(g_exit_key, &exit_registered_);
+    exit_registered_ = true;
+  }
+}
+
+// static
+void ThreadLocalPlatform::OnThreadExit(void*) {
+  // A destructor may set other thread-locals, so this goes over the slots
+  // again until a pass finds nothing to destroy, as pthreads does with keys.
+  int slots = __atomic_load_n(&g_next_static_slot, MEMORY_ORDER_RELAXED);
+  if (slots > kStaticSlots)
+    slots = kStaticSlots;
+  exit_registered_ = false;
+  for (int pass = 0; pass < kDestructorPasses; pass++) {
+    bool destroyed = false;
+    for (int i = 0; i < slots; i++) {
+      void* value = static_slots_[i];
+      if (!value)
+        continue;
+      static_slots_[i] = NULL;
+      ThreadLocalDestructor destructor =
+          __atomic_load_n(&g_static_destructors[i], MEMORY_ORDER_ACQUIRE);
+      if (destructor) {
+        destructor(value);
+        destroyed = true;
+      }
+    }
+    if (!destroyed)
+      break;
+  }
+}
+
+}  // namespace internal
+}  // namespace platform
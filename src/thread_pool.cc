@@ -0,0 +1,143 @@
+// Copyright (c) 2010 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "simple-platform-lib/src/thread_pool.h"
+
+namespace platform {
+
+class ThreadPool::Worker : public Thread::Delegate {
+ public:
+  explicit Worker(ThreadPool* pool) : pool_(pool) {}
+
+  virtual void ThreadMain() {
+    pool_->Run();
+  }
+
+ private:
+  ThreadPool* pool_;
+
+  DISALLOW_COPY_AND_ASSIGN(Worker);
+};
+
+ThreadPool::ThreadPool(int num_threads)
+    : num_threads_(num_threads),
+      lock_("ThreadPool::lock_"),
+      work_available_(&lock_),
+      idle_(&lock_),
+      running_tasks_(0),
+      shutting_down_(false) {
+}
+
+ThreadPool::~ThreadPool() {
+  bool shut_down;
+  {
+    AutoLock auto_lock(lock_);
+    shut_down = shutting_down_;
+  }
+  if (!shut_down)
+    Shutdown(RUN_PENDING_TASKS);
+}
+
+bool ThreadPool::Start() {
+//  DCHECK(workers_.empty());
+  bool success = true;
+  for (int i = 0; i < num_threads_; i++) {
+    Worker* worker = new Worker(this);
+    ThreadHandle handle;
+    if (!Thread::Create(0, worker, &handle)) {
+      delete worker;
+      success = false;
+      continue;
+    }
+    workers_.push_back(worker);
+    handles_.push_back(handle);
+  }
+  return success;
+}
+
+bool ThreadPool::PostTask(Task* task) {
+  {
+    AutoLock auto_lock(lock_);
+    if (!shutting_down_) {
+      tasks_.push_back(task);
+      work_available_.Signal();
+      return true;
+    }
+  }
+  delete task;
+  return false;
+}
+
+void ThreadPool::Execute(Task* task) {
+  PostTask(task);
+}
+
+void ThreadPool::WaitForIdle() {
+  AutoLock auto_lock(lock_);
+  while (!tasks_.empty() || running_tasks_ > 0)
+    idle_.Wait();
+}
+
+void ThreadPool::Shutdown(ShutdownBehavior behavior) {
+  std::deque<Task*> cancelled;
+  {
+    AutoLock auto_lock(lock_);
+//    DCHECK(!shutting_down_);
+    shutting_down_ = true;
+    if (behavior == CANCEL_PENDING_TASKS) {
+      cancelled.swap(tasks_);
+      if (running_tasks_ == 0)
+        idle_.Broadcast();
+    }
+    work_available_.Broadcast();
+  }
+
+  for (size_t i = 0; i < cancelled.size(); i++)
+    delete cancelled[i];
+
+  for (size_t i = 0; i < handles_.size(); i++) {
+    Thread::Join(handles_[i]);
+    delete workers_[i];
+  }
+  handles_.clear();
+  workers_.clear();
+
+  // With no workers (never started, or none could be created), tasks posted
+  // before Shutdown() are still queued; run them on this thread.  Anything
+  // they post is refused, since |shutting_down_| is set.
+  AutoLock auto_lock(lock_);
+  while (!tasks_.empty()) {
+    Task* task = tasks_.front();
+    tasks_.pop_front();
+    AutoUnlock auto_unlock(lock_);
+    task->Run();
+    delete task;
+  }
+  idle_.Broadcast();
+}
+
+void ThreadPool::Run() {
+  AutoLock auto_lock(lock_);
+  for (;;) {
+    while (tasks_.empty() && !shutting_down_)
+      work_available_.Wait();
+    // Once shutting down, the queue is drained before exiting.
+    if (tasks_.empty())
+      break;
+
+    Task* task = tasks_.front();
+    tasks_.pop_front();
+    running_tasks_++;
+    {
+      AutoUnlock auto_unlock(lock_);
+      task->Run();
+      delete task;
+    }
+    running_tasks_--;
+    if (running_tasks_ == 0 && tasks_.empty())
+      idle_.Broadcast();
+  }
+}
+
+}  // namespace platform
@@ -0,0 +1,97 @@
+// Copyright (c) 2010 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+// ThreadPool runs Tasks on a fixed set of worker threads, in the order they
+// were posted (though tasks on different workers of course overlap).
+//
+//   ThreadPool pool(4);
+//   pool.Start();
+//   pool.PostTask(new FooTask(...));
+//   ...
+//   pool.WaitForIdle();
+//   ...
+//   pool.Shutdown(ThreadPool::RUN_PENDING_TASKS);
+
+#ifndef SIMPLEPLATFORMLIB_SRC_THREAD_POOL_H_
+#define SIMPLEPLATFORMLIB_SRC_THREAD_POOL_H_
+#pragma once
+
+#include <deque>
+#include <vector>
+
+#include "simple-platform-lib/src/basictypes.h"
+#include "simple-platform-lib/src/condition_variable.h"
+#include "simple-platform-lib/src/executor.h"
+#include "simple-platform-lib/src/lock.h"
+#include "simple-platform-lib/src/task.h"
+#include "simple-platform-lib/src/thread.h"
+
+namespace platform {
+
+class ThreadPool : public Executor {
+ public:
+  enum ShutdownBehavior {
+    // Run every task posted before Shutdown() was called.  If the pool has
+    // no workers, they are run on the thread calling Shutdown().
+    RUN_PENDING_TASKS,
+    // Delete the tasks that have not started running yet, without running
+    // them.  Tasks that are already running are still waited for.
+    CANCEL_PENDING_TASKS,
+  };
+
+  explicit ThreadPool(int num_threads);
+
+  // Shuts down with RUN_PENDING_TASKS, if Shutdown() has not been called.
+  ~ThreadPool();
+
+  // Starts the worker threads.  Returns false if any of them could not be
+  // created, in which case the pool runs on those that could (if any).
+  bool Start();
+
+  // Queues |task| to be run on a worker, and takes ownership of it.  Tasks may
+  // be posted before Start(), and from tasks.  Once Shutdown() has been
+  // called, |task| is deleted without being run and false is returned.
+  bool PostTask(Task* task);
+
+  // Executor implementation: PostTask().
+  virtual void Execute(Task* task);
+
+  // Blocks until no task is queued or running, which never happens while a
+  // task is queued on a pool without workers (never started, or none could
+  // be created); Shutdown() runs those instead.  Must not be called from a
+  // task, which would wait for itself.
+  void WaitForIdle();
+
+  // Stops accepting tasks, deals with the pending ones according to
+  // |behavior| and joins the workers.  Must be called at most once, and not
+  // from a task.
+  void Shutdown(ShutdownBehavior behavior);
+
+ private:
+  class Worker;
+
+  // The body of each worker thread.
+  void Run();
+
+  int num_threads_;
+  std::vector<Worker*> workers_;
+  std::vector<ThreadHandle> handles_;
+
+  Lock lock_;
+  // Signaled when a task is queued, and broadcast on shutdown.
+  ConditionVariable work_available_;
+  // Broadcast when the last running task finishes with the queue empty.
+  ConditionVariable idle_;
+
+  // The following are protected by |lock_|.
+  std::deque<Task*> tasks_;
+  int running_tasks_;
+  bool shutting_down_;
+
+  DISALLOW_COPY_AND_ASSIGN(ThreadPool);
+};
+
+}  // namespace platform
+
+#endif  // SIMPLEPLATFORMLIB_SRC_THREAD_POOL_H_
@@ -12,6 +12,9 @@
 #include <errno.h>
 #include <sched.h>
 
+#include <map>
+#include <string>
+
 #if defined(OS_MACOSX)
 #include <mach/mach.h>
 #include <sys/resource.h>
@@ -22,8 +25,12 @@
 #include <sys/prctl.h>
 #include <sys/syscall.h>
 #include <unistd.h>
+
+#include "simple-platform-lib/src/sys_info.h"
 #endif
 
+#include "simple-platform-lib/src/stack_pool.h"
+
 namespace platform {
 namespace Thread {
 
@@ -33,13 +40,40 @@ static void* ThreadFunc(void* closure) {
   return NULL;
 }
 
+#if defined(OS_LINUX)
+// The kernel id of the current thread, or 0 if it has not been looked up yet.
+// Debug builds of Lock ask for it on every acquisition, so it is worth saving
+// the system call.
+static __thread pid_t g_current_id = 0;
+
+static pthread_once_t g_register_atfork_once = PTHREAD_ONCE_INIT;
+
+// The child of a fork() starts out with a copy of the forking thread's cached
+// id, which is the parent's.
+static void ResetCurrentIdInChild() {
+  g_current_id = 0;
+}
+
+static void RegisterAtFork() {
+  pthread_atfork(NULL, NULL, ResetCurrentIdInChild);
+}
+#endif  // OS_LINUX
+
 ThreadId CurrentId() {
   // Pthreads doesn't have the concept of a thread ID, so we have to reach down
   // into the kernel.
 #if defined(OS_MACOSX)
   return mach_thread_self();
 #elif defined(OS_LINUX)
-  return syscall(__NR_gettid);
+  pid_t id = g_current_id;
+  if (id == 0) {
+    // Processes cloned without going through fork() (e.g. with a raw clone()
+    // system call) are not covered.
+    pthread_once(&g_register_atfork_once, RegisterAtFork);
+    id = syscall(__NR_gettid);
+    g_current_id = id;
+  }
+  return id;
 #elif defined(OS_FREEBSD)
   // TODO(BSD): find a better thread ID
   return reinterpret_cast<int64>(pthread_self());
@@ -51,22 +85,194 @@ void Yield() {
 }
 
 void Sleep(int duration_ms) {
-  struct timespec sleep_time, remaining;
-
-  // Contains the portion of duration_ms >= 1 sec.
-  sleep_time.tv_sec = duration_ms / 1000;
-  duration_ms -= sleep_time.tv_sec * 1000;
-
-  // Contains the portion of duration_ms < 1 sec.
-  sleep_time.tv_nsec = duration_ms * 1000 * 1000;  // nanoseconds.
+  Sleep(TimeDelta::FromMilliseconds(duration_ms));
+}
 
+void Sleep(const TimeDelta& duration) {
+  struct timespec sleep_time = duration.ToTimeSpec();
+  struct timespec remaining;
   while (nanosleep(&sleep_time, &remaining) == -1 && errno == EINTR)
     sleep_time = remaining;
 }
 
-static bool CreateThread(size_t stack_size, bool joinable, Delegate* delegate,
-                         ThreadHandle* thread_handle) {
+void SleepUntil(const TimeTicks& deadline) {
+#if defined(OS_LINUX)
+  struct timespec deadline_time = deadline.ToTimeSpec();
+  while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &deadline_time,
+                         NULL) == EINTR) {
+  }
+#else
+  TimeTicks now = TimeTicks::Now();
+  while (now < deadline) {
+    Sleep(deadline - now);
+    now = TimeTicks::Now();
+  }
+#endif
+}
+
+#if defined(OS_LINUX)
+// From <numaif.h>, which comes with libnuma rather than the C library.
+const int kMpolBind = 2;
+const int kMaxNumaNodes = 1024;
+
+// Stores |cpus| into |cpu_set|.  Returns false if a processor is out of range.
+static bool MakeCpuSet(const std::vector<int>& cpus, cpu_set_t* cpu_set) {
+  CPU_ZERO(cpu_set);
+  for (size_t i = 0; i < cpus.size(); i++) {
+    if (cpus[i] < 0 || cpus[i] >= CPU_SETSIZE)
+      return false;
+    CPU_SET(cpus[i], cpu_set);
+  }
+  return true;
+}
+
+// Works out the processors a thread created with |options| may run on.
+static bool GetAffinity(const ThreadOptions& options, cpu_set_t* cpu_set) {
+  if (!MakeCpuSet(options.cpus, cpu_set))
+    return false;
+  if (options.numa_node < 0)
+    return true;
+
+  std::vector<int> node_cpus;
+  cpu_set_t node_cpu_set;
+  if (!SysInfo::GetNumaNodeCpus(options.numa_node, &node_cpus) ||
+      !MakeCpuSet(node_cpus, &node_cpu_set))
+    return false;
+  if (!options.cpus.empty())
+    CPU_AND(&node_cpu_set, &node_cpu_set, cpu_set);
+  *cpu_set = node_cpu_set;
+  return CPU_COUNT(cpu_set) > 0;
+}
+#endif  // OS_LINUX
+
+// What the new thread sets up for itself before running the delegate.
+// CreateThread() waits for the new thread to report whether that worked, and
+// owns the params.
+struct ThreadParams {
+  Delegate* delegate;
+  std::string name;
+  int numa_node;
+  // A Linux scheduling policy that pthread attributes do not take, or -1.
+  int policy;
+
+  pthread_mutex_t mutex;
+  // Signaled once |setup_done| is set.
+  pthread_cond_t setup_done_cv;
+  // The following are protected by |mutex|.
+  bool setup_done;
+  // False if the thread could not be placed on |numa_node| or switch to
+  // |policy|; it then exits without running the delegate.
+  bool setup_succeeded;
+};
+
+static void* ThreadFuncWithParams(void* closure) {
+  ThreadParams* params = static_cast<ThreadParams*>(closure);
+  bool succeeded = true;
+#if defined(OS_LINUX)
+  if (!params->name.empty())
+    prctl(PR_SET_NAME, params->name.c_str(), 0, 0, 0);
+  if (params->numa_node >= 0) {
+    unsigned long nodes[kMaxNumaNodes / (8 * sizeof(unsigned long))] = {0};
+    nodes[params->numa_node / (8 * sizeof(unsigned long))] |=
+        1UL << (params->numa_node % (8 * sizeof(unsigned long)));
+    // The kernel reads one bit less than |maxnode|.
+    succeeded = syscall(__NR_set_mempolicy, kMpolBind, nodes,
+                        kMaxNumaNodes + 1) == 0;
+  }
+  if (succeeded && params->policy >= 0) {
+    struct sched_param param;
+    param.sched_priority = 0;
+    succeeded = sched_setscheduler(0, params->policy, &param) == 0;
+  }
+#elif defined(OS_MACOSX)
+  if (!params->name.empty())
+    pthread_setname_np(params->name.c_str());
+#endif
+  // |params| belongs to CreateThread(), which may free it as soon as the
+  // result is in.
+  Delegate* delegate = params->delegate;
+  pthread_mutex_lock(&params->mutex);
+  params->setup_done = true;
+  params->setup_succeeded = succeeded;
+  pthread_cond_signal(&params->setup_done_cv);
+  pthread_mutex_unlock(&params->mutex);
+  if (!succeeded)
+    return NULL;
+  return ThreadFunc(delegate);
+}
+
+// Starts a thread that sets itself up according to |params| before running
+// the delegate, and waits to hear whether that worked.  Returns false, with
+// the thread gone if it was joinable, if it did not.
+static bool CreateThreadWithParams(pthread_attr_t* attributes, bool joinable,
+                                   ThreadParams* params,
+                                   ThreadHandle* thread_handle) {
+  pthread_mutex_init(&params->mutex, NULL);
+  pthread_cond_init(&params->setup_done_cv, NULL);
+  params->setup_done = false;
+  params->setup_succeeded = false;
+
+  bool success = !pthread_create(thread_handle, attributes,
+                                 ThreadFuncWithParams, params);
+  if (success) {
+    pthread_mutex_lock(&params->mutex);
+    while (!params->setup_done)
+      pthread_cond_wait(&params->setup_done_cv, &params->mutex);
+    success = params->setup_succeeded;
+    pthread_mutex_unlock(&params->mutex);
+    if (!success && joinable)
+      pthread_join(*thread_handle, NULL);
+  }
+
+  pthread_cond_destroy(&params->setup_done_cv);
+  pthread_mutex_destroy(&params->mutex);
+  return success;
+}
+
+// A stack lent to a thread by ThreadOptions::stack_pool, until Join() gives it
+// back.
+struct PooledStack {
+  StackPool* pool;
+  Stack stack;
+};
+
+typedef std::map<ThreadHandle, PooledStack> PooledStackMap;
+
+// A plain mutex rather than a Lock, which would need a static initializer.
+static pthread_mutex_t g_pooled_stacks_mutex = PTHREAD_MUTEX_INITIALIZER;
+// Protected by |g_pooled_stacks_mutex|; created on first use.
+static PooledStackMap* g_pooled_stacks = NULL;
+
+static void AddPooledStack(ThreadHandle thread_handle,
+                           const PooledStack& pooled_stack) {
+  pthread_mutex_lock(&g_pooled_stacks_mutex);
+  if (!g_pooled_stacks)
+    g_pooled_stacks = new PooledStackMap;
+  (*g_pooled_stacks)[thread_handle] = pooled_stack;
+  pthread_mutex_unlock(&g_pooled_stacks_mutex);
+}
+
+// Returns false if |thread_handle| has no stack from a pool.
+static bool TakePooledStack(ThreadHandle thread_handle,
+                            PooledStack* pooled_stack) {
+  bool found = false;
+  pthread_mutex_lock(&g_pooled_stacks_mutex);
+  if (g_pooled_stacks) {
+    PooledStackMap::iterator it = g_pooled_stacks->find(thread_handle);
+    if (it != g_pooled_stacks->end()) {
+      *pooled_stack = it->second;
+      g_pooled_stacks->erase(it);
+      found = true;
+    }
+  }
+  pthread_mutex_unlock(&g_pooled_stacks_mutex);
+  return found;
+}
+
+static bool CreateThread(const ThreadOptions& options, bool joinable,
+                         Delegate* delegate, ThreadHandle* thread_handle) {
   bool success = false;
+  size_t stack_size = options.stack_size;
   pthread_attr_t attributes;
   pthread_attr_init(&attributes);
 
@@ -107,10 +313,99 @@ static bool CreateThread(size_t stack_size, bool joinable, Delegate* delegate,
   }
 #endif  // OS_MACOSX
 
-  if (stack_size > 0)
+  if (stack_size > 0 && !options.stack_pool)
     pthread_attr_setstacksize(&attributes, stack_size);
 
-  success = !pthread_create(thread_handle, &attributes, ThreadFunc, delegate);
+  // Placement and scheduling go into the attributes where possible, so that
+  // the thread never runs without them, and so that failures are reported by
+  // pthread_create().
+  bool valid = true;
+#if defined(OS_LINUX)
+  if (!options.cpus.empty() || options.numa_node >= 0) {
+    cpu_set_t cpu_set;
+    valid = GetAffinity(options, &cpu_set) &&
+        pthread_attr_setaffinity_np(&attributes, sizeof(cpu_set),
+                                    &cpu_set) == 0;
+  }
+  if (options.numa_node >= kMaxNumaNodes)
+    valid = false;
+#else
+  if (!options.cpus.empty() || options.numa_node >= 0)
+    valid = false;
+#endif
+
+  // glibc only takes the POSIX policies as attributes.  The others can only
+  // lower the thread's priority, which never needs privileges, so the thread
+  // can switch to them itself.
+  int policy_in_thread = -1;
+  if (options.scheduling_policy != ThreadOptions::SCHEDULING_DEFAULT) {
+    int policy = SCHED_OTHER;
+    switch (options.scheduling_policy) {
+      case ThreadOptions::SCHEDULING_FIFO:
+        policy = SCHED_FIFO;
+        break;
+      case ThreadOptions::SCHEDULING_ROUND_ROBIN:
+        policy = SCHED_RR;
+        break;
+#if defined(OS_LINUX)
+      case ThreadOptions::SCHEDULING_BATCH:
+        policy_in_thread = SCHED_BATCH;
+        break;
+      case ThreadOptions::SCHEDULING_IDLE:
+        policy_in_thread = SCHED_IDLE;
+        break;
+#endif
+      default:
+        valid = false;
+        break;
+    }
+    if (policy != SCHED_OTHER) {
+      struct sched_param param;
+      param.sched_priority = options.priority;
+      valid = valid &&
+          pthread_attr_setinheritsched(&attributes,
+                                       PTHREAD_EXPLICIT_SCHED) == 0 &&
+          pthread_attr_setschedpolicy(&attributes, policy) == 0 &&
+          pthread_attr_setschedparam(&attributes, &param) == 0;
+    }
+  }
+
+  // The stack is taken last, so that invalid options leave the pool alone.
+  // Only Join() can give it back, so the thread must be joinable.
+  PooledStack pooled_stack;
+  pooled_stack.pool = NULL;
+  if (valid && options.stack_pool) {
+    valid = joinable && options.stack_pool->Allocate(&pooled_stack.stack);
+    if (valid) {
+      pooled_stack.pool = options.stack_pool;
+      valid = pthread_attr_setstack(&attributes, pooled_stack.stack.base,
+                                    pooled_stack.stack.size) == 0;
+    }
+  }
+
+  if (valid) {
+    if (options.name || options.numa_node >= 0 || policy_in_thread >= 0) {
+      ThreadParams* params = new ThreadParams;
+      params->delegate = delegate;
+      if (options.name)
+        params->name = options.name;
+      params->numa_node = options.numa_node;
+      params->policy = policy_in_thread;
+      success = CreateThreadWithParams(&attributes, joinable, params,
+                                       thread_handle);
+      delete params;
+    } else {
+      success = !pthread_create(thread_handle, &attributes, ThreadFunc,
+                                delegate);
+    }
+  }
+
+  if (pooled_stack.pool) {
+    if (success)
+      AddPooledStack(*thread_handle, pooled_stack);
+    else
+      pooled_stack.pool->Free(pooled_stack.stack);
+  }
 
   pthread_attr_destroy(&attributes);
   return success;
@@ -118,20 +413,43 @@ static bool CreateThread(size_t stack_size, bool joinable, Delegate* delegate,
 
 bool Create(size_t stack_size, Delegate* delegate,
             ThreadHandle* thread_handle) {
-  return CreateThread(stack_size, true /* joinable thread */,
+  ThreadOptions options;
+  options.stack_size = stack_size;
+  return CreateThread(options, true /* joinable thread */,
+                      delegate, thread_handle);
+}
+
+bool Create(const ThreadOptions& options, Delegate* delegate,
+            ThreadHandle* thread_handle) {
+  return CreateThread(options, true /* joinable thread */,
                       delegate, thread_handle);
 }
 
 bool CreateNonJoinable(size_t stack_size, Delegate* delegate) {
   ThreadHandle unused;
 
-  bool result = CreateThread(stack_size, false /* non-joinable thread */,
+  ThreadOptions options;
+  options.stack_size = stack_size;
+  bool result = CreateThread(options, false /* non-joinable thread */,
                              delegate, &unused);
   return result;
 }
 
 void Join(ThreadHandle thread_handle) {
   pthread_join(thread_handle, NULL);
+  PooledStack pooled_stack;
+  if (TakePooledStack(thread_handle, &pooled_stack))
+    pooled_stack.pool->Free(pooled_stack.stack);
+}
+
+bool SetCurrentAffinity(const std::vector<int>& cpus) {
+#if defined(OS_LINUX)
+  cpu_set_t cpu_set;
+  return MakeCpuSet(cpus, &cpu_set) &&
+      sched_setaffinity(0, sizeof(cpu_set), &cpu_set) == 0;
+#else
+  return false;
+#endif
 }
 
 }  // namespace Thread
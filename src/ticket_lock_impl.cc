@@ -0,0 +1,58 @@
+// Copyright (c) 2010 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "simple-platform-lib/src/ticket_lock_impl.h"
+
+#include "simple-platform-lib/src/spin_wait.h"
+
+namespace platform {
+
+namespace {
+
+// Number of CpuRelax() calls per waiter ahead of us between polls of
+// |now_serving_|, so that waiters far back in line do not hammer its cache
+// line while the lock is handed over.
+const uint32 kBackoffPerWaiter = 8;
+
+}  // namespace
+
+TicketLockImpl::TicketLockImpl() : next_ticket_(0), now_serving_(0) {
+}
+
+TicketLockImpl::~TicketLockImpl() {
+//  DCHECK_EQ(next_ticket_, now_serving_);
+}
+
+bool TicketLockImpl::Try() {
+  // The lock is free exactly when no ticket past the one being served has
+  // been handed out.
+  uint32 serving = now_serving_.Load(MEMORY_ORDER_ACQUIRE);
+  return next_ticket_.CompareExchange(&serving, serving + 1,
+                                      MEMORY_ORDER_ACQUIRE,
+                                      MEMORY_ORDER_RELAXED);
+}
+
+void TicketLockImpl::Lock() {
+  uint32 ticket = next_ticket_.FetchAdd(1, MEMORY_ORDER_RELAXED);
+  SpinWait spin_wait;
+  for (;;) {
+    uint32 serving = now_serving_.Load(MEMORY_ORDER_ACQUIRE);
+    if (serving == ticket)
+      return;
+    // |spin_wait| counts every pause, so a waiter that has been in line for
+    // long starts yielding, and then re-checks after every yield.
+    uint32 backoff = (ticket - serving) * kBackoffPerWaiter;
+    do {
+      spin_wait.Once();
+    } while (--backoff > 0 && !spin_wait.yielding());
+  }
+}
+
+void TicketLockImpl::Unlock() {
+  // Only the holder writes |now_serving_|, so no read-modify-write is needed.
+  uint32 serving = now_serving_.Load(MEMORY_ORDER_RELAXED);
+  now_serving_.Store(serving + 1, MEMORY_ORDER_RELEASE);
+}
+
+}  // namespace platform
@@ -0,0 +1,44 @@
+// Copyright (c) 2010 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef SIMPLEPLATFORMLIB_SRC_TICKET_LOCK_IMPL_H_
+#define SIMPLEPLATFORMLIB_SRC_TICKET_LOCK_IMPL_H_
+#pragma once
+
+#include "simple-platform-lib/src/atomics.h"
+#include "simple-platform-lib/src/basictypes.h"
+
+namespace platform {
+
+// A ticket lock: Lock() takes the next ticket number and waits until it is
+// being served, so the lock is granted in strict FIFO order and no waiter can
+// be starved.  Waiters spin (with backoff proportional to their distance from
+// the head of the line) rather than sleep, so this is only suitable for short
+// critical sections with no more contending threads than processors.  Use it
+// through Lock's policy parameter: TicketLock, see lock.h.
+class TicketLockImpl {
+ public:
+  TicketLockImpl();
+  ~TicketLockImpl();
+
+  // If the lock is not held, take it and return true.  If the lock is already
+  // held by something else, immediately return false.
+  bool Try();
+
+  // Take the lock, waiting for every earlier caller to have had its turn.
+  void Lock();
+
+  // Release the lock.  This must only be called by the lock's holder.
+  void Unlock();
+
+ private:
+  Atomic<uint32> next_ticket_;
+  Atomic<uint32> now_serving_;
+
+  DISALLOW_COPY_AND_ASSIGN(TicketLockImpl);
+};
+
+}  // namespace platform
+
+#endif  // SIMPLEPLATFORMLIB_SRC_TICKET_LOCK_IMPL_H_
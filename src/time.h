@@ -0,0 +1,211 @@
+// Copyright (c) 2010 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+// Loosely based on Chromium: src/base/time.h
+// Significant changes (other than naming):
+//  - only TimeDelta and TimeTicks; no wall-clock Time
+//  - nanosecond resolution
+//  - TimeTicks::FastNow(), on the calibrated time stamp counter
+//  - no Windows implementation yet
+
+// TimeTicks is a point on the monotonic clock, which is not affected by
+// changes to the wall-clock time, and TimeDelta the difference between two of
+// them.  Both count whole nanoseconds in an int64, which is enough for about
+// 292 years.
+//
+//   TimeTicks start = TimeTicks::Now();
+//   ...
+//   TimeDelta elapsed = TimeTicks::Now() - start;
+//   printf("%" PRId64 " us\n", elapsed.InMicroseconds());
+//
+// TimeTicks::Now() reads CLOCK_MONOTONIC, which takes a few tens of
+// nanoseconds through the vDSO, and much longer where the kernel's clock
+// source forces a system call.  TimeTicks::FastNow() reads the processor's
+// time stamp counter instead, where that counts at a constant rate whatever
+// the processor's power state (an "invariant TSC"); it costs about as much as
+// a cache miss.  The counter is calibrated against CLOCK_MONOTONIC on first
+// use, which takes about 10 ms.  Without an invariant TSC, FastNow() is
+// Now().
+//
+// FastNow() is for timing short intervals at high rates, such as lock hold
+// times: its readings are comparable with each other, but drift from Now()'s
+// by the calibration error (typically tens of parts per million), so the two
+// should not be mixed.
+
+#ifndef SIMPLEPLATFORMLIB_SRC_TIME_H_
+#define SIMPLEPLATFORMLIB_SRC_TIME_H_
+#pragma once
+
+#include "simple-platform-lib/build/build_config.h"
+
+#if defined(OS_POSIX)
+#include <time.h>
+#endif
+
+#include "simple-platform-lib/src/basictypes.h"
+
+namespace platform {
+
+class TimeDelta {
+ public:
+  static const int64 kNanosecondsPerMicrosecond = 1000;
+  static const int64 kNanosecondsPerMillisecond = 1000 * 1000;
+  static const int64 kNanosecondsPerSecond = 1000 * 1000 * 1000;
+
+  TimeDelta() : delta_ns_(0) {}
+
+  static TimeDelta FromSeconds(int64 seconds) {
+    return TimeDelta(seconds * kNanosecondsPerSecond);
+  }
+  static TimeDelta FromMilliseconds(int64 ms) {
+    return TimeDelta(ms * kNanosecondsPerMillisecond);
+  }
+  static TimeDelta FromMicroseconds(int64 us) {
+    return TimeDelta(us * kNanosecondsPerMicrosecond);
+  }
+  static TimeDelta FromNanoseconds(int64 ns) {
+    return TimeDelta(ns);
+  }
+
+  // Each rounds towards zero.
+  int64 InSeconds() const { return delta_ns_ / kNanosecondsPerSecond; }
+  int64 InMilliseconds() const {
+    return delta_ns_ / kNanosecondsPerMillisecond;
+  }
+  int64 InMicroseconds() const {
+    return delta_ns_ / kNanosecondsPerMicrosecond;
+  }
+  int64 InNanoseconds() const { return delta_ns_; }
+  double InSecondsF() const {
+    return static_cast<double>(delta_ns_) / kNanosecondsPerSecond;
+  }
+
+#if defined(OS_POSIX)
+  // Negative deltas convert to zero.
+  struct timespec ToTimeSpec() const;
+#endif
+
+  TimeDelta operator+(const TimeDelta& other) const {
+    return TimeDelta(delta_ns_ + other.delta_ns_);
+  }
+  TimeDelta operator-(const TimeDelta& other) const {
+    return TimeDelta(delta_ns_ - other.delta_ns_);
+  }
+  TimeDelta& operator+=(const TimeDelta& other) {
+    delta_ns_ += other.delta_ns_;
+    return *this;
+  }
+  TimeDelta& operator-=(const TimeDelta& other) {
+    delta_ns_ -= other.delta_ns_;
+    return *this;
+  }
+  TimeDelta operator-() const { return TimeDelta(-delta_ns_); }
+  TimeDelta operator*(int64 factor) const {
+    return TimeDelta(delta_ns_ * factor);
+  }
+  TimeDelta operator/(int64 divisor) const {
+    return TimeDelta(delta_ns_ / divisor);
+  }
+
+  bool operator==(const TimeDelta& other) const {
+    return delta_ns_ == other.delta_ns_;
+  }
+  bool operator!=(const TimeDelta& other) const {
+    return delta_ns_ != other.delta_ns_;
+  }
+  bool operator<(const TimeDelta& other) const {
+    return delta_ns_ < other.delta_ns_;
+  }
+  bool operator<=(const TimeDelta& other) const {
+    return delta_ns_ <= other.delta_ns_;
+  }
+  bool operator>(const TimeDelta& other) const {
+    return delta_ns_ > other.delta_ns_;
+  }
+  bool operator>=(const TimeDelta& other) const {
+    return delta_ns_ >= other.delta_ns_;
+  }
+
+ private:
+  explicit TimeDelta(int64 delta_ns) : delta_ns_(delta_ns) {}
+
+  int64 delta_ns_;
+};
+
+class TimeTicks {
+ public:
+  // The null TimeTicks, which is earlier than any that Now() returns.
+  TimeTicks() : ticks_ns_(0) {}
+
+  // The current time on CLOCK_MONOTONIC.
+  static TimeTicks Now();
+
+  // The current time on the time stamp counter, if it is invariant;
+  // otherwise Now().  See above.
+  static TimeTicks FastNow();
+
+  // Returns true if FastNow() reads the time stamp counter.
+  static bool IsFastNowTscBased();
+
+  // For serializing, and for clocks outside this class; nanoseconds since an
+  // unspecified origin (the origin of CLOCK_MONOTONIC on POSIX).
+  static TimeTicks FromInternalValue(int64 ticks_ns) {
+    return TimeTicks(ticks_ns);
+  }
+  int64 ToInternalValue() const { return ticks_ns_; }
+
+  bool is_null() const { return ticks_ns_ == 0; }
+
+#if defined(OS_POSIX)
+  // The absolute time on CLOCK_MONOTONIC, for system calls that take a
+  // deadline.
+  struct timespec ToTimeSpec() const;
+#endif
+
+  TimeDelta operator-(const TimeTicks& other) const {
+    return TimeDelta::FromNanoseconds(ticks_ns_ - other.ticks_ns_);
+  }
+  TimeTicks operator+(const TimeDelta& delta) const {
+    return TimeTicks(ticks_ns_ + delta.InNanoseconds());
+  }
+  TimeTicks operator-(const TimeDelta& delta) const {
+    return TimeTicks(ticks_ns_ - delta.InNanoseconds());
+  }
+  TimeTicks& operator+=(const TimeDelta& delta) {
+    ticks_ns_ += delta.InNanoseconds();
+    return *this;
+  }
+  TimeTicks& operator-=(const TimeDelta& delta) {
+    ticks_ns_ -= delta.InNanoseconds();
+    return *this;
+  }
+
+  bool operator==(const TimeTicks& other) const {
+    return ticks_ns_ == other.ticks_ns_;
+  }
+  bool operator!=(const TimeTicks& other) const {
+    return ticks_ns_ != other.ticks_ns_;
+  }
+  bool operator<(const TimeTicks& other) const {
+    return ticks_ns_ < other.ticks_ns_;
+  }
+  bool operator<=(const TimeTicks& other) const {
+    return ticks_ns_ <= other.ticks_ns_;
+  }
+  bool operator>(const TimeTicks& other) const {
+    return ticks_ns_ > other.ticks_ns_;
+  }
+  bool operator>=(const TimeTicks& other) const {
+    return ticks_ns_ >= other.ticks_ns_;
+  }
+
+ private:
+  explicit TimeTicks(int64 ticks_ns) : ticks_ns_(ticks_ns) {}
+
+  int64 ticks_ns_;
+};
+
+}  // namespace platform
+
+#endif  // SIMPLEPLATFORMLIB_SRC_TIME_H_
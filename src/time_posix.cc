@@ -0,0 +1,164 @@
+// Copyright (c) 2010 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "simple-platform-lib/src/time.h"
+
+#include <pthread.h>
+#include <stdio.h>
+#include <string.h>
+
+#if defined(ARCH_CPU_X86_FAMILY)
+#include <cpuid.h>
+#endif
+
+#include "simple-platform-lib/src/atomics.h"
+
+namespace platform {
+
+const int64 TimeDelta::kNanosecondsPerMicrosecond;
+const int64 TimeDelta::kNanosecondsPerMillisecond;
+const int64 TimeDelta::kNanosecondsPerSecond;
+
+namespace {
+
+#if defined(ARCH_CPU_X86_FAMILY)
+
+// How long the time stamp counter is measured against CLOCK_MONOTONIC.  The
+// calibration error is the clocks' read cost at each end, and any
+// interruption between the paired reads, over this time: a few tens of
+// nanoseconds is already several parts per million, and typically the error
+// is tens of parts per million.
+const int64 kCalibrationNs = 10 * 1000 * 1000;
+
+// Set up by Calibrate(), and then only read.
+bool g_use_tsc = false;
+uint64 g_tsc_base = 0;
+int64 g_ns_base = 0;
+double g_ns_per_tick = 0;
+
+pthread_once_t g_calibrate_once = PTHREAD_ONCE_INIT;
+AtomicFlag g_calibrated;
+
+inline uint64 ReadTsc() {
+  uint32 low, high;
+  __asm__ __volatile__("rdtsc" : "=a"(low), "=d"(high));
+  return (static_cast<uint64>(high) << 32) | low;
+}
+
+// An invariant TSC runs at a constant rate in every P-, C- and T-state, and
+// is synchronized between processors by the BIOS.
+bool HasInvariantTsc() {
+  unsigned int eax, ebx, ecx, edx;
+  if (!__get_cpuid(0x80000007, &eax, &ebx, &ecx, &edx))
+    return false;
+  return (edx & (1 << 8)) != 0;
+}
+
+// The kernel drops the TSC from the clock sources it offers once it finds
+// it unreliable, for instance unsynchronized between sockets.  Trust the
+// processor if the kernel does not say.
+bool KernelTrustsTsc() {
+#if defined(OS_LINUX)
+  FILE* file = fopen(
+      "/sys/devices/system/clocksource/clocksource0/available_clocksource",
+      "r");
+  if (!file)
+    return true;
+  char sources[256];
+  bool trusted = true;
+  if (fgets(sources, sizeof(sources), file))
+    trusted = strstr(sources, "tsc") != NULL;
+  fclose(file);
+  return trusted;
+#else
+  return true;
+#endif
+}
+
+// Reads CLOCK_MONOTONIC and, as close to the same moment as can be, the
+// time stamp counter.
+void ReadBothClocks(int64* ns, uint64* tsc) {
+  uint64 before = ReadTsc();
+  *ns = TimeTicks::Now().ToInternalValue();
+  uint64 after = ReadTsc();
+  *tsc = before + (after - before) / 2;
+}
+
+void Calibrate() {
+  if (HasInvariantTsc() && KernelTrustsTsc()) {
+    int64 start_ns, end_ns;
+    uint64 start_tsc, end_tsc;
+    ReadBothClocks(&start_ns, &start_tsc);
+    do {
+      ReadBothClocks(&end_ns, &end_tsc);
+    } while (end_ns - start_ns < kCalibrationNs);
+    if (end_tsc > start_tsc) {
+      g_ns_per_tick = static_cast<double>(end_ns - start_ns) /
+                      (end_tsc - start_tsc);
+      g_tsc_base = end_tsc;
+      g_ns_base = end_ns;
+      g_use_tsc = true;
+    }
+  }
+  g_calibrated.Set();
+}
+
+inline bool UseTsc() {
+  if (!g_calibrated.IsSet())
+    pthread_once(&g_calibrate_once, Calibrate);
+  return g_use_tsc;
+}
+
+#endif  // ARCH_CPU_X86_FAMILY
+
+}  // namespace
+
+struct timespec TimeDelta::ToTimeSpec() const {
+  struct timespec result;
+  int64 ns = delta_ns_ < 0 ? 0 : delta_ns_;
+  result.tv_sec = static_cast<time_t>(ns / kNanosecondsPerSecond);
+  result.tv_nsec = static_cast<long>(ns % kNanosecondsPerSecond);
+  return result;
+}
+
+// static
+TimeTicks TimeTicks::Now() {
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return TimeTicks(static_cast<int64>(now.tv_sec) *
+                   TimeDelta::kNanosecondsPerSecond + now.tv_nsec);
+}
+
+// static
+TimeTicks TimeTicks::FastNow() {
+#if defined(ARCH_CPU_X86_FAMILY)
+  if (UseTsc()) {
+    // Signed, in case this processor's counter is a little behind the one
+    // that was read for the base.
+    int64 ticks = static_cast<int64>(ReadTsc() - g_tsc_base);
+    return TimeTicks(g_ns_base + static_cast<int64>(ticks * g_ns_per_tick));
+  }
+#endif
+  return Now();
+}
+
+// static
+bool TimeTicks::IsFastNowTscBased() {
+#if defined(ARCH_CPU_X86_FAMILY)
+  return UseTsc();
+#else
+  return false;
+#endif
+}
+
+struct timespec TimeTicks::ToTimeSpec() const {
+  struct timespec result;
+  result.tv_sec = static_cast<time_t>(ticks_ns_ /
+                                      TimeDelta::kNanosecondsPerSecond);
+  result.tv_nsec = static_cast<long>(ticks_ns_ %
+                                     TimeDelta::kNanosecondsPerSecond);
+  return result;
+}
+
+}  // namespace platform
@@ -0,0 +1,104 @@
+// Copyright (c) 2010 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "simple-platform-lib/src/timer_thread.h"
+
+namespace platform {
+
+class TimerThread::Driver : public Thread::Delegate {
+ public:
+  explicit Driver(TimerThread* timer_thread) : timer_thread_(timer_thread) {}
+
+  virtual void ThreadMain() {
+    timer_thread_->Run();
+  }
+
+ private:
+  TimerThread* timer_thread_;
+
+  DISALLOW_COPY_AND_ASSIGN(Driver);
+};
+
+TimerThread::TimerThread(const TimeDelta& resolution)
+    : driver_(NULL),
+      handle_(),
+      lock_("TimerThread::lock_"),
+      wakeup_(&lock_),
+      wheel_(resolution, TimeTicks::Now()),
+      sleeping_(false),
+      stopping_(false) {
+}
+
+TimerThread::~TimerThread() {
+  if (driver_)
+    Stop();
+}
+
+bool TimerThread::Start() {
+//  DCHECK(!driver_);
+  driver_ = new Driver(this);
+  if (!Thread::Create(0, driver_, &handle_)) {
+    delete driver_;
+    driver_ = NULL;
+    return false;
+  }
+  return true;
+}
+
+void TimerThread::Stop() {
+  {
+    AutoLock auto_lock(lock_);
+    stopping_ = true;
+    wakeup_.Signal();
+  }
+  if (driver_) {
+    Thread::Join(handle_);
+    delete driver_;
+    driver_ = NULL;
+  }
+  AutoLock auto_lock(lock_);
+  wheel_.CancelAll();
+}
+
+void TimerThread::Schedule(Timer* timer, const TimeTicks& deadline) {
+  AutoLock auto_lock(lock_);
+  wheel_.Schedule(timer, deadline);
+  if (sleeping_ &&
+      (sleeping_until_.is_null() || deadline < sleeping_until_)) {
+    // Only one thread waits, so one signal is enough.
+    sleeping_ = false;
+    wakeup_.Signal();
+  }
+}
+
+bool TimerThread::Cancel(Timer* timer) {
+  AutoLock auto_lock(lock_);
+  return wheel_.Cancel(timer);
+}
+
+void TimerThread::Run() {
+  std::vector<Timer*> expired;
+  AutoLock auto_lock(lock_);
+  while (!stopping_) {
+    TimeTicks now = TimeTicks::Now();
+    if (wheel_.Advance(now, &expired) > 0) {
+      lock_.Release();
+      for (size_t i = 0; i < expired.size(); i++)
+        expired[i]->OnExpired();
+      expired.clear();
+      lock_.Acquire();
+      continue;
+    }
+
+    sleeping_ = true;
+    sleeping_until_ = wheel_.NextWakeup();
+    if (sleeping_until_.is_null())
+      wakeup_.Wait();
+    else
+      wakeup_.TimedWait(sleeping_until_ - now);
+    sleeping_ = false;
+  }
+}
+
+}  // namespace platform
@@ -0,0 +1,85 @@
+// Copyright (c) 2010 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+// TimerThread expires Timers (see timer_wheel.h) on a thread of its own.
+// Any thread may schedule and cancel timers; the timer thread sleeps until
+// the earliest deadline, expires the timers that are due in one batch, and
+// calls their OnExpired() outside its lock.
+//
+//   TimerThread timers(TimeDelta::FromMilliseconds(1));
+//   timers.Start();
+//   timers.Schedule(&timeout, TimeTicks::Now() + TimeDelta::FromSeconds(30));
+//   ...
+//   if (!timers.Cancel(&timeout))
+//     ...  // Expired, or expiring: OnExpired() may be running right now.
+//
+// OnExpired() runs on the timer thread, so it must be short; it may
+// schedule timers (including its own) again, and may delete its timer, which
+// the timer thread does not touch afterwards.
+
+#ifndef SIMPLEPLATFORMLIB_SRC_TIMER_THREAD_H_
+#define SIMPLEPLATFORMLIB_SRC_TIMER_THREAD_H_
+#pragma once
+
+#include <vector>
+
+#include "simple-platform-lib/src/basictypes.h"
+#include "simple-platform-lib/src/condition_variable.h"
+#include "simple-platform-lib/src/lock.h"
+#include "simple-platform-lib/src/thread.h"
+#include "simple-platform-lib/src/time.h"
+#include "simple-platform-lib/src/timer_wheel.h"
+
+namespace platform {
+
+class TimerThread {
+ public:
+  // Deadlines are rounded up to a multiple of |resolution|.
+  explicit TimerThread(const TimeDelta& resolution);
+
+  // Stops the thread, if Stop() has not been called.
+  ~TimerThread();
+
+  // Starts the timer thread.  Returns false if it could not be created.
+  bool Start();
+
+  // Joins the timer thread.  Timers still scheduled are unscheduled without
+  // expiring.  Must be called at most once, and not from OnExpired().
+  void Stop();
+
+  // Schedules |timer|, which must not be scheduled, to expire at |deadline|.
+  void Schedule(Timer* timer, const TimeTicks& deadline);
+
+  // Unschedules |timer|.  Returns false if it was not scheduled, which
+  // includes having been taken off the wheel to expire.
+  bool Cancel(Timer* timer);
+
+ private:
+  class Driver;
+
+  // The body of the timer thread.
+  void Run();
+
+  Driver* driver_;
+  ThreadHandle handle_;
+
+  Lock lock_;
+  // Signaled when a timer is scheduled before the thread's wakeup time, and
+  // on Stop().
+  ConditionVariable wakeup_;
+
+  // The following are protected by |lock_|.
+  TimerWheel wheel_;
+  // Whether the timer thread is waiting, and until when; null for as long as
+  // it takes.
+  bool sleeping_;
+  TimeTicks sleeping_until_;
+  bool stopping_;
+
+  DISALLOW_COPY_AND_ASSIGN(TimerThread);
+};
+
+}  // namespace platform
+
+#endif  // SIMPLEPLATFORMLIB_SRC_TIMER_THREAD_H_
@@ -0,0 +1,226 @@
+// Copyright (c) 2010 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "simple-platform-lib/src/timer_wheel.h"
+
+namespace platform {
+
+using internal::TimerLink;
+
+namespace {
+
+void InitList(TimerLink* head) {
+  head->next = head;
+  head->prev = head;
+}
+
+bool ListEmpty(const TimerLink* head) {
+  return head->next == head;
+}
+
+void AppendToList(TimerLink* head, TimerLink* link) {
+  link->prev = head->prev;
+  link->next = head;
+  head->prev->next = link;
+  head->prev = link;
+}
+
+void RemoveFromList(TimerLink* link) {
+  link->prev->next = link->next;
+  link->next->prev = link->prev;
+  link->next = NULL;
+  link->prev = NULL;
+}
+
+}  // namespace
+
+Timer::Timer() : tick_(0) {
+  next = NULL;
+  prev = NULL;
+}
+
+Timer::~Timer() {
+//  DCHECK(!is_scheduled());
+}
+
+TimerWheel::TimerWheel(const TimeDelta& resolution, const TimeTicks& origin)
+    : resolution_(resolution),
+      origin_(origin),
+      current_tick_(0),
+      size_(0) {
+  for (int i = 0; i < kSlots; i++)
+    InitList(&slots_[i]);
+}
+
+TimerWheel::~TimerWheel() {
+  CancelAll();
+}
+
+void TimerWheel::Schedule(Timer* timer, const TimeTicks& deadline) {
+//  DCHECK(!timer->is_scheduled());
+  int64 ns = (deadline - origin_).InNanoseconds();
+  int64 resolution_ns = resolution_.InNanoseconds();
+  // Round up, so that a timer never expires early.
+  int64 tick = ns / resolution_ns;
+  if (tick * resolution_ns < ns)
+    tick++;
+  timer->tick_ = tick;
+  AppendToList(SlotFor(timer), timer);
+  size_++;
+}
+
+bool TimerWheel::Cancel(Timer* timer) {
+  if (!timer->is_scheduled())
+    return false;
+  RemoveFromList(timer);
+  size_--;
+  return true;
+}
+
+void TimerWheel::CancelAll() {
+  for (int i = 0; i < kSlots; i++) {
+    while (!ListEmpty(&slots_[i]))
+      RemoveFromList(slots_[i].next);
+  }
+  size_ = 0;
+}
+
+size_t TimerWheel::Advance(const TimeTicks& now,
+                           std::vector<Timer*>* expired) {
+  int64 last_tick =
+      (now - origin_).InNanoseconds() / resolution_.InNanoseconds();
+  size_t count = 0;
+  // Skip straight to the ticks with something to do, so that the cost does
+  // not depend on how far |now| is.
+  while (size_ > 0) {
+    int64 tick = NextEventTick();
+    if (tick > last_tick)
+      break;
+    current_tick_ = tick;
+    int index = static_cast<int>(tick & (kLevel0Slots - 1));
+    if (index == 0)
+      Cascade();
+    // The whole slot expires, so unlink its timers without fixing up their
+    // neighbours.
+    TimerLink* slot = &slots_[index];
+    TimerLink* link = slot->next;
+    while (link != slot) {
+      TimerLink* next = link->next;
+      link->next = NULL;
+      link->prev = NULL;
+      expired->push_back(static_cast<Timer*>(link));
+      size_--;
+      count++;
+      link = next;
+    }
+    InitList(slot);
+    current_tick_ = tick + 1;
+  }
+  if (current_tick_ <= last_tick)
+    current_tick_ = last_tick + 1;
+  return count;
+}
+
+TimeTicks TimerWheel::NextWakeup() const {
+  if (size_ == 0)
+    return TimeTicks();
+  return TickToTime(NextEventTick());
+}
+
+int64 TimerWheel::NextEventTick() const {
+  // The first non-empty level 0 slot.  Its timers are exactly that many
+  // ticks away, as level 0 spans 256 ticks.
+  int64 next_tick = kint64max;
+  int index = static_cast<int>(current_tick_ & (kLevel0Slots - 1));
+  for (int i = 0; i < kLevel0Slots; i++) {
+    if (!ListEmpty(&slots_[(index + i) & (kLevel0Slots - 1)])) {
+      next_tick = current_tick_ + i;
+      break;
+    }
+  }
+
+  // A cascade before that may bring earlier timers down to level 0, so it
+  // is an event too.  Cascades of empty slots are not.
+  const TimerLink* level_slots = &slots_[kLevel0Slots];
+  int shift = kLevel0Bits;
+  for (int level = 1; level < kLevels; level++) {
+    int64 span = GG_LONGLONG(1) << shift;
+    int64 boundary = (current_tick_ + span - 1) & ~(span - 1);
+    for (int i = 0; i < kLevelSlots && boundary < next_tick; i++) {
+      if (!ListEmpty(&level_slots[(boundary >> shift) & (kLevelSlots - 1)])) {
+        next_tick = boundary;
+        break;
+      }
+      boundary += span;
+    }
+    level_slots += kLevelSlots;
+    shift += kLevelBits;
+  }
+  return next_tick;
+}
+
+TimerLink* TimerWheel::SlotFor(const Timer* timer) {
+  int64 tick = timer->tick_;
+  int64 delta = tick - current_tick_;
+  if (delta < 0) {
+    // Overdue; expire with the current tick.
+    return &slots_[current_tick_ & (kLevel0Slots - 1)];
+  }
+  if (delta < kLevel0Slots)
+    return &slots_[tick & (kLevel0Slots - 1)];
+
+  const int64 kMaxDelta =
+      (GG_LONGLONG(1) << (kLevel0Bits + (kLevels - 1) * kLevelBits)) - 1;
+  if (delta > kMaxDelta) {
+    // Beyond the wheel; wait in the furthest slot and be looked at again
+    // when it is cascaded.
+    tick = current_tick_ + kMaxDelta;
+    delta = kMaxDelta;
+  }
+  TimerLink* level_slots = &slots_[kLevel0Slots];
+  int shift = kLevel0Bits;
+  for (int level = 1; ; level++) {
+    if (level == kLevels - 1 ||
+        delta < GG_LONGLONG(1) << (shift + kLevelBits))
+      return &level_slots[(tick >> shift) & (kLevelSlots - 1)];
+    level_slots += kLevelSlots;
+    shift += kLevelBits;
+  }
+}
+
+void TimerWheel::Cascade() {
+  TimerLink* level_slots = &slots_[kLevel0Slots];
+  int shift = kLevel0Bits;
+  for (int level = 1; level < kLevels; level++) {
+    int index =
+        static_cast<int>((current_tick_ >> shift) & (kLevelSlots - 1));
+    TimerLink list;
+    TakeAll(&level_slots[index], &list);
+    while (!ListEmpty(&list)) {
+      Timer* timer = static_cast<Timer*>(list.next);
+      RemoveFromList(timer);
+      AppendToList(SlotFor(timer), timer);
+    }
+    // The next level's turn only comes when this one wraps around.
+    if (index != 0)
+      break;
+    level_slots += kLevelSlots;
+    shift += kLevelBits;
+  }
+}
+
+// static
+void TimerWheel::TakeAll(TimerLink* slot, TimerLink* list) {
+  if (ListEmpty(slot)) {
+    InitList(list);
+    return;
+  }
+  list->next = slot->next;
+  list->prev = slot->prev;
+  list->next->prev = list;
+  list->prev->next = list;
+  InitList(slot);
+}
+
+}  // namespace platform
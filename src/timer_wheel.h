@@ -0,0 +1,142 @@
+// Copyright (c) 2010 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+// TimerWheel keeps track of large numbers of timeouts, such as one per
+// connection or request, at a fixed resolution (say a millisecond).
+// Scheduling and cancelling a timer take constant time, however many are
+// pending, and so does expiring each one.
+//
+// It is a hierarchical timing wheel, as in the Linux kernel: an array of 256
+// slots, one per tick, holds the timers due in the next 256 ticks, and four
+// coarser arrays of 64 slots hold the later ones, each slot covering 256,
+// 256 * 64, ... ticks.  Every 256 ticks the next slot of a coarser array is
+// redistributed ("cascaded") into the finer ones.  Timers due more than 2^32
+// ticks ahead wait in the last slot and are redistributed until they fit.
+//
+// Timers are intrusive: derive from Timer, and the wheel links the timer
+// itself into its slots, so scheduling allocates nothing.
+//
+//   class RequestTimeout : public Timer {
+//     virtual void OnExpired() { ... }
+//   };
+//
+//   TimerWheel wheel(TimeDelta::FromMilliseconds(1), TimeTicks::Now());
+//   wheel.Schedule(&timeout, TimeTicks::Now() + TimeDelta::FromSeconds(30));
+//   ...
+//   wheel.Advance(TimeTicks::Now(), &expired);
+//
+// A TimerWheel is not thread-safe; TimerThread (see timer_thread.h) wraps
+// one with a lock and a thread that expires the timers.
+
+#ifndef SIMPLEPLATFORMLIB_SRC_TIMER_WHEEL_H_
+#define SIMPLEPLATFORMLIB_SRC_TIMER_WHEEL_H_
+#pragma once
+
+#include <stddef.h>
+
+#include <vector>
+
+#include "simple-platform-lib/src/basictypes.h"
+#include "simple-platform-lib/src/time.h"
+
+namespace platform {
+
+namespace internal {
+
+// A link in a circular, doubly-linked list of timers.
+struct TimerLink {
+  TimerLink* next;
+  TimerLink* prev;
+};
+
+}  // namespace internal
+
+class Timer : private internal::TimerLink {
+ public:
+  Timer();
+  // A timer must not be destroyed while it is scheduled.
+  virtual ~Timer();
+
+  // Called by whoever expires the timer (e.g. TimerThread), not by the wheel.
+  virtual void OnExpired() = 0;
+
+  bool is_scheduled() const { return next != NULL; }
+
+ private:
+  friend class TimerWheel;
+
+  // The tick at which the timer expires.
+  int64 tick_;
+
+  DISALLOW_COPY_AND_ASSIGN(Timer);
+};
+
+class TimerWheel {
+ public:
+  // Ticks are |resolution| long, counted from |origin|.
+  TimerWheel(const TimeDelta& resolution, const TimeTicks& origin);
+  // Calls CancelAll().
+  ~TimerWheel();
+
+  // Schedules |timer|, which must not be scheduled, to expire at |deadline|,
+  // rounded up to a tick.  A deadline in the past expires with the first
+  // tick that has not been advanced over yet.
+  void Schedule(Timer* timer, const TimeTicks& deadline);
+
+  // Unschedules |timer|.  Returns false if it was not scheduled.
+  bool Cancel(Timer* timer);
+
+  // Unschedules every timer.
+  void CancelAll();
+
+  // Unschedules the timers due at or before |now| and appends them to
+  // |expired|, earliest first.  Returns the number of timers expired.
+  size_t Advance(const TimeTicks& now, std::vector<Timer*>* expired);
+
+  // The time by which Advance() must be called next: the deadline of the
+  // earliest timer, or the time of a cascade before that (which may bring
+  // down timers due earlier).  Null if no timer is scheduled.
+  TimeTicks NextWakeup() const;
+
+  size_t size() const { return size_; }
+  TimeDelta resolution() const { return resolution_; }
+
+ private:
+  static const int kLevels = 5;
+  static const int kLevel0Bits = 8;
+  static const int kLevelBits = 6;
+  static const int kLevel0Slots = 1 << kLevel0Bits;
+  static const int kLevelSlots = 1 << kLevelBits;
+  static const int kSlots = kLevel0Slots + (kLevels - 1) * kLevelSlots;
+
+  // The first tick, from |current_tick_| on, at which a timer expires or a
+  // non-empty slot is cascaded.  Only called with timers scheduled.
+  int64 NextEventTick() const;
+  // The slot that |timer| belongs in, given |current_tick_|.
+  internal::TimerLink* SlotFor(const Timer* timer);
+  // Redistributes the timers of the current slot of each coarse level whose
+  // turn has come.
+  void Cascade();
+  // Moves the timers of |slot| into |list|, leaving |slot| empty.
+  static void TakeAll(internal::TimerLink* slot, internal::TimerLink* list);
+
+  TimeTicks TickToTime(int64 tick) const {
+    return origin_ + resolution_ * tick;
+  }
+
+  const TimeDelta resolution_;
+  const TimeTicks origin_;
+  // The next tick to expire; every earlier one has been expired.  Ticks
+  // with nothing to expire or cascade are skipped over.
+  int64 current_tick_;
+  size_t size_;
+  // The list heads: the 256 level 0 slots, then 64 for each coarser level.
+  internal::TimerLink slots_[kSlots];
+
+  DISALLOW_COPY_AND_ASSIGN(TimerWheel);
+};
+
+}  // namespace platform
+
+#endif  // SIMPLEPLATFORMLIB_SRC_TIMER_WHEEL_H_
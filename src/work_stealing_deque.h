@@ -0,0 +1,148 @@
+// Copyright (c) 2010 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+// WorkStealingDeque<T> is the Chase-Lev lock-free deque of T pointers, with
+// the memory orderings of Le, Pop, Cohen and Zappa Nardelli, "Correct and
+// Efficient Work-Stealing for Weak Memory Models" (PPoPP 2013).
+//
+// One thread, the owner, pushes and pops at the bottom, so it uses the deque
+// as a stack and gets the most recently pushed (cache-hot) item.  Any thread
+// may steal from the top, taking the oldest item, which in fork/join
+// workloads tends to be the biggest piece of work left.  Push() and Pop()
+// touch no shared cache line unless the deque is nearly empty.
+//
+// The deque grows as needed; it never shrinks.  Arrays that have been grown
+// out of are kept until the deque is destroyed, since a thief may still be
+// reading from one.
+
+#ifndef SIMPLEPLATFORMLIB_SRC_WORK_STEALING_DEQUE_H_
+#define SIMPLEPLATFORMLIB_SRC_WORK_STEALING_DEQUE_H_
+#pragma once
+
+#include <vector>
+
+#include "simple-platform-lib/src/atomics.h"
+#include "simple-platform-lib/src/basictypes.h"
+
+namespace platform {
+
+template <typename T>
+class WorkStealingDeque {
+ public:
+  WorkStealingDeque() : top_(0), bottom_(0), array_(new Array(kInitialSize)) {
+    arrays_.push_back(array_.Load(MEMORY_ORDER_RELAXED));
+  }
+
+  ~WorkStealingDeque() {
+    for (size_t i = 0; i < arrays_.size(); i++)
+      delete arrays_[i];
+  }
+
+  // Owner only.  |item| must not be NULL.
+  void Push(T* item) {
+    int64 bottom = bottom_.Load(MEMORY_ORDER_RELAXED);
+    int64 top = top_.Load(MEMORY_ORDER_ACQUIRE);
+    Array* array = array_.Load(MEMORY_ORDER_RELAXED);
+    if (bottom - top > array->mask)
+      array = Grow(array, top, bottom);
+    array->Put(bottom, item);
+    // The paper has a release fence and a relaxed store; a release store is
+    // just as cheap, and is understood by race detectors.
+    bottom_.Store(bottom + 1, MEMORY_ORDER_RELEASE);
+  }
+
+  // Owner only.  Returns the most recently pushed item, or NULL if the deque
+  // is empty.
+  T* Pop() {
+    int64 bottom = bottom_.Load(MEMORY_ORDER_RELAXED) - 1;
+    Array* array = array_.Load(MEMORY_ORDER_RELAXED);
+    bottom_.Store(bottom, MEMORY_ORDER_RELAXED);
+    AtomicThreadFence(MEMORY_ORDER_SEQ_CST);
+    int64 top = top_.Load(MEMORY_ORDER_RELAXED);
+    if (top > bottom) {
+      // Empty.
+      bottom_.Store(bottom + 1, MEMORY_ORDER_RELAXED);
+      return NULL;
+    }
+    T* item = array->Get(bottom);
+    if (top == bottom) {
+      // The last item; race the thieves for it.
+      if (!top_.CompareExchange(&top, top + 1, MEMORY_ORDER_SEQ_CST,
+                                MEMORY_ORDER_RELAXED))
+        item = NULL;
+      bottom_.Store(bottom + 1, MEMORY_ORDER_RELAXED);
+    }
+    return item;
+  }
+
+  // Any thread.  Returns the least recently pushed item, or NULL if the deque
+  // is empty.
+  T* Steal() {
+    for (;;) {
+      int64 top = top_.Load(MEMORY_ORDER_ACQUIRE);
+      AtomicThreadFence(MEMORY_ORDER_SEQ_CST);
+      int64 bottom = bottom_.Load(MEMORY_ORDER_ACQUIRE);
+      if (top >= bottom)
+        return NULL;
+      // Consume ordering would do, but compilers implement it as acquire.
+      Array* array = array_.Load(MEMORY_ORDER_ACQUIRE);
+      T* item = array->Get(top);
+      if (top_.CompareExchange(&top, top + 1, MEMORY_ORDER_SEQ_CST,
+                               MEMORY_ORDER_RELAXED))
+        return item;
+      // Lost the race to the owner or another thief; look again.
+    }
+  }
+
+  // Any thread.  Only a hint, unless called by the owner with no thieves
+  // around.
+  bool Empty() const {
+    int64 top = top_.Load(MEMORY_ORDER_RELAXED);
+    int64 bottom = bottom_.Load(MEMORY_ORDER_RELAXED);
+    return top >= bottom;
+  }
+
+ private:
+  static const int64 kInitialSize = 256;
+
+  // A power-of-two sized circular buffer, indexed by the ever increasing
+  // top/bottom positions.
+  struct Array {
+    explicit Array(int64 size) : mask(size - 1), items(new Atomic<T*>[size]) {}
+    ~Array() { delete[] items; }
+
+    T* Get(int64 index) const {
+      return items[index & mask].Load(MEMORY_ORDER_RELAXED);
+    }
+    void Put(int64 index, T* item) {
+      items[index & mask].Store(item, MEMORY_ORDER_RELAXED);
+    }
+
+    const int64 mask;
+    Atomic<T*>* const items;
+  };
+
+  Array* Grow(Array* array, int64 top, int64 bottom) {
+    Array* bigger = new Array((array->mask + 1) * 2);
+    for (int64 i = top; i < bottom; i++)
+      bigger->Put(i, array->Get(i));
+    arrays_.push_back(bigger);
+    array_.Store(bigger, MEMORY_ORDER_RELEASE);
+    return bigger;
+  }
+
+  // Thieves contend on |top_|; keep it off the owner's cache line.
+  Atomic<int64> top_;
+  char padding_[kCacheLineSize - sizeof(Atomic<int64>)];
+  Atomic<int64> bottom_;
+  Atomic<Array*> array_;
+  // Every array ever used, |array_| included.  Owner only.
+  std::vector<Array*> arrays_;
+
+  DISALLOW_COPY_AND_ASSIGN(WorkStealingDeque);
+};
+
+}  // namespace platform
+
+#endif  // SIMPLEPLATFORMLIB_SRC_WORK_STEALING_DEQUE_H_
@@ -0,0 +1,293 @@
+// Copyright (c) 2010 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "simple-platform-lib/src/work_stealing_scheduler.h"
+
+#include "simple-platform-lib/src/spin_wait.h"
+#include "simple-platform-lib/src/sys_info.h"
+#include "simple-platform-lib/src/work_stealing_deque.h"
+
+namespace platform {
+
+namespace {
+
+// The Worker running on the current thread, if any.  A void* because Worker
+// is private to WorkStealingScheduler.
+__thread void* g_current_worker = NULL;
+
+}  // namespace
+
+struct WorkStealingScheduler::Job {
+  Task* task;
+  TaskGroup* group;
+};
+
+class WorkStealingScheduler::Worker : public Thread::Delegate {
+ public:
+  Worker(WorkStealingScheduler* scheduler, int index)
+      : scheduler_(scheduler),
+        random_state_(static_cast<uint32>(index + 1) * 2654435761U) {}
+
+  virtual void ThreadMain() {
+    g_current_worker = this;
+    scheduler_->Run(this);
+    g_current_worker = NULL;
+  }
+
+  WorkStealingScheduler* scheduler() const { return scheduler_; }
+  WorkStealingDeque<Job>* deque() { return &deque_; }
+
+  // xorshift; only needs to spread the victims around.
+  uint32 NextRandom() {
+    random_state_ ^= random_state_ << 13;
+    random_state_ ^= random_state_ >> 17;
+    random_state_ ^= random_state_ << 5;
+    return random_state_;
+  }
+
+ private:
+  WorkStealingScheduler* scheduler_;
+  uint32 random_state_;
+  WorkStealingDeque<Job> deque_;
+
+  DISALLOW_COPY_AND_ASSIGN(Worker);
+};
+
+TaskGroup::TaskGroup(WorkStealingScheduler* scheduler)
+    : scheduler_(scheduler),
+      pending_(0) {
+}
+
+TaskGroup::~TaskGroup() {
+//  DCHECK_EQ(0, pending_.Load());
+}
+
+void TaskGroup::Spawn(Task* task) {
+  scheduler_->Spawn(task, this);
+}
+
+void TaskGroup::Join() {
+  scheduler_->Join(this);
+}
+
+WorkStealingScheduler::WorkStealingScheduler(int num_threads)
+    : num_threads_(num_threads > 0 ? num_threads :
+                                     SysInfo::NumberOfProcessors()),
+      injected_lock_("WorkStealingScheduler::injected_lock_"),
+      injected_count_(0),
+      park_lock_("WorkStealingScheduler::park_lock_"),
+      park_cv_(&park_lock_),
+      sleepers_(0),
+      wake_epoch_(0),
+      stopping_(false),
+      join_lock_("WorkStealingScheduler::join_lock_"),
+      join_cv_(&join_lock_),
+      external_joiners_(0),
+      root_group_(this) {
+}
+
+WorkStealingScheduler::~WorkStealingScheduler() {
+  // Without workers, the posted tasks are run here.
+  if (handles_.empty()) {
+    while (Job* job = FindWork(NULL))
+      Execute(job);
+  }
+  root_group_.Join();
+
+  {
+    AutoLock auto_lock(park_lock_);
+    stopping_ = true;
+    park_cv_.Broadcast();
+  }
+  for (size_t i = 0; i < handles_.size(); i++)
+    Thread::Join(handles_[i]);
+  for (size_t i = 0; i < workers_.size(); i++)
+    delete workers_[i];
+}
+
+bool WorkStealingScheduler::Start() {
+//  DCHECK(workers_.empty());
+  // All workers exist before any runs, since they steal from each other.
+  for (int i = 0; i < num_threads_; i++)
+    workers_.push_back(new Worker(this, i));
+
+  bool success = true;
+  for (int i = 0; i < num_threads_; i++) {
+    ThreadHandle handle;
+    if (Thread::Create(0, workers_[i], &handle))
+      handles_.push_back(handle);
+    else
+      success = false;
+  }
+  return success;
+}
+
+void WorkStealingScheduler::PostTask(Task* task) {
+  Spawn(task, &root_group_);
+}
+
+void WorkStealingScheduler::Execute(Task* task) {
+  PostTask(task);
+}
+
+bool WorkStealingScheduler::CurrentQueueEmpty() {
+  Worker* worker = CurrentWorker();
+  return !worker || worker->deque()->Empty();
+}
+
+// static
+WorkStealingScheduler* WorkStealingScheduler::GetDefault() {
+  static WorkStealingScheduler* scheduler = CreateDefault();
+  return scheduler;
+}
+
+// static
+WorkStealingScheduler* WorkStealingScheduler::CreateDefault() {
+  WorkStealingScheduler* scheduler = new WorkStealingScheduler(0);
+  scheduler->Start();
+  return scheduler;
+}
+
+void WorkStealingScheduler::Spawn(Task* task, TaskGroup* group) {
+  group->pending_.FetchAdd(1);
+  Job* job = new Job;
+  job->task = task;
+  job->group = group;
+
+  Worker* worker = CurrentWorker();
+  if (worker) {
+    worker->deque()->Push(job);
+  } else {
+    AutoLock auto_lock(injected_lock_);
+    injected_.push_back(job);
+    injected_count_.FetchAdd(1);
+  }
+  WakeWorker();
+}
+
+void WorkStealingScheduler::Join(TaskGroup* group) {
+  Worker* worker = CurrentWorker();
+  if (worker) {
+    // Help out rather than block: the tasks we are waiting for may well be on
+    // our own deque.
+    SpinWait spin_wait;
+    while (group->pending_.Load(MEMORY_ORDER_ACQUIRE) > 0) {
+      Job* job = FindWork(worker);
+      if (job) {
+        Execute(job);
+        spin_wait.Reset();
+      } else {
+        spin_wait.Once();
+      }
+    }
+    return;
+  }
+
+  // Registering as a joiner and then reading |pending_| pairs with
+  // Execute()'s decrement of |pending_| and then read of |external_joiners_|.
+  // Both reads must be SEQ_CST, or each side may see the other's old value
+  // and the wakeup is lost.
+  AutoLock auto_lock(join_lock_);
+  external_joiners_.FetchAdd(1);
+  while (group->pending_.Load(MEMORY_ORDER_SEQ_CST) > 0)
+    join_cv_.Wait();
+  external_joiners_.FetchSub(1);
+}
+
+WorkStealingScheduler::Worker* WorkStealingScheduler::CurrentWorker() {
+  Worker* worker = static_cast<Worker*>(g_current_worker);
+  if (worker && worker->scheduler() == this)
+    return worker;
+  return NULL;
+}
+
+WorkStealingScheduler::Job* WorkStealingScheduler::FindWork(Worker* worker) {
+  if (worker) {
+    Job* job = worker->deque()->Pop();
+    if (job)
+      return job;
+  }
+
+  if (injected_count_.Load(MEMORY_ORDER_RELAXED) > 0) {
+    AutoLock auto_lock(injected_lock_);
+    if (!injected_.empty()) {
+      Job* job = injected_.front();
+      injected_.pop_front();
+      injected_count_.FetchSub(1);
+      return job;
+    }
+  }
+
+  size_t count = workers_.size();
+  size_t start = worker ? worker->NextRandom() % count : 0;
+  for (size_t i = 0; i < count; i++) {
+    Worker* victim = workers_[(start + i) % count];
+    if (victim == worker)
+      continue;
+    Job* job = victim->deque()->Steal();
+    if (job)
+      return job;
+  }
+  return NULL;
+}
+
+WorkStealingScheduler::Job* WorkStealingScheduler::WaitForWork(
+    Worker* worker) {
+  for (;;) {
+    int32 epoch = wake_epoch_.Load(MEMORY_ORDER_RELAXED);
+    sleepers_.FetchAdd(1);
+    Job* job = FindWork(worker);
+    bool stopping = false;
+    if (!job) {
+      AutoLock auto_lock(park_lock_);
+      while (wake_epoch_.Load(MEMORY_ORDER_RELAXED) == epoch && !stopping_)
+        park_cv_.Wait();
+      stopping = stopping_;
+    }
+    sleepers_.FetchSub(1);
+    if (job)
+      return job;
+    if (stopping)
+      return NULL;
+  }
+}
+
+void WorkStealingScheduler::WakeWorker() {
+  // Orders the queuing of the job before the read of |sleepers_|.
+  AtomicThreadFence(MEMORY_ORDER_SEQ_CST);
+  if (sleepers_.Load(MEMORY_ORDER_RELAXED) == 0)
+    return;
+  AutoLock auto_lock(park_lock_);
+  wake_epoch_.Store(wake_epoch_.Load(MEMORY_ORDER_RELAXED) + 1,
+                    MEMORY_ORDER_RELAXED);
+  park_cv_.Signal();
+}
+
+void WorkStealingScheduler::Execute(Job* job) {
+  job->task->Run();
+  delete job->task;
+  TaskGroup* group = job->group;
+  delete job;
+
+  // The group may be destroyed as soon as |pending_| drops to zero, so it is
+  // not touched after that.  See Join() for why the read is SEQ_CST.
+  if (group->pending_.FetchSub(1) == 1 &&
+      external_joiners_.Load(MEMORY_ORDER_SEQ_CST) > 0) {
+    AutoLock auto_lock(join_lock_);
+    join_cv_.Broadcast();
+  }
+}
+
+void WorkStealingScheduler::Run(Worker* worker) {
+  for (;;) {
+    Job* job = FindWork(worker);
+    if (!job)
+      job = WaitForWork(worker);
+    if (!job)
+      break;
+    Execute(job);
+  }
+}
+
+}  // namespace platform
@@ -0,0 +1,173 @@
+// Copyright (c) 2010 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+// WorkStealingScheduler runs Tasks on a fixed set of worker threads, for
+// fine-grained and recursive (fork/join) parallelism where a ThreadPool's
+// single queue would be the bottleneck.
+//
+// Each worker owns a WorkStealingDeque.  Tasks spawned on a worker go onto
+// its own deque, and the worker runs them last-in first-out, which keeps the
+// working set in its cache.  A worker that runs out of tasks steals the
+// oldest task of a randomly chosen other worker, then parks until more tasks
+// are spawned.  Tasks spawned from other threads go through a shared queue.
+//
+// A TaskGroup tracks a set of tasks, including tasks spawned into it by those
+// tasks, and can be joined:
+//
+//   class SumTask : public Task {
+//    public:
+//     virtual void Run() {
+//       if (end_ - begin_ <= kCutoff) {
+//         *sum_ = SerialSum(begin_, end_);
+//         return;
+//       }
+//       int64 left, right;
+//       TaskGroup group(scheduler_);
+//       group.Spawn(new SumTask(scheduler_, begin_, middle, &left));
+//       group.Spawn(new SumTask(scheduler_, middle, end_, &right));
+//       group.Join();
+//       *sum_ = left + right;
+//     }
+//     ...
+//   };
+//
+// Join() on a worker thread runs other tasks while it waits, so recursive
+// joins do not tie up workers.
+
+#ifndef SIMPLEPLATFORMLIB_SRC_WORK_STEALING_SCHEDULER_H_
+#define SIMPLEPLATFORMLIB_SRC_WORK_STEALING_SCHEDULER_H_
+#pragma once
+
+#include <deque>
+#include <vector>
+
+#include "simple-platform-lib/src/atomics.h"
+#include "simple-platform-lib/src/basictypes.h"
+#include "simple-platform-lib/src/condition_variable.h"
+#include "simple-platform-lib/src/executor.h"
+#include "simple-platform-lib/src/lock.h"
+#include "simple-platform-lib/src/task.h"
+#include "simple-platform-lib/src/thread.h"
+
+namespace platform {
+
+class WorkStealingScheduler;
+
+class TaskGroup {
+ public:
+  explicit TaskGroup(WorkStealingScheduler* scheduler);
+
+  // The group must have been joined, or never have had tasks.
+  ~TaskGroup();
+
+  // Schedules |task| as part of this group, and takes ownership of it.
+  void Spawn(Task* task);
+
+  // Returns once every task of the group has run, including tasks spawned
+  // while joining.  On a worker thread of the group's scheduler, runs other
+  // tasks meanwhile; on any other thread, blocks.
+  void Join();
+
+ private:
+  friend class WorkStealingScheduler;
+
+  WorkStealingScheduler* scheduler_;
+  // Tasks spawned and not yet finished.
+  Atomic<int32> pending_;
+
+  DISALLOW_COPY_AND_ASSIGN(TaskGroup);
+};
+
+class WorkStealingScheduler : public Executor {
+ public:
+  // |num_threads| of 0 means one worker per processor.
+  explicit WorkStealingScheduler(int num_threads);
+
+  // Runs the tasks posted with PostTask(), then stops the workers.  Every
+  // TaskGroup must have been joined.
+  ~WorkStealingScheduler();
+
+  // Starts the worker threads.  Returns false if any of them could not be
+  // created, in which case the scheduler runs on those that could (if any).
+  bool Start();
+
+  // Schedules |task| outside of any group, and takes ownership of it.
+  void PostTask(Task* task);
+
+  // Executor implementation: PostTask().
+  virtual void Execute(Task* task);
+
+  // Returns true unless called on a worker of this scheduler that has tasks
+  // queued, i.e. true when idle workers would find nothing to steal from the
+  // caller.  Tasks that can split their work use it to split only on demand
+  // (lazy binary splitting, see parallel.h).
+  bool CurrentQueueEmpty();
+
+  int num_threads() const { return num_threads_; }
+
+  // A started scheduler with one worker per processor, created on first use
+  // and never destroyed.
+  static WorkStealingScheduler* GetDefault();
+
+ private:
+  friend class TaskGroup;
+  class Worker;
+  struct Job;
+
+  static WorkStealingScheduler* CreateDefault();
+
+  void Spawn(Task* task, TaskGroup* group);
+  void Join(TaskGroup* group);
+
+  // Returns the worker of this scheduler running on the current thread, or
+  // NULL.
+  Worker* CurrentWorker();
+
+  // Returns a job from |worker|'s deque, the shared queue, or another
+  // worker's deque, or NULL.  |worker| may be NULL.
+  Job* FindWork(Worker* worker);
+  // Parks |worker| until it finds a job, or the scheduler is stopping (in
+  // which case it returns NULL).
+  Job* WaitForWork(Worker* worker);
+  // Wakes a parked worker, if any, after a job has been queued.
+  void WakeWorker();
+  void Execute(Job* job);
+
+  // The body of each worker thread.
+  void Run(Worker* worker);
+
+  int num_threads_;
+  std::vector<Worker*> workers_;
+  std::vector<ThreadHandle> handles_;
+
+  // Jobs spawned from threads other than workers.
+  Lock injected_lock_;
+  std::deque<Job*> injected_;
+  Atomic<int32> injected_count_;
+
+  // Parking.  A worker about to park bumps |sleepers_| and looks for work one
+  // last time; a spawner queues its job, then bumps |wake_epoch_| if
+  // |sleepers_| is non-zero.  Full barriers on both sides make sure one of
+  // them sees the other.
+  Lock park_lock_;
+  ConditionVariable park_cv_;
+  Atomic<int32> sleepers_;
+  Atomic<int32> wake_epoch_;  // Written under |park_lock_|.
+  bool stopping_;     // Protected by |park_lock_|.
+
+  // Threads other than workers blocked in TaskGroup::Join().  A finishing
+  // group only takes |join_lock_| if |external_joiners_| is non-zero.
+  Lock join_lock_;
+  ConditionVariable join_cv_;
+  Atomic<int32> external_joiners_;
+
+  // The group of tasks posted with PostTask().
+  TaskGroup root_group_;
+
+  DISALLOW_COPY_AND_ASSIGN(WorkStealingScheduler);
+};
+
+}  // namespace platform
+
+#endif  // SIMPLEPLATFORMLIB_SRC_WORK_STEALING_SCHEDULER_H_
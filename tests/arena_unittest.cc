@@ -0,0 +1,105 @@
+// Copyright (c) 2010 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "simple-platform-lib/src/arena.h"
+
+#include <stdint.h>
+#include <string.h>
+
+#include <gtest/gtest.h>
+
+using platform::Arena;
+
+typedef testing::Test ArenaTest;
+
+namespace {
+
+struct Point {
+  Point() : x(1), y(2) {}
+  int x;
+  int y;
+};
+
+bool IsAligned(void* memory) {
+  return reinterpret_cast<uintptr_t>(memory) % Arena::kAlignment == 0;
+}
+
+}  // namespace
+
+// Test that allocations are aligned and packed ------------------------------
+
+TEST_F(ArenaTest, Allocate) {
+  Arena arena(4096);
+  char* first = static_cast<char*>(arena.Allocate(1));
+  char* second = static_cast<char*>(arena.Allocate(17));
+  char* third = static_cast<char*>(arena.Allocate(16));
+  EXPECT_TRUE(IsAligned(first));
+  EXPECT_EQ(first + 16, second);
+  EXPECT_EQ(second + 32, third);
+  EXPECT_EQ(64U, arena.bytes_allocated());
+
+  Point* point = arena.New<Point>();
+  EXPECT_TRUE(IsAligned(point));
+  EXPECT_EQ(1, point->x);
+  EXPECT_EQ(2, point->y);
+}
+
+// Test that empty allocations get addresses of their own --------------------
+
+TEST_F(ArenaTest, AllocateZero) {
+  Arena arena(4096);
+  char* first = static_cast<char*>(arena.Allocate(0));
+  ASSERT_TRUE(first != NULL);
+  EXPECT_TRUE(IsAligned(first));
+  char* second = static_cast<char*>(arena.Allocate(0));
+  EXPECT_EQ(first + Arena::kAlignment, second);
+  char* third = static_cast<char*>(arena.Allocate(1));
+  EXPECT_EQ(second + Arena::kAlignment, third);
+
+  arena.Reset();
+  EXPECT_TRUE(arena.Allocate(0) != NULL);
+
+  EXPECT_DEATH(arena.Allocate(static_cast<size_t>(-1)), "");
+}
+
+// Test allocations that span blocks, or need one of their own ---------------
+
+TEST_F(ArenaTest, Blocks) {
+  Arena arena(4096);
+  char* small = static_cast<char*>(arena.Allocate(100));
+  memset(small, 1, 100);
+
+  // A large allocation does not use up the current block.
+  char* large = static_cast<char*>(arena.Allocate(100 * 1000));
+  EXPECT_TRUE(IsAligned(large));
+  memset(large, 2, 100 * 1000);
+  char* next = static_cast<char*>(arena.Allocate(100));
+  EXPECT_EQ(small + 112, next);
+
+  // Filling the block moves on to another.
+  for (int i = 0; i < 100; i++) {
+    char* memory = static_cast<char*>(arena.Allocate(1000));
+    EXPECT_TRUE(IsAligned(memory));
+    memset(memory, 3, 1000);
+  }
+  EXPECT_EQ(1, small[99]);
+  EXPECT_EQ(2, large[100 * 1000 - 1]);
+}
+
+// Test that Reset() frees everything and keeps a block ----------------------
+
+TEST_F(ArenaTest, Reset) {
+  Arena arena(4096);
+  arena.Reset();  // Nothing to free.
+  for (int i = 0; i < 50; i++)
+    arena.Allocate(1000);
+  arena.Allocate(100 * 1000);
+  EXPECT_GT(arena.bytes_allocated(), 150U * 1000);
+
+  arena.Reset();
+  EXPECT_EQ(0U, arena.bytes_allocated());
+  void* first = arena.Allocate(16);
+  void* second = arena.Allocate(16);
+  EXPECT_EQ(static_cast<char*>(first) + 16, second);
+}
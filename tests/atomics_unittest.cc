@@ -0,0 +1,149 @@
+// Copyright (c) 2010 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "simple-platform-lib/src/atomics.h"
+
+#include <gtest/gtest.h>
+
+#include "simple-platform-lib/src/thread.h"
+
+typedef testing::Test AtomicsTest;
+
+// Test the single-threaded behavior -------------------------------------------
+
+TEST_F(AtomicsTest, LoadStoreExchange) {
+  platform::Atomic<int32> value;
+  EXPECT_EQ(0, value.Load());
+  value.Store(5);
+  EXPECT_EQ(5, value.Load(platform::MEMORY_ORDER_RELAXED));
+  EXPECT_EQ(5, value.Exchange(7, platform::MEMORY_ORDER_ACQ_REL));
+  EXPECT_EQ(7, value.Load(platform::MEMORY_ORDER_ACQUIRE));
+
+  int pointee;
+  platform::Atomic<int*> pointer(&pointee);
+  EXPECT_EQ(&pointee, pointer.Load());
+  pointer.Store(NULL, platform::MEMORY_ORDER_RELEASE);
+  EXPECT_EQ(NULL, pointer.Load());
+}
+
+TEST_F(AtomicsTest, CompareExchange) {
+  platform::Atomic<int64> value(10);
+  int64 expected = 11;
+  EXPECT_FALSE(value.CompareExchange(&expected, 20));
+  EXPECT_EQ(10, expected);
+  EXPECT_EQ(10, value.Load());
+  EXPECT_TRUE(value.CompareExchange(&expected, 20,
+                                    platform::MEMORY_ORDER_RELEASE));
+  EXPECT_EQ(20, value.Load());
+
+  // The weak form may fail spuriously, but not forever.
+  expected = 20;
+  while (!value.CompareExchangeWeak(&expected, 30,
+                                    platform::MEMORY_ORDER_ACQ_REL)) {
+    EXPECT_EQ(20, expected);
+  }
+  EXPECT_EQ(30, value.Load());
+}
+
+TEST_F(AtomicsTest, Fetch) {
+  platform::Atomic<uint32> value(0x0f);
+  EXPECT_EQ(0x0fu, value.FetchAdd(1));
+  EXPECT_EQ(0x10u, value.FetchSub(2));
+  EXPECT_EQ(0x0eu, value.FetchOr(0xf0));
+  EXPECT_EQ(0xfeu, value.FetchAnd(0x3c));
+  EXPECT_EQ(0x3cu, value.Load());
+}
+
+TEST_F(AtomicsTest, Flag) {
+  platform::AtomicFlag flag;
+  EXPECT_FALSE(flag.IsSet());
+  EXPECT_FALSE(flag.TestAndSet());
+  EXPECT_TRUE(flag.IsSet());
+  EXPECT_TRUE(flag.TestAndSet());
+  flag.Clear();
+  EXPECT_FALSE(flag.IsSet());
+  flag.Set();
+  EXPECT_TRUE(flag.IsSet());
+}
+
+TEST_F(AtomicsTest, CacheAligned) {
+  platform::CacheAligned<int32> values[3];
+  EXPECT_EQ(0, values[0].value);
+  EXPECT_EQ(0u, reinterpret_cast<uintptr_t>(&values[0]) %
+                platform::kCacheLineSize);
+  EXPECT_EQ(0u, sizeof(values[0]) % platform::kCacheLineSize);
+  EXPECT_EQ(platform::kCacheLineSize,
+            static_cast<size_t>(reinterpret_cast<char*>(&values[1]) -
+                                reinterpret_cast<char*>(&values[0])));
+}
+
+// Test that read-modify-writes from several threads do not lose updates -------
+
+namespace {
+
+const int kIncrementsPerThread = 100000;
+
+class IncrementThread : public platform::Thread::Delegate {
+ public:
+  explicit IncrementThread(platform::Atomic<int32>* counter)
+      : counter_(counter) {}
+
+  virtual void ThreadMain() {
+    for (int i = 0; i < kIncrementsPerThread; i++)
+      counter_->FetchAdd(1, platform::MEMORY_ORDER_RELAXED);
+  }
+
+ private:
+  platform::Atomic<int32>* counter_;
+
+  DISALLOW_COPY_AND_ASSIGN(IncrementThread);
+};
+
+// Publishes |value_| through |ready_|.
+class PublishThread : public platform::Thread::Delegate {
+ public:
+  PublishThread() : value_(0) {}
+
+  virtual void ThreadMain() {
+    value_ = 42;
+    ready_.Set();
+  }
+
+  bool ready() const { return ready_.IsSet(); }
+  int value() const { return value_; }
+
+ private:
+  int value_;
+  platform::AtomicFlag ready_;
+
+  DISALLOW_COPY_AND_ASSIGN(PublishThread);
+};
+
+}  // namespace
+
+TEST_F(AtomicsTest, ConcurrentFetchAdd) {
+  const int kThreads = 4;
+  platform::Atomic<int32> counter;
+  IncrementThread* threads[kThreads];
+  platform::ThreadHandle handles[kThreads];
+  for (int i = 0; i < kThreads; i++) {
+    threads[i] = new IncrementThread(&counter);
+    ASSERT_TRUE(platform::Thread::Create(0, threads[i], &handles[i]));
+  }
+  for (int i = 0; i < kThreads; i++) {
+    platform::Thread::Join(handles[i]);
+    delete threads[i];
+  }
+  EXPECT_EQ(kThreads * kIncrementsPerThread, counter.Load());
+}
+
+TEST_F(AtomicsTest, FlagPublishes) {
+  PublishThread thread;
+  platform::ThreadHandle handle = platform::kNullThreadHandle;
+  ASSERT_TRUE(platform::Thread::Create(0, &thread, &handle));
+  while (!thread.ready())
+    platform::Thread::Yield();
+  EXPECT_EQ(42, thread.value());
+  platform::Thread::Join(handle);
+}
@@ -0,0 +1,91 @@
+// Copyright (c) 2010 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+// Measures the wake-up latency of a thread blocked on a ConditionVariable,
+// compared to a thread polling shared state with Thread::Sleep().
+
+#include "simple-platform-lib/src/condition_variable.h"
+
+#include <gtest/gtest.h>
+
+#include "simple-platform-lib/src/lock.h"
+#include "simple-platform-lib/src/thread.h"
+#include "simple-platform-lib/tests/perftimer.h"
+
+namespace {
+
+// Two threads passing a token back and forth.  Each hand-off wakes the other
+// thread, so the round trip time is twice the wake-up latency.
+class PingPong : public platform::Thread::Delegate {
+ public:
+  PingPong(bool use_condition_variable, int round_trips)
+      : use_condition_variable_(use_condition_variable),
+        round_trips_(round_trips),
+        cv_(&lock_),
+        turn_(0) {}
+
+  virtual void ThreadMain() {
+    for (int i = 0; i < round_trips_; i++) {
+      WaitForTurn(1);
+      PassTurn(0);
+    }
+  }
+
+  // Runs the ping side on the calling thread.  Returns the mean one-way
+  // wake-up latency in microseconds.
+  double Run() {
+    platform::ThreadHandle handle = platform::kNullThreadHandle;
+    EXPECT_TRUE(platform::Thread::Create(0, this, &handle));
+
+    platform::PerfTimer timer;
+    for (int i = 0; i < round_trips_; i++) {
+      PassTurn(1);
+      WaitForTurn(0);
+    }
+    double elapsed_us = timer.ElapsedNs() / 1e3;
+
+    platform::Thread::Join(handle);
+    return elapsed_us / (2 * round_trips_);
+  }
+
+ private:
+  void WaitForTurn(int turn) {
+    platform::AutoLock auto_lock(lock_);
+    while (turn_ != turn) {
+      if (use_condition_variable_) {
+        cv_.Wait();
+      } else {
+        platform::AutoUnlock auto_unlock(lock_);
+        platform::Thread::Sleep(1);
+      }
+    }
+  }
+
+  void PassTurn(int turn) {
+    platform::AutoLock auto_lock(lock_);
+    turn_ = turn;
+    if (use_condition_variable_)
+      cv_.Signal();
+  }
+
+  bool use_condition_variable_;
+  int round_trips_;
+  platform::Lock lock_;
+  platform::ConditionVariable cv_;
+  int turn_;
+
+  DISALLOW_COPY_AND_ASSIGN(PingPong);
+};
+
+}  // namespace
+
+TEST(ConditionVariablePerfTest, WakeUpLatency) {
+  PingPong condition_variable(true, 20000);
+  platform::PrintPerfResult("wakeup_latency", "", "condition_variable",
+                            condition_variable.Run(), "us");
+
+  PingPong poll(false, 200);
+  platform::PrintPerfResult("wakeup_latency", "", "sleep_poll", poll.Run(),
+                            "us");
+}
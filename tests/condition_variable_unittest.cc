@@ -0,0 +1,221 @@
+// Copyright (c) 2010 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "simple-platform-lib/src/condition_variable.h"
+
+#include <gtest/gtest.h>
+
+#include "simple-platform-lib/src/lock.h"
+#include "simple-platform-lib/src/thread.h"
+#include "simple-platform-lib/src/time.h"
+
+typedef testing::Test ConditionVariableTest;
+
+namespace {
+
+int64 NowMs() {
+  return platform::TimeTicks::Now().ToInternalValue() / (1000 * 1000);
+}
+
+}  // namespace
+
+// Test that TimedWait() gives up -----------------------------------------------
+
+TEST_F(ConditionVariableTest, TimedWaitTimesOut) {
+  platform::Lock lock;
+  platform::ConditionVariable cv(&lock);
+
+  platform::AutoLock auto_lock(lock);
+  int64 start = NowMs();
+  bool signaled = true;
+  // Spurious wakeups are allowed, so keep waiting until we time out.
+  while (signaled && NowMs() - start < 1000)
+    signaled = cv.TimedWait(50);
+  int64 elapsed = NowMs() - start;
+
+  EXPECT_FALSE(signaled);
+  EXPECT_GE(elapsed, 50);
+  lock.AssertAcquired();
+}
+
+TEST_F(ConditionVariableTest, TimedWaitTimeDelta) {
+  platform::Lock lock;
+  platform::ConditionVariable cv(&lock);
+
+  platform::AutoLock auto_lock(lock);
+  platform::TimeTicks start = platform::TimeTicks::Now();
+  platform::TimeTicks give_up = start + platform::TimeDelta::FromSeconds(1);
+  bool signaled = true;
+  while (signaled && platform::TimeTicks::Now() < give_up)
+    signaled = cv.TimedWait(platform::TimeDelta::FromMicroseconds(2500));
+  platform::TimeDelta elapsed = platform::TimeTicks::Now() - start;
+
+  EXPECT_FALSE(signaled);
+  EXPECT_GE(elapsed, platform::TimeDelta::FromMicroseconds(2500));
+  // A negative time does not wait.
+  EXPECT_FALSE(cv.TimedWait(platform::TimeDelta::FromMilliseconds(-1)));
+  lock.AssertAcquired();
+}
+
+// Test a single producer and a single consumer handing off items ---------------
+
+class ProducerThread : public platform::Thread::Delegate {
+ public:
+  ProducerThread(platform::Lock* lock, platform::ConditionVariable* cv,
+                 int* available, int count)
+      : lock_(lock), cv_(cv), available_(available), count_(count) {}
+
+  virtual void ThreadMain() {
+    for (int i = 0; i < count_; i++) {
+      platform::AutoLock auto_lock(*lock_);
+      (*available_)++;
+      cv_->Signal();
+    }
+  }
+
+ private:
+  platform::Lock* lock_;
+  platform::ConditionVariable* cv_;
+  int* available_;
+  int count_;
+
+  DISALLOW_COPY_AND_ASSIGN(ProducerThread);
+};
+
+class ConsumerThread : public platform::Thread::Delegate {
+ public:
+  ConsumerThread(platform::Lock* lock, platform::ConditionVariable* cv,
+                 int* available, int count)
+      : lock_(lock), cv_(cv), available_(available), count_(count),
+        consumed_(0) {}
+
+  virtual void ThreadMain() {
+    for (int i = 0; i < count_; i++) {
+      platform::AutoLock auto_lock(*lock_);
+      while (*available_ == 0)
+        cv_->Wait();
+      lock_->AssertAcquired();
+      (*available_)--;
+      consumed_++;
+    }
+  }
+
+  int consumed() const { return consumed_; }
+
+ private:
+  platform::Lock* lock_;
+  platform::ConditionVariable* cv_;
+  int* available_;
+  int count_;
+  int consumed_;
+
+  DISALLOW_COPY_AND_ASSIGN(ConsumerThread);
+};
+
+TEST_F(ConditionVariableTest, ProducerConsumer) {
+  const int kCount = 10000;
+  platform::Lock lock;
+  platform::ConditionVariable cv(&lock);
+  int available = 0;
+
+  ConsumerThread consumer(&lock, &cv, &available, kCount);
+  ProducerThread producer(&lock, &cv, &available, kCount);
+  platform::ThreadHandle consumer_handle = platform::kNullThreadHandle;
+  platform::ThreadHandle producer_handle = platform::kNullThreadHandle;
+
+  ASSERT_TRUE(platform::Thread::Create(0, &consumer, &consumer_handle));
+  ASSERT_TRUE(platform::Thread::Create(0, &producer, &producer_handle));
+  platform::Thread::Join(producer_handle);
+  platform::Thread::Join(consumer_handle);
+
+  EXPECT_EQ(kCount, consumer.consumed());
+  EXPECT_EQ(0, available);
+}
+
+TEST_F(ConditionVariableTest, ManyProducersManyConsumers) {
+  const int kCount = 5000;
+  platform::Lock lock;
+  platform::ConditionVariable cv(&lock);
+  int available = 0;
+
+  ConsumerThread consumer1(&lock, &cv, &available, kCount);
+  ConsumerThread consumer2(&lock, &cv, &available, kCount);
+  ProducerThread producer1(&lock, &cv, &available, kCount);
+  ProducerThread producer2(&lock, &cv, &available, kCount);
+  platform::ThreadHandle handles[4];
+
+  ASSERT_TRUE(platform::Thread::Create(0, &consumer1, &handles[0]));
+  ASSERT_TRUE(platform::Thread::Create(0, &consumer2, &handles[1]));
+  ASSERT_TRUE(platform::Thread::Create(0, &producer1, &handles[2]));
+  ASSERT_TRUE(platform::Thread::Create(0, &producer2, &handles[3]));
+  for (size_t n = 0; n < arraysize(handles); n++)
+    platform::Thread::Join(handles[n]);
+
+  EXPECT_EQ(kCount, consumer1.consumed());
+  EXPECT_EQ(kCount, consumer2.consumed());
+  EXPECT_EQ(0, available);
+}
+
+// Test that Broadcast() wakes every waiter -------------------------------------
+
+class BroadcastWaiterThread : public platform::Thread::Delegate {
+ public:
+  BroadcastWaiterThread(platform::Lock* lock, platform::ConditionVariable* cv,
+                        int* waiting, bool* go)
+      : lock_(lock), cv_(cv), waiting_(waiting), go_(go), woke_(false) {}
+
+  virtual void ThreadMain() {
+    platform::AutoLock auto_lock(*lock_);
+    (*waiting_)++;
+    cv_->Broadcast();  // Tell the main thread we are waiting.
+    while (!*go_)
+      cv_->Wait();
+    woke_ = true;
+  }
+
+  bool woke() const { return woke_; }
+
+ private:
+  platform::Lock* lock_;
+  platform::ConditionVariable* cv_;
+  int* waiting_;
+  bool* go_;
+  bool woke_;
+
+  DISALLOW_COPY_AND_ASSIGN(BroadcastWaiterThread);
+};
+
+TEST_F(ConditionVariableTest, Broadcast) {
+  platform::Lock lock;
+  platform::ConditionVariable cv(&lock);
+  int waiting = 0;
+  bool go = false;
+
+  BroadcastWaiterThread thread1(&lock, &cv, &waiting, &go);
+  BroadcastWaiterThread thread2(&lock, &cv, &waiting, &go);
+  BroadcastWaiterThread thread3(&lock, &cv, &waiting, &go);
+  BroadcastWaiterThread thread4(&lock, &cv, &waiting, &go);
+  platform::ThreadHandle handles[4];
+
+  ASSERT_TRUE(platform::Thread::Create(0, &thread1, &handles[0]));
+  ASSERT_TRUE(platform::Thread::Create(0, &thread2, &handles[1]));
+  ASSERT_TRUE(platform::Thread::Create(0, &thread3, &handles[2]));
+  ASSERT_TRUE(platform::Thread::Create(0, &thread4, &handles[3]));
+
+  {
+    platform::AutoLock auto_lock(lock);
+    while (waiting < 4)
+      cv.Wait();
+    go = true;
+    cv.Broadcast();
+  }
+
+  for (size_t n = 0; n < arraysize(handles); n++)
+    platform::Thread::Join(handles[n]);
+
+  EXPECT_TRUE(thread1.woke());
+  EXPECT_TRUE(thread2.woke());
+  EXPECT_TRUE(thread3.woke());
+  EXPECT_TRUE(thread4.woke());
+}
@@ -0,0 +1,150 @@
+// Copyright (c) 2010 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+// Measures switching between coroutines against handing off between
+// threads: awaiting a coroutine that returns right away (a call and a
+// return, plus a pooled frame), resuming and suspending a coroutine, a hop
+// onto a ThreadPool with ScheduleOn(), and a handoff between two threads
+// that wait on condition variables.
+
+#include "simple-platform-lib/src/coroutine.h"
+
+#if defined(__cpp_impl_coroutine)
+
+#include <gtest/gtest.h>
+
+#include "simple-platform-lib/src/condition_variable.h"
+#include "simple-platform-lib/src/lock.h"
+#include "simple-platform-lib/src/thread.h"
+#include "simple-platform-lib/src/thread_pool.h"
+#include "simple-platform-lib/tests/perftimer.h"
+
+using platform::CoroutineTask;
+
+namespace {
+
+const int kIterations = 1000 * 1000;
+const int kHops = 100 * 1000;
+const int kHandoffs = 100 * 1000;
+
+CoroutineTask<int> Constant(int value) {
+  co_return value;
+}
+
+CoroutineTask<int64> AwaitMany(int count) {
+  int64 sum = 0;
+  for (int i = 0; i < count; i++)
+    sum += co_await Constant(i);
+  co_return sum;
+}
+
+// Suspends, leaving its handle for the driver to resume it with.
+struct Yield {
+  bool await_ready() const { return false; }
+  void await_suspend(std::coroutine_handle<> handle) const {
+    *resume_handle = handle;
+  }
+  void await_resume() const {}
+
+  std::coroutine_handle<>* resume_handle;
+};
+
+CoroutineTask<void> YieldForever(std::coroutine_handle<>* resume_handle) {
+  for (;;)
+    co_await Yield{resume_handle};
+}
+
+CoroutineTask<void> Hop(platform::Executor* executor, int count) {
+  for (int i = 0; i < count; i++)
+    co_await platform::ScheduleOn(executor);
+}
+
+// Waits for |turn_| to be its own number, then hands it over.
+class HandoffThread : public platform::Thread::Delegate {
+ public:
+  HandoffThread(platform::Lock* lock, platform::ConditionVariable* cv,
+                int* turn, int me)
+      : lock_(lock), cv_(cv), turn_(turn), me_(me) {}
+
+  virtual void ThreadMain() {
+    platform::AutoLock auto_lock(*lock_);
+    for (int i = 0; i < kHandoffs; i++) {
+      while (*turn_ != me_)
+        cv_->Wait();
+      *turn_ = 1 - me_;
+      cv_->Signal();
+    }
+  }
+
+ private:
+  platform::Lock* lock_;
+  platform::ConditionVariable* cv_;
+  int* turn_;
+  int me_;
+
+  DISALLOW_COPY_AND_ASSIGN(HandoffThread);
+};
+
+}  // namespace
+
+TEST(CoroutinePerfTest, Await) {
+  // In chunks, as GCC only keeps the stack flat when optimizing.
+  const int kChunk = 1000;
+  int64 sum = 0;
+  platform::PerfTimer timer;
+  for (int i = 0; i < kIterations / kChunk; i++)
+    sum += platform::SyncWait(AwaitMany(kChunk));
+  double ns = static_cast<double>(timer.ElapsedNs()) / kIterations;
+  EXPECT_EQ(static_cast<int64>(kChunk) * (kChunk - 1) / 2 *
+                (kIterations / kChunk),
+            sum);
+  platform::PrintPerfResult("coroutine_switch", "", "await_child", ns, "ns");
+}
+
+TEST(CoroutinePerfTest, ResumeSuspend) {
+  std::coroutine_handle<> resume_handle;
+  CoroutineTask<void> task = YieldForever(&resume_handle);
+  // Start the task without waiting for it; it never finishes, and is
+  // destroyed along with |task|.
+  std::coroutine_handle<> starter =
+      task.await_suspend(std::noop_coroutine());
+  starter.resume();
+  platform::PerfTimer timer;
+  for (int i = 0; i < kIterations; i++)
+    resume_handle.resume();
+  double ns = static_cast<double>(timer.ElapsedNs()) / kIterations;
+  platform::PrintPerfResult("coroutine_switch", "", "resume_suspend", ns,
+                            "ns");
+}
+
+TEST(CoroutinePerfTest, ExecutorHop) {
+  platform::ThreadPool pool(1);
+  ASSERT_TRUE(pool.Start());
+  platform::PerfTimer timer;
+  platform::SyncWait(Hop(&pool, kHops));
+  double ns = static_cast<double>(timer.ElapsedNs()) / kHops;
+  pool.Shutdown(platform::ThreadPool::RUN_PENDING_TASKS);
+  platform::PrintPerfResult("coroutine_switch", "", "thread_pool_hop", ns,
+                            "ns");
+}
+
+TEST(CoroutinePerfTest, ThreadHandoff) {
+  platform::Lock lock;
+  platform::ConditionVariable cv(&lock);
+  int turn = 0;
+  HandoffThread ping(&lock, &cv, &turn, 0);
+  HandoffThread pong(&lock, &cv, &turn, 1);
+  platform::PerfTimer timer;
+  platform::ThreadHandle ping_handle, pong_handle;
+  ASSERT_TRUE(platform::Thread::Create(0, &ping, &ping_handle));
+  ASSERT_TRUE(platform::Thread::Create(0, &pong, &pong_handle));
+  platform::Thread::Join(ping_handle);
+  platform::Thread::Join(pong_handle);
+  // Each thread hands off |kHandoffs| times.
+  double ns = static_cast<double>(timer.ElapsedNs()) / (2 * kHandoffs);
+  platform::PrintPerfResult("coroutine_switch", "", "thread_handoff", ns,
+                            "ns");
+}
+
+#endif  // defined(__cpp_impl_coroutine)
@@ -0,0 +1,200 @@
+// Copyright (c) 2010 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "simple-platform-lib/src/coroutine.h"
+
+#if defined(__cpp_impl_coroutine)
+
+#include <gtest/gtest.h>
+
+#include <string>
+#include <utility>
+
+#include "simple-platform-lib/src/atomics.h"
+#include "simple-platform-lib/src/thread.h"
+#include "simple-platform-lib/src/thread_pool.h"
+#include "simple-platform-lib/src/time.h"
+#include "simple-platform-lib/src/timer_thread.h"
+
+using platform::CoroutineTask;
+using platform::TimeDelta;
+using platform::TimeTicks;
+
+typedef testing::Test CoroutineTest;
+
+namespace {
+
+CoroutineTask<int> Constant(int value) {
+  co_return value;
+}
+
+CoroutineTask<int> Sum(int count) {
+  int sum = 0;
+  for (int i = 0; i < count; i++)
+    sum += co_await Constant(i);
+  co_return sum;
+}
+
+CoroutineTask<std::string> Repeat(std::string part, int count) {
+  std::string result;
+  for (int i = 0; i < count; i++)
+    result += part;
+  co_return result;
+}
+
+CoroutineTask<void> Store(int value, int* out) {
+  *out = co_await Constant(value);
+}
+
+CoroutineTask<platform::ThreadId> IdAfterHop(platform::Executor* executor) {
+  co_await platform::ScheduleOn(executor);
+  co_return platform::Thread::CurrentId();
+}
+
+// Increments |*counter| |count| times under |lock|, hopping to |pool|
+// inside the critical section so that other coroutines contend for it.
+CoroutineTask<void> IncrementUnderLock(platform::AsyncLock* lock,
+                                       platform::ThreadPool* pool,
+                                       int* counter, int count) {
+  for (int i = 0; i < count; i++) {
+    co_await lock->Acquire();
+    int value = *counter;
+    co_await platform::ScheduleOn(pool);
+    *counter = value + 1;
+    lock->Release();
+  }
+}
+
+CoroutineTask<void> SpawnedIncrement(platform::AsyncLock* lock,
+                                     platform::ThreadPool* pool,
+                                     int* counter, int count,
+                                     platform::Atomic<int32>* finished) {
+  co_await IncrementUnderLock(lock, pool, counter, count);
+  finished->FetchAdd(1);
+}
+
+CoroutineTask<TimeDelta> TimedSleep(platform::TimerThread* timer_thread,
+                                    TimeDelta duration,
+                                    platform::Executor* executor) {
+  TimeTicks start = TimeTicks::Now();
+  co_await platform::AsyncSleep(timer_thread, duration, executor);
+  co_return TimeTicks::Now() - start;
+}
+
+}  // namespace
+
+// Test results and awaiting coroutines ----------------------------------------
+
+TEST_F(CoroutineTest, Results) {
+  EXPECT_EQ(42, platform::SyncWait(Constant(42)));
+  EXPECT_EQ("abab", platform::SyncWait(Repeat("ab", 2)));
+  int out = 0;
+  platform::SyncWait(Store(7, &out));
+  EXPECT_EQ(7, out);
+}
+
+TEST_F(CoroutineTest, LazyStart) {
+  int out = 0;
+  CoroutineTask<void> task = Store(1, &out);
+  EXPECT_EQ(0, out);
+  CoroutineTask<void> moved = std::move(task);
+  platform::SyncWait(std::move(moved));
+  EXPECT_EQ(1, out);
+
+  // Never awaited: destroyed without running.
+  Store(2, &out);
+  EXPECT_EQ(1, out);
+}
+
+TEST_F(CoroutineTest, AwaitEmptyTaskAborts) {
+  EXPECT_DEATH(platform::SyncWait(CoroutineTask<int>()), "");
+}
+
+// Awaiting a million coroutines that complete synchronously, one after the
+// other, would overflow the stack if the transfers were not tail calls,
+// which GCC only makes them when optimizing.
+TEST_F(CoroutineTest, SymmetricTransfer) {
+#if defined(NDEBUG)
+  const int kCount = 1000 * 1000;
+#else
+  const int kCount = 1000;
+#endif
+  EXPECT_EQ(static_cast<int>(static_cast<int64>(kCount) * (kCount - 1) / 2),
+            platform::SyncWait(Sum(kCount)));
+}
+
+TEST_F(CoroutineTest, FrameAllocatorReusesFrames) {
+  typedef platform::internal::CoroutineFrameAllocator Allocator;
+  void* frame = Allocator::Allocate(100);
+  Allocator::Free(frame, 100);
+  // Same size class.
+  void* again = Allocator::Allocate(120);
+  EXPECT_EQ(frame, again);
+  Allocator::Free(again, 120);
+
+  // Too big to cache.
+  void* big = Allocator::Allocate(64 * 1024);
+  Allocator::Free(big, 64 * 1024);
+}
+
+// Test executors, locks and timers --------------------------------------------
+
+TEST_F(CoroutineTest, ScheduleOn) {
+  platform::ThreadPool pool(1);
+  ASSERT_TRUE(pool.Start());
+  EXPECT_NE(platform::Thread::CurrentId(),
+            platform::SyncWait(IdAfterHop(&pool)));
+  pool.Shutdown(platform::ThreadPool::RUN_PENDING_TASKS);
+}
+
+TEST_F(CoroutineTest, AsyncLockTryAcquire) {
+  platform::AsyncLock lock;
+  EXPECT_TRUE(lock.TryAcquire());
+  EXPECT_FALSE(lock.TryAcquire());
+  lock.Release();
+  EXPECT_TRUE(lock.TryAcquire());
+  lock.Release();
+}
+
+TEST_F(CoroutineTest, AsyncLockExcludes) {
+  const int kCoroutines = 8;
+  const int kIncrements = 200;
+  platform::ThreadPool pool(4);
+  ASSERT_TRUE(pool.Start());
+  platform::AsyncLock lock;
+  int counter = 0;
+  platform::Atomic<int32> finished(0);
+  for (int i = 0; i < kCoroutines; i++) {
+    platform::Spawn(&pool, SpawnedIncrement(&lock, &pool, &counter,
+                                            kIncrements, &finished));
+  }
+  while (finished.Load() < kCoroutines)
+    platform::Thread::Sleep(1);
+  pool.Shutdown(platform::ThreadPool::RUN_PENDING_TASKS);
+  EXPECT_EQ(kCoroutines * kIncrements, counter);
+  EXPECT_TRUE(lock.TryAcquire());
+  lock.Release();
+}
+
+TEST_F(CoroutineTest, AsyncSleep) {
+  platform::TimerThread timer_thread(TimeDelta::FromMilliseconds(1));
+  ASSERT_TRUE(timer_thread.Start());
+  platform::ThreadPool pool(1);
+  ASSERT_TRUE(pool.Start());
+
+  TimeDelta slept = platform::SyncWait(
+      TimedSleep(&timer_thread, TimeDelta::FromMilliseconds(20), NULL));
+  EXPECT_TRUE(slept >= TimeDelta::FromMilliseconds(20));
+  slept = platform::SyncWait(
+      TimedSleep(&timer_thread, TimeDelta::FromMilliseconds(20), &pool));
+  EXPECT_TRUE(slept >= TimeDelta::FromMilliseconds(20));
+  // Already due: does not suspend.
+  slept = platform::SyncWait(TimedSleep(&timer_thread, TimeDelta(), NULL));
+  EXPECT_TRUE(slept < TimeDelta::FromSeconds(1));
+
+  pool.Shutdown(platform::ThreadPool::RUN_PENDING_TASKS);
+  timer_thread.Stop();
+}
+
+#endif  // defined(__cpp_impl_coroutine)
@@ -0,0 +1,179 @@
+// Copyright (c) 2010 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+// What epoch-based reclamation costs readers: a read of a shared pointer
+// bare, in an AutoEpoch, and under an AutoLock; and what it holds back:
+// the most objects retired and not yet freed while writers replace nodes
+// as fast as they can and readers keep entering critical sections.
+
+#include "simple-platform-lib/src/epoch_reclaimer.h"
+
+#include <gtest/gtest.h>
+
+#include <vector>
+
+#include "simple-platform-lib/src/atomics.h"
+#include "simple-platform-lib/src/lock.h"
+#include "simple-platform-lib/src/thread.h"
+#include "simple-platform-lib/tests/perftimer.h"
+
+namespace {
+
+const int kReads = 10 * 1000 * 1000;
+const int kReplacements = 1000 * 1000;
+const int kSlots = 64;
+
+struct Node {
+  int64 value;
+  char payload[56];
+};
+
+class Slots {
+ public:
+  Slots() {
+    for (int i = 0; i < kSlots; i++) {
+      Node* node = new Node;
+      node->value = 0;
+      slots_[i].Store(node);
+    }
+  }
+  ~Slots() {
+    for (int i = 0; i < kSlots; i++)
+      delete slots_[i].Load();
+  }
+
+  Node* Get(int slot) {
+    return slots_[slot].Load(platform::MEMORY_ORDER_ACQUIRE);
+  }
+  Node* Replace(int slot, Node* node) {
+    return slots_[slot].Exchange(node, platform::MEMORY_ORDER_ACQ_REL);
+  }
+
+ private:
+  platform::Atomic<Node*> slots_[kSlots];
+
+  DISALLOW_COPY_AND_ASSIGN(Slots);
+};
+
+class WriterThread : public platform::Thread::Delegate {
+ public:
+  WriterThread(platform::EpochReclaimer* reclaimer, Slots* slots)
+      : reclaimer_(reclaimer), slots_(slots), peak_pending_(0) {}
+
+  virtual void ThreadMain() {
+    for (int i = 0; i < kReplacements; i++) {
+      Node* node = new Node;
+      node->value = i;
+      reclaimer_->Retire(slots_->Replace(i % kSlots, node));
+      int64 pending = reclaimer_->pending();
+      if (pending > peak_pending_)
+        peak_pending_ = pending;
+    }
+  }
+
+  int64 peak_pending() const { return peak_pending_; }
+
+ private:
+  platform::EpochReclaimer* reclaimer_;
+  Slots* slots_;
+  int64 peak_pending_;
+
+  DISALLOW_COPY_AND_ASSIGN(WriterThread);
+};
+
+class ReaderThread : public platform::Thread::Delegate {
+ public:
+  ReaderThread(platform::EpochReclaimer* reclaimer, Slots* slots)
+      : reclaimer_(reclaimer), slots_(slots), stop_(0), sum_(0) {}
+
+  virtual void ThreadMain() {
+    for (int i = 0; !stop_.Load(platform::MEMORY_ORDER_RELAXED); i++) {
+      platform::AutoEpoch auto_epoch(reclaimer_);
+      sum_ += slots_->Get(i % kSlots)->value;
+    }
+  }
+
+  void Stop() { stop_.Store(1, platform::MEMORY_ORDER_RELAXED); }
+
+ private:
+  platform::EpochReclaimer* reclaimer_;
+  Slots* slots_;
+  platform::Atomic<int> stop_;
+  int64 sum_;
+
+  DISALLOW_COPY_AND_ASSIGN(ReaderThread);
+};
+
+void PrintReadResult(const char* trace, const platform::PerfTimer& timer) {
+  platform::PrintPerfResult("epoch_read", "", trace,
+                            static_cast<double>(timer.ElapsedNs()) / kReads,
+                            "ns");
+}
+
+void MeasureChurn(const char* trace, int readers) {
+  platform::EpochReclaimer reclaimer;
+  Slots slots;
+  std::vector<ReaderThread*> reader_threads;
+  std::vector<platform::ThreadHandle> reader_handles(readers);
+  for (int i = 0; i < readers; i++) {
+    reader_threads.push_back(new ReaderThread(&reclaimer, &slots));
+    ASSERT_TRUE(platform::Thread::Create(0, reader_threads[i],
+                                         &reader_handles[i]));
+  }
+
+  WriterThread writer(&reclaimer, &slots);
+  platform::ThreadHandle writer_handle;
+  platform::PerfTimer timer;
+  ASSERT_TRUE(platform::Thread::Create(0, &writer, &writer_handle));
+  platform::Thread::Join(writer_handle);
+  double ns = static_cast<double>(timer.ElapsedNs()) / kReplacements;
+
+  for (int i = 0; i < readers; i++) {
+    reader_threads[i]->Stop();
+    platform::Thread::Join(reader_handles[i]);
+    delete reader_threads[i];
+  }
+
+  platform::PrintPerfResult("epoch_retire", "", trace, ns, "ns");
+  platform::PrintPerfResult("epoch_limbo_peak", "", trace,
+                            static_cast<double>(writer.peak_pending()),
+                            "objects");
+  platform::PrintPerfResult("epoch_limbo_peak_bytes", "", trace,
+                            static_cast<double>(writer.peak_pending() *
+                                                sizeof(Node)),
+                            "bytes");
+}
+
+}  // namespace
+
+TEST(EpochReclaimerPerfTest, ReaderOverhead) {
+  Slots slots;
+  int64 sum = 0;
+  platform::PerfTimer timer;
+  for (int i = 0; i < kReads; i++)
+    sum += slots.Get(i % kSlots)->value;
+  PrintReadResult("bare", timer);
+
+  platform::EpochReclaimer reclaimer;
+  timer.Reset();
+  for (int i = 0; i < kReads; i++) {
+    platform::AutoEpoch auto_epoch(&reclaimer);
+    sum += slots.Get(i % kSlots)->value;
+  }
+  PrintReadResult("auto_epoch", timer);
+
+  platform::Lock lock;
+  timer.Reset();
+  for (int i = 0; i < kReads; i++) {
+    platform::AutoLock auto_lock(lock);
+    sum += slots.Get(i % kSlots)->value;
+  }
+  PrintReadResult("auto_lock", timer);
+  EXPECT_EQ(0, sum);
+}
+
+TEST(EpochReclaimerPerfTest, LimboUnderChurn) {
+  MeasureChurn("no_readers", 0);
+  MeasureChurn("2_readers", 2);
+}
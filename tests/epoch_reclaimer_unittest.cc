@@ -0,0 +1,230 @@
+// Copyright (c) 2010 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "simple-platform-lib/src/epoch_reclaimer.h"
+
+#include <gtest/gtest.h>
+
+#include <vector>
+
+#include "simple-platform-lib/src/atomics.h"
+#include "simple-platform-lib/src/thread.h"
+
+using platform::AutoEpoch;
+using platform::EpochReclaimer;
+
+typedef testing::Test EpochReclaimerTest;
+
+namespace {
+
+const int kMagic = 0x5eed;
+const int kSlots = 16;
+
+class Node {
+ public:
+  explicit Node(int value) : magic_(kMagic), value_(value), check_(~value) {
+    live_.FetchAdd(1);
+  }
+  ~Node() {
+    magic_ = 0;
+    live_.FetchSub(1);
+  }
+
+  bool IsValid() const { return magic_ == kMagic && check_ == ~value_; }
+
+  static int live() { return live_.Load(); }
+
+ private:
+  int magic_;
+  int value_;
+  int check_;
+  static platform::Atomic<int> live_;
+};
+
+platform::Atomic<int> Node::live_;
+
+int g_deleted = 0;
+
+void CountingDeleter(void* object) {
+  g_deleted++;
+  delete static_cast<Node*>(object);
+}
+
+// Retires a node and collects, checking that it stays.
+class RetiringThread : public platform::Thread::Delegate {
+ public:
+  explicit RetiringThread(EpochReclaimer* reclaimer)
+      : reclaimer_(reclaimer), freed_early_(false) {}
+
+  virtual void ThreadMain() {
+    reclaimer_->Retire(new Node(1), &CountingDeleter);
+    for (int i = 0; i < 10; i++)
+      reclaimer_->Collect();
+    freed_early_ = g_deleted != 0;
+  }
+
+  bool freed_early() const { return freed_early_; }
+
+ private:
+  EpochReclaimer* reclaimer_;
+  bool freed_early_;
+
+  DISALLOW_COPY_AND_ASSIGN(RetiringThread);
+};
+
+// A few nodes that writers replace and readers check.
+class Slots {
+ public:
+  Slots() {
+    for (int i = 0; i < kSlots; i++)
+      slots_[i].Store(new Node(i));
+  }
+  ~Slots() {
+    for (int i = 0; i < kSlots; i++)
+      delete slots_[i].Load();
+  }
+
+  Node* Get(int slot) {
+    return slots_[slot].Load(platform::MEMORY_ORDER_ACQUIRE);
+  }
+  Node* Replace(int slot, Node* node) {
+    return slots_[slot].Exchange(node, platform::MEMORY_ORDER_ACQ_REL);
+  }
+
+ private:
+  platform::Atomic<Node*> slots_[kSlots];
+
+  DISALLOW_COPY_AND_ASSIGN(Slots);
+};
+
+class StressThread : public platform::Thread::Delegate {
+ public:
+  StressThread(EpochReclaimer* reclaimer, Slots* slots, bool writer,
+               int seed)
+      : reclaimer_(reclaimer),
+        slots_(slots),
+        writer_(writer),
+        random_(seed),
+        corrupted_(0) {}
+
+  virtual void ThreadMain() {
+    for (int i = 0; i < 20000; i++) {
+      int slot = Next() % kSlots;
+      if (writer_) {
+        reclaimer_->Retire(slots_->Replace(slot, new Node(Next())));
+      } else {
+        AutoEpoch auto_epoch(reclaimer_);
+        for (int j = 0; j < 4; j++) {
+          if (!slots_->Get((slot + j) % kSlots)->IsValid())
+            corrupted_++;
+        }
+      }
+      if (i % 64 == 0)
+        platform::Thread::Yield();
+    }
+  }
+
+  int corrupted() const { return corrupted_; }
+
+ private:
+  int Next() {
+    random_ = random_ * 1103515245 + 12345;
+    return static_cast<int>((random_ >> 16) & 0x7fff);
+  }
+
+  EpochReclaimer* reclaimer_;
+  Slots* slots_;
+  bool writer_;
+  uint32 random_;
+  int corrupted_;
+
+  DISALLOW_COPY_AND_ASSIGN(StressThread);
+};
+
+}  // namespace
+
+// Test that retired objects are freed after two epochs ----------------------
+
+TEST_F(EpochReclaimerTest, RetireAndCollect) {
+  EpochReclaimer reclaimer;
+  g_deleted = 0;
+  reclaimer.Retire(new Node(1), &CountingDeleter);
+  reclaimer.Retire(new Node(2));
+  EXPECT_EQ(2, reclaimer.pending());
+  EXPECT_EQ(2, Node::live());
+
+  reclaimer.Collect();
+  EXPECT_EQ(2, reclaimer.pending());
+  reclaimer.Collect();
+  EXPECT_EQ(0, reclaimer.pending());
+  EXPECT_EQ(1, g_deleted);
+  EXPECT_EQ(0, Node::live());
+}
+
+// Test that retiring in batches frees as it goes ----------------------------
+
+TEST_F(EpochReclaimerTest, Batches) {
+  EpochReclaimer reclaimer;
+  for (int i = 0; i < 100 * EpochReclaimer::kRetireBatch; i++) {
+    AutoEpoch auto_epoch(&reclaimer);
+    reclaimer.Retire(new Node(i));
+  }
+  EXPECT_LE(reclaimer.pending(), 3 * EpochReclaimer::kRetireBatch);
+
+  // The destructor frees the rest.
+}
+
+// Test that a critical section holds retired objects back -------------------
+
+TEST_F(EpochReclaimerTest, CriticalSectionHoldsBack) {
+  EpochReclaimer reclaimer;
+  g_deleted = 0;
+  {
+    AutoEpoch outer(&reclaimer);
+    {
+      AutoEpoch inner(&reclaimer);
+    }
+    // Still in |outer|.  The other thread exits with its node retired, so
+    // leaves it behind.
+    RetiringThread retiring(&reclaimer);
+    platform::ThreadHandle handle;
+    ASSERT_TRUE(platform::Thread::Create(0, &retiring, &handle));
+    platform::Thread::Join(handle);
+    EXPECT_FALSE(retiring.freed_early());
+    EXPECT_EQ(1, reclaimer.pending());
+  }
+
+  for (int i = 0; i < 3; i++)
+    reclaimer.Collect();
+  EXPECT_EQ(1, g_deleted);
+  EXPECT_EQ(0, reclaimer.pending());
+}
+
+// Test readers against writers retiring what they read ----------------------
+
+TEST_F(EpochReclaimerTest, Stress) {
+  const int kThreadPairs = 2;
+  {
+    EpochReclaimer reclaimer;
+    Slots slots;
+    std::vector<StressThread*> threads;
+    std::vector<platform::ThreadHandle> handles(2 * kThreadPairs);
+    for (int i = 0; i < 2 * kThreadPairs; i++) {
+      threads.push_back(new StressThread(&reclaimer, &slots, i % 2 == 0, i));
+      ASSERT_TRUE(platform::Thread::Create(0, threads[i], &handles[i]));
+    }
+    for (int i = 0; i < 2 * kThreadPairs; i++) {
+      platform::Thread::Join(handles[i]);
+      EXPECT_EQ(0, threads[i]->corrupted());
+      delete threads[i];
+    }
+
+    // The writers left what they retired behind them.
+    for (int i = 0; i < 3; i++)
+      reclaimer.Collect();
+    EXPECT_EQ(0, reclaimer.pending());
+    EXPECT_EQ(kSlots, Node::live());
+  }
+  EXPECT_EQ(0, Node::live());
+}
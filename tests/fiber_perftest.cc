@@ -0,0 +1,184 @@
+// Copyright (c) 2010 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+// Measures what fibers cost against threads: a raw context switch, a yield
+// through the scheduler, and the resident memory taken by each of many
+// blocked fibers and by each of many blocked threads.
+
+#include "simple-platform-lib/src/fiber.h"
+
+#include <stdio.h>
+#include <unistd.h>
+
+#include <gtest/gtest.h>
+
+#include <vector>
+
+#include "simple-platform-lib/src/condition_variable.h"
+#include "simple-platform-lib/src/fiber_context.h"
+#include "simple-platform-lib/src/lock.h"
+#include "simple-platform-lib/src/stack_pool.h"
+#include "simple-platform-lib/src/thread.h"
+#include "simple-platform-lib/tests/perftimer.h"
+
+using platform::FiberScheduler;
+
+namespace {
+
+const int kSwitches = 1000 * 1000;
+const int kYields = 1000 * 1000;
+const int kBlockedFibers = 10000;
+const int kBlockedThreads = 1000;
+
+// Returns the process's resident set size in bytes, or 0 if unknown.
+int64 ResidentBytes() {
+  FILE* statm = fopen("/proc/self/statm", "r");
+  if (!statm)
+    return 0;
+  long total_pages = 0, resident_pages = 0;
+  int fields = fscanf(statm, "%ld %ld", &total_pages, &resident_pages);
+  fclose(statm);
+  if (fields != 2)
+    return 0;
+  return static_cast<int64>(resident_pages) * sysconf(_SC_PAGESIZE);
+}
+
+struct PingPong {
+  void* main_context;
+  void* fiber_context;
+};
+
+void PingPongMain(void* arg) {
+  PingPong* ping_pong = static_cast<PingPong*>(arg);
+  for (;;) {
+    platform::SwitchFiberContext(&ping_pong->fiber_context,
+                                 ping_pong->main_context);
+  }
+}
+
+class YieldingTask : public platform::Task {
+ public:
+  explicit YieldingTask(int count) : count_(count) {}
+
+  virtual void Run() {
+    for (int i = 0; i < count_; i++)
+      platform::Fiber::Yield();
+  }
+
+ private:
+  int count_;
+};
+
+// Blocks on |lock|, which the test holds.
+class BlockedFiberTask : public platform::Task {
+ public:
+  explicit BlockedFiberTask(platform::FiberLock* lock) : lock_(lock) {}
+
+  virtual void Run() {
+    platform::AutoFiberLock auto_lock(*lock_);
+  }
+
+ private:
+  platform::FiberLock* lock_;
+};
+
+// Blocks until |*released| is set.
+class BlockedThread : public platform::Thread::Delegate {
+ public:
+  BlockedThread(platform::Lock* lock, platform::ConditionVariable* cv,
+                bool* released)
+      : lock_(lock), cv_(cv), released_(released) {}
+
+  virtual void ThreadMain() {
+    platform::AutoLock auto_lock(*lock_);
+    while (!*released_)
+      cv_->Wait();
+  }
+
+ private:
+  platform::Lock* lock_;
+  platform::ConditionVariable* cv_;
+  bool* released_;
+
+  DISALLOW_COPY_AND_ASSIGN(BlockedThread);
+};
+
+}  // namespace
+
+TEST(FiberPerfTest, SwitchContext) {
+  platform::StackPool pool(0, 1);
+  platform::Stack stack;
+  ASSERT_TRUE(pool.Allocate(&stack));
+  PingPong ping_pong;
+  ping_pong.fiber_context = platform::MakeFiberContext(
+      stack.base, stack.size, &PingPongMain, &ping_pong);
+  platform::PerfTimer timer;
+  for (int i = 0; i < kSwitches; i++) {
+    platform::SwitchFiberContext(&ping_pong.main_context,
+                                 ping_pong.fiber_context);
+  }
+  // Each round trip is two switches.
+  double ns = static_cast<double>(timer.ElapsedNs()) / (2 * kSwitches);
+  pool.Free(stack);
+  platform::PrintPerfResult("fiber_switch", "", "context_switch", ns, "ns");
+}
+
+TEST(FiberPerfTest, SchedulerYield) {
+  FiberScheduler scheduler(1, 0);
+  ASSERT_TRUE(scheduler.Spawn(new YieldingTask(kYields / 2)));
+  ASSERT_TRUE(scheduler.Spawn(new YieldingTask(kYields / 2)));
+  platform::PerfTimer timer;
+  ASSERT_TRUE(scheduler.Start());
+  scheduler.WaitForIdle();
+  double ns = static_cast<double>(timer.ElapsedNs()) / kYields;
+  platform::PrintPerfResult("fiber_switch", "", "scheduler_yield", ns, "ns");
+}
+
+TEST(FiberPerfTest, MemoryPerBlockedFiber) {
+  platform::FiberLock lock;
+  ASSERT_TRUE(lock.Try());
+  FiberScheduler scheduler(1, 0);
+  ASSERT_TRUE(scheduler.Start());
+  int64 before = ResidentBytes();
+  for (int i = 0; i < kBlockedFibers; i++)
+    ASSERT_TRUE(scheduler.Spawn(new BlockedFiberTask(&lock)));
+  // Let every fiber run up to the lock.
+  platform::Thread::Sleep(platform::TimeDelta::FromMilliseconds(100));
+  int64 after = ResidentBytes();
+  lock.Release();
+  scheduler.WaitForIdle();
+  platform::PrintPerfResult("fiber_memory", "", "rss_per_fiber",
+                            static_cast<double>(after - before) /
+                                kBlockedFibers,
+                            "bytes");
+}
+
+TEST(FiberPerfTest, MemoryPerBlockedThread) {
+  platform::Lock lock;
+  platform::ConditionVariable cv(&lock);
+  bool released = false;
+  BlockedThread delegate(&lock, &cv, &released);
+  std::vector<platform::ThreadHandle> handles;
+  int64 before = ResidentBytes();
+  for (int i = 0; i < kBlockedThreads; i++) {
+    platform::ThreadHandle handle;
+    if (!platform::Thread::Create(0, &delegate, &handle))
+      break;
+    handles.push_back(handle);
+  }
+  platform::Thread::Sleep(platform::TimeDelta::FromMilliseconds(100));
+  int64 after = ResidentBytes();
+  {
+    platform::AutoLock auto_lock(lock);
+    released = true;
+    cv.Broadcast();
+  }
+  for (size_t i = 0; i < handles.size(); i++)
+    platform::Thread::Join(handles[i]);
+  ASSERT_FALSE(handles.empty());
+  platform::PrintPerfResult("fiber_memory", "", "rss_per_thread",
+                            static_cast<double>(after - before) /
+                                handles.size(),
+                            "bytes");
+}
@@ -0,0 +1,320 @@
+// Copyright (c) 2010 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "simple-platform-lib/src/fiber.h"
+
+#include <gtest/gtest.h>
+
+#include <vector>
+
+#include "simple-platform-lib/src/atomics.h"
+#include "simple-platform-lib/src/fiber_context.h"
+#include "simple-platform-lib/src/lock.h"
+#include "simple-platform-lib/src/stack_pool.h"
+#include "simple-platform-lib/src/time.h"
+
+using platform::Fiber::IsInFiber;
+using platform::FiberLock;
+using platform::FiberScheduler;
+using platform::TimeDelta;
+using platform::TimeTicks;
+
+typedef testing::Test FiberTest;
+
+namespace {
+
+// Switches back and forth with the main context, counting.
+struct PingPong {
+  void* main_context;
+  void* fiber_context;
+  int count;
+};
+
+void PingPongMain(void* arg) {
+  PingPong* ping_pong = static_cast<PingPong*>(arg);
+  for (;;) {
+    ping_pong->count++;
+    platform::SwitchFiberContext(&ping_pong->fiber_context,
+                                 ping_pong->main_context);
+  }
+}
+
+class IncrementTask : public platform::Task {
+ public:
+  explicit IncrementTask(platform::Atomic<int>* counter) : counter_(counter) {}
+
+  virtual void Run() {
+    EXPECT_TRUE(IsInFiber());
+    counter_->FetchAdd(1);
+  }
+
+ private:
+  platform::Atomic<int>* counter_;
+};
+
+// Counts its deletions; must not be run.
+class NotRunTask : public platform::Task {
+ public:
+  explicit NotRunTask(platform::Atomic<int>* deleted) : deleted_(deleted) {}
+
+  virtual ~NotRunTask() {
+    deleted_->FetchAdd(1);
+  }
+
+  virtual void Run() {
+    ADD_FAILURE();
+  }
+
+ private:
+  platform::Atomic<int>* deleted_;
+};
+
+// Appends its id to |order| |rounds| times, yielding in between.
+class YieldingTask : public platform::Task {
+ public:
+  YieldingTask(std::vector<int>* order, int id, int rounds)
+      : order_(order), id_(id), rounds_(rounds) {}
+
+  virtual void Run() {
+    for (int i = 0; i < rounds_; i++) {
+      order_->push_back(id_);
+      platform::Fiber::Yield();
+    }
+  }
+
+ private:
+  std::vector<int>* order_;
+  int id_;
+  int rounds_;
+};
+
+// Increments |*value| non-atomically under |lock|, yielding in the middle
+// of the critical section so that the other fibers get to try the lock.
+class LockingTask : public platform::Task {
+ public:
+  LockingTask(FiberLock* lock, int* value, int* inside, int iterations)
+      : lock_(lock), value_(value), inside_(inside),
+        iterations_(iterations) {}
+
+  virtual void Run() {
+    for (int i = 0; i < iterations_; i++) {
+      platform::AutoFiberLock auto_lock(*lock_);
+      EXPECT_EQ(0, (*inside_)++);
+      int value = *value_;
+      platform::Fiber::Yield();
+      *value_ = value + 1;
+      (*inside_)--;
+    }
+  }
+
+ private:
+  FiberLock* lock_;
+  int* value_;
+  int* inside_;
+  int iterations_;
+};
+
+class SleepingTask : public platform::Task {
+ public:
+  SleepingTask(TimeDelta duration, platform::Atomic<int>* done)
+      : duration_(duration), done_(done) {}
+
+  virtual void Run() {
+    TimeTicks start = TimeTicks::Now();
+    platform::Fiber::Sleep(duration_);
+    EXPECT_GE((TimeTicks::Now() - start).InMicroseconds(),
+              duration_.InMicroseconds());
+    done_->FetchAdd(1);
+  }
+
+ private:
+  TimeDelta duration_;
+  platform::Atomic<int>* done_;
+};
+
+// Spawns |count| IncrementTasks from a fiber.
+class SpawningTask : public platform::Task {
+ public:
+  SpawningTask(FiberScheduler* scheduler, platform::Atomic<int>* counter,
+               int count)
+      : scheduler_(scheduler), counter_(counter), count_(count) {}
+
+  virtual void Run() {
+    for (int i = 0; i < count_; i++)
+      EXPECT_TRUE(scheduler_->Spawn(new IncrementTask(counter_)));
+  }
+
+ private:
+  FiberScheduler* scheduler_;
+  platform::Atomic<int>* counter_;
+  int count_;
+};
+
+}  // namespace
+
+// Test switching to a context made on a pooled stack -------------------------
+
+TEST_F(FiberTest, SwitchContext) {
+  platform::StackPool pool(16 * 1024, 1);
+  platform::Stack stack;
+  ASSERT_TRUE(pool.Allocate(&stack));
+
+  PingPong ping_pong;
+  ping_pong.count = 0;
+  ping_pong.fiber_context = platform::MakeFiberContext(
+      stack.base, stack.size, &PingPongMain, &ping_pong);
+  for (int i = 1; i <= 100; i++) {
+    platform::SwitchFiberContext(&ping_pong.main_context,
+                                 ping_pong.fiber_context);
+    EXPECT_EQ(i, ping_pong.count);
+  }
+  // The fiber never finishes; its stack just goes back to the pool.
+  pool.Free(stack);
+}
+
+// Test that stacks are rounded up to pages and reused ------------------------
+
+TEST_F(FiberTest, StackPoolReuse) {
+  size_t page_size = platform::StackPool::PageSize();
+  platform::StackPool pool(page_size + 1, 1);
+  EXPECT_EQ(2 * page_size, pool.stack_size());
+
+  platform::Stack first, second;
+  ASSERT_TRUE(pool.Allocate(&first));
+  ASSERT_TRUE(pool.Allocate(&second));
+  EXPECT_NE(first.base, second.base);
+  EXPECT_EQ(pool.stack_size(), first.size);
+  // The whole stack is usable.
+  static_cast<char*>(first.base)[0] = 1;
+  static_cast<char*>(first.base)[first.size - 1] = 1;
+
+  pool.Free(first);
+  pool.Free(second);  // Over the limit: unmapped.
+  platform::Stack again;
+  ASSERT_TRUE(pool.Allocate(&again));
+  EXPECT_EQ(first.base, again.base);
+  pool.Free(again);
+}
+
+// Test that the page below a stack faults ------------------------------------
+
+TEST_F(FiberTest, GuardPage) {
+  platform::StackPool pool(0, 0);
+  platform::Stack stack;
+  ASSERT_TRUE(pool.Allocate(&stack));
+  EXPECT_DEATH(static_cast<volatile char*>(stack.base)[-1] = 1, "");
+  pool.Free(stack);
+}
+
+// Test running many fibers to completion -------------------------------------
+
+TEST_F(FiberTest, SpawnMany) {
+  const int kFibers = 10000;
+  platform::Atomic<int> counter(0);
+  FiberScheduler scheduler(2, 16 * 1024);
+  // Fibers spawned before Start() wait for the workers.
+  for (int i = 0; i < kFibers / 2; i++)
+    ASSERT_TRUE(scheduler.Spawn(new IncrementTask(&counter)));
+  ASSERT_TRUE(scheduler.Start());
+  for (int i = kFibers / 2; i < kFibers; i++)
+    ASSERT_TRUE(scheduler.Spawn(new IncrementTask(&counter)));
+  scheduler.WaitForIdle();
+  EXPECT_EQ(kFibers, counter.Load());
+  EXPECT_FALSE(IsInFiber());
+  scheduler.Shutdown();
+}
+
+// Test that a scheduler that was never started drops its fibers --------------
+
+TEST_F(FiberTest, ShutdownWithoutStart) {
+  platform::Atomic<int> deleted(0);
+  {
+    FiberScheduler scheduler(1, 0);
+    for (int i = 0; i < 3; i++)
+      ASSERT_TRUE(scheduler.Spawn(new NotRunTask(&deleted)));
+  }
+  EXPECT_EQ(3, deleted.Load());
+}
+
+// Test spawning from a fiber -------------------------------------------------
+
+TEST_F(FiberTest, SpawnFromFiber) {
+  platform::Atomic<int> counter(0);
+  FiberScheduler scheduler(1, 0);
+  ASSERT_TRUE(scheduler.Start());
+  ASSERT_TRUE(scheduler.Spawn(new SpawningTask(&scheduler, &counter, 100)));
+  scheduler.WaitForIdle();
+  EXPECT_EQ(100, counter.Load());
+}
+
+// Test that yielding round-robins the fibers of a worker ---------------------
+
+TEST_F(FiberTest, YieldInterleaves) {
+  std::vector<int> order;
+  FiberScheduler scheduler(1, 0);
+  for (int id = 0; id < 3; id++)
+    ASSERT_TRUE(scheduler.Spawn(new YieldingTask(&order, id, 3)));
+  ASSERT_TRUE(scheduler.Start());
+  scheduler.WaitForIdle();
+
+  const int kExpected[] = { 0, 1, 2, 0, 1, 2, 0, 1, 2 };
+  ASSERT_EQ(arraysize(kExpected), order.size());
+  for (size_t i = 0; i < order.size(); i++)
+    EXPECT_EQ(kExpected[i], order[i]);
+}
+
+// Test that FiberLock excludes fibers that yield while holding it ------------
+
+TEST_F(FiberTest, LockExcludes) {
+  const int kFibers = 20;
+  const int kIterations = 100;
+  FiberLock lock;
+  int value = 0;
+  int inside = 0;
+  FiberScheduler scheduler(2, 0);
+  ASSERT_TRUE(scheduler.Start());
+  for (int i = 0; i < kFibers; i++) {
+    ASSERT_TRUE(scheduler.Spawn(
+        new LockingTask(&lock, &value, &inside, kIterations)));
+  }
+  // The test thread competes too, by yielding the thread.
+  for (int i = 0; i < kIterations; i++) {
+    platform::AutoFiberLock auto_lock(lock);
+    EXPECT_EQ(0, inside++);
+    value++;
+    inside--;
+  }
+  scheduler.WaitForIdle();
+  EXPECT_EQ((kFibers + 1) * kIterations, value);
+  EXPECT_TRUE(lock.Try());
+  lock.Release();
+}
+
+// Test that sleeping fibers give up their worker -----------------------------
+
+TEST_F(FiberTest, SleepersShareWorker) {
+  const int kFibers = 100;
+  const TimeDelta kSleep = TimeDelta::FromMilliseconds(50);
+  platform::Atomic<int> done(0);
+  FiberScheduler scheduler(1, 0);
+  ASSERT_TRUE(scheduler.Start());
+  TimeTicks start = TimeTicks::Now();
+  for (int i = 0; i < kFibers; i++)
+    ASSERT_TRUE(scheduler.Spawn(new SleepingTask(kSleep, &done)));
+  scheduler.WaitForIdle();
+  EXPECT_EQ(kFibers, done.Load());
+  // The sleeps overlap, on a single worker; were they serialized, this
+  // would take five seconds.
+  EXPECT_LT((TimeTicks::Now() - start).InMilliseconds(), 2500);
+}
+
+// Test that the Fiber functions fall back on threads -------------------------
+
+TEST_F(FiberTest, OutsideFiber) {
+  EXPECT_FALSE(IsInFiber());
+  platform::Fiber::Yield();
+  TimeTicks start = TimeTicks::Now();
+  platform::Fiber::Sleep(TimeDelta::FromMilliseconds(10));
+  EXPECT_GE((TimeTicks::Now() - start).InMilliseconds(), 10);
+}
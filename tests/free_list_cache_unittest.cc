@@ -0,0 +1,100 @@
+// Copyright (c) 2010 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "simple-platform-lib/src/free_list_cache.h"
+
+#include <string.h>
+
+#include <gtest/gtest.h>
+
+#include <set>
+#include <vector>
+
+#include "simple-platform-lib/src/thread.h"
+
+using platform::FreeListCache;
+
+typedef testing::Test FreeListCacheTest;
+
+namespace {
+
+// Frees the blocks it is given, then allocates as many.
+class FreeingThread : public platform::Thread::Delegate {
+ public:
+  FreeingThread(FreeListCache* cache, const std::vector<void*>& blocks)
+      : cache_(cache), blocks_(blocks) {}
+
+  virtual void ThreadMain() {
+    for (size_t i = 0; i < blocks_.size(); i++)
+      cache_->Free(blocks_[i]);
+    for (size_t i = 0; i < blocks_.size(); i++)
+      blocks_[i] = cache_->Allocate();
+  }
+
+  const std::vector<void*>& blocks() const { return blocks_; }
+
+ private:
+  FreeListCache* cache_;
+  std::vector<void*> blocks_;
+
+  DISALLOW_COPY_AND_ASSIGN(FreeingThread);
+};
+
+}  // namespace
+
+// Test that a thread gets its own freed blocks back -------------------------
+
+TEST_F(FreeListCacheTest, ReusesFreedBlocks) {
+  FreeListCache cache(24, 16);
+  EXPECT_EQ(24U, cache.block_size());
+
+  void* first = cache.Allocate();
+  memset(first, 0xcd, cache.block_size());
+  cache.Free(first);
+  EXPECT_EQ(first, cache.Allocate());
+  cache.Free(first);
+}
+
+// Test that blocks too small for a link are rounded up ----------------------
+
+TEST_F(FreeListCacheTest, MinimumBlockSize) {
+  FreeListCache cache(1, 4);
+  EXPECT_EQ(sizeof(void*), cache.block_size());
+  void* block = cache.Allocate();
+  cache.Free(block);
+}
+
+// Test that blocks move between threads through the shared list -------------
+
+TEST_F(FreeListCacheTest, CrossThread) {
+  const size_t kBlocks = 100;
+  FreeListCache cache(64, 8);
+  std::vector<void*> blocks;
+  std::set<void*> allocated;
+  for (size_t i = 0; i < kBlocks; i++) {
+    blocks.push_back(cache.Allocate());
+    EXPECT_TRUE(allocated.insert(blocks.back()).second);
+  }
+
+  // Another thread frees them; all but the few it keeps overflow to the
+  // shared list, and the rest go there as it exits.
+  FreeingThread thread(&cache, blocks);
+  platform::ThreadHandle handle;
+  ASSERT_TRUE(platform::Thread::Create(0, &thread, &handle));
+  platform::Thread::Join(handle);
+  std::set<void*> reallocated(thread.blocks().begin(),
+                              thread.blocks().end());
+  EXPECT_EQ(kBlocks, reallocated.size());
+  EXPECT_TRUE(reallocated == allocated);
+  for (size_t i = 0; i < kBlocks; i++)
+    cache.Free(thread.blocks()[i]);
+
+  // This thread takes them back from the shared list.
+  std::set<void*> taken;
+  for (size_t i = 0; i < kBlocks; i++)
+    taken.insert(cache.Allocate());
+  EXPECT_TRUE(taken == allocated);
+  for (std::set<void*>::iterator it = taken.begin(); it != taken.end(); ++it)
+    cache.Free(*it);
+}
@@ -0,0 +1,72 @@
+// Copyright (c) 2010 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+// Measures the latency of a chain of 1 .. 1000 continuations, from setting
+// the first future's value to the last one being ready, with the
+// continuations run inline, on a ThreadPool and on a WorkStealingScheduler.
+
+#include "simple-platform-lib/src/future.h"
+
+#include <gtest/gtest.h>
+#include <stdio.h>
+
+#include "simple-platform-lib/src/thread_pool.h"
+#include "simple-platform-lib/src/work_stealing_scheduler.h"
+#include "simple-platform-lib/tests/perftimer.h"
+
+using platform::Future;
+using platform::Promise;
+
+namespace {
+
+const int kChainLengths[] = { 1, 10, 100, 1000 };
+const int kRounds = 100;
+
+struct AddOne {
+  typedef int result_type;
+  int operator()(int value) const { return value + 1; }
+};
+
+// |executor| may be NULL for inline continuations.
+void MeasureChains(platform::Executor* executor, const char* trace) {
+  for (size_t i = 0; i < arraysize(kChainLengths); i++) {
+    int length = kChainLengths[i];
+    int64 total_ns = 0;
+    for (int round = 0; round < kRounds; round++) {
+      Promise<int> promise;
+      Future<int> future = promise.GetFuture();
+      for (int j = 0; j < length; j++)
+        future = future.Then(executor, AddOne());
+
+      platform::PerfTimer timer;
+      promise.SetValue(0);
+      EXPECT_EQ(length, future.Get());
+      total_ns += timer.ElapsedNs();
+    }
+
+    char modifier[32];
+    snprintf(modifier, sizeof(modifier), "_%d", length);
+    platform::PrintPerfResult("future_chain", modifier, trace,
+                              static_cast<double>(total_ns) / kRounds / 1000,
+                              "us");
+    platform::PrintPerfResult("future_continuation", modifier, trace,
+                              static_cast<double>(total_ns) / kRounds / length,
+                              "ns");
+  }
+}
+
+}  // namespace
+
+TEST(FuturePerfTest, ChainLatency) {
+  MeasureChains(NULL, "inline");
+
+  platform::ThreadPool pool(2);
+  ASSERT_TRUE(pool.Start());
+  MeasureChains(&pool, "thread_pool");
+  pool.Shutdown(platform::ThreadPool::RUN_PENDING_TASKS);
+
+  platform::WorkStealingScheduler scheduler(2);
+  ASSERT_TRUE(scheduler.Start());
+  MeasureChains(&scheduler, "work_stealing_scheduler");
+}
@@ -0,0 +1,243 @@
+// Copyright (c) 2010 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "simple-platform-lib/src/future.h"
+
+#include <gtest/gtest.h>
+
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "simple-platform-lib/src/thread.h"
+#include "simple-platform-lib/src/thread_pool.h"
+#include "simple-platform-lib/src/work_stealing_scheduler.h"
+
+using platform::Future;
+using platform::Promise;
+
+typedef testing::Test FutureTest;
+
+namespace {
+
+struct AddOne {
+  typedef int result_type;
+  int operator()(int value) const { return value + 1; }
+};
+
+struct ToString {
+  typedef std::string result_type;
+  std::string operator()(int value) const {
+    return std::string(value, 'x');
+  }
+};
+
+// Appends |id| to |order| when it runs.
+class RecordOrder {
+ public:
+  typedef int result_type;
+
+  RecordOrder(std::vector<int>* order, int id) : order_(order), id_(id) {}
+
+  int operator()(int value) const {
+    order_->push_back(id_);
+    return value;
+  }
+
+ private:
+  std::vector<int>* order_;
+  int id_;
+};
+
+// Records the thread it ran on.
+class RecordThread {
+ public:
+  typedef int result_type;
+
+  explicit RecordThread(platform::ThreadId* thread_id)
+      : thread_id_(thread_id) {}
+
+  int operator()(int value) const {
+    *thread_id_ = platform::Thread::CurrentId();
+    return value;
+  }
+
+ private:
+  platform::ThreadId* thread_id_;
+};
+
+// Sets a promise after sleeping.
+class SetValueDelegate : public platform::Thread::Delegate {
+ public:
+  SetValueDelegate(const Promise<int>& promise, int value, int sleep_ms)
+      : promise_(promise), value_(value), sleep_ms_(sleep_ms) {}
+
+  virtual void ThreadMain() {
+    platform::Thread::Sleep(sleep_ms_);
+    promise_.SetValue(value_);
+  }
+
+ private:
+  Promise<int> promise_;
+  int value_;
+  int sleep_ms_;
+
+  DISALLOW_COPY_AND_ASSIGN(SetValueDelegate);
+};
+
+}  // namespace
+
+// Test values and inline continuations ----------------------------------------
+
+TEST_F(FutureTest, SetValue) {
+  Promise<int> promise;
+  Future<int> future = promise.GetFuture();
+  EXPECT_TRUE(future.is_valid());
+  EXPECT_FALSE(future.IsReady());
+  promise.SetValue(42);
+  EXPECT_TRUE(future.IsReady());
+  EXPECT_EQ(42, future.Get());
+
+  // Copies share the value.
+  Future<int> copy;
+  EXPECT_FALSE(copy.is_valid());
+  copy = future;
+  EXPECT_EQ(42, copy.Get());
+  EXPECT_EQ(7, platform::MakeReadyFuture(7).Get());
+}
+
+TEST_F(FutureTest, ThenBeforeAndAfterSetValue) {
+  Promise<int> promise;
+  Future<int> before = promise.GetFuture().Then(AddOne());
+  EXPECT_FALSE(before.IsReady());
+  promise.SetValue(1);
+  EXPECT_TRUE(before.IsReady());
+  EXPECT_EQ(2, before.Get());
+
+  // Runs right away on a ready future.
+  Future<std::string> after = promise.GetFuture().Then(ToString());
+  EXPECT_TRUE(after.IsReady());
+  EXPECT_EQ("x", after.Get());
+}
+
+TEST_F(FutureTest, Chain) {
+  Promise<int> promise;
+  Future<int> future = promise.GetFuture();
+  for (int i = 0; i < 100; i++)
+    future = future.Then(AddOne());
+  promise.SetValue(0);
+  EXPECT_EQ(100, future.Get());
+}
+
+TEST_F(FutureTest, ContinuationsRunInOrder) {
+  std::vector<int> order;
+  Promise<int> promise;
+  Future<int> future = promise.GetFuture();
+  for (int i = 0; i < 5; i++)
+    future.Then(RecordOrder(&order, i));
+  promise.SetValue(0);
+  ASSERT_EQ(5u, order.size());
+  for (int i = 0; i < 5; i++)
+    EXPECT_EQ(i, order[i]);
+}
+
+// Test continuations on executors, and blocking -------------------------------
+
+TEST_F(FutureTest, ThenOnThreadPool) {
+  platform::ThreadPool pool(2);
+  ASSERT_TRUE(pool.Start());
+  platform::ThreadId thread_id = platform::Thread::CurrentId();
+  Promise<int> promise;
+  Future<int> future =
+      promise.GetFuture().Then(&pool, RecordThread(&thread_id))
+                         .Then(&pool, AddOne());
+  promise.SetValue(1);
+  EXPECT_EQ(2, future.Get());
+  EXPECT_NE(platform::Thread::CurrentId(), thread_id);
+  pool.Shutdown(platform::ThreadPool::RUN_PENDING_TASKS);
+}
+
+TEST_F(FutureTest, ThenOnWorkStealingScheduler) {
+  platform::WorkStealingScheduler scheduler(2);
+  ASSERT_TRUE(scheduler.Start());
+  Promise<int> promise;
+  Future<int> future = promise.GetFuture();
+  for (int i = 0; i < 100; i++)
+    future = future.Then(&scheduler, AddOne());
+  promise.SetValue(0);
+  EXPECT_EQ(100, future.Get());
+}
+
+TEST_F(FutureTest, GetBlocksUntilSet) {
+  Promise<int> promise;
+  Future<int> future = promise.GetFuture();
+  SetValueDelegate delegate(promise, 5, 20);
+  platform::ThreadHandle handle;
+  ASSERT_TRUE(platform::Thread::Create(0, &delegate, &handle));
+  EXPECT_EQ(5, future.Get());
+  platform::Thread::Join(handle);
+}
+
+// Test that concurrent SetValue() and Then() run every continuation once ------
+
+TEST_F(FutureTest, RacingThen) {
+  platform::ThreadPool pool(2);
+  ASSERT_TRUE(pool.Start());
+  for (int round = 0; round < 200; round++) {
+    Promise<int> promise;
+    Future<int> future = promise.GetFuture();
+    SetValueDelegate delegate(promise, round, 0);
+    platform::ThreadHandle handle;
+    ASSERT_TRUE(platform::Thread::Create(0, &delegate, &handle));
+    std::vector<Future<int> > results;
+    for (int i = 0; i < 10; i++)
+      results.push_back(future.Then(i % 2 ? &pool : NULL, AddOne()));
+    for (int i = 0; i < 10; i++)
+      ASSERT_EQ(round + 1, results[i].Get());
+    platform::Thread::Join(handle);
+  }
+  pool.Shutdown(platform::ThreadPool::RUN_PENDING_TASKS);
+}
+
+// Test the combinators --------------------------------------------------------
+
+TEST_F(FutureTest, WhenAll) {
+  std::vector<Promise<int> > promises;
+  std::vector<Future<int> > futures;
+  for (int i = 0; i < 3; i++) {
+    promises.push_back(Promise<int>());
+    futures.push_back(promises[i].GetFuture());
+  }
+  Future<std::vector<int> > all = platform::WhenAll(futures);
+  promises[2].SetValue(2);
+  promises[0].SetValue(0);
+  EXPECT_FALSE(all.IsReady());
+  promises[1].SetValue(1);
+  ASSERT_TRUE(all.IsReady());
+  ASSERT_EQ(3u, all.Get().size());
+  for (int i = 0; i < 3; i++)
+    EXPECT_EQ(i, all.Get()[i]);
+
+  EXPECT_TRUE(platform::WhenAll(std::vector<Future<int> >()).Get().empty());
+}
+
+TEST_F(FutureTest, WhenAny) {
+  std::vector<Promise<int> > promises;
+  std::vector<Future<int> > futures;
+  for (int i = 0; i < 3; i++) {
+    promises.push_back(Promise<int>());
+    futures.push_back(promises[i].GetFuture());
+  }
+  Future<std::pair<size_t, int> > any = platform::WhenAny(futures);
+  EXPECT_FALSE(any.IsReady());
+  promises[1].SetValue(10);
+  ASSERT_TRUE(any.IsReady());
+  EXPECT_EQ(1u, any.Get().first);
+  EXPECT_EQ(10, any.Get().second);
+
+  // The others do not change the result.
+  promises[0].SetValue(0);
+  promises[2].SetValue(20);
+  EXPECT_EQ(1u, any.Get().first);
+}
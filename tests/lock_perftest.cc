@@ -0,0 +1,157 @@
+// Copyright (c) 2010 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+// Contention benchmark for the Lock policies.  For 1 .. 64 threads hammering a
+// single lock around a short critical section, reports the total throughput
+// and the 99th percentile of the time from calling Acquire() to holding the
+// lock.  Also reports the cost of an uncontended Acquire()/Release() pair,
+// with and without contention profiling when it is compiled in.  In debug
+// builds that includes the ownership checks, and so Thread::CurrentId().
+
+#include "simple-platform-lib/src/lock.h"
+
+#include <gtest/gtest.h>
+#include <stdio.h>
+
+#include <algorithm>
+#include <vector>
+
+#include "simple-platform-lib/src/lock_profiler.h"
+#include "simple-platform-lib/src/thread.h"
+#include "simple-platform-lib/tests/perftimer.h"
+
+namespace {
+
+const int kMaxThreads = 64;
+const int kRunTimeMs = 100;
+const size_t kMaxSamplesPerThread = 100000;
+const int kUncontendedIterations = 10 * 1000 * 1000;
+
+struct SharedState {
+  SharedState() : counter(0) {}
+  int64 counter;
+  int64 data[8];
+};
+
+template <class LockType>
+class ContendingThread : public platform::Thread::Delegate {
+ public:
+  ContendingThread() : lock_(NULL), state_(NULL), stop_(NULL), acquires_(0) {}
+
+  void Init(LockType* lock, SharedState* state, volatile bool* stop) {
+    lock_ = lock;
+    state_ = state;
+    stop_ = stop;
+    samples_.reserve(kMaxSamplesPerThread);
+  }
+
+  virtual void ThreadMain() {
+    int64 acquires = 0;
+    while (!*stop_) {
+      int64 start = platform::PerfTimer::NowNs();
+      lock_->Acquire();
+      int64 acquired = platform::PerfTimer::NowNs();
+      state_->counter++;
+      for (size_t i = 0; i < arraysize(state_->data); i++)
+        state_->data[i] += state_->counter;
+      lock_->Release();
+
+      if (samples_.size() < kMaxSamplesPerThread)
+        samples_.push_back(acquired - start);
+      acquires++;
+    }
+    acquires_ = acquires;
+  }
+
+  int64 acquires() const { return acquires_; }
+  const std::vector<int64>& samples() const { return samples_; }
+
+ private:
+  LockType* lock_;
+  SharedState* state_;
+  volatile bool* stop_;
+  int64 acquires_;
+  std::vector<int64> samples_;
+
+  DISALLOW_COPY_AND_ASSIGN(ContendingThread);
+};
+
+template <class LockType>
+void MeasureContention(const char* trace, int thread_count) {
+  LockType lock;
+  SharedState state;
+  volatile bool stop = false;
+  ContendingThread<LockType> threads[kMaxThreads];
+  platform::ThreadHandle handles[kMaxThreads];
+
+  platform::PerfTimer timer;
+  for (int i = 0; i < thread_count; i++) {
+    threads[i].Init(&lock, &state, &stop);
+    EXPECT_TRUE(platform::Thread::Create(0, &threads[i], &handles[i]));
+  }
+  platform::Thread::Sleep(kRunTimeMs);
+  stop = true;
+
+  int64 acquires = 0;
+  std::vector<int64> samples;
+  for (int i = 0; i < thread_count; i++) {
+    platform::Thread::Join(handles[i]);
+    acquires += threads[i].acquires();
+    samples.insert(samples.end(), threads[i].samples().begin(),
+                   threads[i].samples().end());
+  }
+  double elapsed_s = timer.ElapsedMs() / 1000;
+  EXPECT_EQ(acquires, state.counter);
+
+  double p99_us = 0;
+  if (!samples.empty()) {
+    std::vector<int64>::iterator p99 =
+        samples.begin() + (samples.size() * 99) / 100;
+    std::nth_element(samples.begin(), p99, samples.end());
+    p99_us = *p99 / 1e3;
+  }
+
+  char modifier[32];
+  snprintf(modifier, sizeof(modifier), "_%dthreads", thread_count);
+  platform::PrintPerfResult("acquires_per_sec", modifier, trace,
+                            acquires / elapsed_s, "acquires/s");
+  platform::PrintPerfResult("acquire_latency_p99", modifier, trace, p99_us,
+                            "us");
+}
+
+template <class LockType>
+void RunContention(const char* trace) {
+  for (int threads = 1; threads <= kMaxThreads; threads *= 2)
+    MeasureContention<LockType>(trace, threads);
+}
+
+void MeasureUncontended(const char* trace) {
+  platform::Lock lock("LockPerfTest.Uncontended");
+  platform::PerfTimer timer;
+  for (int i = 0; i < kUncontendedIterations; i++) {
+    lock.Acquire();
+    lock.Release();
+  }
+  platform::PrintPerfResult("acquire_release", "", trace,
+                            static_cast<double>(timer.ElapsedNs()) /
+                                kUncontendedIterations, "ns");
+}
+
+}  // namespace
+
+TEST(LockPerfTest, Uncontended) {
+  MeasureUncontended("lock");
+#if defined(ENABLE_LOCK_PROFILING)
+  platform::LockProfiler::SetEnabled(true);
+  MeasureUncontended("lock_profiled");
+  platform::LockProfiler::SetEnabled(false);
+  platform::LockProfiler::Reset();
+#endif
+}
+
+TEST(LockPerfTest, Contention) {
+  RunContention<platform::Lock>("lock");
+  RunContention<platform::TicketLock>("ticket_lock");
+  RunContention<platform::McsLock>("mcs_lock");
+}
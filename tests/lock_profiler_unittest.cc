@@ -0,0 +1,170 @@
+// Copyright (c) 2010 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "simple-platform-lib/src/lock_profiler.h"
+
+#include <gtest/gtest.h>
+
+#include <string>
+#include <vector>
+
+#include "simple-platform-lib/src/lock.h"
+#include "simple-platform-lib/src/thread.h"
+
+using platform::LockProfile;
+using platform::LockProfileStats;
+namespace LockProfiler = platform::LockProfiler;
+
+namespace {
+
+class LockProfilerTest : public testing::Test {
+ protected:
+  virtual void SetUp() {
+    LockProfiler::Reset();
+    LockProfiler::SetEnabled(true);
+  }
+
+  virtual void TearDown() {
+    LockProfiler::SetEnabled(false);
+    LockProfiler::Reset();
+  }
+};
+
+bool FindStats(const std::string& name, LockProfileStats* stats) {
+  std::vector<LockProfileStats> all;
+  LockProfiler::GetTopContended(static_cast<size_t>(-1), &all);
+  for (size_t i = 0; i < all.size(); i++) {
+    if (all[i].name == name) {
+      *stats = all[i];
+      return true;
+    }
+  }
+  return false;
+}
+
+}  // namespace
+
+// Test the counters of a single LockProfile -----------------------------------
+
+TEST_F(LockProfilerTest, RecordAcquire) {
+  LockProfile profile("LockProfilerTest.RecordAcquire");
+  LockProfileStats stats;
+  EXPECT_FALSE(FindStats("LockProfilerTest.RecordAcquire", &stats));
+
+  for (int i = 0; i < 3; i++) {
+    profile.RecordAcquire(false, 0);
+    profile.RecordRelease();
+  }
+  profile.RecordAcquire(true, 500);
+  platform::Thread::Sleep(1);
+  profile.RecordRelease();
+
+  ASSERT_TRUE(FindStats("LockProfilerTest.RecordAcquire", &stats));
+  EXPECT_EQ(4, stats.acquisitions);
+  EXPECT_EQ(1, stats.contended);
+  EXPECT_EQ(500, stats.total_wait_ns);
+  // The contended acquisition's hold is always timed.
+  EXPECT_GE(stats.max_hold_ns, 1000 * 1000);
+
+  LockProfiler::Reset();
+  EXPECT_FALSE(FindStats("LockProfilerTest.RecordAcquire", &stats));
+}
+
+// Test that statistics are added up by name, including destroyed locks --------
+
+TEST_F(LockProfilerTest, AggregateByName) {
+  LockProfile live("LockProfilerTest.AggregateByName");
+  live.RecordAcquire(true, 100);
+  live.RecordRelease();
+  {
+    LockProfile destroyed("LockProfilerTest.AggregateByName");
+    destroyed.RecordAcquire(true, 200);
+    destroyed.RecordRelease();
+    destroyed.RecordAcquire(false, 0);
+    destroyed.RecordRelease();
+  }
+
+  LockProfileStats stats;
+  ASSERT_TRUE(FindStats("LockProfilerTest.AggregateByName", &stats));
+  EXPECT_EQ(3, stats.acquisitions);
+  EXPECT_EQ(2, stats.contended);
+  EXPECT_EQ(300, stats.total_wait_ns);
+}
+
+// Test the ordering and formatting of the dumps -------------------------------
+
+TEST_F(LockProfilerTest, TopContended) {
+  LockProfile cold("LockProfilerTest.cold");
+  LockProfile warm("LockProfilerTest.warm");
+  LockProfile hot("LockProfilerTest.\"hot\"");
+  cold.RecordAcquire(false, 0);
+  cold.RecordRelease();
+  warm.RecordAcquire(true, 10);
+  warm.RecordRelease();
+  hot.RecordAcquire(true, 1000);
+  hot.RecordRelease();
+
+  std::vector<LockProfileStats> top;
+  LockProfiler::GetTopContended(2, &top);
+  ASSERT_EQ(2u, top.size());
+  EXPECT_EQ("LockProfilerTest.\"hot\"", top[0].name);
+  EXPECT_EQ("LockProfilerTest.warm", top[1].name);
+
+  std::string text = LockProfiler::DumpText(1);
+  EXPECT_NE(std::string::npos, text.find("LockProfilerTest.\"hot\""));
+  EXPECT_EQ(std::string::npos, text.find("LockProfilerTest.warm"));
+
+  std::string json = LockProfiler::DumpJson(1);
+  EXPECT_EQ(0u, json.find("[{\"name\":\"LockProfilerTest.\\\"hot\\\"\","
+                          "\"acquisitions\":1,\"contended\":1,"
+                          "\"total_wait_ns\":1000,\"max_hold_ns\":"));
+  EXPECT_EQ(json.size() - 2, json.find("}]"));
+}
+
+#if defined(ENABLE_LOCK_PROFILING)
+
+// Test that a Lock records its contention -------------------------------------
+
+namespace {
+
+class HoldingThread : public platform::Thread::Delegate {
+ public:
+  explicit HoldingThread(platform::Lock* lock) : lock_(lock) {}
+
+  virtual void ThreadMain() {
+    platform::AutoLock auto_lock(*lock_);
+    platform::Thread::Sleep(50);
+  }
+
+ private:
+  platform::Lock* lock_;
+
+  DISALLOW_COPY_AND_ASSIGN(HoldingThread);
+};
+
+}  // namespace
+
+TEST_F(LockProfilerTest, Lock) {
+  platform::Lock lock("LockProfilerTest.Lock");
+  HoldingThread thread(&lock);
+  platform::ThreadHandle handle = platform::kNullThreadHandle;
+  ASSERT_TRUE(platform::Thread::Create(0, &thread, &handle));
+  while (lock.Try()) {
+    lock.Release();
+    platform::Thread::Yield();
+  }
+  {
+    platform::AutoLock auto_lock(lock);
+  }
+  platform::Thread::Join(handle);
+
+  LockProfileStats stats;
+  ASSERT_TRUE(FindStats("LockProfilerTest.Lock", &stats));
+  EXPECT_GE(stats.acquisitions, 2);
+  EXPECT_GE(stats.contended, 1);
+  EXPECT_GT(stats.total_wait_ns, 0);
+  EXPECT_GT(stats.max_hold_ns, 0);
+}
+
+#endif  // ENABLE_LOCK_PROFILING
@@ -212,3 +212,193 @@ TEST_F(LockTest, MutexFourThreads) {
 
   EXPECT_EQ(4 * 40, value);
 }
+
+// Tests that locks exclude under heavy contention -----------------------------
+
+class CounterLockTestThread : public platform::Thread::Delegate {
+ public:
+  CounterLockTestThread(platform::Lock* lock, int* value)
+      : lock_(lock), value_(value) {}
+
+  static const int kIterations = 20000;
+
+  virtual void ThreadMain() {
+    for (int i = 0; i < kIterations; i++) {
+      platform::AutoLock auto_lock(*lock_);
+      (*value_)++;
+    }
+  }
+
+ private:
+  platform::Lock* lock_;
+  int* value_;
+
+  DISALLOW_COPY_AND_ASSIGN(CounterLockTestThread);
+};
+
+static void RunCounterThreads(platform::Lock* lock, int* value) {
+  CounterLockTestThread thread1(lock, value);
+  CounterLockTestThread thread2(lock, value);
+  CounterLockTestThread thread3(lock, value);
+  CounterLockTestThread thread4(lock, value);
+  platform::ThreadHandle handle1 = platform::kNullThreadHandle;
+  platform::ThreadHandle handle2 = platform::kNullThreadHandle;
+  platform::ThreadHandle handle3 = platform::kNullThreadHandle;
+  platform::ThreadHandle handle4 = platform::kNullThreadHandle;
+
+  ASSERT_TRUE(platform::Thread::Create(0, &thread1, &handle1));
+  ASSERT_TRUE(platform::Thread::Create(0, &thread2, &handle2));
+  ASSERT_TRUE(platform::Thread::Create(0, &thread3, &handle3));
+  ASSERT_TRUE(platform::Thread::Create(0, &thread4, &handle4));
+
+  platform::Thread::Join(handle1);
+  platform::Thread::Join(handle2);
+  platform::Thread::Join(handle3);
+  platform::Thread::Join(handle4);
+}
+
+TEST_F(LockTest, MutexContended) {
+  platform::Lock lock;
+  int value = 0;
+
+  RunCounterThreads(&lock, &value);
+
+  EXPECT_EQ(4 * CounterLockTestThread::kIterations, value);
+}
+
+#if defined(OS_LINUX)
+// The futex-based implementation should be a single word, with or without the
+// adaptive spin phase.
+TEST_F(LockTest, FutexImpl) {
+  EXPECT_EQ(4u, sizeof(platform::LockImpl));
+
+  int old_spin_count = platform::LockImpl::spin_count();
+  platform::LockImpl::SetSpinCount(0);
+  EXPECT_EQ(0, platform::LockImpl::spin_count());
+
+  platform::Lock lock;
+  int value = 0;
+  RunCounterThreads(&lock, &value);
+  EXPECT_EQ(4 * CounterLockTestThread::kIterations, value);
+
+  platform::LockImpl::SetSpinCount(1000);
+  value = 0;
+  RunCounterThreads(&lock, &value);
+  EXPECT_EQ(4 * CounterLockTestThread::kIterations, value);
+
+  platform::LockImpl::SetSpinCount(old_spin_count);
+}
+#endif  // OS_LINUX
+
+// Tests that apply to every lock policy ---------------------------------------
+
+template <class LockType>
+class LockPolicyTest : public testing::Test {
+};
+
+typedef testing::Types<platform::Lock, platform::TicketLock,
+                       platform::McsLock> LockTypes;
+TYPED_TEST_SUITE(LockPolicyTest, LockTypes);
+
+template <class LockType>
+class TryLockPolicyTestThread : public platform::Thread::Delegate {
+ public:
+  explicit TryLockPolicyTestThread(LockType* lock)
+      : lock_(lock), got_lock_(false) {}
+
+  virtual void ThreadMain() {
+    got_lock_ = lock_->Try();
+    if (got_lock_)
+      lock_->Release();
+  }
+
+  bool got_lock() const { return got_lock_; }
+
+ private:
+  LockType* lock_;
+  bool got_lock_;
+
+  DISALLOW_COPY_AND_ASSIGN(TryLockPolicyTestThread);
+};
+
+TYPED_TEST(LockPolicyTest, TryLock) {
+  TypeParam lock;
+
+  ASSERT_TRUE(lock.Try());
+  {
+    TryLockPolicyTestThread<TypeParam> thread(&lock);
+    platform::ThreadHandle handle = platform::kNullThreadHandle;
+    ASSERT_TRUE(platform::Thread::Create(0, &thread, &handle));
+    platform::Thread::Join(handle);
+    EXPECT_FALSE(thread.got_lock());
+  }
+  lock.Release();
+
+  {
+    TryLockPolicyTestThread<TypeParam> thread(&lock);
+    platform::ThreadHandle handle = platform::kNullThreadHandle;
+    ASSERT_TRUE(platform::Thread::Create(0, &thread, &handle));
+    platform::Thread::Join(handle);
+    EXPECT_TRUE(thread.got_lock());
+  }
+  ASSERT_TRUE(lock.Try());
+  lock.Release();
+}
+
+TYPED_TEST(LockPolicyTest, AutoLockAndAutoUnlock) {
+  TypeParam lock;
+  {
+    platform::BasicAutoLock<TypeParam> auto_lock(lock);
+    lock.AssertAcquired();
+    {
+      platform::BasicAutoUnlock<TypeParam> auto_unlock(lock);
+      ASSERT_TRUE(lock.Try());
+      lock.Release();
+    }
+    lock.AssertAcquired();
+  }
+  ASSERT_TRUE(lock.Try());
+  lock.Release();
+}
+
+template <class LockType>
+class CounterLockPolicyTestThread : public platform::Thread::Delegate {
+ public:
+  CounterLockPolicyTestThread(LockType* lock, int* value)
+      : lock_(lock), value_(value) {}
+
+  static const int kIterations = 20000;
+
+  virtual void ThreadMain() {
+    for (int i = 0; i < kIterations; i++) {
+      platform::BasicAutoLock<LockType> auto_lock(*lock_);
+      (*value_)++;
+    }
+  }
+
+ private:
+  LockType* lock_;
+  int* value_;
+
+  DISALLOW_COPY_AND_ASSIGN(CounterLockPolicyTestThread);
+};
+
+TYPED_TEST(LockPolicyTest, MutexContended) {
+  TypeParam lock;
+  int value = 0;
+
+  CounterLockPolicyTestThread<TypeParam> thread1(&lock, &value);
+  CounterLockPolicyTestThread<TypeParam> thread2(&lock, &value);
+  CounterLockPolicyTestThread<TypeParam> thread3(&lock, &value);
+  CounterLockPolicyTestThread<TypeParam> thread4(&lock, &value);
+  platform::ThreadHandle handles[4];
+
+  ASSERT_TRUE(platform::Thread::Create(0, &thread1, &handles[0]));
+  ASSERT_TRUE(platform::Thread::Create(0, &thread2, &handles[1]));
+  ASSERT_TRUE(platform::Thread::Create(0, &thread3, &handles[2]));
+  ASSERT_TRUE(platform::Thread::Create(0, &thread4, &handles[3]));
+  for (size_t n = 0; n < arraysize(handles); n++)
+    platform::Thread::Join(handles[n]);
+
+  EXPECT_EQ(4 * CounterLockPolicyTestThread<TypeParam>::kIterations, value);
+}
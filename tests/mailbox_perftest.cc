@@ -0,0 +1,111 @@
+// Copyright (c) 2010 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+// Throughput of many threads posting to one Mailbox, drained by a single
+// thread, against a mailbox that takes a Lock on every post.
+
+#include "simple-platform-lib/src/mailbox.h"
+
+#include <gtest/gtest.h>
+
+#include <deque>
+#include <vector>
+
+#include "simple-platform-lib/src/condition_variable.h"
+#include "simple-platform-lib/src/lock.h"
+#include "simple-platform-lib/src/thread.h"
+#include "simple-platform-lib/tests/perftimer.h"
+
+namespace {
+
+const int kMessages = 2 * 1000 * 1000;
+
+struct Message : public platform::MpscQueueNode {
+};
+
+// The mailbox that Mailbox replaces.
+class LockedMailbox {
+ public:
+  LockedMailbox() : message_posted_(&lock_) {}
+
+  void Post(Message* message) {
+    platform::AutoLock auto_lock(lock_);
+    messages_.push_back(message);
+    if (messages_.size() == 1)
+      message_posted_.Signal();
+  }
+
+  Message* Receive() {
+    platform::AutoLock auto_lock(lock_);
+    while (messages_.empty())
+      message_posted_.Wait();
+    Message* message = messages_.front();
+    messages_.pop_front();
+    return message;
+  }
+
+ private:
+  platform::Lock lock_;
+  platform::ConditionVariable message_posted_;
+  std::deque<Message*> messages_;
+
+  DISALLOW_COPY_AND_ASSIGN(LockedMailbox);
+};
+
+template <class MailboxType>
+class PosterThread : public platform::Thread::Delegate {
+ public:
+  PosterThread(MailboxType* mailbox, Message* messages, int count)
+      : mailbox_(mailbox), messages_(messages), count_(count) {}
+
+  virtual void ThreadMain() {
+    for (int i = 0; i < count_; i++)
+      mailbox_->Post(&messages_[i]);
+  }
+
+ private:
+  MailboxType* mailbox_;
+  Message* messages_;
+  int count_;
+
+  DISALLOW_COPY_AND_ASSIGN(PosterThread);
+};
+
+template <class MailboxType>
+void MeasurePosting(int num_posters, const char* trace) {
+  int per_poster = kMessages / num_posters;
+  std::vector<Message> messages(per_poster * num_posters);
+  MailboxType mailbox;
+  std::vector<PosterThread<MailboxType>*> posters;
+  std::vector<platform::ThreadHandle> handles(num_posters);
+
+  platform::PerfTimer timer;
+  for (int i = 0; i < num_posters; i++) {
+    posters.push_back(new PosterThread<MailboxType>(
+        &mailbox, &messages[i * per_poster], per_poster));
+    ASSERT_TRUE(platform::Thread::Create(0, posters[i], &handles[i]));
+  }
+  for (size_t i = 0; i < messages.size(); i++)
+    mailbox.Receive();
+  double seconds = timer.ElapsedNs() / 1e9;
+
+  for (int i = 0; i < num_posters; i++) {
+    platform::Thread::Join(handles[i]);
+    delete posters[i];
+  }
+
+  char modifier[32];
+  snprintf(modifier, sizeof(modifier), "_%d_posters", num_posters);
+  platform::PrintPerfResult("mailbox_post", modifier, trace,
+                            messages.size() / seconds, "messages/s");
+}
+
+}  // namespace
+
+TEST(MailboxPerfTest, Post) {
+  for (int num_posters = 1; num_posters <= 64; num_posters *= 2) {
+    MeasurePosting<LockedMailbox>(num_posters, "locked_mailbox");
+    MeasurePosting<platform::Mailbox<Message> >(num_posters, "mailbox");
+  }
+}
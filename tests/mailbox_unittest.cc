@@ -0,0 +1,127 @@
+// Copyright (c) 2010 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "simple-platform-lib/src/mailbox.h"
+
+#include <gtest/gtest.h>
+
+#include <vector>
+
+#include "simple-platform-lib/src/thread.h"
+
+typedef testing::Test MailboxTest;
+
+namespace {
+
+struct Message : public platform::MpscQueueNode {
+  Message() : value(0) {}
+
+  int value;
+};
+
+}  // namespace
+
+// Test the single-threaded behavior -------------------------------------------
+
+TEST_F(MailboxTest, TryReceive) {
+  Message messages[3];
+  platform::Mailbox<Message> mailbox;
+  EXPECT_EQ(NULL, mailbox.TryReceive());
+  for (int round = 0; round < 3; round++) {
+    for (int i = 0; i < 3; i++)
+      mailbox.Post(&messages[i]);
+    EXPECT_EQ(&messages[0], mailbox.Receive());
+    EXPECT_EQ(&messages[1], mailbox.TryReceive());
+    EXPECT_EQ(&messages[2], mailbox.Receive());
+    EXPECT_EQ(NULL, mailbox.TryReceive());
+  }
+}
+
+// Test that Receive() sleeps until something is posted ------------------------
+
+namespace {
+
+class DelayedPostThread : public platform::Thread::Delegate {
+ public:
+  DelayedPostThread(platform::Mailbox<Message>* mailbox, Message* message)
+      : mailbox_(mailbox), message_(message) {}
+
+  virtual void ThreadMain() {
+    platform::Thread::Sleep(50);
+    mailbox_->Post(message_);
+  }
+
+ private:
+  platform::Mailbox<Message>* mailbox_;
+  Message* message_;
+
+  DISALLOW_COPY_AND_ASSIGN(DelayedPostThread);
+};
+
+}  // namespace
+
+TEST_F(MailboxTest, ReceiveWaits) {
+  Message message;
+  platform::Mailbox<Message> mailbox;
+  for (int i = 0; i < 3; i++) {
+    DelayedPostThread thread(&mailbox, &message);
+    platform::ThreadHandle handle = platform::kNullThreadHandle;
+    ASSERT_TRUE(platform::Thread::Create(0, &thread, &handle));
+    EXPECT_EQ(&message, mailbox.Receive());
+    platform::Thread::Join(handle);
+  }
+}
+
+// Test that every message posted by many threads is received once -------------
+
+namespace {
+
+const int kPosters = 8;
+const int kMessagesPerPoster = 20000;
+
+class PosterThread : public platform::Thread::Delegate {
+ public:
+  PosterThread(platform::Mailbox<Message>* mailbox, Message* messages)
+      : mailbox_(mailbox), messages_(messages) {}
+
+  virtual void ThreadMain() {
+    for (int i = 0; i < kMessagesPerPoster; i++) {
+      mailbox_->Post(&messages_[i]);
+      // Let the receiver catch up now and then, so that it goes to sleep.
+      if (i % 1000 == 0)
+        platform::Thread::Sleep(1);
+    }
+  }
+
+ private:
+  platform::Mailbox<Message>* mailbox_;
+  Message* messages_;
+
+  DISALLOW_COPY_AND_ASSIGN(PosterThread);
+};
+
+}  // namespace
+
+TEST_F(MailboxTest, ConcurrentPost) {
+  std::vector<Message> messages(kPosters * kMessagesPerPoster);
+  platform::Mailbox<Message> mailbox;
+  std::vector<PosterThread*> posters;
+  std::vector<platform::ThreadHandle> handles(kPosters);
+  for (int i = 0; i < kPosters; i++) {
+    posters.push_back(
+        new PosterThread(&mailbox, &messages[i * kMessagesPerPoster]));
+    ASSERT_TRUE(platform::Thread::Create(0, posters[i], &handles[i]));
+  }
+
+  for (size_t i = 0; i < messages.size(); i++)
+    mailbox.Receive()->value++;
+  EXPECT_EQ(NULL, mailbox.TryReceive());
+  for (size_t i = 0; i < messages.size(); i++)
+    ASSERT_EQ(1, messages[i].value) << "message " << i;
+
+  for (int i = 0; i < kPosters; i++) {
+    platform::Thread::Join(handles[i]);
+    delete posters[i];
+  }
+}
@@ -0,0 +1,205 @@
+// Copyright (c) 2010 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+// Throughput of MpmcQueue and BlockingMpmcQueue for several numbers of
+// producers and consumers, against a bounded queue guarded by a Lock, with
+// condition variables for full and empty.
+
+#include "simple-platform-lib/src/mpmc_queue.h"
+
+#include <gtest/gtest.h>
+
+#include <deque>
+#include <vector>
+
+#include "simple-platform-lib/src/condition_variable.h"
+#include "simple-platform-lib/src/lock.h"
+#include "simple-platform-lib/src/spin_wait.h"
+#include "simple-platform-lib/src/thread.h"
+#include "simple-platform-lib/tests/perftimer.h"
+
+namespace {
+
+const int kMessages = 2 * 1000 * 1000;
+const size_t kCapacity = 1024;
+// Tells a consumer to stop.
+const int64 kStop = -1;
+
+// The queue that MpmcQueue replaces.
+class LockedQueue {
+ public:
+  explicit LockedQueue(size_t capacity)
+      : capacity_(capacity), not_empty_(&lock_), not_full_(&lock_) {}
+
+  void Push(int64 item) {
+    platform::AutoLock auto_lock(lock_);
+    while (items_.size() == capacity_)
+      not_full_.Wait();
+    items_.push_back(item);
+    not_empty_.Signal();
+  }
+
+  int64 Pop() {
+    platform::AutoLock auto_lock(lock_);
+    while (items_.empty())
+      not_empty_.Wait();
+    int64 item = items_.front();
+    items_.pop_front();
+    not_full_.Signal();
+    return item;
+  }
+
+ private:
+  const size_t capacity_;
+  platform::Lock lock_;
+  platform::ConditionVariable not_empty_;
+  platform::ConditionVariable not_full_;
+  std::deque<int64> items_;
+
+  DISALLOW_COPY_AND_ASSIGN(LockedQueue);
+};
+
+void Push(LockedQueue* queue, int64 item) {
+  queue->Push(item);
+}
+
+int64 Pop(LockedQueue* queue) {
+  return queue->Pop();
+}
+
+// The lock-free queue on its own, waiting with SpinWait.
+void Push(platform::MpmcQueue<int64>* queue, int64 item) {
+  platform::SpinWait spin_wait;
+  while (!queue->TryPush(item))
+    spin_wait.Once();
+}
+
+int64 Pop(platform::MpmcQueue<int64>* queue) {
+  int64 item;
+  platform::SpinWait spin_wait;
+  while (!queue->TryPop(&item))
+    spin_wait.Once();
+  return item;
+}
+
+void Push(platform::BlockingMpmcQueue<int64>* queue, int64 item) {
+  queue->Push(item);
+}
+
+int64 Pop(platform::BlockingMpmcQueue<int64>* queue) {
+  int64 item = kStop;
+  queue->Pop(&item);
+  return item;
+}
+
+template <class Queue>
+class ProducerThread : public platform::Thread::Delegate {
+ public:
+  ProducerThread(Queue* queue, int count) : queue_(queue), count_(count) {}
+
+  virtual void ThreadMain() {
+    for (int i = 0; i < count_; i++)
+      Push(queue_, i);
+  }
+
+ private:
+  Queue* queue_;
+  int count_;
+
+  DISALLOW_COPY_AND_ASSIGN(ProducerThread);
+};
+
+template <class Queue>
+class ConsumerThread : public platform::Thread::Delegate {
+ public:
+  explicit ConsumerThread(Queue* queue) : queue_(queue), count_(0) {}
+
+  virtual void ThreadMain() {
+    while (Pop(queue_) != kStop)
+      count_++;
+  }
+
+  int count() const { return count_; }
+
+ private:
+  Queue* queue_;
+  int count_;
+
+  DISALLOW_COPY_AND_ASSIGN(ConsumerThread);
+};
+
+template <class Queue>
+void MeasureThroughput(int num_producers, int num_consumers,
+                       const char* trace) {
+  Queue queue(kCapacity);
+  std::vector<ProducerThread<Queue>*> producers;
+  std::vector<ConsumerThread<Queue>*> consumers;
+  std::vector<platform::ThreadHandle> producer_handles(num_producers);
+  std::vector<platform::ThreadHandle> consumer_handles(num_consumers);
+
+  platform::PerfTimer timer;
+  for (int i = 0; i < num_consumers; i++) {
+    consumers.push_back(new ConsumerThread<Queue>(&queue));
+    ASSERT_TRUE(platform::Thread::Create(0, consumers[i],
+                                         &consumer_handles[i]));
+  }
+  for (int i = 0; i < num_producers; i++) {
+    producers.push_back(new ProducerThread<Queue>(&queue,
+                                                  kMessages / num_producers));
+    ASSERT_TRUE(platform::Thread::Create(0, producers[i],
+                                         &producer_handles[i]));
+  }
+  for (int i = 0; i < num_producers; i++) {
+    platform::Thread::Join(producer_handles[i]);
+    delete producers[i];
+  }
+  for (int i = 0; i < num_consumers; i++)
+    Push(&queue, kStop);
+  int total = 0;
+  for (int i = 0; i < num_consumers; i++) {
+    platform::Thread::Join(consumer_handles[i]);
+    total += consumers[i]->count();
+    delete consumers[i];
+  }
+  double seconds = timer.ElapsedNs() / 1e9;
+
+  EXPECT_EQ(kMessages / num_producers * num_producers, total);
+  char modifier[32];
+  snprintf(modifier, sizeof(modifier), "_%dp_%dc", num_producers,
+           num_consumers);
+  platform::PrintPerfResult("mpmc_throughput", modifier, trace,
+                            total / seconds, "messages/s");
+}
+
+void MeasureAll(int num_producers, int num_consumers) {
+  MeasureThroughput<LockedQueue>(num_producers, num_consumers,
+                                 "locked_queue");
+  MeasureThroughput<platform::MpmcQueue<int64> >(num_producers,
+                                                 num_consumers, "mpmc");
+  MeasureThroughput<platform::BlockingMpmcQueue<int64> >(
+      num_producers, num_consumers, "mpmc_blocking");
+}
+
+}  // namespace
+
+TEST(MpmcQueuePerfTest, OneToOne) {
+  MeasureAll(1, 1);
+}
+
+TEST(MpmcQueuePerfTest, FanIn) {
+  MeasureAll(4, 1);
+  MeasureAll(8, 1);
+  MeasureAll(16, 1);
+}
+
+TEST(MpmcQueuePerfTest, FanOut) {
+  MeasureAll(1, 4);
+  MeasureAll(1, 8);
+  MeasureAll(1, 16);
+}
+
+TEST(MpmcQueuePerfTest, ManyToMany) {
+  MeasureAll(4, 4);
+  MeasureAll(16, 16);
+}
@@ -0,0 +1,209 @@
+// Copyright (c) 2010 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "simple-platform-lib/src/mpmc_queue.h"
+
+#include <gtest/gtest.h>
+
+#include <vector>
+
+#include "simple-platform-lib/src/atomics.h"
+#include "simple-platform-lib/src/thread.h"
+
+typedef testing::Test MpmcQueueTest;
+
+// Test the single-threaded behavior -------------------------------------------
+
+TEST_F(MpmcQueueTest, FifoAndFull) {
+  platform::MpmcQueue<int> queue(3);
+  EXPECT_EQ(4u, queue.capacity());
+  int item = -1;
+  EXPECT_FALSE(queue.TryPop(&item));
+
+  // Several laps around the array.
+  for (int lap = 0; lap < 3; lap++) {
+    for (int i = 0; i < 4; i++)
+      EXPECT_TRUE(queue.TryPush(lap * 10 + i));
+    EXPECT_FALSE(queue.TryPush(-1));
+    EXPECT_EQ(4u, queue.Size());
+    for (int i = 0; i < 4; i++) {
+      EXPECT_TRUE(queue.TryPop(&item));
+      EXPECT_EQ(lap * 10 + i, item);
+    }
+    EXPECT_FALSE(queue.TryPop(&item));
+    EXPECT_EQ(0u, queue.Size());
+  }
+}
+
+TEST_F(MpmcQueueTest, Capacity) {
+  EXPECT_EQ(2u, platform::MpmcQueue<int>(0).capacity());
+  EXPECT_EQ(2u, platform::MpmcQueue<int>(2).capacity());
+  EXPECT_EQ(1024u, platform::MpmcQueue<int>(1000).capacity());
+  EXPECT_EQ(1024u, platform::MpmcQueue<int>(1024).capacity());
+}
+
+TEST_F(MpmcQueueTest, Close) {
+  platform::BlockingMpmcQueue<int> queue(4);
+  EXPECT_TRUE(queue.Push(1));
+  EXPECT_TRUE(queue.TryPush(2));
+  EXPECT_FALSE(queue.IsClosed());
+  queue.Close();
+  EXPECT_TRUE(queue.IsClosed());
+  EXPECT_FALSE(queue.Push(3));
+  EXPECT_FALSE(queue.TryPush(3));
+
+  // What was pushed before can still be popped.
+  int item = 0;
+  EXPECT_TRUE(queue.Pop(&item));
+  EXPECT_EQ(1, item);
+  EXPECT_TRUE(queue.TryPop(&item));
+  EXPECT_EQ(2, item);
+  EXPECT_FALSE(queue.Pop(&item));
+  EXPECT_FALSE(queue.TryPop(&item));
+}
+
+// Test that every item is popped exactly once, in order per producer ----------
+
+namespace {
+
+const int kProducers = 4;
+const int kConsumers = 4;
+const int kItemsPerProducer = 50000;
+
+// Items encode their producer and their sequence number.
+int MakeItem(int producer, int sequence) {
+  return producer * kItemsPerProducer + sequence;
+}
+
+// The lock-free queue is polled; the blocking one is closed when done.
+bool Push(platform::MpmcQueue<int>* queue, int item) {
+  while (!queue->TryPush(item))
+    platform::Thread::Yield();
+  return true;
+}
+
+bool Pop(platform::MpmcQueue<int>* queue, int* item) {
+  return queue->TryPop(item);
+}
+
+void CloseIfBlocking(platform::MpmcQueue<int>* /* queue */) {}
+
+bool Push(platform::BlockingMpmcQueue<int>* queue, int item) {
+  return queue->Push(item);
+}
+
+bool Pop(platform::BlockingMpmcQueue<int>* queue, int* item) {
+  return queue->Pop(item);
+}
+
+void CloseIfBlocking(platform::BlockingMpmcQueue<int>* queue) {
+  queue->Close();
+}
+
+template <class Queue>
+class ProducerThread : public platform::Thread::Delegate {
+ public:
+  ProducerThread(Queue* queue, int producer)
+      : queue_(queue), producer_(producer) {}
+
+  virtual void ThreadMain() {
+    for (int i = 0; i < kItemsPerProducer; i++)
+      Push(queue_, MakeItem(producer_, i));
+  }
+
+ private:
+  Queue* queue_;
+  int producer_;
+
+  DISALLOW_COPY_AND_ASSIGN(ProducerThread);
+};
+
+// Pops until |*done| is set and the queue is empty (or, for a blocking
+// queue, until it is closed and empty), checking that each producer's items
+// come in order.
+template <class Queue>
+class ConsumerThread : public platform::Thread::Delegate {
+ public:
+  ConsumerThread(Queue* queue, platform::AtomicFlag* done,
+                 std::vector<platform::Atomic<int> >* popped)
+      : queue_(queue), done_(done), popped_(popped), in_order_(true) {}
+
+  virtual void ThreadMain() {
+    std::vector<int> last(kProducers, -1);
+    for (;;) {
+      bool done = done_->IsSet();
+      int item;
+      if (!Pop(queue_, &item)) {
+        if (done)
+          break;
+        platform::Thread::Yield();
+        continue;
+      }
+      int producer = item / kItemsPerProducer;
+      int sequence = item % kItemsPerProducer;
+      if (sequence <= last[producer])
+        in_order_ = false;
+      last[producer] = sequence;
+      (*popped_)[item].FetchAdd(1);
+    }
+  }
+
+  bool in_order() const { return in_order_; }
+
+ private:
+  Queue* queue_;
+  platform::AtomicFlag* done_;
+  std::vector<platform::Atomic<int> >* popped_;
+  bool in_order_;
+
+  DISALLOW_COPY_AND_ASSIGN(ConsumerThread);
+};
+
+template <class Queue>
+void PushAndPopConcurrently(Queue* queue) {
+  platform::AtomicFlag done;
+  std::vector<platform::Atomic<int> > popped(kProducers * kItemsPerProducer);
+  std::vector<ProducerThread<Queue>*> producers;
+  std::vector<ConsumerThread<Queue>*> consumers;
+  std::vector<platform::ThreadHandle> producer_handles(kProducers);
+  std::vector<platform::ThreadHandle> consumer_handles(kConsumers);
+  for (int i = 0; i < kConsumers; i++) {
+    consumers.push_back(new ConsumerThread<Queue>(queue, &done, &popped));
+    ASSERT_TRUE(platform::Thread::Create(0, consumers[i],
+                                         &consumer_handles[i]));
+  }
+  for (int i = 0; i < kProducers; i++) {
+    producers.push_back(new ProducerThread<Queue>(queue, i));
+    ASSERT_TRUE(platform::Thread::Create(0, producers[i],
+                                         &producer_handles[i]));
+  }
+
+  for (int i = 0; i < kProducers; i++) {
+    platform::Thread::Join(producer_handles[i]);
+    delete producers[i];
+  }
+  done.Set();
+  CloseIfBlocking(queue);
+  for (int i = 0; i < kConsumers; i++) {
+    platform::Thread::Join(consumer_handles[i]);
+    EXPECT_TRUE(consumers[i]->in_order());
+    delete consumers[i];
+  }
+
+  for (size_t i = 0; i < popped.size(); i++)
+    ASSERT_EQ(1, popped[i].Load()) << "item " << i;
+}
+
+}  // namespace
+
+TEST_F(MpmcQueueTest, Concurrent) {
+  platform::MpmcQueue<int> queue(64);
+  PushAndPopConcurrently(&queue);
+}
+
+TEST_F(MpmcQueueTest, ConcurrentBlocking) {
+  // Small enough for producers to block on a full queue, too.
+  platform::BlockingMpmcQueue<int> queue(8);
+  PushAndPopConcurrently(&queue);
+}
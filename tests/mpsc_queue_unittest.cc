@@ -0,0 +1,120 @@
+// Copyright (c) 2010 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "simple-platform-lib/src/mpsc_queue.h"
+
+#include <gtest/gtest.h>
+
+#include <vector>
+
+#include "simple-platform-lib/src/thread.h"
+
+typedef testing::Test MpscQueueTest;
+
+namespace {
+
+struct Item : public platform::MpscQueueNode {
+  Item() : producer(0), sequence(0) {}
+
+  int producer;
+  int sequence;
+};
+
+}  // namespace
+
+// Test the single-threaded behavior -------------------------------------------
+
+TEST_F(MpscQueueTest, Fifo) {
+  Item items[3];
+  platform::MpscQueue<Item> queue;
+  EXPECT_TRUE(queue.Empty());
+  EXPECT_EQ(NULL, queue.Pop());
+
+  for (int i = 0; i < 3; i++)
+    queue.Push(&items[i]);
+  EXPECT_FALSE(queue.Empty());
+  for (int i = 0; i < 3; i++)
+    EXPECT_EQ(&items[i], queue.Pop());
+  EXPECT_TRUE(queue.Empty());
+  EXPECT_EQ(NULL, queue.Pop());
+}
+
+TEST_F(MpscQueueTest, Interleaved) {
+  // Popping the last item and pushing again goes through the stub node.
+  Item items[2];
+  platform::MpscQueue<Item> queue;
+  for (int i = 0; i < 5; i++) {
+    queue.Push(&items[0]);
+    EXPECT_EQ(&items[0], queue.Pop());
+    EXPECT_TRUE(queue.Empty());
+    queue.Push(&items[0]);
+    queue.Push(&items[1]);
+    EXPECT_EQ(&items[0], queue.Pop());
+    EXPECT_EQ(&items[1], queue.Pop());
+    EXPECT_EQ(NULL, queue.Pop());
+  }
+}
+
+// Test that concurrent pushes all arrive, in order per producer ---------------
+
+namespace {
+
+const int kProducers = 8;
+const int kItemsPerProducer = 20000;
+
+class ProducerThread : public platform::Thread::Delegate {
+ public:
+  ProducerThread(platform::MpscQueue<Item>* queue, Item* items)
+      : queue_(queue), items_(items) {}
+
+  virtual void ThreadMain() {
+    for (int i = 0; i < kItemsPerProducer; i++)
+      queue_->Push(&items_[i]);
+  }
+
+ private:
+  platform::MpscQueue<Item>* queue_;
+  Item* items_;
+
+  DISALLOW_COPY_AND_ASSIGN(ProducerThread);
+};
+
+}  // namespace
+
+TEST_F(MpscQueueTest, ConcurrentPush) {
+  std::vector<Item> items(kProducers * kItemsPerProducer);
+  for (int i = 0; i < kProducers; i++) {
+    for (int j = 0; j < kItemsPerProducer; j++) {
+      items[i * kItemsPerProducer + j].producer = i;
+      items[i * kItemsPerProducer + j].sequence = j;
+    }
+  }
+
+  platform::MpscQueue<Item> queue;
+  std::vector<ProducerThread*> producers;
+  std::vector<platform::ThreadHandle> handles(kProducers);
+  for (int i = 0; i < kProducers; i++) {
+    producers.push_back(
+        new ProducerThread(&queue, &items[i * kItemsPerProducer]));
+    ASSERT_TRUE(platform::Thread::Create(0, producers[i], &handles[i]));
+  }
+
+  std::vector<int> next(kProducers, 0);
+  for (int popped = 0; popped < kProducers * kItemsPerProducer;) {
+    Item* item = queue.Pop();
+    if (!item) {
+      platform::Thread::Yield();
+      continue;
+    }
+    ASSERT_EQ(next[item->producer], item->sequence);
+    next[item->producer]++;
+    popped++;
+  }
+  EXPECT_EQ(NULL, queue.Pop());
+
+  for (int i = 0; i < kProducers; i++) {
+    platform::Thread::Join(handles[i]);
+    delete producers[i];
+  }
+}
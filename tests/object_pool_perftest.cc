@@ -0,0 +1,153 @@
+// Copyright (c) 2010 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+// ObjectPool and Arena against the heap (new and delete, so malloc and
+// free): allocating and freeing on one thread, in batches; a producer
+// allocating messages that a consumer thread frees, through an SpscRing;
+// and request-scoped allocation, freed all at once with Arena::Reset().
+
+#include "simple-platform-lib/src/object_pool.h"
+
+#include <gtest/gtest.h>
+
+#include "simple-platform-lib/src/arena.h"
+#include "simple-platform-lib/src/spsc_ring.h"
+#include "simple-platform-lib/src/thread.h"
+#include "simple-platform-lib/tests/perftimer.h"
+
+namespace {
+
+const int kBatches = 100 * 1000;
+const int kBatchSize = 64;
+const int kMessages = 1000 * 1000;
+const int kRequests = 100 * 1000;
+const int kAllocationsPerRequest = 32;
+
+struct Message {
+  int64 id;
+  char payload[56];
+};
+
+typedef platform::SpscRing<Message*, 1024> MessageRing;
+
+// Allocates with the pool, or with new if there is none.
+class MessageFactory {
+ public:
+  explicit MessageFactory(platform::ObjectPool<Message>* pool)
+      : pool_(pool) {}
+
+  Message* New() { return pool_ ? pool_->New() : new Message; }
+
+  void Delete(Message* message) {
+    if (pool_)
+      pool_->Delete(message);
+    else
+      delete message;
+  }
+
+ private:
+  platform::ObjectPool<Message>* pool_;
+};
+
+class ConsumerThread : public platform::Thread::Delegate {
+ public:
+  ConsumerThread(MessageFactory* factory, MessageRing* ring)
+      : factory_(factory), ring_(ring) {}
+
+  virtual void ThreadMain() {
+    for (int i = 0; i < kMessages; i++) {
+      Message* message;
+      ring_->Pop(&message);
+      factory_->Delete(message);
+    }
+  }
+
+ private:
+  MessageFactory* factory_;
+  MessageRing* ring_;
+
+  DISALLOW_COPY_AND_ASSIGN(ConsumerThread);
+};
+
+void MeasureBatches(const char* trace, MessageFactory* factory) {
+  Message* messages[kBatchSize];
+  platform::PerfTimer timer;
+  for (int i = 0; i < kBatches; i++) {
+    for (int j = 0; j < kBatchSize; j++) {
+      messages[j] = factory->New();
+      messages[j]->id = j;
+    }
+    for (int j = 0; j < kBatchSize; j++)
+      factory->Delete(messages[j]);
+  }
+  double ns = static_cast<double>(timer.ElapsedNs()) /
+              (static_cast<int64>(kBatches) * kBatchSize);
+  platform::PrintPerfResult("object_alloc_free", "", trace, ns, "ns");
+}
+
+void MeasureProducerConsumer(const char* trace, MessageFactory* factory) {
+  MessageRing ring(MessageRing::WAIT_BLOCK);
+  ConsumerThread consumer(factory, &ring);
+  platform::ThreadHandle handle;
+  platform::PerfTimer timer;
+  ASSERT_TRUE(platform::Thread::Create(0, &consumer, &handle));
+  for (int i = 0; i < kMessages; i++) {
+    Message* message = factory->New();
+    message->id = i;
+    ring.Push(message);
+  }
+  platform::Thread::Join(handle);
+  double ns = static_cast<double>(timer.ElapsedNs()) / kMessages;
+  platform::PrintPerfResult("object_producer_consumer", "", trace, ns, "ns");
+}
+
+}  // namespace
+
+TEST(ObjectPoolPerfTest, SingleThread) {
+  MessageFactory heap(NULL);
+  MeasureBatches("new_delete", &heap);
+
+  platform::ObjectPool<Message> pool;
+  MessageFactory pooled(&pool);
+  MeasureBatches("object_pool", &pooled);
+}
+
+TEST(ObjectPoolPerfTest, ProducerFreesConsumer) {
+  MessageFactory heap(NULL);
+  MeasureProducerConsumer("new_delete", &heap);
+
+  platform::ObjectPool<Message> pool;
+  MessageFactory pooled(&pool);
+  MeasureProducerConsumer("object_pool", &pooled);
+}
+
+TEST(ObjectPoolPerfTest, RequestScoped) {
+  const int kAllocations = kRequests * kAllocationsPerRequest;
+  Message* messages[kAllocationsPerRequest];
+  platform::PerfTimer timer;
+  for (int i = 0; i < kRequests; i++) {
+    for (int j = 0; j < kAllocationsPerRequest; j++) {
+      messages[j] = new Message;
+      messages[j]->id = j;
+    }
+    for (int j = 0; j < kAllocationsPerRequest; j++)
+      delete messages[j];
+  }
+  platform::PrintPerfResult("request_alloc", "", "new_delete",
+                            static_cast<double>(timer.ElapsedNs()) /
+                                kAllocations, "ns");
+
+  platform::Arena arena(64 * 1024);
+  timer.Reset();
+  for (int i = 0; i < kRequests; i++) {
+    for (int j = 0; j < kAllocationsPerRequest; j++) {
+      messages[j] = arena.New<Message>();
+      messages[j]->id = j;
+    }
+    arena.Reset();
+  }
+  platform::PrintPerfResult("request_alloc", "", "arena",
+                            static_cast<double>(timer.ElapsedNs()) /
+                                kAllocations, "ns");
+}
@@ -0,0 +1,217 @@
+// Copyright (c) 2010 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "simple-platform-lib/src/object_pool.h"
+
+#include <stdint.h>
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <set>
+#include <vector>
+
+#include "simple-platform-lib/src/atomics.h"
+#include "simple-platform-lib/src/spsc_ring.h"
+#include "simple-platform-lib/src/thread.h"
+
+using platform::ObjectPool;
+
+typedef testing::Test ObjectPoolTest;
+
+namespace {
+
+const int kMagazineSize = platform::internal::ObjectPoolBase::kMagazineSize;
+
+class Message {
+ public:
+  Message() : id_(-1), payload_(0) { live_.FetchAdd(1); }
+  explicit Message(int id) : id_(id), payload_(id * 3) { live_.FetchAdd(1); }
+  Message(int id, int payload) : id_(id), payload_(payload) {
+    live_.FetchAdd(1);
+  }
+  ~Message() { live_.FetchSub(1); }
+
+  int id() const { return id_; }
+  int payload() const { return payload_; }
+
+  static int live() { return live_.Load(); }
+
+ private:
+  int id_;
+  int payload_;
+  static platform::Atomic<int> live_;
+};
+
+platform::Atomic<int> Message::live_;
+
+struct Aligned {
+  double value;
+  char tag;
+} __attribute__((aligned(16)));
+
+typedef platform::SpscRing<Message*, 1024> MessageRing;
+
+// Deletes what comes through the ring, until a NULL.
+class ConsumerThread : public platform::Thread::Delegate {
+ public:
+  ConsumerThread(ObjectPool<Message>* pool, MessageRing* ring)
+      : pool_(pool), ring_(ring), received_(0), corrupted_(0) {}
+
+  virtual void ThreadMain() {
+    for (;;) {
+      Message* message;
+      ring_->Pop(&message);
+      if (!message)
+        break;
+      if (message->payload() != message->id() * 3)
+        corrupted_++;
+      received_++;
+      pool_->Delete(message);
+    }
+  }
+
+  int received() const { return received_; }
+  int corrupted() const { return corrupted_; }
+
+ private:
+  ObjectPool<Message>* pool_;
+  MessageRing* ring_;
+  int received_;
+  int corrupted_;
+
+  DISALLOW_COPY_AND_ASSIGN(ConsumerThread);
+};
+
+// Allocates a batch of messages and frees it again, |rounds| times.
+class ChurnThread : public platform::Thread::Delegate {
+ public:
+  ChurnThread(ObjectPool<Message>* pool, int batch, int rounds)
+      : pool_(pool), batch_(batch), rounds_(rounds) {}
+
+  virtual void ThreadMain() {
+    std::vector<Message*> messages(batch_);
+    for (int round = 0; round < rounds_; round++) {
+      for (int i = 0; i < batch_; i++)
+        messages[i] = pool_->New(i);
+      for (int i = 0; i < batch_; i++)
+        pool_->Delete(messages[i]);
+    }
+  }
+
+ private:
+  ObjectPool<Message>* pool_;
+  int batch_;
+  int rounds_;
+
+  DISALLOW_COPY_AND_ASSIGN(ChurnThread);
+};
+
+}  // namespace
+
+// Test constructing and destroying objects ----------------------------------
+
+TEST_F(ObjectPoolTest, NewAndDelete) {
+  ObjectPool<Message> pool;
+  Message* first = pool.New();
+  Message* second = pool.New(7);
+  Message* third = pool.New(8, 9);
+  EXPECT_EQ(3, Message::live());
+  EXPECT_EQ(-1, first->id());
+  EXPECT_EQ(21, second->payload());
+  EXPECT_EQ(9, third->payload());
+  pool.Delete(first);
+  pool.Delete(second);
+  pool.Delete(third);
+  pool.Delete(NULL);
+  EXPECT_EQ(0, Message::live());
+
+  // The last one freed is the first one reused.
+  Message* again = pool.New();
+  EXPECT_EQ(third, again);
+  pool.Delete(again);
+}
+
+// Test that objects are distinct and aligned --------------------------------
+
+TEST_F(ObjectPoolTest, DistinctAndAligned) {
+  const int kObjects = 10 * kMagazineSize;
+  ObjectPool<Aligned> pool;
+  std::set<Aligned*> seen;
+  std::vector<Aligned*> objects;
+  for (int i = 0; i < kObjects; i++) {
+    Aligned* object = pool.New();
+    EXPECT_EQ(0U, reinterpret_cast<uintptr_t>(object) % 16);
+    EXPECT_TRUE(seen.insert(object).second);
+    object->tag = static_cast<char>(i);
+    objects.push_back(object);
+  }
+  for (int i = 0; i < kObjects; i++) {
+    EXPECT_EQ(static_cast<char>(i), objects[i]->tag);
+    pool.Delete(objects[i]);
+  }
+}
+
+// Test that objects freed on another thread come back through the depot -----
+
+TEST_F(ObjectPoolTest, CrossThreadFree) {
+  const int kMessages = 20 * kMagazineSize;
+  ObjectPool<Message> pool;
+  MessageRing ring(MessageRing::WAIT_BLOCK);
+  ConsumerThread consumer(&pool, &ring);
+  platform::ThreadHandle handle;
+  ASSERT_TRUE(platform::Thread::Create(0, &consumer, &handle));
+
+  std::set<Message*> sent;
+  for (int i = 0; i < kMessages; i++) {
+    Message* message = pool.New(i);
+    sent.insert(message);
+    ring.Push(message);
+  }
+  ring.Push(NULL);
+  platform::Thread::Join(handle);
+  EXPECT_EQ(kMessages, consumer.received());
+  EXPECT_EQ(0, consumer.corrupted());
+  EXPECT_EQ(0, Message::live());
+
+  // Past what this thread's own magazines held back, the objects are the
+  // ones the consumer freed.  (The producer may have reused some already,
+  // so fewer than kMessages were sent.)
+  std::vector<Message*> messages;
+  int reused = 0;
+  for (int i = 0; i < kMessages; i++) {
+    messages.push_back(pool.New(i));
+    if (sent.count(messages.back()))
+      reused++;
+  }
+  int sent_objects = static_cast<int>(sent.size());
+  EXPECT_GE(reused, std::min(sent_objects, kMessages - 2 * kMagazineSize));
+  for (int i = 0; i < kMessages; i++)
+    pool.Delete(messages[i]);
+}
+
+// Test that threads allocating at once reuse objects rather than carve more -
+
+TEST_F(ObjectPoolTest, CapacityBoundedUnderContention) {
+  const int kThreads = 4;
+  const int kBatch = 4 * kMagazineSize;
+  ObjectPool<Message> pool;
+  ChurnThread* threads[kThreads];
+  platform::ThreadHandle handles[kThreads];
+  for (int i = 0; i < kThreads; i++) {
+    threads[i] = new ChurnThread(&pool, kBatch, 2000);
+    ASSERT_TRUE(platform::Thread::Create(0, threads[i], &handles[i]));
+  }
+  for (int i = 0; i < kThreads; i++) {
+    platform::Thread::Join(handles[i]);
+    delete threads[i];
+  }
+  EXPECT_EQ(0, Message::live());
+
+  // Objects are only carved when the depot has no full magazine, at which
+  // point every object is live or in a thread's two magazines; each thread
+  // carves a magazine's worth at a time.
+  EXPECT_LE(pool.capacity(),
+            static_cast<size_t>(kThreads * (kBatch + 3 * kMagazineSize)));
+}
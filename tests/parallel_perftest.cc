@@ -0,0 +1,94 @@
+// Copyright (c) 2010 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+// ParallelFor and ParallelReduce on the default scheduler against serial
+// loops, for 1e3 .. 1e8 elements.
+
+#include "simple-platform-lib/src/parallel.h"
+
+#include <gtest/gtest.h>
+#include <math.h>
+#include <stdio.h>
+
+#include <vector>
+
+#include "simple-platform-lib/tests/perftimer.h"
+
+namespace {
+
+const int64 kMinSize = 1000;
+const int64 kMaxSize = 100 * 1000 * 1000;
+const int64 kGrain = 1024;
+
+inline float Work(int64 i) {
+  return sqrtf(static_cast<float>(i)) * 0.5f + 1.0f;
+}
+
+class FillBody {
+ public:
+  explicit FillBody(float* values) : values_(values) {}
+
+  void operator()(int64 begin, int64 end) const {
+    for (int64 i = begin; i < end; i++)
+      values_[i] = Work(i);
+  }
+
+ private:
+  float* values_;
+};
+
+class SumBody {
+ public:
+  double operator()(int64 begin, int64 end) const {
+    double sum = 0;
+    for (int64 i = begin; i < end; i++)
+      sum += Work(i);
+    return sum;
+  }
+};
+
+class Plus {
+ public:
+  double operator()(double a, double b) const { return a + b; }
+};
+
+void PrintResult(const char* measurement, int64 size, const char* trace,
+                 double ms) {
+  char modifier[32];
+  snprintf(modifier, sizeof(modifier), "_%lld", static_cast<long long>(size));
+  platform::PrintPerfResult(measurement, modifier, trace, ms, "ms");
+}
+
+}  // namespace
+
+TEST(ParallelPerfTest, For) {
+  std::vector<float> values(kMaxSize);
+  FillBody body(&values[0]);
+  // Start the default scheduler's threads outside of the measurements.
+  platform::ParallelFor(0, kMaxSize, kGrain, body);
+
+  for (int64 size = kMinSize; size <= kMaxSize; size *= 10) {
+    platform::PerfTimer timer;
+    body(0, size);
+    PrintResult("parallel_for", size, "serial", timer.ElapsedMs());
+
+    timer.Reset();
+    platform::ParallelFor(0, size, kGrain, body);
+    PrintResult("parallel_for", size, "parallel", timer.ElapsedMs());
+  }
+}
+
+TEST(ParallelPerfTest, Reduce) {
+  for (int64 size = kMinSize; size <= kMaxSize; size *= 10) {
+    platform::PerfTimer timer;
+    double expected = SumBody()(0, size);
+    PrintResult("parallel_reduce", size, "serial", timer.ElapsedMs());
+
+    timer.Reset();
+    double sum = platform::ParallelReduce(0, size, kGrain, 0.0, SumBody(),
+                                          Plus());
+    PrintResult("parallel_reduce", size, "parallel", timer.ElapsedMs());
+    EXPECT_NEAR(expected, sum, fabs(expected) * 1e-9);
+  }
+}
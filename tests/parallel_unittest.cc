@@ -0,0 +1,167 @@
+// Copyright (c) 2010 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "simple-platform-lib/src/parallel.h"
+
+#include <gtest/gtest.h>
+
+#include <string>
+#include <vector>
+
+#include "simple-platform-lib/src/atomics.h"
+#include "simple-platform-lib/src/thread.h"
+
+namespace {
+
+class ParallelTest : public testing::Test {
+ protected:
+  ParallelTest() : scheduler_(4) {}
+
+  virtual void SetUp() {
+    ASSERT_TRUE(scheduler_.Start());
+  }
+
+  platform::WorkStealingScheduler scheduler_;
+};
+
+typedef std::vector<platform::Atomic<int32> > Visits;
+
+// Counts the visits to each index, and the calls.
+class CountBody {
+ public:
+  explicit CountBody(Visits* visits) : visits_(visits) {}
+
+  void operator()(int64 begin, int64 end) const {
+    calls_.FetchAdd(1);
+    for (int64 i = begin; i < end; i++)
+      (*visits_)[i].FetchAdd(1);
+  }
+
+  int32 calls() const { return calls_.Load(); }
+
+ private:
+  Visits* visits_;
+  mutable platform::Atomic<int32> calls_;
+};
+
+// Sums the squares of the indices.
+class SquareBody {
+ public:
+  int64 operator()(int64 begin, int64 end) const {
+    int64 sum = 0;
+    for (int64 i = begin; i < end; i++)
+      sum += i * i;
+    return sum;
+  }
+};
+
+class Plus {
+ public:
+  int64 operator()(int64 a, int64 b) const { return a + b; }
+};
+
+// Concatenates the indices' last digits, to check the order of combining.
+class DigitsBody {
+ public:
+  std::string operator()(int64 begin, int64 end) const {
+    std::string digits;
+    for (int64 i = begin; i < end; i++)
+      digits.push_back(static_cast<char>('0' + i % 10));
+    return digits;
+  }
+};
+
+class Concatenate {
+ public:
+  std::string operator()(const std::string& a, const std::string& b) const {
+    return a + b;
+  }
+};
+
+// A ParallelFor whose body runs ParallelFors.
+class NestedBody {
+ public:
+  NestedBody(platform::WorkStealingScheduler* scheduler,
+             Visits* visits)
+      : scheduler_(scheduler), visits_(visits) {}
+
+  void operator()(int64 begin, int64 end) const {
+    for (int64 i = begin; i < end; i++)
+      platform::ParallelFor(scheduler_, i * 100, (i + 1) * 100, 7,
+                            CountBody(visits_));
+  }
+
+ private:
+  platform::WorkStealingScheduler* scheduler_;
+  Visits* visits_;
+};
+
+}  // namespace
+
+// Test that ParallelFor covers its range exactly once -------------------------
+
+TEST_F(ParallelTest, ForCoversRange) {
+  const int kSize = 100000;
+  Visits visits(kSize);
+  CountBody body(&visits);
+  platform::ParallelFor(&scheduler_, 10, kSize - 10, 16, body);
+  for (int i = 0; i < kSize; i++)
+    ASSERT_EQ(i >= 10 && i < kSize - 10 ? 1 : 0, visits[i].Load())
+        << "index " << i;
+  EXPECT_GT(body.calls(), 1);
+}
+
+TEST_F(ParallelTest, ForSmallRangesRunInline) {
+  Visits visits(100);
+  CountBody body(&visits);
+  platform::ParallelFor(&scheduler_, 0, 100, 100, body);
+  EXPECT_EQ(1, body.calls());
+
+  // Empty ranges, and grains below 1.
+  platform::ParallelFor(&scheduler_, 50, 50, 1, body);
+  platform::ParallelFor(&scheduler_, 60, 50, 1, body);
+  EXPECT_EQ(1, body.calls());
+  platform::ParallelFor(&scheduler_, 0, 100, 0, body);
+  for (int i = 0; i < 100; i++)
+    EXPECT_EQ(2, visits[i].Load());
+}
+
+TEST_F(ParallelTest, ForNested) {
+  Visits visits(100 * 100);
+  platform::ParallelFor(&scheduler_, 0, 100, 1,
+                        NestedBody(&scheduler_, &visits));
+  for (size_t i = 0; i < visits.size(); i++)
+    ASSERT_EQ(1, visits[i].Load()) << "index " << i;
+}
+
+TEST_F(ParallelTest, ForOnDefaultScheduler) {
+  Visits visits(10000);
+  platform::ParallelFor(0, 10000, 10, CountBody(&visits));
+  for (size_t i = 0; i < visits.size(); i++)
+    ASSERT_EQ(1, visits[i].Load()) << "index " << i;
+}
+
+// Test ParallelReduce ---------------------------------------------------------
+
+TEST_F(ParallelTest, Reduce) {
+  const int64 kSize = 1000000;
+  int64 expected = (kSize - 1) * kSize * (2 * kSize - 1) / 6;
+  EXPECT_EQ(expected, platform::ParallelReduce(&scheduler_, 0, kSize, 100,
+                                               static_cast<int64>(0),
+                                               SquareBody(), Plus()));
+  EXPECT_EQ(expected, platform::ParallelReduce(0, kSize, 100,
+                                               static_cast<int64>(0),
+                                               SquareBody(), Plus()));
+  EXPECT_EQ(42, platform::ParallelReduce(&scheduler_, 5, 5, 1,
+                                         static_cast<int64>(42),
+                                         SquareBody(), Plus()));
+}
+
+TEST_F(ParallelTest, ReduceKeepsOrder) {
+  const int kSize = 10000;
+  std::string expected = DigitsBody()(0, kSize);
+  EXPECT_EQ(expected, platform::ParallelReduce(&scheduler_, 0, kSize, 3,
+                                               std::string(), DigitsBody(),
+                                               Concatenate()));
+}
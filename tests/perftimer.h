@@ -0,0 +1,51 @@
+// Copyright (c) 2010 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+// Loosely based on Chromium: src/base/perftimer.h and src/base/perf_test_util.h
+
+// Timing and reporting helpers for the perf tests.  Results are printed in the
+// Chromium perf bot format:
+//
+//   *RESULT <measurement><modifier>: <trace>= <value> <units>
+
+#ifndef SIMPLEPLATFORMLIB_TESTS_PERFTIMER_H_
+#define SIMPLEPLATFORMLIB_TESTS_PERFTIMER_H_
+#pragma once
+
+#include <stdio.h>
+
+#include "simple-platform-lib/src/basictypes.h"
+#include "simple-platform-lib/src/time.h"
+
+namespace platform {
+
+// Measures elapsed wall-clock time on the monotonic clock.
+class PerfTimer {
+ public:
+  PerfTimer() { Reset(); }
+
+  void Reset() { start_ns_ = NowNs(); }
+
+  int64 ElapsedNs() const { return NowNs() - start_ns_; }
+  double ElapsedMs() const { return ElapsedNs() / 1e6; }
+
+  static int64 NowNs() { return TimeTicks::Now().ToInternalValue(); }
+
+ private:
+  int64 start_ns_;
+
+  DISALLOW_COPY_AND_ASSIGN(PerfTimer);
+};
+
+inline void PrintPerfResult(const char* measurement, const char* modifier,
+                            const char* trace, double value,
+                            const char* units) {
+  printf("*RESULT %s%s: %s= %.3f %s\n", measurement, modifier, trace, value,
+         units);
+  fflush(stdout);
+}
+
+}  // namespace platform
+
+#endif  // SIMPLEPLATFORMLIB_TESTS_PERFTIMER_H_
@@ -0,0 +1,135 @@
+// Copyright (c) 2010 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+// Measures read-side throughput of the reader/writer locks against Lock, for
+// 1 .. NumberOfProcessors() reader threads.  With per-processor reader shards,
+// ShardedRWLock throughput should grow linearly with the number of threads.
+
+#include "simple-platform-lib/src/rw_lock.h"
+
+#include <gtest/gtest.h>
+#include <stdio.h>
+
+#include "simple-platform-lib/src/lock.h"
+#include "simple-platform-lib/src/sharded_rw_lock.h"
+#include "simple-platform-lib/src/sys_info.h"
+#include "simple-platform-lib/src/thread.h"
+#include "simple-platform-lib/tests/perftimer.h"
+
+namespace {
+
+const int kMaxThreads = 64;
+const int kRunTimeMs = 200;
+
+// Adapts Lock to the reader/writer interface, so that the exclusive lock can
+// serve as the baseline.
+class ExclusiveLock {
+ public:
+  ExclusiveLock() {}
+  void ReadAcquire() { lock_.Acquire(); }
+  void ReadRelease() { lock_.Release(); }
+
+ private:
+  platform::Lock lock_;
+
+  DISALLOW_COPY_AND_ASSIGN(ExclusiveLock);
+};
+
+// A small read-mostly "configuration table".
+struct Table {
+  Table() {
+    for (size_t i = 0; i < arraysize(values); i++)
+      values[i] = static_cast<int>(i);
+  }
+  int values[16];
+};
+
+template <class LockType>
+class ReadLoopThread : public platform::Thread::Delegate {
+ public:
+  ReadLoopThread()
+      : lock_(NULL), table_(NULL), stop_(NULL), reads_(0), sum_(0) {}
+
+  void Init(LockType* lock, const Table* table, volatile bool* stop) {
+    lock_ = lock;
+    table_ = table;
+    stop_ = stop;
+  }
+
+  virtual void ThreadMain() {
+    int64 reads = 0;
+    int sum = 0;
+    while (!*stop_) {
+      for (int i = 0; i < 64; i++) {
+        lock_->ReadAcquire();
+        sum += table_->values[i & 15];
+        lock_->ReadRelease();
+      }
+      reads += 64;
+    }
+    reads_ = reads;
+    sum_ = sum;
+  }
+
+  int64 reads() const { return reads_; }
+
+ private:
+  LockType* lock_;
+  const Table* table_;
+  volatile bool* stop_;
+  int64 reads_;
+  int sum_;
+
+  DISALLOW_COPY_AND_ASSIGN(ReadLoopThread);
+};
+
+// Returns the total number of reads per second achieved by |thread_count|
+// threads.
+template <class LockType>
+double MeasureReads(int thread_count) {
+  LockType lock;
+  Table table;
+  volatile bool stop = false;
+  ReadLoopThread<LockType> threads[kMaxThreads];
+  platform::ThreadHandle handles[kMaxThreads];
+
+  platform::PerfTimer timer;
+  for (int i = 0; i < thread_count; i++) {
+    threads[i].Init(&lock, &table, &stop);
+    EXPECT_TRUE(platform::Thread::Create(0, &threads[i], &handles[i]));
+  }
+  platform::Thread::Sleep(kRunTimeMs);
+  stop = true;
+  int64 reads = 0;
+  for (int i = 0; i < thread_count; i++) {
+    platform::Thread::Join(handles[i]);
+    reads += threads[i].reads();
+  }
+  return reads / (timer.ElapsedMs() / 1000);
+}
+
+template <class LockType>
+void RunScaling(const char* trace) {
+  int max_threads = platform::SysInfo::NumberOfProcessors();
+  if (max_threads > kMaxThreads)
+    max_threads = kMaxThreads;
+  for (int threads = 1; ; threads *= 2) {
+    if (threads > max_threads)
+      threads = max_threads;
+    char modifier[32];
+    snprintf(modifier, sizeof(modifier), "_%dthreads", threads);
+    platform::PrintPerfResult("reads_per_sec", modifier, trace,
+                              MeasureReads<LockType>(threads), "reads/s");
+    if (threads == max_threads)
+      break;
+  }
+}
+
+}  // namespace
+
+TEST(RWLockPerfTest, ReadScaling) {
+  RunScaling<ExclusiveLock>("lock");
+  RunScaling<platform::RWLock>("rw_lock");
+  RunScaling<platform::ShardedRWLock>("sharded_rw_lock");
+}
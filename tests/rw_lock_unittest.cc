@@ -0,0 +1,179 @@
+// Copyright (c) 2010 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "simple-platform-lib/src/rw_lock.h"
+
+#include <gtest/gtest.h>
+
+#include "simple-platform-lib/src/sharded_rw_lock.h"
+#include "simple-platform-lib/src/thread.h"
+
+namespace {
+
+// Lets the tests below construct each lock flavor the same way.
+class WriterPreferringRWLock : public platform::RWLock {
+ public:
+  WriterPreferringRWLock() : platform::RWLock(PREFER_WRITERS) {}
+};
+
+}  // namespace
+
+template <class RWLockType>
+class RWLockTest : public testing::Test {
+};
+
+typedef testing::Types<platform::RWLock, WriterPreferringRWLock,
+                       platform::ShardedRWLock> RWLockTypes;
+TYPED_TEST_SUITE(RWLockTest, RWLockTypes);
+
+// Test that Try*() respect the holders of the lock ----------------------------
+
+template <class RWLockType>
+class TryRWLockTestThread : public platform::Thread::Delegate {
+ public:
+  explicit TryRWLockTestThread(RWLockType* lock)
+      : lock_(lock), got_read_lock_(false), got_write_lock_(false) {}
+
+  virtual void ThreadMain() {
+    got_read_lock_ = lock_->ReadTry();
+    if (got_read_lock_)
+      lock_->ReadRelease();
+    got_write_lock_ = lock_->WriteTry();
+    if (got_write_lock_)
+      lock_->WriteRelease();
+  }
+
+  bool got_read_lock() const { return got_read_lock_; }
+  bool got_write_lock() const { return got_write_lock_; }
+
+ private:
+  RWLockType* lock_;
+  bool got_read_lock_;
+  bool got_write_lock_;
+
+  DISALLOW_COPY_AND_ASSIGN(TryRWLockTestThread);
+};
+
+template <class RWLockType>
+void RunTryThread(RWLockType* lock, bool* got_read_lock, bool* got_write_lock) {
+  TryRWLockTestThread<RWLockType> thread(lock);
+  platform::ThreadHandle handle = platform::kNullThreadHandle;
+  ASSERT_TRUE(platform::Thread::Create(0, &thread, &handle));
+  platform::Thread::Join(handle);
+  *got_read_lock = thread.got_read_lock();
+  *got_write_lock = thread.got_write_lock();
+}
+
+TYPED_TEST(RWLockTest, Try) {
+  TypeParam lock;
+  bool got_read_lock = false;
+  bool got_write_lock = false;
+
+  // Readers share with readers, but not with writers.
+  ASSERT_TRUE(lock.ReadTry());
+  RunTryThread(&lock, &got_read_lock, &got_write_lock);
+  EXPECT_TRUE(got_read_lock);
+  EXPECT_FALSE(got_write_lock);
+  lock.ReadRelease();
+
+  // Writers exclude everybody.
+  ASSERT_TRUE(lock.WriteTry());
+  RunTryThread(&lock, &got_read_lock, &got_write_lock);
+  EXPECT_FALSE(got_read_lock);
+  EXPECT_FALSE(got_write_lock);
+  lock.WriteRelease();
+
+  // And once released, the lock is free again.
+  RunTryThread(&lock, &got_read_lock, &got_write_lock);
+  EXPECT_TRUE(got_read_lock);
+  EXPECT_TRUE(got_write_lock);
+}
+
+// Test that readers never see a half-done write -------------------------------
+
+template <class RWLockType>
+struct SharedPair {
+  SharedPair() : first(0), second(0) {}
+
+  RWLockType lock;
+  int first;
+  int second;  // Always equal to |first| outside of the write lock.
+};
+
+template <class RWLockType>
+class WriterThread : public platform::Thread::Delegate {
+ public:
+  WriterThread(SharedPair<RWLockType>* pair, int count)
+      : pair_(pair), count_(count) {}
+
+  virtual void ThreadMain() {
+    for (int i = 0; i < count_; i++) {
+      platform::BasicAutoWriteLock<RWLockType> auto_lock(pair_->lock);
+      pair_->first++;
+      if (i % 16 == 0)
+        platform::Thread::Yield();
+      pair_->second++;
+    }
+  }
+
+ private:
+  SharedPair<RWLockType>* pair_;
+  int count_;
+
+  DISALLOW_COPY_AND_ASSIGN(WriterThread);
+};
+
+template <class RWLockType>
+class ReaderThread : public platform::Thread::Delegate {
+ public:
+  ReaderThread(SharedPair<RWLockType>* pair, int count)
+      : pair_(pair), count_(count), mismatches_(0) {}
+
+  virtual void ThreadMain() {
+    for (int i = 0; i < count_; i++) {
+      platform::BasicAutoReadLock<RWLockType> auto_lock(pair_->lock);
+      int first = pair_->first;
+      if (i % 16 == 0)
+        platform::Thread::Yield();
+      if (first != pair_->second)
+        mismatches_++;
+    }
+  }
+
+  int mismatches() const { return mismatches_; }
+
+ private:
+  SharedPair<RWLockType>* pair_;
+  int count_;
+  int mismatches_;
+
+  DISALLOW_COPY_AND_ASSIGN(ReaderThread);
+};
+
+TYPED_TEST(RWLockTest, ReadersSeeConsistentWrites) {
+  const int kWrites = 2000;
+  const int kReads = 20000;
+  SharedPair<TypeParam> pair;
+
+  WriterThread<TypeParam> writer1(&pair, kWrites);
+  WriterThread<TypeParam> writer2(&pair, kWrites);
+  ReaderThread<TypeParam> reader1(&pair, kReads);
+  ReaderThread<TypeParam> reader2(&pair, kReads);
+  ReaderThread<TypeParam> reader3(&pair, kReads);
+  platform::ThreadHandle handles[5];
+
+  ASSERT_TRUE(platform::Thread::Create(0, &reader1, &handles[0]));
+  ASSERT_TRUE(platform::Thread::Create(0, &writer1, &handles[1]));
+  ASSERT_TRUE(platform::Thread::Create(0, &reader2, &handles[2]));
+  ASSERT_TRUE(platform::Thread::Create(0, &writer2, &handles[3]));
+  ASSERT_TRUE(platform::Thread::Create(0, &reader3, &handles[4]));
+  for (size_t n = 0; n < arraysize(handles); n++)
+    platform::Thread::Join(handles[n]);
+
+  EXPECT_EQ(0, reader1.mismatches());
+  EXPECT_EQ(0, reader2.mismatches());
+  EXPECT_EQ(0, reader3.mismatches());
+  EXPECT_EQ(2 * kWrites, pair.first);
+  EXPECT_EQ(2 * kWrites, pair.second);
+}
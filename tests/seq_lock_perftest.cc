@@ -0,0 +1,160 @@
+// Copyright (c) 2010 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+// Measures read throughput of SeqLock against Lock with one thread writing
+// continuously and 1 .. NumberOfProcessors() threads reading.
+
+#include "simple-platform-lib/src/seq_lock.h"
+
+#include <gtest/gtest.h>
+#include <stdio.h>
+
+#include "simple-platform-lib/src/lock.h"
+#include "simple-platform-lib/src/sys_info.h"
+#include "simple-platform-lib/src/thread.h"
+#include "simple-platform-lib/tests/perftimer.h"
+
+namespace {
+
+const int kMaxReaders = 64;
+const int kRunTimeMs = 200;
+
+struct ClockOffset {
+  int64 offset_ns;
+  int64 drift_ppb;
+};
+
+// Lock-protected baseline with the same interface as SeqLock.
+class LockedValue {
+ public:
+  LockedValue() {
+    value_.offset_ns = 0;
+    value_.drift_ppb = 0;
+  }
+
+  ClockOffset Read() {
+    platform::AutoLock auto_lock(lock_);
+    return value_;
+  }
+
+  void Write(const ClockOffset& value) {
+    platform::AutoLock auto_lock(lock_);
+    value_ = value;
+  }
+
+ private:
+  platform::Lock lock_;
+  ClockOffset value_;
+
+  DISALLOW_COPY_AND_ASSIGN(LockedValue);
+};
+
+template <class ProtectedValue>
+class ReaderThread : public platform::Thread::Delegate {
+ public:
+  ReaderThread() : value_(NULL), stop_(NULL), reads_(0), sum_(0) {}
+
+  void Init(ProtectedValue* value, volatile bool* stop) {
+    value_ = value;
+    stop_ = stop;
+  }
+
+  virtual void ThreadMain() {
+    int64 reads = 0;
+    int64 sum = 0;
+    while (!*stop_) {
+      for (int i = 0; i < 64; i++)
+        sum += value_->Read().offset_ns;
+      reads += 64;
+    }
+    reads_ = reads;
+    sum_ = sum;
+  }
+
+  int64 reads() const { return reads_; }
+
+ private:
+  ProtectedValue* value_;
+  volatile bool* stop_;
+  int64 reads_;
+  int64 sum_;
+
+  DISALLOW_COPY_AND_ASSIGN(ReaderThread);
+};
+
+template <class ProtectedValue>
+class WriterThread : public platform::Thread::Delegate {
+ public:
+  WriterThread(ProtectedValue* value, volatile bool* stop)
+      : value_(value), stop_(stop) {}
+
+  virtual void ThreadMain() {
+    ClockOffset offset;
+    offset.offset_ns = 0;
+    offset.drift_ppb = 0;
+    while (!*stop_) {
+      offset.offset_ns++;
+      value_->Write(offset);
+      // Writes are rare compared to reads.
+      platform::Thread::Sleep(1);
+    }
+  }
+
+ private:
+  ProtectedValue* value_;
+  volatile bool* stop_;
+
+  DISALLOW_COPY_AND_ASSIGN(WriterThread);
+};
+
+template <class ProtectedValue>
+double MeasureReads(int reader_count) {
+  ProtectedValue value;
+  volatile bool stop = false;
+  WriterThread<ProtectedValue> writer(&value, &stop);
+  ReaderThread<ProtectedValue> readers[kMaxReaders];
+  platform::ThreadHandle writer_handle = platform::kNullThreadHandle;
+  platform::ThreadHandle handles[kMaxReaders];
+
+  platform::PerfTimer timer;
+  EXPECT_TRUE(platform::Thread::Create(0, &writer, &writer_handle));
+  for (int i = 0; i < reader_count; i++) {
+    readers[i].Init(&value, &stop);
+    EXPECT_TRUE(platform::Thread::Create(0, &readers[i], &handles[i]));
+  }
+  platform::Thread::Sleep(kRunTimeMs);
+  stop = true;
+  int64 reads = 0;
+  for (int i = 0; i < reader_count; i++) {
+    platform::Thread::Join(handles[i]);
+    reads += readers[i].reads();
+  }
+  platform::Thread::Join(writer_handle);
+  return reads / (timer.ElapsedMs() / 1000);
+}
+
+template <class ProtectedValue>
+void RunScaling(const char* trace) {
+  int max_readers = platform::SysInfo::NumberOfProcessors();
+  if (max_readers > kMaxReaders)
+    max_readers = kMaxReaders;
+  for (int readers = 1; ; readers *= 2) {
+    if (readers > max_readers)
+      readers = max_readers;
+    char modifier[32];
+    snprintf(modifier, sizeof(modifier), "_1writer_%dreaders", readers);
+    platform::PrintPerfResult("reads_per_sec", modifier, trace,
+                              MeasureReads<ProtectedValue>(readers),
+                              "reads/s");
+    if (readers == max_readers)
+      break;
+  }
+}
+
+}  // namespace
+
+TEST(SeqLockPerfTest, ReadScaling) {
+  RunScaling<LockedValue>("lock");
+  RunScaling<platform::SeqLock<ClockOffset> >("seq_lock");
+}
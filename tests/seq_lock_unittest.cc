@@ -0,0 +1,117 @@
+// Copyright (c) 2010 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "simple-platform-lib/src/seq_lock.h"
+
+#include <gtest/gtest.h>
+
+#include "simple-platform-lib/src/thread.h"
+
+typedef testing::Test SeqLockTest;
+
+namespace {
+
+// Large enough that a torn copy is likely to be caught.
+struct Snapshot {
+  int64 values[8];
+};
+
+Snapshot MakeSnapshot(int64 value) {
+  Snapshot snapshot;
+  for (size_t i = 0; i < arraysize(snapshot.values); i++)
+    snapshot.values[i] = value;
+  return snapshot;
+}
+
+bool IsConsistent(const Snapshot& snapshot) {
+  for (size_t i = 1; i < arraysize(snapshot.values); i++) {
+    if (snapshot.values[i] != snapshot.values[0])
+      return false;
+  }
+  return true;
+}
+
+}  // namespace
+
+TEST_F(SeqLockTest, ReadWrite) {
+  platform::SeqLock<int> zero;
+  EXPECT_EQ(0, zero.Read());
+
+  platform::SeqLock<Snapshot> lock(MakeSnapshot(7));
+  EXPECT_EQ(7, lock.Read().values[0]);
+  lock.Write(MakeSnapshot(42));
+  Snapshot snapshot = lock.Read();
+  EXPECT_TRUE(IsConsistent(snapshot));
+  EXPECT_EQ(42, snapshot.values[0]);
+}
+
+// Test that readers never see a torn value ------------------------------------
+
+class SeqLockWriterThread : public platform::Thread::Delegate {
+ public:
+  SeqLockWriterThread(platform::SeqLock<Snapshot>* lock, int count)
+      : lock_(lock), count_(count) {}
+
+  virtual void ThreadMain() {
+    for (int i = 1; i <= count_; i++)
+      lock_->Write(MakeSnapshot(i));
+  }
+
+ private:
+  platform::SeqLock<Snapshot>* lock_;
+  int count_;
+
+  DISALLOW_COPY_AND_ASSIGN(SeqLockWriterThread);
+};
+
+class SeqLockReaderThread : public platform::Thread::Delegate {
+ public:
+  SeqLockReaderThread(platform::SeqLock<Snapshot>* lock, int count)
+      : lock_(lock), count_(count), torn_reads_(0), went_backwards_(0) {}
+
+  virtual void ThreadMain() {
+    int64 last = 0;
+    for (int i = 0; i < count_; i++) {
+      Snapshot snapshot = lock_->Read();
+      if (!IsConsistent(snapshot))
+        torn_reads_++;
+      // There is a single writer, so values only ever increase.
+      if (snapshot.values[0] < last)
+        went_backwards_++;
+      last = snapshot.values[0];
+    }
+  }
+
+  int torn_reads() const { return torn_reads_; }
+  int went_backwards() const { return went_backwards_; }
+
+ private:
+  platform::SeqLock<Snapshot>* lock_;
+  int count_;
+  int torn_reads_;
+  int went_backwards_;
+
+  DISALLOW_COPY_AND_ASSIGN(SeqLockReaderThread);
+};
+
+TEST_F(SeqLockTest, ReadersSeeConsistentWrites) {
+  platform::SeqLock<Snapshot> lock;
+
+  SeqLockWriterThread writer(&lock, 200000);
+  SeqLockReaderThread reader1(&lock, 200000);
+  SeqLockReaderThread reader2(&lock, 200000);
+  platform::ThreadHandle handles[3];
+
+  ASSERT_TRUE(platform::Thread::Create(0, &reader1, &handles[0]));
+  ASSERT_TRUE(platform::Thread::Create(0, &writer, &handles[1]));
+  ASSERT_TRUE(platform::Thread::Create(0, &reader2, &handles[2]));
+  for (size_t n = 0; n < arraysize(handles); n++)
+    platform::Thread::Join(handles[n]);
+
+  EXPECT_EQ(0, reader1.torn_reads());
+  EXPECT_EQ(0, reader2.torn_reads());
+  EXPECT_EQ(0, reader1.went_backwards());
+  EXPECT_EQ(0, reader2.went_backwards());
+  EXPECT_EQ(200000, lock.Read().values[0]);
+}
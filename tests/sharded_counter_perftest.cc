@@ -0,0 +1,132 @@
+// Copyright (c) 2010 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+// Measures increment throughput of ShardedCounter against an int64 guarded by
+// a Lock and a single atomic int64, for 1 .. NumberOfProcessors() threads.
+// The sharded counter should scale linearly; the other two should not scale
+// at all.
+
+#include "simple-platform-lib/src/sharded_counter.h"
+
+#include <gtest/gtest.h>
+#include <stdio.h>
+
+#include "simple-platform-lib/src/atomics.h"
+#include "simple-platform-lib/src/lock.h"
+#include "simple-platform-lib/src/sys_info.h"
+#include "simple-platform-lib/src/thread.h"
+#include "simple-platform-lib/tests/perftimer.h"
+
+namespace {
+
+const int kMaxThreads = 64;
+const int kRunTimeMs = 200;
+
+class LockedCounter {
+ public:
+  LockedCounter() : value_(0) {}
+
+  void Increment() {
+    platform::AutoLock auto_lock(lock_);
+    value_++;
+  }
+
+ private:
+  platform::Lock lock_;
+  int64 value_;
+
+  DISALLOW_COPY_AND_ASSIGN(LockedCounter);
+};
+
+class AtomicCounter {
+ public:
+  AtomicCounter() {}
+
+  void Increment() { value_.FetchAdd(1, platform::MEMORY_ORDER_RELAXED); }
+
+ private:
+  platform::Atomic<int64> value_;
+
+  DISALLOW_COPY_AND_ASSIGN(AtomicCounter);
+};
+
+template <class CounterType>
+class IncrementLoopThread : public platform::Thread::Delegate {
+ public:
+  IncrementLoopThread() : counter_(NULL), stop_(NULL), increments_(0) {}
+
+  void Init(CounterType* counter, const platform::AtomicFlag* stop) {
+    counter_ = counter;
+    stop_ = stop;
+  }
+
+  virtual void ThreadMain() {
+    int64 increments = 0;
+    while (!stop_->IsSet(platform::MEMORY_ORDER_RELAXED)) {
+      for (int i = 0; i < 64; i++)
+        counter_->Increment();
+      increments += 64;
+    }
+    increments_ = increments;
+  }
+
+  int64 increments() const { return increments_; }
+
+ private:
+  CounterType* counter_;
+  const platform::AtomicFlag* stop_;
+  int64 increments_;
+
+  DISALLOW_COPY_AND_ASSIGN(IncrementLoopThread);
+};
+
+// Returns the total number of increments per second achieved by
+// |thread_count| threads.
+template <class CounterType>
+double MeasureIncrements(int thread_count) {
+  CounterType counter;
+  platform::AtomicFlag stop;
+  IncrementLoopThread<CounterType> threads[kMaxThreads];
+  platform::ThreadHandle handles[kMaxThreads];
+
+  platform::PerfTimer timer;
+  for (int i = 0; i < thread_count; i++) {
+    threads[i].Init(&counter, &stop);
+    EXPECT_TRUE(platform::Thread::Create(0, &threads[i], &handles[i]));
+  }
+  platform::Thread::Sleep(kRunTimeMs);
+  stop.Set();
+  int64 increments = 0;
+  for (int i = 0; i < thread_count; i++) {
+    platform::Thread::Join(handles[i]);
+    increments += threads[i].increments();
+  }
+  return increments / (timer.ElapsedMs() / 1000);
+}
+
+template <class CounterType>
+void RunScaling(const char* trace) {
+  int max_threads = platform::SysInfo::NumberOfProcessors();
+  if (max_threads > kMaxThreads)
+    max_threads = kMaxThreads;
+  for (int threads = 1; ; threads *= 2) {
+    if (threads > max_threads)
+      threads = max_threads;
+    char modifier[32];
+    snprintf(modifier, sizeof(modifier), "_%dthreads", threads);
+    platform::PrintPerfResult("increments_per_sec", modifier, trace,
+                              MeasureIncrements<CounterType>(threads),
+                              "increments/s");
+    if (threads == max_threads)
+      break;
+  }
+}
+
+}  // namespace
+
+TEST(ShardedCounterPerfTest, IncrementScaling) {
+  RunScaling<LockedCounter>("locked_int64");
+  RunScaling<AtomicCounter>("atomic_int64");
+  RunScaling<platform::ShardedCounter>("sharded_counter");
+}
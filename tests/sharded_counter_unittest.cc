@@ -0,0 +1,121 @@
+// Copyright (c) 2010 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "simple-platform-lib/src/sharded_counter.h"
+
+#include <gtest/gtest.h>
+
+#include <vector>
+
+#include "simple-platform-lib/src/thread.h"
+
+typedef testing::Test ShardedCounterTest;
+
+namespace {
+
+std::vector<int64> MakeLimits(int64 a, int64 b, int64 c) {
+  std::vector<int64> limits;
+  limits.push_back(a);
+  limits.push_back(b);
+  limits.push_back(c);
+  return limits;
+}
+
+}  // namespace
+
+// Test the single-threaded behavior -------------------------------------------
+
+TEST_F(ShardedCounterTest, Counter) {
+  platform::ShardedCounter counter;
+  EXPECT_EQ(0, counter.Value());
+  counter.Increment();
+  counter.Add(41);
+  EXPECT_EQ(42, counter.Value());
+  counter.Add(-2);
+  EXPECT_EQ(40, counter.Value());
+}
+
+TEST_F(ShardedCounterTest, HistogramBuckets) {
+  platform::ShardedHistogram histogram(MakeLimits(10, 100, 1000));
+  EXPECT_EQ(4u, histogram.bucket_count());
+  const int64 kSamples[] = { -5, 0, 9, 10, 99, 100, 999, 1000, 123456 };
+  for (size_t i = 0; i < arraysize(kSamples); i++)
+    histogram.Add(kSamples[i]);
+
+  std::vector<int64> counts;
+  histogram.GetCounts(&counts);
+  ASSERT_EQ(4u, counts.size());
+  EXPECT_EQ(3, counts[0]);
+  EXPECT_EQ(2, counts[1]);
+  EXPECT_EQ(2, counts[2]);
+  EXPECT_EQ(2, counts[3]);
+  EXPECT_EQ(9, histogram.TotalCount());
+  EXPECT_EQ(-5 + 0 + 9 + 10 + 99 + 100 + 999 + 1000 + 123456,
+            histogram.Sum());
+}
+
+TEST_F(ShardedCounterTest, HistogramWithoutLimits) {
+  platform::ShardedHistogram histogram((std::vector<int64>()));
+  EXPECT_EQ(1u, histogram.bucket_count());
+  histogram.Add(7);
+  histogram.Add(-7);
+  EXPECT_EQ(2, histogram.TotalCount());
+  EXPECT_EQ(0, histogram.Sum());
+}
+
+// Test that no update is lost when many threads update concurrently -----------
+
+namespace {
+
+const int kThreads = 8;
+const int kUpdatesPerThread = 50000;
+
+class UpdateThread : public platform::Thread::Delegate {
+ public:
+  UpdateThread(platform::ShardedCounter* counter,
+               platform::ShardedHistogram* histogram)
+      : counter_(counter), histogram_(histogram) {}
+
+  virtual void ThreadMain() {
+    for (int i = 0; i < kUpdatesPerThread; i++) {
+      counter_->Increment();
+      histogram_->Add(i % 4 * 10);
+      // Give the scheduler a chance to migrate us.
+      if (i % 10000 == 0)
+        platform::Thread::Yield();
+    }
+  }
+
+ private:
+  platform::ShardedCounter* counter_;
+  platform::ShardedHistogram* histogram_;
+
+  DISALLOW_COPY_AND_ASSIGN(UpdateThread);
+};
+
+}  // namespace
+
+TEST_F(ShardedCounterTest, ConcurrentUpdates) {
+  platform::ShardedCounter counter;
+  platform::ShardedHistogram histogram(MakeLimits(10, 20, 30));
+  UpdateThread* threads[kThreads];
+  platform::ThreadHandle handles[kThreads];
+  for (int i = 0; i < kThreads; i++) {
+    threads[i] = new UpdateThread(&counter, &histogram);
+    ASSERT_TRUE(platform::Thread::Create(0, threads[i], &handles[i]));
+  }
+  for (int i = 0; i < kThreads; i++) {
+    platform::Thread::Join(handles[i]);
+    delete threads[i];
+  }
+
+  EXPECT_EQ(kThreads * kUpdatesPerThread, counter.Value());
+  std::vector<int64> counts;
+  histogram.GetCounts(&counts);
+  ASSERT_EQ(4u, counts.size());
+  for (size_t bucket = 0; bucket < counts.size(); bucket++)
+    EXPECT_EQ(kThreads * kUpdatesPerThread / 4, counts[bucket]);
+  EXPECT_EQ(static_cast<int64>(kThreads) * kUpdatesPerThread / 4 * 60,
+            histogram.Sum());
+}
@@ -0,0 +1,305 @@
+// Copyright (c) 2010 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+// Throughput and latency of handing messages from one thread to another
+// through an SpscRing, against a Lock-protected std::deque.  The two threads
+// are pinned to different processors when there are at least two.
+
+#include "simple-platform-lib/src/spsc_ring.h"
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <deque>
+
+#include "simple-platform-lib/src/lock.h"
+#include "simple-platform-lib/src/sys_info.h"
+#include "simple-platform-lib/src/thread.h"
+#include "simple-platform-lib/tests/perftimer.h"
+
+namespace {
+
+const int kMessages = 4 * 1000 * 1000;
+const int kRoundTrips = 100 * 1000;
+const size_t kBatchSize = 32;
+
+typedef platform::SpscRing<int64, 1024> Ring;
+
+// The queue that SpscRing replaces.
+class LockedQueue {
+ public:
+  LockedQueue() {}
+
+  bool TryPush(int64 item) {
+    platform::AutoLock auto_lock(lock_);
+    items_.push_back(item);
+    return true;
+  }
+
+  size_t TryPushBatch(const int64* items, size_t count) {
+    platform::AutoLock auto_lock(lock_);
+    items_.insert(items_.end(), items, items + count);
+    return count;
+  }
+
+  bool TryPop(int64* item) {
+    platform::AutoLock auto_lock(lock_);
+    if (items_.empty())
+      return false;
+    *item = items_.front();
+    items_.pop_front();
+    return true;
+  }
+
+  size_t TryPopBatch(int64* items, size_t max_count) {
+    platform::AutoLock auto_lock(lock_);
+    size_t count = std::min(max_count, items_.size());
+    std::copy(items_.begin(), items_.begin() + count, items);
+    items_.erase(items_.begin(), items_.begin() + count);
+    return count;
+  }
+
+ private:
+  platform::Lock lock_;
+  std::deque<int64> items_;
+
+  DISALLOW_COPY_AND_ASSIGN(LockedQueue);
+};
+
+template <class Queue>
+void PushOne(Queue* queue, int64 item) {
+  platform::SpinWait spin_wait;
+  while (!queue->TryPush(item))
+    spin_wait.Once();
+}
+
+template <class Queue>
+int64 PopOne(Queue* queue) {
+  int64 item;
+  platform::SpinWait spin_wait;
+  while (!queue->TryPop(&item))
+    spin_wait.Once();
+  return item;
+}
+
+// SpscRing waits by itself, and in WAIT_BLOCK mode, sleeps.
+void PushOne(Ring* ring, int64 item) {
+  ring->Push(item);
+}
+
+int64 PopOne(Ring* ring) {
+  int64 item;
+  ring->Pop(&item);
+  return item;
+}
+
+// Pushes kMessages messages, one at a time or in batches.
+template <class Queue>
+class ProducerThread : public platform::Thread::Delegate {
+ public:
+  ProducerThread(Queue* queue, bool batch) : queue_(queue), batch_(batch) {}
+
+  virtual void ThreadMain() {
+    if (!batch_) {
+      for (int64 i = 0; i < kMessages; i++)
+        PushOne(queue_, i);
+      return;
+    }
+    int64 items[kBatchSize];
+    for (int64 i = 0; i < kMessages; i += kBatchSize) {
+      for (size_t j = 0; j < kBatchSize; j++)
+        items[j] = i + j;
+      size_t pushed = 0;
+      platform::SpinWait spin_wait;
+      while (pushed < kBatchSize) {
+        size_t count = queue_->TryPushBatch(items + pushed,
+                                            kBatchSize - pushed);
+        if (count == 0)
+          spin_wait.Once();
+        pushed += count;
+      }
+    }
+  }
+
+ private:
+  Queue* queue_;
+  bool batch_;
+
+  DISALLOW_COPY_AND_ASSIGN(ProducerThread);
+};
+
+// Pops kMessages messages and adds them up.
+template <class Queue>
+class ConsumerThread : public platform::Thread::Delegate {
+ public:
+  ConsumerThread(Queue* queue, bool batch)
+      : queue_(queue), batch_(batch), sum_(0) {}
+
+  virtual void ThreadMain() {
+    if (!batch_) {
+      for (int64 i = 0; i < kMessages; i++)
+        sum_ += PopOne(queue_);
+      return;
+    }
+    int64 items[kBatchSize];
+    int64 popped = 0;
+    platform::SpinWait spin_wait;
+    while (popped < kMessages) {
+      size_t count = queue_->TryPopBatch(items, kBatchSize);
+      if (count == 0) {
+        spin_wait.Once();
+        continue;
+      }
+      spin_wait.Reset();
+      for (size_t i = 0; i < count; i++)
+        sum_ += items[i];
+      popped += count;
+    }
+  }
+
+  int64 sum() const { return sum_; }
+
+ private:
+  Queue* queue_;
+  bool batch_;
+  int64 sum_;
+
+  DISALLOW_COPY_AND_ASSIGN(ConsumerThread);
+};
+
+// Bounces a message through |requests| and |responses| kRoundTrips times.
+template <class Queue>
+class EchoThread : public platform::Thread::Delegate {
+ public:
+  EchoThread(Queue* requests, Queue* responses)
+      : requests_(requests), responses_(responses) {}
+
+  virtual void ThreadMain() {
+    for (int i = 0; i < kRoundTrips; i++)
+      PushOne(responses_, PopOne(requests_));
+  }
+
+ private:
+  Queue* requests_;
+  Queue* responses_;
+
+  DISALLOW_COPY_AND_ASSIGN(EchoThread);
+};
+
+// Pins the two threads of a test to different processors, if possible.
+void GetOptions(platform::ThreadOptions* first,
+                platform::ThreadOptions* second) {
+#if defined(OS_LINUX)
+  if (platform::SysInfo::NumberOfProcessors() >= 2) {
+    first->cpus.push_back(0);
+    second->cpus.push_back(1);
+  }
+#endif
+}
+
+template <class Queue>
+void MeasureThroughput(Queue* queue, bool batch, const char* trace) {
+  ProducerThread<Queue> producer(queue, batch);
+  ConsumerThread<Queue> consumer(queue, batch);
+  platform::ThreadOptions producer_options, consumer_options;
+  GetOptions(&producer_options, &consumer_options);
+
+  platform::PerfTimer timer;
+  platform::ThreadHandle producer_handle, consumer_handle;
+  ASSERT_TRUE(platform::Thread::Create(consumer_options, &consumer,
+                                       &consumer_handle));
+  ASSERT_TRUE(platform::Thread::Create(producer_options, &producer,
+                                       &producer_handle));
+  platform::Thread::Join(producer_handle);
+  platform::Thread::Join(consumer_handle);
+  double seconds = timer.ElapsedNs() / 1e9;
+
+  EXPECT_EQ(static_cast<int64>(kMessages) * (kMessages - 1) / 2,
+            consumer.sum());
+  platform::PrintPerfResult("spsc_throughput", "", trace,
+                            kMessages / seconds, "messages/s");
+}
+
+template <class Queue>
+class PingThread : public platform::Thread::Delegate {
+ public:
+  PingThread(Queue* requests, Queue* responses)
+      : requests_(requests), responses_(responses), elapsed_ns_(0) {}
+
+  virtual void ThreadMain() {
+    platform::PerfTimer timer;
+    for (int i = 0; i < kRoundTrips; i++) {
+      PushOne(requests_, i);
+      PopOne(responses_);
+    }
+    elapsed_ns_ = timer.ElapsedNs();
+  }
+
+  int64 elapsed_ns() const { return elapsed_ns_; }
+
+ private:
+  Queue* requests_;
+  Queue* responses_;
+  int64 elapsed_ns_;
+
+  DISALLOW_COPY_AND_ASSIGN(PingThread);
+};
+
+template <class Queue>
+void MeasureLatency(Queue* requests, Queue* responses, const char* trace) {
+  PingThread<Queue> ping(requests, responses);
+  EchoThread<Queue> echo(requests, responses);
+  platform::ThreadOptions ping_options, echo_options;
+  GetOptions(&ping_options, &echo_options);
+
+  platform::ThreadHandle ping_handle, echo_handle;
+  ASSERT_TRUE(platform::Thread::Create(echo_options, &echo, &echo_handle));
+  ASSERT_TRUE(platform::Thread::Create(ping_options, &ping, &ping_handle));
+  platform::Thread::Join(ping_handle);
+  platform::Thread::Join(echo_handle);
+
+  // Half a round trip.
+  platform::PrintPerfResult("spsc_latency", "", trace,
+                            ping.elapsed_ns() / (2.0 * kRoundTrips), "ns");
+}
+
+}  // namespace
+
+TEST(SpscRingPerfTest, Throughput) {
+  {
+    LockedQueue queue;
+    MeasureThroughput(&queue, false, "locked_deque");
+  }
+  {
+    LockedQueue queue;
+    MeasureThroughput(&queue, true, "locked_deque_batch");
+  }
+  {
+    Ring ring;
+    MeasureThroughput(&ring, false, "ring");
+  }
+  {
+    Ring ring;
+    MeasureThroughput(&ring, true, "ring_batch");
+  }
+  {
+    Ring ring(Ring::WAIT_BLOCK);
+    MeasureThroughput(&ring, false, "ring_block");
+  }
+}
+
+TEST(SpscRingPerfTest, Latency) {
+  {
+    LockedQueue requests, responses;
+    MeasureLatency(&requests, &responses, "locked_deque");
+  }
+  {
+    Ring requests, responses;
+    MeasureLatency(&requests, &responses, "ring");
+  }
+  {
+    Ring requests(Ring::WAIT_BLOCK), responses(Ring::WAIT_BLOCK);
+    MeasureLatency(&requests, &responses, "ring_block");
+  }
+}
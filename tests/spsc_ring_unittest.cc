@@ -0,0 +1,141 @@
+// Copyright (c) 2010 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "simple-platform-lib/src/spsc_ring.h"
+
+#include <gtest/gtest.h>
+
+#include "simple-platform-lib/src/thread.h"
+
+typedef testing::Test SpscRingTest;
+
+// Test the single-threaded behavior -------------------------------------------
+
+TEST_F(SpscRingTest, FifoAndFull) {
+  platform::SpscRing<int, 4> ring;
+  EXPECT_EQ(4u, ring.capacity());
+  EXPECT_TRUE(ring.Empty());
+  int item = -1;
+  EXPECT_FALSE(ring.TryPop(&item));
+
+  for (int i = 0; i < 4; i++)
+    EXPECT_TRUE(ring.TryPush(i));
+  EXPECT_FALSE(ring.TryPush(4));
+  EXPECT_EQ(4u, ring.Size());
+
+  EXPECT_TRUE(ring.TryPop(&item));
+  EXPECT_EQ(0, item);
+  EXPECT_TRUE(ring.TryPush(4));
+  for (int i = 1; i <= 4; i++) {
+    EXPECT_TRUE(ring.TryPop(&item));
+    EXPECT_EQ(i, item);
+  }
+  EXPECT_FALSE(ring.TryPop(&item));
+  EXPECT_TRUE(ring.Empty());
+}
+
+TEST_F(SpscRingTest, Batch) {
+  platform::SpscRing<int, 8> ring;
+  int in[12];
+  for (int i = 0; i < 12; i++)
+    in[i] = i;
+  int out[12];
+  EXPECT_EQ(0u, ring.TryPopBatch(out, 12));
+
+  // Only as much as fits, wrapping around the end of the ring.
+  EXPECT_EQ(5u, ring.TryPushBatch(in, 5));
+  EXPECT_EQ(3u, ring.TryPopBatch(out, 3));
+  EXPECT_EQ(6u, ring.TryPushBatch(in + 5, 7));
+  EXPECT_EQ(0u, ring.TryPushBatch(in + 11, 1));
+  EXPECT_EQ(8u, ring.TryPopBatch(out + 3, 12));
+  for (int i = 0; i < 11; i++)
+    EXPECT_EQ(i, out[i]);
+  EXPECT_TRUE(ring.Empty());
+}
+
+// Test handing items from one thread to another -------------------------------
+
+namespace {
+
+const int kItems = 200000;
+
+typedef platform::SpscRing<int, 64> Ring;
+
+class ProducerThread : public platform::Thread::Delegate {
+ public:
+  ProducerThread(Ring* ring, bool batch) : ring_(ring), batch_(batch) {}
+
+  virtual void ThreadMain() {
+    int next = 0;
+    while (next < kItems) {
+      if (batch_) {
+        int items[16];
+        int count = 0;
+        for (; count < 16 && next + count < kItems; count++)
+          items[count] = next + count;
+        int pushed = static_cast<int>(ring_->TryPushBatch(items, count));
+        if (pushed == 0)
+          platform::Thread::Yield();
+        next += pushed;
+      } else {
+        ring_->Push(next++);
+      }
+      // Now and then, leave the consumer to empty the ring.
+      if (next % 50000 == 0)
+        platform::Thread::Sleep(5);
+    }
+  }
+
+ private:
+  Ring* ring_;
+  bool batch_;
+
+  DISALLOW_COPY_AND_ASSIGN(ProducerThread);
+};
+
+// Pops kItems items and checks that they come in order.
+void Consume(Ring* ring, bool batch) {
+  int expected = 0;
+  while (expected < kItems) {
+    if (batch) {
+      int items[16];
+      size_t count = ring->TryPopBatch(items, 16);
+      if (count == 0)
+        platform::Thread::Yield();
+      for (size_t i = 0; i < count; i++)
+        ASSERT_EQ(expected++, items[i]);
+    } else {
+      int item;
+      ring->Pop(&item);
+      ASSERT_EQ(expected++, item);
+    }
+    // Now and then, leave the producer to fill the ring.
+    if (expected % 70000 == 0)
+      platform::Thread::Sleep(5);
+  }
+}
+
+void Transfer(Ring::WaitMode wait_mode, bool batch) {
+  Ring ring(wait_mode);
+  ProducerThread producer(&ring, batch);
+  platform::ThreadHandle handle = platform::kNullThreadHandle;
+  ASSERT_TRUE(platform::Thread::Create(0, &producer, &handle));
+  Consume(&ring, batch);
+  platform::Thread::Join(handle);
+  EXPECT_TRUE(ring.Empty());
+}
+
+}  // namespace
+
+TEST_F(SpscRingTest, TransferSpin) {
+  Transfer(Ring::WAIT_SPIN, false);
+}
+
+TEST_F(SpscRingTest, TransferBlock) {
+  Transfer(Ring::WAIT_BLOCK, false);
+}
+
+TEST_F(SpscRingTest, TransferBatch) {
+  Transfer(Ring::WAIT_SPIN, true);
+}
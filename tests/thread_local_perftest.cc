@@ -0,0 +1,127 @@
+// Copyright (c) 2010 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+// Cost of reaching a per-thread object: through a ThreadLocalPointer in a
+// static slot, through pthread_getspecific() (what the slots past the static
+// ones use), and through a map from thread id under a Lock.
+//
+// And FreeListCache against malloc(), allocating and freeing blocks in
+// batches on several threads at once.
+
+#include "simple-platform-lib/src/thread_local.h"
+
+#include <pthread.h>
+#include <stdlib.h>
+
+#include <gtest/gtest.h>
+
+#include <map>
+#include <vector>
+
+#include "simple-platform-lib/src/free_list_cache.h"
+#include "simple-platform-lib/src/lock.h"
+#include "simple-platform-lib/src/thread.h"
+#include "simple-platform-lib/tests/perftimer.h"
+
+namespace {
+
+const int kLookups = 10 * 1000 * 1000;
+const int kThreads = 4;
+const int kBatches = 10 * 1000;
+const int kBatchSize = 64;
+const size_t kBlockSize = 64;
+
+// Allocates and frees |kBatches| batches of blocks.
+class AllocatingThread : public platform::Thread::Delegate {
+ public:
+  explicit AllocatingThread(platform::FreeListCache* cache) : cache_(cache) {}
+
+  virtual void ThreadMain() {
+    void* blocks[kBatchSize];
+    for (int i = 0; i < kBatches; i++) {
+      for (int j = 0; j < kBatchSize; j++)
+        blocks[j] = cache_ ? cache_->Allocate() : malloc(kBlockSize);
+      for (int j = 0; j < kBatchSize; j++) {
+        if (cache_)
+          cache_->Free(blocks[j]);
+        else
+          free(blocks[j]);
+      }
+    }
+  }
+
+ private:
+  // NULL for malloc().
+  platform::FreeListCache* cache_;
+
+  DISALLOW_COPY_AND_ASSIGN(AllocatingThread);
+};
+
+void MeasureAllocation(const char* trace, platform::FreeListCache* cache) {
+  std::vector<AllocatingThread*> threads;
+  std::vector<platform::ThreadHandle> handles(kThreads);
+  for (int i = 0; i < kThreads; i++)
+    threads.push_back(new AllocatingThread(cache));
+  platform::PerfTimer timer;
+  for (int i = 0; i < kThreads; i++)
+    ASSERT_TRUE(platform::Thread::Create(0, threads[i], &handles[i]));
+  for (int i = 0; i < kThreads; i++) {
+    platform::Thread::Join(handles[i]);
+    delete threads[i];
+  }
+  // An allocation and a free per block.
+  double ns = static_cast<double>(timer.ElapsedNs()) /
+              (static_cast<int64>(kThreads) * kBatches * kBatchSize);
+  platform::PrintPerfResult("alloc_free", "", trace, ns, "ns");
+}
+
+}  // namespace
+
+TEST(ThreadLocalPerfTest, Lookup) {
+  int value = 1;
+  int64 sum = 0;
+
+  platform::ThreadLocalPointer<int> pointer;
+  pointer.Set(&value);
+  // Read through a volatile, so that the lookup is not hoisted out of the
+  // loop.
+  platform::ThreadLocalPointer<int>* volatile pointer_ref = &pointer;
+  platform::PerfTimer timer;
+  for (int i = 0; i < kLookups; i++)
+    sum += *pointer_ref->Get();
+  platform::PrintPerfResult("thread_local_lookup", "", "static_slot",
+                            static_cast<double>(timer.ElapsedNs()) / kLookups,
+                            "ns");
+
+  pthread_key_t key;
+  ASSERT_EQ(0, pthread_key_create(&key, NULL));
+  pthread_setspecific(key, &value);
+  timer.Reset();
+  for (int i = 0; i < kLookups; i++)
+    sum += *static_cast<int*>(pthread_getspecific(key));
+  platform::PrintPerfResult("thread_local_lookup", "", "pthread_getspecific",
+                            static_cast<double>(timer.ElapsedNs()) / kLookups,
+                            "ns");
+  pthread_key_delete(key);
+
+  platform::Lock lock;
+  std::map<platform::ThreadId, int*> map;
+  map[platform::Thread::CurrentId()] = &value;
+  timer.Reset();
+  for (int i = 0; i < kLookups; i++) {
+    platform::AutoLock auto_lock(lock);
+    sum += *map[platform::Thread::CurrentId()];
+  }
+  platform::PrintPerfResult("thread_local_lookup", "", "locked_map",
+                            static_cast<double>(timer.ElapsedNs()) / kLookups,
+                            "ns");
+
+  EXPECT_EQ(3 * kLookups, sum);
+}
+
+TEST(ThreadLocalPerfTest, FreeListCache) {
+  MeasureAllocation("malloc", NULL);
+  platform::FreeListCache cache(kBlockSize, 2 * kBatchSize);
+  MeasureAllocation("free_list_cache", &cache);
+}
@@ -0,0 +1,186 @@
+// Copyright (c) 2010 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "simple-platform-lib/src/thread_local.h"
+
+#include <gtest/gtest.h>
+
+#include "simple-platform-lib/src/atomics.h"
+#include "simple-platform-lib/src/thread.h"
+
+using platform::ThreadLocal;
+using platform::ThreadLocalPointer;
+
+typedef testing::Test ThreadLocalTest;
+
+namespace {
+
+// Counts its live instances.
+class Counted {
+ public:
+  Counted() : value(0) { live_.FetchAdd(1); }
+  ~Counted() { live_.FetchAdd(-1); }
+
+  static int live() { return live_.Load(); }
+
+  int value;
+
+ private:
+  static platform::Atomic<int> live_;
+};
+
+platform::Atomic<int> Counted::live_;
+
+// Created by a static initializer, which may run before the thread-local
+// implementation's own.
+ThreadLocal<Counted>* g_static_local = new ThreadLocal<Counted>;
+
+// Sets the pointer to |value| and checks it reads back, from a thread of its
+// own.
+class PointerThread : public platform::Thread::Delegate {
+ public:
+  PointerThread(ThreadLocalPointer<int>* pointer, int* value)
+      : pointer_(pointer), value_(value), saw_null_(false),
+        read_back_(false) {}
+
+  virtual void ThreadMain() {
+    saw_null_ = pointer_->Get() == NULL;
+    pointer_->Set(value_);
+    platform::Thread::Yield();
+    read_back_ = pointer_->Get() == value_;
+  }
+
+  bool saw_null() const { return saw_null_; }
+  bool read_back() const { return read_back_; }
+
+ private:
+  ThreadLocalPointer<int>* pointer_;
+  int* value_;
+  bool saw_null_;
+  bool read_back_;
+
+  DISALLOW_COPY_AND_ASSIGN(PointerThread);
+};
+
+// Bumps its own Counted, and records whether another thread's showed
+// through.
+class CountedThread : public platform::Thread::Delegate {
+ public:
+  explicit CountedThread(ThreadLocal<Counted>* local)
+      : local_(local), fresh_(false) {}
+
+  virtual void ThreadMain() {
+    fresh_ = local_->GetIfExists() == NULL;
+    Counted* counted = local_->Get();
+    fresh_ = fresh_ && counted->value == 0;
+    counted->value++;
+    EXPECT_EQ(counted, local_->Get());
+  }
+
+  bool fresh() const { return fresh_; }
+
+ private:
+  ThreadLocal<Counted>* local_;
+  bool fresh_;
+
+  DISALLOW_COPY_AND_ASSIGN(CountedThread);
+};
+
+}  // namespace
+
+// Test that each thread sees its own pointer --------------------------------
+
+TEST_F(ThreadLocalTest, PointerPerThread) {
+  ThreadLocalPointer<int> pointer;
+  int main_value = 0;
+  EXPECT_EQ(NULL, pointer.Get());
+  pointer.Set(&main_value);
+
+  int values[4];
+  PointerThread* threads[4];
+  platform::ThreadHandle handles[4];
+  for (int i = 0; i < 4; i++) {
+    threads[i] = new PointerThread(&pointer, &values[i]);
+    ASSERT_TRUE(platform::Thread::Create(0, threads[i], &handles[i]));
+  }
+  for (int i = 0; i < 4; i++) {
+    platform::Thread::Join(handles[i]);
+    EXPECT_TRUE(threads[i]->saw_null());
+    EXPECT_TRUE(threads[i]->read_back());
+    delete threads[i];
+  }
+  EXPECT_EQ(&main_value, pointer.Get());
+  pointer.Set(NULL);
+  EXPECT_EQ(NULL, pointer.Get());
+}
+
+// Test that objects are created per thread and deleted at thread exit -------
+
+TEST_F(ThreadLocalTest, ObjectsDeletedAtThreadExit) {
+  int live_before = Counted::live();
+  {
+    ThreadLocal<Counted> local;
+    for (int i = 0; i < 3; i++) {
+      CountedThread thread(&local);
+      platform::ThreadHandle handle;
+      ASSERT_TRUE(platform::Thread::Create(0, &thread, &handle));
+      platform::Thread::Join(handle);
+      EXPECT_TRUE(thread.fresh());
+      EXPECT_EQ(live_before, Counted::live());
+    }
+
+    // The main thread's object lasts until the ThreadLocal goes.
+    EXPECT_EQ(NULL, local.GetIfExists());
+    local.Get()->value = 5;
+    EXPECT_EQ(5, local.Get()->value);
+    EXPECT_EQ(live_before + 1, Counted::live());
+  }
+  EXPECT_EQ(live_before, Counted::live());
+}
+
+// Test a thread-local created during static initialization ------------------
+
+TEST_F(ThreadLocalTest, CreatedByStaticInitializer) {
+  int live_before = Counted::live();
+  g_static_local->Get()->value = 1;
+
+  // Its slot is not handed out again...
+  ThreadLocal<Counted> local;
+  local.Get()->value = 2;
+  EXPECT_EQ(1, g_static_local->Get()->value);
+
+  // ...and its destructor still runs at thread exit.
+  CountedThread thread(g_static_local);
+  platform::ThreadHandle handle;
+  ASSERT_TRUE(platform::Thread::Create(0, &thread, &handle));
+  platform::Thread::Join(handle);
+  EXPECT_TRUE(thread.fresh());
+  EXPECT_EQ(live_before + 2, Counted::live());
+}
+
+// Test thread-locals past the static slots, which use pthread keys ----------
+
+TEST_F(ThreadLocalTest, PastStaticSlots) {
+  const int kCount = platform::internal::ThreadLocalPlatform::kStaticSlots + 8;
+  int live_before = Counted::live();
+  ThreadLocal<Counted>* locals[kCount];
+  for (int i = 0; i < kCount; i++) {
+    locals[i] = new ThreadLocal<Counted>;
+    locals[i]->Get()->value = i;
+  }
+  for (int i = 0; i < kCount; i++)
+    EXPECT_EQ(i, locals[i]->Get()->value);
+
+  // The keys' destructors run at thread exit too.
+  CountedThread thread(locals[kCount - 1]);
+  platform::ThreadHandle handle;
+  ASSERT_TRUE(platform::Thread::Create(0, &thread, &handle));
+  platform::Thread::Join(handle);
+  EXPECT_TRUE(thread.fresh());
+  EXPECT_EQ(live_before + kCount, Counted::live());
+
+  for (int i = 0; i < kCount; i++)
+    delete locals[i];
+  EXPECT_EQ(live_before, Counted::live());
+}
@@ -0,0 +1,193 @@
+// Copyright (c) 2010 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+// Cost of Thread::CurrentId(), which debug builds of Lock call on every
+// acquisition, against the system call it caches on Linux.
+//
+// Also the round-trip latency of two threads bouncing a cache line between
+// each other, unpinned and pinned with ThreadOptions: to the same processor,
+// to two processors of one NUMA node, and to processors of different nodes,
+// as far as the machine allows.
+//
+// And the cost of creating and joining a thread, with a stack from the
+// system against one from a StackPool (mapped ahead of time, with its top
+// pages faulted in), in time and in page faults per thread.
+
+#include "simple-platform-lib/src/thread.h"
+
+#include <gtest/gtest.h>
+
+#include <vector>
+
+#include <sys/resource.h>
+
+#if defined(OS_LINUX)
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+#include "simple-platform-lib/src/atomics.h"
+#include "simple-platform-lib/src/spin_wait.h"
+#include "simple-platform-lib/src/stack_pool.h"
+#include "simple-platform-lib/src/sys_info.h"
+#include "simple-platform-lib/tests/perftimer.h"
+
+namespace {
+
+const int kIterations = 1000 * 1000;
+const int kRoundTrips = 100 * 1000;
+const int kThreadsCreated = 10 * 1000;
+const int kChurnBurst = 16;
+const size_t kChurnStackSize = 256 * 1024;
+
+// Each player waits for |turn_| to be its own number, then hands it over.
+class PingPongThread : public platform::Thread::Delegate {
+ public:
+  PingPongThread(platform::Atomic<int32>* turn, int32 me)
+      : turn_(turn), me_(me), elapsed_ns_(0) {}
+
+  virtual void ThreadMain() {
+    platform::PerfTimer timer;
+    for (int i = 0; i < kRoundTrips; i++) {
+      platform::SpinWait spin_wait;
+      while (turn_->Load(platform::MEMORY_ORDER_ACQUIRE) != me_)
+        spin_wait.Once();
+      turn_->Store(1 - me_, platform::MEMORY_ORDER_RELEASE);
+    }
+    elapsed_ns_ = timer.ElapsedNs();
+  }
+
+  int64 elapsed_ns() const { return elapsed_ns_; }
+
+ private:
+  platform::Atomic<int32>* turn_;
+  int32 me_;
+  int64 elapsed_ns_;
+
+  DISALLOW_COPY_AND_ASSIGN(PingPongThread);
+};
+
+// Plays ping-pong between a thread on |cpu0| and one on |cpu1|; -1 leaves a
+// thread unpinned.
+void MeasurePingPong(const char* trace, int cpu0, int cpu1) {
+  // On a cache line of its own.
+  platform::CacheAligned<platform::Atomic<int32> > turn;
+
+  PingPongThread ping(&turn.value, 0);
+  PingPongThread pong(&turn.value, 1);
+  platform::ThreadOptions ping_options;
+  platform::ThreadOptions pong_options;
+  if (cpu0 >= 0)
+    ping_options.cpus.push_back(cpu0);
+  if (cpu1 >= 0)
+    pong_options.cpus.push_back(cpu1);
+
+  platform::ThreadHandle ping_handle, pong_handle;
+  ASSERT_TRUE(platform::Thread::Create(ping_options, &ping, &ping_handle));
+  ASSERT_TRUE(platform::Thread::Create(pong_options, &pong, &pong_handle));
+  platform::Thread::Join(ping_handle);
+  platform::Thread::Join(pong_handle);
+
+  platform::PrintPerfResult("ping_pong_round_trip", "", trace,
+                            static_cast<double>(ping.elapsed_ns()) /
+                                kRoundTrips, "ns");
+}
+
+// Touches a few pages of its stack, as a short-lived worker would.
+class ChurnThread : public platform::Thread::Delegate {
+ public:
+  ChurnThread() {}
+
+  virtual void ThreadMain() {
+    volatile char buffer[16 * 1024];
+    for (size_t i = 0; i < sizeof(buffer); i += 1024)
+      buffer[i] = 0;
+  }
+
+ private:
+  DISALLOW_COPY_AND_ASSIGN(ChurnThread);
+};
+
+int64 MinorFaults() {
+  struct rusage usage;
+  getrusage(RUSAGE_SELF, &usage);
+  return usage.ru_minflt;
+}
+
+// Creates and joins |kThreadsCreated| threads, |kChurnBurst| at a time.
+void MeasureChurn(const char* trace, const platform::ThreadOptions& options) {
+  ChurnThread delegate;
+  platform::ThreadHandle handles[kChurnBurst];
+  int64 faults = MinorFaults();
+  platform::PerfTimer timer;
+  for (int i = 0; i < kThreadsCreated / kChurnBurst; i++) {
+    for (int j = 0; j < kChurnBurst; j++)
+      ASSERT_TRUE(platform::Thread::Create(options, &delegate, &handles[j]));
+    for (int j = 0; j < kChurnBurst; j++)
+      platform::Thread::Join(handles[j]);
+  }
+  double ns = static_cast<double>(timer.ElapsedNs()) / kThreadsCreated;
+  faults = MinorFaults() - faults;
+  platform::PrintPerfResult("thread_churn", "", trace, ns, "ns");
+  platform::PrintPerfResult("thread_churn_faults", "", trace,
+                            static_cast<double>(faults) / kThreadsCreated,
+                            "faults");
+}
+
+}  // namespace
+
+TEST(ThreadPerfTest, CurrentId) {
+  platform::ThreadId sum = 0;
+  platform::PerfTimer timer;
+  for (int i = 0; i < kIterations; i++)
+    sum += platform::Thread::CurrentId();
+  platform::PrintPerfResult("current_id", "", "cached",
+                            static_cast<double>(timer.ElapsedNs()) /
+                                kIterations, "ns");
+
+#if defined(OS_LINUX)
+  timer.Reset();
+  for (int i = 0; i < kIterations; i++)
+    sum -= syscall(__NR_gettid);
+  platform::PrintPerfResult("current_id", "", "gettid",
+                            static_cast<double>(timer.ElapsedNs()) /
+                                kIterations, "ns");
+  EXPECT_EQ(0, sum);
+#endif
+}
+
+TEST(ThreadPerfTest, PingPong) {
+  MeasurePingPong("unpinned", -1, -1);
+
+#if defined(OS_LINUX)
+  std::vector<int> node0_cpus;
+  ASSERT_TRUE(platform::SysInfo::GetNumaNodeCpus(0, &node0_cpus));
+  if (node0_cpus.empty())
+    return;
+  MeasurePingPong("same_cpu", node0_cpus[0], node0_cpus[0]);
+  if (node0_cpus.size() >= 2)
+    MeasurePingPong("same_node", node0_cpus[0], node0_cpus.back());
+
+  for (int node = 1; node < platform::SysInfo::NumberOfNumaNodes(); node++) {
+    std::vector<int> node_cpus;
+    if (platform::SysInfo::GetNumaNodeCpus(node, &node_cpus) &&
+        !node_cpus.empty()) {
+      MeasurePingPong("cross_node", node0_cpus[0], node_cpus[0]);
+      break;
+    }
+  }
+#endif
+}
+
+TEST(ThreadPerfTest, CreateJoin) {
+  platform::ThreadOptions options;
+  options.stack_size = kChurnStackSize;
+  MeasureChurn("system_stack", options);
+
+  platform::StackPool pool(kChurnStackSize, kChurnBurst);
+  pool.set_prefault_size(32 * 1024);
+  ASSERT_TRUE(pool.Reserve(kChurnBurst));
+  options.stack_pool = &pool;
+  MeasureChurn("pooled_stack", options);
+}
@@ -0,0 +1,80 @@
+// Copyright (c) 2010 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+// Compares running small tasks on a ThreadPool with creating and joining a
+// thread per task, the way ThreadTest does.  Also reports how long it takes
+// to start and shut down a pool.
+
+#include "simple-platform-lib/src/thread_pool.h"
+
+#include <gtest/gtest.h>
+
+#include "simple-platform-lib/src/thread.h"
+#include "simple-platform-lib/tests/perftimer.h"
+
+namespace {
+
+const int kPoolThreads = 4;
+const int kPoolTasks = 100000;
+const int kThreadTasks = 1000;
+const int kStartIterations = 100;
+
+volatile int g_sink = 0;
+
+void DoWork() {
+  for (int i = 0; i < 100; i++)
+    g_sink = g_sink + i;
+}
+
+class WorkTask : public platform::Task {
+ public:
+  WorkTask() {}
+  virtual void Run() { DoWork(); }
+
+ private:
+  DISALLOW_COPY_AND_ASSIGN(WorkTask);
+};
+
+class WorkThread : public platform::Thread::Delegate {
+ public:
+  WorkThread() {}
+  virtual void ThreadMain() { DoWork(); }
+
+ private:
+  DISALLOW_COPY_AND_ASSIGN(WorkThread);
+};
+
+}  // namespace
+
+TEST(ThreadPoolPerfTest, StartAndShutdown) {
+  platform::PerfTimer timer;
+  for (int i = 0; i < kStartIterations; i++) {
+    platform::ThreadPool pool(kPoolThreads);
+    EXPECT_TRUE(pool.Start());
+    pool.Shutdown(platform::ThreadPool::RUN_PENDING_TASKS);
+  }
+  platform::PrintPerfResult("start_shutdown", "_4threads", "thread_pool",
+                            timer.ElapsedMs() * 1000 / kStartIterations, "us");
+}
+
+TEST(ThreadPoolPerfTest, TaskOverhead) {
+  platform::ThreadPool pool(kPoolThreads);
+  EXPECT_TRUE(pool.Start());
+  platform::PerfTimer timer;
+  for (int i = 0; i < kPoolTasks; i++)
+    pool.PostTask(new WorkTask);
+  pool.WaitForIdle();
+  platform::PrintPerfResult("per_task", "", "thread_pool",
+                            timer.ElapsedMs() * 1000 / kPoolTasks, "us");
+
+  timer.Reset();
+  for (int i = 0; i < kThreadTasks; i++) {
+    WorkThread thread;
+    platform::ThreadHandle handle;
+    EXPECT_TRUE(platform::Thread::Create(0, &thread, &handle));
+    platform::Thread::Join(handle);
+  }
+  platform::PrintPerfResult("per_task", "", "thread_per_task",
+                            timer.ElapsedMs() * 1000 / kThreadTasks, "us");
+}
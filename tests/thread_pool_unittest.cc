@@ -0,0 +1,149 @@
+// Copyright (c) 2010 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "simple-platform-lib/src/thread_pool.h"
+
+#include <gtest/gtest.h>
+
+#include "simple-platform-lib/src/lock.h"
+#include "simple-platform-lib/src/thread.h"
+
+typedef testing::Test ThreadPoolTest;
+
+namespace {
+
+// Counts how many tasks ran and how many were deleted.
+struct TaskCounts {
+  TaskCounts() : ran(0), deleted(0) {}
+
+  platform::Lock lock;
+  int ran;
+  int deleted;
+};
+
+class CountingTask : public platform::Task {
+ public:
+  CountingTask(TaskCounts* counts, int sleep_ms)
+      : counts_(counts), sleep_ms_(sleep_ms) {}
+
+  virtual ~CountingTask() {
+    platform::AutoLock auto_lock(counts_->lock);
+    counts_->deleted++;
+  }
+
+  virtual void Run() {
+    if (sleep_ms_ > 0)
+      platform::Thread::Sleep(sleep_ms_);
+    platform::AutoLock auto_lock(counts_->lock);
+    counts_->ran++;
+  }
+
+ private:
+  TaskCounts* counts_;
+  int sleep_ms_;
+
+  DISALLOW_COPY_AND_ASSIGN(CountingTask);
+};
+
+// Posts |count| CountingTasks from within the pool.
+class PostingTask : public platform::Task {
+ public:
+  PostingTask(platform::ThreadPool* pool, TaskCounts* counts, int count)
+      : pool_(pool), counts_(counts), count_(count) {}
+
+  virtual void Run() {
+    for (int i = 0; i < count_; i++)
+      pool_->PostTask(new CountingTask(counts_, 0));
+  }
+
+ private:
+  platform::ThreadPool* pool_;
+  TaskCounts* counts_;
+  int count_;
+
+  DISALLOW_COPY_AND_ASSIGN(PostingTask);
+};
+
+}  // namespace
+
+// Test that every posted task runs and is deleted -----------------------------
+
+TEST_F(ThreadPoolTest, RunsAllTasks) {
+  TaskCounts counts;
+  platform::ThreadPool pool(4);
+  ASSERT_TRUE(pool.Start());
+  for (int i = 0; i < 1000; i++)
+    EXPECT_TRUE(pool.PostTask(new CountingTask(&counts, 0)));
+  pool.WaitForIdle();
+  EXPECT_EQ(1000, counts.ran);
+  EXPECT_EQ(1000, counts.deleted);
+
+  // The pool can go idle more than once, and tasks can post tasks.
+  pool.PostTask(new PostingTask(&pool, &counts, 100));
+  pool.WaitForIdle();
+  EXPECT_EQ(1100, counts.ran);
+  EXPECT_EQ(1100, counts.deleted);
+
+  pool.Shutdown(platform::ThreadPool::RUN_PENDING_TASKS);
+}
+
+TEST_F(ThreadPoolTest, PostBeforeStart) {
+  TaskCounts counts;
+  platform::ThreadPool pool(2);
+  for (int i = 0; i < 10; i++)
+    pool.PostTask(new CountingTask(&counts, 0));
+  ASSERT_TRUE(pool.Start());
+  pool.WaitForIdle();
+  EXPECT_EQ(10, counts.ran);
+}
+
+// Test the two shutdown behaviors ---------------------------------------------
+
+TEST_F(ThreadPoolTest, ShutdownRunsPendingTasks) {
+  TaskCounts counts;
+  {
+    platform::ThreadPool pool(2);
+    ASSERT_TRUE(pool.Start());
+    for (int i = 0; i < 20; i++)
+      pool.PostTask(new CountingTask(&counts, 1));
+    // The destructor drains the queue.
+  }
+  EXPECT_EQ(20, counts.ran);
+  EXPECT_EQ(20, counts.deleted);
+}
+
+TEST_F(ThreadPoolTest, ShutdownCancelsPendingTasks) {
+  TaskCounts counts;
+  platform::ThreadPool pool(1);
+  ASSERT_TRUE(pool.Start());
+  for (int i = 0; i < 20; i++)
+    pool.PostTask(new CountingTask(&counts, 10));
+  pool.Shutdown(platform::ThreadPool::CANCEL_PENDING_TASKS);
+
+  // At most the task that was running when Shutdown() was called has run.
+  EXPECT_LE(counts.ran, 1);
+  EXPECT_EQ(20, counts.deleted);
+
+  EXPECT_FALSE(pool.PostTask(new CountingTask(&counts, 0)));
+  EXPECT_EQ(21, counts.deleted);
+  EXPECT_LE(counts.ran, 1);
+}
+
+TEST_F(ThreadPoolTest, ShutdownWithoutStart) {
+  TaskCounts counts;
+  platform::ThreadPool pool(2);
+  pool.PostTask(new CountingTask(&counts, 0));
+  pool.Shutdown(platform::ThreadPool::RUN_PENDING_TASKS);
+  EXPECT_EQ(1, counts.ran);
+  EXPECT_EQ(1, counts.deleted);
+}
+
+TEST_F(ThreadPoolTest, CancelWithoutStart) {
+  TaskCounts counts;
+  platform::ThreadPool pool(2);
+  pool.PostTask(new CountingTask(&counts, 0));
+  pool.Shutdown(platform::ThreadPool::CANCEL_PENDING_TASKS);
+  EXPECT_EQ(0, counts.ran);
+  EXPECT_EQ(1, counts.deleted);
+}
@@ -4,24 +4,42 @@
 
 #include "simple-platform-lib/src/thread.h"
 
+#include <limits.h>
+#include <stdint.h>
+
 #include <gtest/gtest.h>
 
+#if defined(OS_LINUX)
+#include <sched.h>
+#include <sys/prctl.h>
+#include <sys/syscall.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
+#include <string>
+#include <vector>
+
+#include "simple-platform-lib/src/atomics.h"
+#include "simple-platform-lib/src/stack_pool.h"
+#include "simple-platform-lib/src/sys_info.h"
+
 typedef testing::Test ThreadTest;
 
 // Trivial test that thread runs and doesn't crash on create and join ----------
 
 class TrivialThread : public platform::Thread::Delegate {
  public:
-  TrivialThread() : did_run_(false) {}
+  TrivialThread() {}
 
   virtual void ThreadMain() {
-    did_run_ = true;
+    did_run_.Set();
   }
 
-  bool did_run() const { return did_run_; }
+  bool did_run() const { return did_run_.IsSet(); }
 
  private:
-  bool did_run_;
+  platform::AtomicFlag did_run_;
 
   DISALLOW_COPY_AND_ASSIGN(TrivialThread);
 };
@@ -103,3 +121,195 @@ TEST_F(ThreadTest, FunctionTimesTen) {
     EXPECT_NE(thread[n].thread_id(), main_thread_id);
   }
 }
+
+#if defined(OS_LINUX)
+
+// Test that the cached thread id is right, including after a fork -------------
+
+TEST_F(ThreadTest, CurrentIdMatchesKernel) {
+  EXPECT_EQ(static_cast<pid_t>(syscall(__NR_gettid)),
+            platform::Thread::CurrentId());
+  EXPECT_EQ(platform::Thread::CurrentId(), platform::Thread::CurrentId());
+}
+
+TEST_F(ThreadTest, CurrentIdAfterFork) {
+  platform::ThreadId parent_id = platform::Thread::CurrentId();
+  pid_t child = fork();
+  ASSERT_NE(-1, child);
+  if (child == 0) {
+    // The forking thread is the child's only thread, so its id is the pid.
+    platform::ThreadId child_id = platform::Thread::CurrentId();
+    _exit(child_id == getpid() && child_id != parent_id ? 0 : 1);
+  }
+  int status = 0;
+  ASSERT_EQ(child, waitpid(child, &status, 0));
+  ASSERT_TRUE(WIFEXITED(status));
+  EXPECT_EQ(0, WEXITSTATUS(status));
+}
+
+#endif  // OS_LINUX
+
+// Test of thread options ------------------------------------------------------
+
+namespace {
+
+// Records what the thread finds out about its own placement and scheduling.
+class OptionsTestThread : public platform::Thread::Delegate {
+ public:
+  OptionsTestThread() : policy_(-1) {}
+
+  virtual void ThreadMain() {
+#if defined(OS_LINUX)
+    char name[16] = {0};
+    prctl(PR_GET_NAME, name, 0, 0, 0);
+    name_ = name;
+
+    cpu_set_t cpu_set;
+    CPU_ZERO(&cpu_set);
+    sched_getaffinity(0, sizeof(cpu_set), &cpu_set);
+    for (int cpu = 0; cpu < CPU_SETSIZE; cpu++) {
+      if (CPU_ISSET(cpu, &cpu_set))
+        cpus_.push_back(cpu);
+    }
+
+    policy_ = sched_getscheduler(0);
+#endif
+  }
+
+  const std::string& name() const { return name_; }
+  const std::vector<int>& cpus() const { return cpus_; }
+  int policy() const { return policy_; }
+
+ private:
+  std::string name_;
+  std::vector<int> cpus_;
+  int policy_;
+
+  DISALLOW_COPY_AND_ASSIGN(OptionsTestThread);
+};
+
+}  // namespace
+
+TEST_F(ThreadTest, CreateWithDefaultOptions) {
+  OptionsTestThread thread;
+  platform::ThreadHandle handle = platform::kNullThreadHandle;
+  ASSERT_TRUE(platform::Thread::Create(platform::ThreadOptions(), &thread,
+                                       &handle));
+  platform::Thread::Join(handle);
+}
+
+TEST_F(ThreadTest, CreateWithInvalidOptions) {
+  OptionsTestThread thread;
+  platform::ThreadHandle handle = platform::kNullThreadHandle;
+
+  platform::ThreadOptions bad_cpu;
+  bad_cpu.cpus.push_back(-1);
+  EXPECT_FALSE(platform::Thread::Create(bad_cpu, &thread, &handle));
+
+  platform::ThreadOptions bad_node;
+  bad_node.numa_node = platform::SysInfo::NumberOfNumaNodes();
+  EXPECT_FALSE(platform::Thread::Create(bad_node, &thread, &handle));
+}
+
+// Test running threads on stacks from a StackPool --------------------------
+
+namespace {
+
+// Records where its stack is.
+class StackAddressThread : public platform::Thread::Delegate {
+ public:
+  StackAddressThread() : stack_address_(0) {}
+
+  virtual void ThreadMain() {
+    char local = 0;
+    stack_address_ = reinterpret_cast<uintptr_t>(&local);
+  }
+
+  uintptr_t stack_address() const { return stack_address_; }
+
+ private:
+  uintptr_t stack_address_;
+
+  DISALLOW_COPY_AND_ASSIGN(StackAddressThread);
+};
+
+}  // namespace
+
+TEST_F(ThreadTest, CreateWithStackPool) {
+  platform::StackPool pool(256 * 1024, 1);
+  pool.set_prefault_size(16 * 1024);
+  ASSERT_TRUE(pool.Reserve(1));
+
+  platform::ThreadOptions options;
+  options.stack_pool = &pool;
+  for (int i = 0; i < 3; i++) {
+    StackAddressThread thread;
+    platform::ThreadHandle handle = platform::kNullThreadHandle;
+    ASSERT_TRUE(platform::Thread::Create(options, &thread, &handle));
+    platform::Thread::Join(handle);
+
+    // Join() gave the thread's stack back to the pool.
+    platform::Stack stack;
+    ASSERT_TRUE(pool.Allocate(&stack));
+    uintptr_t base = reinterpret_cast<uintptr_t>(stack.base);
+    EXPECT_GE(thread.stack_address(), base);
+    EXPECT_LT(thread.stack_address(), base + stack.size);
+    pool.Free(stack);
+  }
+}
+
+TEST_F(ThreadTest, CreateWithTooSmallStackPool) {
+  platform::StackPool pool(1, 1);  // A page.
+  if (pool.stack_size() >= static_cast<size_t>(PTHREAD_STACK_MIN))
+    return;
+  platform::ThreadOptions options;
+  options.stack_pool = &pool;
+  StackAddressThread thread;
+  platform::ThreadHandle handle = platform::kNullThreadHandle;
+  EXPECT_FALSE(platform::Thread::Create(options, &thread, &handle));
+}
+
+#if defined(OS_LINUX)
+
+TEST_F(ThreadTest, CreateWithOptions) {
+  platform::ThreadOptions options;
+  options.name = "options_test";
+  options.cpus.push_back(0);
+  options.scheduling_policy = platform::ThreadOptions::SCHEDULING_BATCH;
+
+  OptionsTestThread thread;
+  platform::ThreadHandle handle = platform::kNullThreadHandle;
+  ASSERT_TRUE(platform::Thread::Create(options, &thread, &handle));
+  platform::Thread::Join(handle);
+  EXPECT_EQ("options_test", thread.name());
+  EXPECT_EQ(options.cpus, thread.cpus());
+  EXPECT_EQ(SCHED_BATCH, thread.policy());
+}
+
+TEST_F(ThreadTest, CreateOnNumaNode) {
+  std::vector<int> node_cpus;
+  ASSERT_TRUE(platform::SysInfo::GetNumaNodeCpus(0, &node_cpus));
+  ASSERT_FALSE(node_cpus.empty());
+
+  platform::ThreadOptions options;
+  options.numa_node = 0;
+  OptionsTestThread thread;
+  platform::ThreadHandle handle = platform::kNullThreadHandle;
+  ASSERT_TRUE(platform::Thread::Create(options, &thread, &handle));
+  platform::Thread::Join(handle);
+  EXPECT_EQ(node_cpus, thread.cpus());
+}
+
+TEST_F(ThreadTest, SetCurrentAffinity) {
+  cpu_set_t original;
+  ASSERT_EQ(0, sched_getaffinity(0, sizeof(original), &original));
+
+  std::vector<int> cpus(1, 0);
+  ASSERT_TRUE(platform::Thread::SetCurrentAffinity(cpus));
+  EXPECT_EQ(0, sched_getcpu());
+  EXPECT_FALSE(platform::Thread::SetCurrentAffinity(std::vector<int>()));
+
+  ASSERT_EQ(0, sched_setaffinity(0, sizeof(original), &original));
+}
+
+#endif  // OS_LINUX
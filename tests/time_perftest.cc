@@ -0,0 +1,66 @@
+// Copyright (c) 2010 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+// Measures the cost of reading each clock.
+
+#include "simple-platform-lib/src/time.h"
+
+#include <gtest/gtest.h>
+#include <sys/time.h>
+#include <time.h>
+
+#include "simple-platform-lib/tests/perftimer.h"
+
+namespace {
+
+const int kIterations = 2 * 1000 * 1000;
+
+int64 ReadNow() {
+  return platform::TimeTicks::Now().ToInternalValue();
+}
+
+int64 ReadFastNow() {
+  return platform::TimeTicks::FastNow().ToInternalValue();
+}
+
+template <clockid_t kClock>
+int64 ReadClockGettime() {
+  struct timespec now;
+  clock_gettime(kClock, &now);
+  return now.tv_nsec;
+}
+
+int64 ReadGettimeofday() {
+  struct timeval now;
+  gettimeofday(&now, NULL);
+  return now.tv_usec;
+}
+
+void MeasureClock(int64 (*read_clock)(), const char* trace) {
+  // Warm up, and get FastNow()'s calibration out of the way.
+  int64 sum = read_clock();
+  platform::PerfTimer timer;
+  for (int i = 0; i < kIterations; i++)
+    sum += read_clock();
+  double ns_per_call = static_cast<double>(timer.ElapsedNs()) / kIterations;
+  EXPECT_NE(0, sum);
+  platform::PrintPerfResult("clock_read", "", trace, ns_per_call, "ns");
+}
+
+}  // namespace
+
+TEST(TimePerfTest, ClockRead) {
+  MeasureClock(ReadNow, "time_ticks_now");
+  MeasureClock(ReadFastNow,
+               platform::TimeTicks::IsFastNowTscBased() ?
+                   "time_ticks_fast_now_tsc" : "time_ticks_fast_now_no_tsc");
+  MeasureClock(ReadClockGettime<CLOCK_MONOTONIC>, "clock_monotonic");
+#if defined(CLOCK_MONOTONIC_COARSE)
+  // Only as fine as the scheduler tick; for comparison.
+  MeasureClock(ReadClockGettime<CLOCK_MONOTONIC_COARSE>,
+               "clock_monotonic_coarse");
+#endif
+  MeasureClock(ReadClockGettime<CLOCK_REALTIME>, "clock_realtime");
+  MeasureClock(ReadGettimeofday, "gettimeofday");
+}
@@ -0,0 +1,110 @@
+// Copyright (c) 2010 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "simple-platform-lib/src/time.h"
+
+#include <gtest/gtest.h>
+
+#include "simple-platform-lib/src/thread.h"
+
+using platform::TimeDelta;
+using platform::TimeTicks;
+
+typedef testing::Test TimeTest;
+
+// Test TimeDelta conversions and arithmetic -----------------------------------
+
+TEST_F(TimeTest, DeltaConversions) {
+  EXPECT_EQ(3000000000LL, TimeDelta::FromSeconds(3).InNanoseconds());
+  EXPECT_EQ(3000, TimeDelta::FromMilliseconds(3).InMicroseconds());
+  EXPECT_EQ(3000, TimeDelta::FromMicroseconds(3).InNanoseconds());
+  EXPECT_EQ(1, TimeDelta::FromMilliseconds(1999).InSeconds());
+  EXPECT_EQ(-1, TimeDelta::FromMicroseconds(-1999).InMilliseconds());
+  EXPECT_DOUBLE_EQ(1.5, TimeDelta::FromMilliseconds(1500).InSecondsF());
+  EXPECT_EQ(0, TimeDelta().InNanoseconds());
+}
+
+TEST_F(TimeTest, DeltaArithmetic) {
+  TimeDelta a = TimeDelta::FromMilliseconds(5);
+  TimeDelta b = TimeDelta::FromMicroseconds(250);
+  EXPECT_EQ(5250, (a + b).InMicroseconds());
+  EXPECT_EQ(4750, (a - b).InMicroseconds());
+  EXPECT_EQ(-5, (-a).InMilliseconds());
+  EXPECT_EQ(20, (a * 4).InMilliseconds());
+  EXPECT_EQ(1250, (a / 4).InMicroseconds());
+  a += b;
+  EXPECT_EQ(5250, a.InMicroseconds());
+  a -= b;
+  EXPECT_EQ(5, a.InMilliseconds());
+  EXPECT_TRUE(b < a);
+  EXPECT_TRUE(a > b);
+  EXPECT_TRUE(a >= a);
+  EXPECT_TRUE(a == TimeDelta::FromMicroseconds(5000));
+  EXPECT_TRUE(a != b);
+}
+
+TEST_F(TimeTest, DeltaToTimeSpec) {
+  struct timespec spec = TimeDelta::FromMicroseconds(2500001).ToTimeSpec();
+  EXPECT_EQ(2, spec.tv_sec);
+  EXPECT_EQ(500001000, spec.tv_nsec);
+  spec = TimeDelta::FromSeconds(-1).ToTimeSpec();
+  EXPECT_EQ(0, spec.tv_sec);
+  EXPECT_EQ(0, spec.tv_nsec);
+}
+
+// Test the clocks -------------------------------------------------------------
+
+TEST_F(TimeTest, NowIsMonotonic) {
+  TimeTicks previous = TimeTicks::Now();
+  EXPECT_FALSE(previous.is_null());
+  for (int i = 0; i < 1000; i++) {
+    TimeTicks now = TimeTicks::Now();
+    EXPECT_GE(now, previous);
+    previous = now;
+  }
+  EXPECT_TRUE(TimeTicks().is_null());
+  EXPECT_EQ(previous, TimeTicks::FromInternalValue(
+                          previous.ToInternalValue()));
+}
+
+TEST_F(TimeTest, FastNowTracksNow) {
+  TimeTicks fast_start = TimeTicks::FastNow();
+  TimeTicks start = TimeTicks::Now();
+  platform::Thread::Sleep(50);
+  TimeTicks fast_end = TimeTicks::FastNow();
+  TimeTicks end = TimeTicks::Now();
+
+  // The two clocks share an origin, and measure the same interval to well
+  // within a percent.
+  TimeDelta offset = fast_start - start;
+  EXPECT_LT(offset, TimeDelta::FromMilliseconds(1));
+  EXPECT_GT(offset, TimeDelta::FromMilliseconds(-1));
+  TimeDelta elapsed = end - start;
+  TimeDelta fast_elapsed = fast_end - fast_start;
+  EXPECT_GE(fast_elapsed, TimeDelta::FromMilliseconds(49));
+  EXPECT_LT(fast_elapsed, elapsed + elapsed / 100);
+  EXPECT_GT(fast_elapsed, elapsed - elapsed / 100);
+}
+
+// Test sleeping ---------------------------------------------------------------
+
+TEST_F(TimeTest, Sleep) {
+  TimeTicks start = TimeTicks::Now();
+  platform::Thread::Sleep(TimeDelta::FromMicroseconds(1500));
+  EXPECT_GE(TimeTicks::Now() - start, TimeDelta::FromMicroseconds(1500));
+
+  // Nothing to sleep.
+  platform::Thread::Sleep(TimeDelta::FromNanoseconds(-1));
+}
+
+TEST_F(TimeTest, SleepUntil) {
+  TimeTicks deadline = TimeTicks::Now();
+  for (int i = 0; i < 5; i++) {
+    deadline += TimeDelta::FromMilliseconds(2);
+    platform::Thread::SleepUntil(deadline);
+    EXPECT_GE(TimeTicks::Now(), deadline);
+  }
+  // A deadline in the past returns at once.
+  platform::Thread::SleepUntil(deadline - TimeDelta::FromSeconds(1));
+}
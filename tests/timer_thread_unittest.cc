@@ -0,0 +1,135 @@
+// Copyright (c) 2010 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "simple-platform-lib/src/timer_thread.h"
+
+#include <gtest/gtest.h>
+
+#include "simple-platform-lib/src/condition_variable.h"
+#include "simple-platform-lib/src/lock.h"
+#include "simple-platform-lib/src/time.h"
+
+using platform::TimeDelta;
+using platform::TimeTicks;
+
+typedef testing::Test TimerThreadTest;
+
+namespace {
+
+// Records when it expired, and reschedules itself |repeats| more times.
+class TestTimer : public platform::Timer {
+ public:
+  explicit TestTimer(platform::TimerThread* timer_thread)
+      : timer_thread_(timer_thread),
+        repeats_(0),
+        expirations_(0),
+        changed_(&lock_) {
+  }
+
+  virtual void OnExpired() {
+    platform::AutoLock auto_lock(lock_);
+    expired_at_ = TimeTicks::Now();
+    expirations_++;
+    if (repeats_ > 0) {
+      repeats_--;
+      timer_thread_->Schedule(this,
+                              expired_at_ + TimeDelta::FromMilliseconds(1));
+    }
+    changed_.Broadcast();
+  }
+
+  void set_repeats(int repeats) {
+    platform::AutoLock auto_lock(lock_);
+    repeats_ = repeats;
+  }
+
+  // Waits up to 10 seconds for |count| expirations; returns how many there
+  // were.
+  int WaitForExpirations(int count) {
+    platform::AutoLock auto_lock(lock_);
+    TimeTicks give_up = TimeTicks::Now() + TimeDelta::FromSeconds(10);
+    while (expirations_ < count) {
+      TimeTicks now = TimeTicks::Now();
+      if (now >= give_up)
+        break;
+      changed_.TimedWait(give_up - now);
+    }
+    return expirations_;
+  }
+
+  TimeTicks expired_at() {
+    platform::AutoLock auto_lock(lock_);
+    return expired_at_;
+  }
+
+ private:
+  platform::TimerThread* timer_thread_;
+  platform::Lock lock_;
+  int repeats_;
+  int expirations_;
+  TimeTicks expired_at_;
+  platform::ConditionVariable changed_;
+};
+
+}  // namespace
+
+// Test that timers expire, and not early --------------------------------------
+
+TEST_F(TimerThreadTest, Expires) {
+  platform::TimerThread timer_thread(TimeDelta::FromMilliseconds(1));
+  ASSERT_TRUE(timer_thread.Start());
+  TestTimer timer(&timer_thread);
+  TimeTicks deadline = TimeTicks::Now() + TimeDelta::FromMilliseconds(20);
+  timer_thread.Schedule(&timer, deadline);
+  EXPECT_EQ(1, timer.WaitForExpirations(1));
+  EXPECT_TRUE(timer.expired_at() >= deadline);
+  EXPECT_FALSE(timer.is_scheduled());
+  timer_thread.Stop();
+}
+
+TEST_F(TimerThreadTest, Cancel) {
+  platform::TimerThread timer_thread(TimeDelta::FromMilliseconds(1));
+  ASSERT_TRUE(timer_thread.Start());
+  TestTimer cancelled(&timer_thread), control(&timer_thread);
+  TimeTicks now = TimeTicks::Now();
+  timer_thread.Schedule(&cancelled, now + TimeDelta::FromMilliseconds(10));
+  timer_thread.Schedule(&control, now + TimeDelta::FromMilliseconds(30));
+  EXPECT_TRUE(timer_thread.Cancel(&cancelled));
+  EXPECT_FALSE(timer_thread.Cancel(&cancelled));
+
+  // Once the later timer has expired, the cancelled one would have too.
+  EXPECT_EQ(1, control.WaitForExpirations(1));
+  EXPECT_EQ(0, cancelled.WaitForExpirations(0));
+  timer_thread.Stop();
+}
+
+TEST_F(TimerThreadTest, ReschedulesFromOnExpired) {
+  platform::TimerThread timer_thread(TimeDelta::FromMilliseconds(1));
+  ASSERT_TRUE(timer_thread.Start());
+  TestTimer timer(&timer_thread);
+  timer.set_repeats(4);
+  timer_thread.Schedule(&timer, TimeTicks::Now());
+  EXPECT_EQ(5, timer.WaitForExpirations(5));
+  timer_thread.Stop();
+}
+
+// Test that an earlier timer wakes the sleeping thread ------------------------
+
+TEST_F(TimerThreadTest, EarlierTimerWakesThread) {
+  platform::TimerThread timer_thread(TimeDelta::FromMilliseconds(1));
+  ASSERT_TRUE(timer_thread.Start());
+  TestTimer late(&timer_thread), early(&timer_thread);
+  TimeTicks start = TimeTicks::Now();
+  timer_thread.Schedule(&late, start + TimeDelta::FromSeconds(60));
+  // Give the thread time to go to sleep until |late|'s deadline.
+  platform::Thread::Sleep(TimeDelta::FromMilliseconds(10));
+  timer_thread.Schedule(&early, TimeTicks::Now());
+  EXPECT_EQ(1, early.WaitForExpirations(1));
+  EXPECT_TRUE(early.expired_at() - start < TimeDelta::FromSeconds(10));
+
+  // Stop() unschedules |late| without expiring it.
+  timer_thread.Stop();
+  EXPECT_FALSE(late.is_scheduled());
+  EXPECT_EQ(0, late.WaitForExpirations(0));
+}
@@ -0,0 +1,214 @@
+// Copyright (c) 2010 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "simple-platform-lib/src/timer_wheel.h"
+
+#include <gtest/gtest.h>
+#include <stdlib.h>
+
+#include <algorithm>
+#include <vector>
+
+using platform::TimeDelta;
+using platform::TimeTicks;
+
+typedef testing::Test TimerWheelTest;
+
+namespace {
+
+class TestTimer : public platform::Timer {
+ public:
+  TestTimer() : id(0), deadline_ms(0) {}
+
+  virtual void OnExpired() {}
+
+  int id;
+  int64 deadline_ms;
+};
+
+// Times are in milliseconds past a fixed origin, and so are ticks.
+TimeTicks At(int64 ms) {
+  return TimeTicks::FromInternalValue(1000 * 1000 * 1000) +
+         TimeDelta::FromMilliseconds(ms);
+}
+
+class Wheel : public platform::TimerWheel {
+ public:
+  Wheel() : platform::TimerWheel(TimeDelta::FromMilliseconds(1), At(0)) {}
+};
+
+std::vector<int> AdvanceTo(Wheel* wheel, int64 ms) {
+  std::vector<platform::Timer*> expired;
+  wheel->Advance(At(ms), &expired);
+  std::vector<int> ids;
+  for (size_t i = 0; i < expired.size(); i++)
+    ids.push_back(static_cast<TestTimer*>(expired[i])->id);
+  return ids;
+}
+
+}  // namespace
+
+// Test the single-timer behavior ----------------------------------------------
+
+TEST_F(TimerWheelTest, ExpiresAtDeadline) {
+  Wheel wheel;
+  TestTimer timer;
+  timer.id = 1;
+  EXPECT_TRUE(wheel.NextWakeup().is_null());
+  wheel.Schedule(&timer, At(10));
+  EXPECT_TRUE(timer.is_scheduled());
+  EXPECT_EQ(1u, wheel.size());
+  EXPECT_TRUE(wheel.NextWakeup() == At(10));
+
+  EXPECT_TRUE(AdvanceTo(&wheel, 9).empty());
+  std::vector<int> ids = AdvanceTo(&wheel, 10);
+  ASSERT_EQ(1u, ids.size());
+  EXPECT_EQ(1, ids[0]);
+  EXPECT_FALSE(timer.is_scheduled());
+  EXPECT_EQ(0u, wheel.size());
+  EXPECT_TRUE(wheel.NextWakeup().is_null());
+}
+
+TEST_F(TimerWheelTest, RoundsUp) {
+  Wheel wheel;
+  TestTimer timer;
+  wheel.Schedule(&timer, At(5) + TimeDelta::FromMicroseconds(1));
+  EXPECT_TRUE(AdvanceTo(&wheel, 5).empty());
+  EXPECT_EQ(1u, AdvanceTo(&wheel, 6).size());
+}
+
+TEST_F(TimerWheelTest, Cancel) {
+  Wheel wheel;
+  TestTimer timer;
+  EXPECT_FALSE(wheel.Cancel(&timer));
+  wheel.Schedule(&timer, At(10));
+  EXPECT_TRUE(wheel.Cancel(&timer));
+  EXPECT_FALSE(timer.is_scheduled());
+  EXPECT_FALSE(wheel.Cancel(&timer));
+  EXPECT_EQ(0u, wheel.size());
+  EXPECT_TRUE(AdvanceTo(&wheel, 100).empty());
+
+  // A cancelled timer can be scheduled again.
+  wheel.Schedule(&timer, At(200));
+  EXPECT_EQ(1u, AdvanceTo(&wheel, 200).size());
+}
+
+TEST_F(TimerWheelTest, PastDeadline) {
+  Wheel wheel;
+  AdvanceTo(&wheel, 1000);
+  TestTimer timer;
+  wheel.Schedule(&timer, At(500));
+  // Ticks up to 1000 are done with, so it expires with the next one.
+  EXPECT_TRUE(wheel.NextWakeup() == At(1001));
+  EXPECT_TRUE(AdvanceTo(&wheel, 1000).empty());
+  EXPECT_EQ(1u, AdvanceTo(&wheel, 1001).size());
+}
+
+TEST_F(TimerWheelTest, CancelAll) {
+  Wheel wheel;
+  TestTimer timers[3];
+  for (int i = 0; i < 3; i++)
+    wheel.Schedule(&timers[i], At(i * 100000));
+  wheel.CancelAll();
+  EXPECT_EQ(0u, wheel.size());
+  for (int i = 0; i < 3; i++)
+    EXPECT_FALSE(timers[i].is_scheduled());
+}
+
+// Test that timers on every level expire at their deadline, in order ----------
+
+TEST_F(TimerWheelTest, Levels) {
+  // One timer just before and one at each level's boundary, and two beyond
+  // the wheel.
+  const int64 kDeadlines[] = {
+    0, 255, 256, 257, 16383, 16384, 16385, 1048575, 1048576,
+    67108863, 67108864, GG_LONGLONG(4294967295), GG_LONGLONG(4294967296),
+    GG_LONGLONG(10000000000)
+  };
+  const size_t kCount = arraysize(kDeadlines);
+  Wheel wheel;
+  TestTimer timers[kCount];
+  for (size_t i = 0; i < kCount; i++) {
+    timers[i].id = static_cast<int>(i);
+    timers[i].deadline_ms = kDeadlines[i];
+    wheel.Schedule(&timers[i], At(kDeadlines[i]));
+  }
+
+  // Jump from just before each deadline to it, so that every cascade on the
+  // way happens, but quickly.
+  for (size_t i = 0; i < kCount; i++) {
+    if (kDeadlines[i] > 0) {
+      std::vector<int> early = AdvanceTo(&wheel, kDeadlines[i] - 1);
+      EXPECT_TRUE(early.empty()) << "before timer " << i;
+    }
+    std::vector<int> ids = AdvanceTo(&wheel, kDeadlines[i]);
+    ASSERT_EQ(1u, ids.size()) << "timer " << i;
+    EXPECT_EQ(static_cast<int>(i), ids[0]);
+  }
+  EXPECT_EQ(0u, wheel.size());
+}
+
+TEST_F(TimerWheelTest, NextWakeup) {
+  Wheel wheel;
+  TestTimer near_timer, far_timer;
+  // 100000 ticks away is on level 2, whose slots span 16384 ticks; the
+  // timer comes down a level when its slot is cascaded, at 6 * 16384.
+  wheel.Schedule(&far_timer, At(100000));
+  EXPECT_TRUE(wheel.NextWakeup() == At(6 * 16384));
+  wheel.Schedule(&near_timer, At(42));
+  EXPECT_TRUE(wheel.NextWakeup() == At(42));
+  EXPECT_EQ(1u, AdvanceTo(&wheel, 42).size());
+  EXPECT_TRUE(wheel.NextWakeup() == At(6 * 16384));
+
+  // Following the wakeups reaches the deadline in a few steps.
+  int wakeups = 0;
+  std::vector<int> ids;
+  while (ids.empty()) {
+    int64 ms = (wheel.NextWakeup() - At(0)).InMilliseconds();
+    ASSERT_LE(ms, 100000);
+    ids = AdvanceTo(&wheel, ms);
+    wakeups++;
+  }
+  EXPECT_LE(wakeups, 3);
+  EXPECT_TRUE(wheel.NextWakeup().is_null());
+}
+
+// Test against a sorted reference, with random deadlines and cancellations ----
+
+TEST_F(TimerWheelTest, Random) {
+  const int kTimers = 20000;
+  const int64 kHorizonMs = 3000000;
+  srand(42);
+  Wheel wheel;
+  std::vector<TestTimer> timers(kTimers);
+  std::vector<std::pair<int64, int> > expected;
+  for (int i = 0; i < kTimers; i++) {
+    timers[i].id = i;
+    timers[i].deadline_ms =
+        static_cast<int64>(rand()) * rand() % kHorizonMs;
+    wheel.Schedule(&timers[i], At(timers[i].deadline_ms));
+  }
+  for (int i = 0; i < kTimers; i++) {
+    if (i % 3 == 0)
+      EXPECT_TRUE(wheel.Cancel(&timers[i]));
+    else
+      expected.push_back(std::make_pair(timers[i].deadline_ms, i));
+  }
+  std::sort(expected.begin(), expected.end());
+
+  // Advance in irregular steps, checking that each timer expires in the step
+  // that covers its deadline.
+  size_t next = 0;
+  for (int64 now = 0; now <= kHorizonMs; now += 1 + rand() % 5000) {
+    std::vector<int> ids = AdvanceTo(&wheel, now);
+    std::vector<int> due;
+    while (next < expected.size() && expected[next].first <= now)
+      due.push_back(expected[next++].second);
+    std::sort(ids.begin(), ids.end());
+    std::sort(due.begin(), due.end());
+    ASSERT_EQ(due, ids) << "at " << now;
+  }
+  AdvanceTo(&wheel, kHorizonMs);
+  EXPECT_EQ(0u, wheel.size());
+}
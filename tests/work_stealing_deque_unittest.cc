@@ -0,0 +1,116 @@
+// Copyright (c) 2010 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "simple-platform-lib/src/work_stealing_deque.h"
+
+#include <gtest/gtest.h>
+
+#include <vector>
+
+#include "simple-platform-lib/src/atomics.h"
+#include "simple-platform-lib/src/thread.h"
+
+typedef testing::Test WorkStealingDequeTest;
+
+// Test the order in which the owner and thieves see items ---------------------
+
+TEST_F(WorkStealingDequeTest, PopIsLifoStealIsFifo) {
+  int items[4];
+  platform::WorkStealingDeque<int> deque;
+  EXPECT_TRUE(deque.Empty());
+  EXPECT_EQ(NULL, deque.Pop());
+  EXPECT_EQ(NULL, deque.Steal());
+
+  for (int i = 0; i < 4; i++)
+    deque.Push(&items[i]);
+  EXPECT_FALSE(deque.Empty());
+  EXPECT_EQ(&items[3], deque.Pop());
+  EXPECT_EQ(&items[0], deque.Steal());
+  EXPECT_EQ(&items[2], deque.Pop());
+  EXPECT_EQ(&items[1], deque.Steal());
+  EXPECT_TRUE(deque.Empty());
+  EXPECT_EQ(NULL, deque.Pop());
+  EXPECT_EQ(NULL, deque.Steal());
+}
+
+TEST_F(WorkStealingDequeTest, Grow) {
+  const int kCount = 10000;
+  std::vector<int> items(kCount);
+  platform::WorkStealingDeque<int> deque;
+  for (int i = 0; i < kCount; i++)
+    deque.Push(&items[i]);
+  for (int i = 0; i < kCount / 2; i++)
+    EXPECT_EQ(&items[i], deque.Steal());
+  for (int i = kCount - 1; i >= kCount / 2; i--)
+    EXPECT_EQ(&items[i], deque.Pop());
+  EXPECT_TRUE(deque.Empty());
+}
+
+// Test that every item is taken exactly once under concurrent stealing --------
+
+namespace {
+
+const int kItems = 200000;
+
+typedef platform::Atomic<int> Counter;
+
+class ThiefThread : public platform::Thread::Delegate {
+ public:
+  ThiefThread(platform::WorkStealingDeque<Counter>* deque,
+              platform::AtomicFlag* done)
+      : deque_(deque), done_(done) {}
+
+  virtual void ThreadMain() {
+    while (!done_->IsSet() || !deque_->Empty()) {
+      Counter* item = deque_->Steal();
+      if (item)
+        item->FetchAdd(1);
+      else
+        platform::Thread::Yield();
+    }
+  }
+
+ private:
+  platform::WorkStealingDeque<Counter>* deque_;
+  platform::AtomicFlag* done_;
+
+  DISALLOW_COPY_AND_ASSIGN(ThiefThread);
+};
+
+}  // namespace
+
+TEST_F(WorkStealingDequeTest, ConcurrentSteal) {
+  std::vector<Counter> taken(kItems);
+  platform::WorkStealingDeque<Counter> deque;
+  platform::AtomicFlag done;
+
+  const int kThieves = 3;
+  ThiefThread* thieves[kThieves];
+  platform::ThreadHandle handles[kThieves];
+  for (int i = 0; i < kThieves; i++) {
+    thieves[i] = new ThiefThread(&deque, &done);
+    ASSERT_TRUE(platform::Thread::Create(0, thieves[i], &handles[i]));
+  }
+
+  // Push in bursts, popping some back, so that the owner races the thieves
+  // for the last item as well as growing the array under them.
+  for (int i = 0; i < kItems; i++) {
+    deque.Push(&taken[i]);
+    if (i % 3 == 0) {
+      Counter* item = deque.Pop();
+      if (item)
+        item->FetchAdd(1);
+    }
+  }
+  while (Counter* item = deque.Pop())
+    item->FetchAdd(1);
+  done.Set();
+
+  for (int i = 0; i < kThieves; i++) {
+    platform::Thread::Join(handles[i]);
+    delete thieves[i];
+  }
+  for (int i = 0; i < kItems; i++)
+    ASSERT_EQ(1, taken[i].Load()) << "item " << i;
+}
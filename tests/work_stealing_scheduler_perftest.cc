@@ -0,0 +1,169 @@
+// Copyright (c) 2010 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+// Scaling of recursive fork/join workloads on the WorkStealingScheduler: a
+// parallel sum and a parallel quicksort, for 1 .. NumberOfProcessors()
+// workers, against a plain serial run.
+
+#include "simple-platform-lib/src/work_stealing_scheduler.h"
+
+#include <gtest/gtest.h>
+#include <stdio.h>
+
+#include <algorithm>
+#include <vector>
+
+#include "simple-platform-lib/src/sys_info.h"
+#include "simple-platform-lib/tests/perftimer.h"
+
+namespace {
+
+const size_t kSumSize = 16 * 1024 * 1024;
+const size_t kSumCutoff = 16 * 1024;
+const size_t kSortSize = 4 * 1024 * 1024;
+const size_t kSortCutoff = 4 * 1024;
+
+int64 SerialSum(const int32* begin, const int32* end) {
+  int64 sum = 0;
+  for (const int32* p = begin; p != end; ++p)
+    sum += *p;
+  return sum;
+}
+
+class SumTask : public platform::Task {
+ public:
+  SumTask(platform::WorkStealingScheduler* scheduler, const int32* begin,
+          const int32* end, int64* result)
+      : scheduler_(scheduler), begin_(begin), end_(end), result_(result) {}
+
+  virtual void Run() {
+    if (static_cast<size_t>(end_ - begin_) <= kSumCutoff) {
+      *result_ = SerialSum(begin_, end_);
+      return;
+    }
+    const int32* middle = begin_ + (end_ - begin_) / 2;
+    int64 left, right;
+    platform::TaskGroup group(scheduler_);
+    group.Spawn(new SumTask(scheduler_, begin_, middle, &left));
+    group.Spawn(new SumTask(scheduler_, middle, end_, &right));
+    group.Join();
+    *result_ = left + right;
+  }
+
+ private:
+  platform::WorkStealingScheduler* scheduler_;
+  const int32* begin_;
+  const int32* end_;
+  int64* result_;
+
+  DISALLOW_COPY_AND_ASSIGN(SumTask);
+};
+
+// Hoare partition around the median of three; returns the split point.
+int32* Partition(int32* begin, int32* end) {
+  int32 a = begin[0], b = begin[(end - begin) / 2], c = end[-1];
+  int32 pivot = std::max(std::min(a, b), std::min(std::max(a, b), c));
+  int32* left = begin - 1;
+  int32* right = end;
+  for (;;) {
+    do { ++left; } while (*left < pivot);
+    do { --right; } while (*right > pivot);
+    if (left >= right)
+      return right + 1;
+    std::swap(*left, *right);
+  }
+}
+
+class SortTask : public platform::Task {
+ public:
+  SortTask(platform::WorkStealingScheduler* scheduler, int32* begin,
+           int32* end)
+      : scheduler_(scheduler), begin_(begin), end_(end) {}
+
+  virtual void Run() {
+    if (static_cast<size_t>(end_ - begin_) <= kSortCutoff) {
+      std::sort(begin_, end_);
+      return;
+    }
+    int32* middle = Partition(begin_, end_);
+    platform::TaskGroup group(scheduler_);
+    group.Spawn(new SortTask(scheduler_, begin_, middle));
+    group.Spawn(new SortTask(scheduler_, middle, end_));
+    group.Join();
+  }
+
+ private:
+  platform::WorkStealingScheduler* scheduler_;
+  int32* begin_;
+  int32* end_;
+
+  DISALLOW_COPY_AND_ASSIGN(SortTask);
+};
+
+void FillRandom(std::vector<int32>* values) {
+  uint32 state = 12345;
+  for (size_t i = 0; i < values->size(); i++) {
+    state = state * 1103515245 + 12345;
+    (*values)[i] = static_cast<int32>(state >> 1);
+  }
+}
+
+void PrintResult(const char* measurement, int threads, double ms) {
+  char modifier[32];
+  snprintf(modifier, sizeof(modifier), "_%dthreads", threads);
+  platform::PrintPerfResult(measurement, modifier, "work_stealing", ms, "ms");
+}
+
+}  // namespace
+
+TEST(WorkStealingSchedulerPerfTest, ParallelSum) {
+  std::vector<int32> values(kSumSize);
+  FillRandom(&values);
+  const int32* begin = &values[0];
+  const int32* end = begin + values.size();
+
+  platform::PerfTimer timer;
+  int64 expected = SerialSum(begin, end);
+  platform::PrintPerfResult("parallel_sum", "", "serial", timer.ElapsedMs(),
+                            "ms");
+
+  for (int threads = 1; threads <= platform::SysInfo::NumberOfProcessors();
+       threads *= 2) {
+    platform::WorkStealingScheduler scheduler(threads);
+    EXPECT_TRUE(scheduler.Start());
+    int64 sum = 0;
+    timer.Reset();
+    platform::TaskGroup group(&scheduler);
+    group.Spawn(new SumTask(&scheduler, begin, end, &sum));
+    group.Join();
+    PrintResult("parallel_sum", threads, timer.ElapsedMs());
+    EXPECT_EQ(expected, sum);
+  }
+}
+
+TEST(WorkStealingSchedulerPerfTest, Quicksort) {
+  std::vector<int32> original(kSortSize);
+  FillRandom(&original);
+
+  std::vector<int32> values(original);
+  platform::PerfTimer timer;
+  std::sort(values.begin(), values.end());
+  platform::PrintPerfResult("quicksort", "", "serial", timer.ElapsedMs(),
+                            "ms");
+  std::vector<int32> expected(values);
+
+  for (int threads = 1; threads <= platform::SysInfo::NumberOfProcessors();
+       threads *= 2) {
+    platform::WorkStealingScheduler scheduler(threads);
+    EXPECT_TRUE(scheduler.Start());
+    values = original;
+    timer.Reset();
+    platform::TaskGroup group(&scheduler);
+    group.Spawn(new SortTask(&scheduler, &values[0],
+                             &values[0] + values.size()));
+    group.Join();
+    PrintResult("quicksort", threads, timer.ElapsedMs());
+    EXPECT_TRUE(values == expected);
+  }
+}
@@ -0,0 +1,146 @@
+// Copyright (c) 2010 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "simple-platform-lib/src/work_stealing_scheduler.h"
+
+#include <gtest/gtest.h>
+
+#include "simple-platform-lib/src/atomics.h"
+#include "simple-platform-lib/src/thread.h"
+
+typedef testing::Test WorkStealingSchedulerTest;
+
+namespace {
+
+class IncrementTask : public platform::Task {
+ public:
+  explicit IncrementTask(platform::Atomic<int32>* counter)
+      : counter_(counter) {}
+
+  virtual void Run() {
+    counter_->FetchAdd(1);
+  }
+
+ private:
+  platform::Atomic<int32>* counter_;
+
+  DISALLOW_COPY_AND_ASSIGN(IncrementTask);
+};
+
+// Computes the |n|th Fibonacci number by forking a task per call.
+class FibTask : public platform::Task {
+ public:
+  FibTask(platform::WorkStealingScheduler* scheduler, int n, int64* result)
+      : scheduler_(scheduler), n_(n), result_(result) {}
+
+  virtual void Run() {
+    if (n_ < 2) {
+      *result_ = n_;
+      return;
+    }
+    int64 a, b;
+    platform::TaskGroup group(scheduler_);
+    group.Spawn(new FibTask(scheduler_, n_ - 1, &a));
+    group.Spawn(new FibTask(scheduler_, n_ - 2, &b));
+    group.Join();
+    *result_ = a + b;
+  }
+
+ private:
+  platform::WorkStealingScheduler* scheduler_;
+  int n_;
+  int64* result_;
+
+  DISALLOW_COPY_AND_ASSIGN(FibTask);
+};
+
+// Spawns |count| IncrementTasks into |group| from inside the group.
+class SpawningTask : public platform::Task {
+ public:
+  SpawningTask(platform::TaskGroup* group, int count,
+               platform::Atomic<int32>* counter)
+      : group_(group), count_(count), counter_(counter) {}
+
+  virtual void Run() {
+    for (int i = 0; i < count_; i++)
+      group_->Spawn(new IncrementTask(counter_));
+  }
+
+ private:
+  platform::TaskGroup* group_;
+  int count_;
+  platform::Atomic<int32>* counter_;
+
+  DISALLOW_COPY_AND_ASSIGN(SpawningTask);
+};
+
+}  // namespace
+
+// Test groups joined from outside the scheduler -------------------------------
+
+TEST_F(WorkStealingSchedulerTest, JoinFromOutside) {
+  platform::WorkStealingScheduler scheduler(4);
+  ASSERT_TRUE(scheduler.Start());
+  EXPECT_EQ(4, scheduler.num_threads());
+
+  platform::Atomic<int32> counter;
+  platform::TaskGroup group(&scheduler);
+  for (int i = 0; i < 10000; i++)
+    group.Spawn(new IncrementTask(&counter));
+  group.Join();
+  EXPECT_EQ(10000, counter.Load());
+
+  // Tasks spawned into the group by its tasks are joined too.
+  group.Spawn(new SpawningTask(&group, 1000, &counter));
+  group.Join();
+  EXPECT_EQ(11000, counter.Load());
+}
+
+TEST_F(WorkStealingSchedulerTest, PostTask) {
+  platform::Atomic<int32> counter;
+  {
+    platform::WorkStealingScheduler scheduler(2);
+    ASSERT_TRUE(scheduler.Start());
+    for (int i = 0; i < 1000; i++)
+      scheduler.PostTask(new IncrementTask(&counter));
+    // The destructor runs the posted tasks.
+  }
+  EXPECT_EQ(1000, counter.Load());
+}
+
+TEST_F(WorkStealingSchedulerTest, PostTaskWithoutStart) {
+  platform::Atomic<int32> counter;
+  {
+    platform::WorkStealingScheduler scheduler(2);
+    scheduler.PostTask(new IncrementTask(&counter));
+  }
+  EXPECT_EQ(1, counter.Load());
+}
+
+// Test recursive fork/join ----------------------------------------------------
+
+TEST_F(WorkStealingSchedulerTest, Fibonacci) {
+  platform::WorkStealingScheduler scheduler(0);
+  ASSERT_TRUE(scheduler.Start());
+  EXPECT_GE(scheduler.num_threads(), 1);
+
+  int64 result = 0;
+  platform::TaskGroup group(&scheduler);
+  group.Spawn(new FibTask(&scheduler, 20, &result));
+  group.Join();
+  EXPECT_EQ(6765, result);
+}
+
+TEST_F(WorkStealingSchedulerTest, FibonacciOversubscribed) {
+  platform::WorkStealingScheduler scheduler(8);
+  ASSERT_TRUE(scheduler.Start());
+
+  int64 results[4];
+  platform::TaskGroup group(&scheduler);
+  for (int i = 0; i < 4; i++)
+    group.Spawn(new FibTask(&scheduler, 18, &results[i]));
+  group.Join();
+  for (int i = 0; i < 4; i++)
+    EXPECT_EQ(2584, results[i]);
+}